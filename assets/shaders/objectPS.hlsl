@@ -6,6 +6,12 @@ uint main(PixelInput input) : SV_Target
 {
     return 0;
 }
+#elif defined(OBJECTSHADER_FALLBACK)
+// Drawn while the pipelines of the object shader are compiled, keep the resource layout of the object shader
+float4 main(PixelInput input) : SV_Target
+{
+    return float4(GetMaterial().baseColor.rgb, 1.0f);
+}
 #else
 
 float4 main(PixelInput input) : SV_Target
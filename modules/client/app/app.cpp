@@ -26,7 +26,8 @@ App::App()
     Logger::RegisterSink(mStdoutLoggerSink);
     Logger::Info("App initialized.");
      
-    Jobsystem::Initialize(Platform::GetCPUsCount());
+    // Background workers run the long tasks, e.g. asset compiling
+    Jobsystem::Initialize(Platform::GetCPUsCount(), std::max(1, Platform::GetCPUsCount() / 4));
 
     Platform::Initialize();
     Platform::LogPlatformInfo();
@@ -100,6 +101,9 @@ void App::Initialize()
 
 void App::Uninitialize()
 {
+    Logger::Info("Frame allocators:%d, peak of the frames:%d KB",
+        FrameAllocator::GetAllocatorCount(), (U32)(FrameAllocator::GetMaxPeakBytes() / 1024));
+
     engine->Stop(*world);
     engine->DestroyWorld(*world);
     engine.Reset();
@@ -195,6 +199,7 @@ void App::OnEvent(const Platform::WindowEvent& ent)
 void App::OnIdle()
 {
     Profiler::BeginFrame();
+    FrameAllocator::NewFrame();
     wsi.BeginFrame();
 
     // Calculate delta time
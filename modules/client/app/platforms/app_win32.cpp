@@ -4,6 +4,7 @@
 #include "core\utils\profiler.h"
 #include "core\platform\sync.h"
 #include "core\platform\platform.h"
+#include "core\utils\string.h"
 #include "gpu\vulkan\wsi.h"
 
 #include <thread>
@@ -147,6 +148,13 @@ int ApplicationMain(std::function<App*(int, char **)> createAppFunc, int argc, c
 	if (app == nullptr)
 		return 1;
 
+	// -record_pipelines: record the pipeline states of this run for the offline replay
+	for (int i = 1; i < argc; i++)
+	{
+		if (EqualString(argv[i], "-record_pipelines"))
+			app->GetWSI().SetPipelineRecording(true);
+	}
+
 	PlatformWin32::Options options = {};
 	std::unique_ptr<PlatformWin32> platform = std::make_unique<PlatformWin32>(options);
 	app->Run(std::move(platform));
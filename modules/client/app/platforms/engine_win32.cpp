@@ -22,6 +22,7 @@ namespace VulkanTest
 		WSI* wsi;
 		bool isGameRunning = false;
 		bool isPaused = false;
+		F32 asyncTimeBudget = DEFAULT_ASYNC_TIME_BUDGET;
 
 		lua_State* luaState = NULL;
 		size_t luaAllocated = 0;
@@ -41,16 +42,21 @@ namespace VulkanTest
 			luaL_openlibs(luaState);
 
 			// Create filesystem
+			asyncTimeBudget = initConfig.asyncTimeBudget;
 			if (initConfig.workingDir != nullptr) {
-				fileSystem = FileSystem::Create(initConfig.workingDir);
+				fileSystem = FileSystem::Create(initConfig.workingDir, initConfig.ioWorkerCount);
 			}
 			else
 			{
 				char currentDir[MAX_PATH_LENGTH];
 				Platform::GetCurrentDir(currentDir);
-				fileSystem = FileSystem::Create(currentDir);
+				fileSystem = FileSystem::Create(currentDir, initConfig.ioWorkerCount);
 			}
 
+			// Mount the packed compiled resources read-only, the editor remounts it to write the compiled ones
+			if (fileSystem->FileExists(RESOURCE_PACK_PATH))
+				fileSystem->MountPack(RESOURCE_PACK_PATH);
+
 			// Init resource manager
 			resourceManager.Initialize(*fileSystem);
 
@@ -150,7 +156,7 @@ namespace VulkanTest
 			inputSystem->Update(dt);
 
 			// Process async loading jobs
-			fileSystem->ProcessAsync();
+			fileSystem->ProcessAsync(asyncTimeBudget);
 		}
 
 		void Stop(World& world) override
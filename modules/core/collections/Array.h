@@ -10,10 +10,11 @@ namespace VulkanTest
     {
     public:
         Array() = default;
+        explicit Array(IAllocator& allocator_) : allocator(&allocator_) {}
         ~Array()
         {
             DestructData(data_, data_ + size_);
-            CJING_FREE_ALIGN(data_);
+            FreeData(data_);
         }
 
         Array(const Array& rhs) = delete;
@@ -28,12 +29,16 @@ namespace VulkanTest
             if (data_ != nullptr)
             {
                 DestructData(data_, data_ + size_);
-                CJING_FREE_ALIGN(data_);
+                FreeData(data_);
+                data_ = nullptr;
+                size_ = 0;
+                capacity_ = 0;
             }
 
             std::swap(size_, rhs.size_);
             std::swap(capacity_, rhs.capacity_);
             std::swap(data_, rhs.data_);
+            std::swap(allocator, rhs.allocator);
         }
 
         void swap(Array<T>&& rhs)
@@ -41,6 +46,7 @@ namespace VulkanTest
             std::swap(size_, rhs.size_);
             std::swap(capacity_, rhs.capacity_);
             std::swap(data_, rhs.data_);
+            std::swap(allocator, rhs.allocator);
         }
 
         T* begin() const { 
@@ -205,13 +211,13 @@ namespace VulkanTest
             
             if constexpr (__is_trivially_copyable(T))
             {
-                data_ = static_cast<T*>(CJING_REMALLOC_ALIGN(data_, newCapacity * sizeof(T), alignof(T)));
+                data_ = static_cast<T*>(ReallocData(data_, newCapacity * sizeof(T)));
             }
             else
             {
-                T* newData = static_cast<T*>(CJING_MALLOC_ALIGN(newCapacity * sizeof(T), alignof(T)));
+                T* newData = static_cast<T*>(ReallocData(nullptr, newCapacity * sizeof(T)));
                 MoveData(newData, data_, size_);
-                CJING_FREE_ALIGN(data_);
+                FreeData(data_);
                 data_ = newData;
             }
             capacity_ = newCapacity;
@@ -280,8 +286,29 @@ namespace VulkanTest
             reserve(capacity_ == 0 ? 4 : capacity_ * 2);
         }
 
+        // Use the global allocator if no allocator is specified
+        void* ReallocData(void* ptr, size_t size)
+        {
+            if (allocator != nullptr)
+                return CJING_ALLOCATOR_REMALLOC_ALIGN((*allocator), ptr, size, alignof(T));
+            return CJING_REMALLOC_ALIGN(ptr, size, alignof(T));
+        }
+
+        void FreeData(void* ptr)
+        {
+            if (allocator != nullptr)
+            {
+                CJING_ALLOCATOR_FREE_ALIGN((*allocator), ptr);
+            }
+            else
+            {
+                CJING_FREE_ALIGN(ptr);
+            }
+        }
+
         U32 capacity_ = 0;
         U32 size_ = 0;
         T* data_ = nullptr;
+        IAllocator* allocator = nullptr;
     };
 }
\ No newline at end of file
@@ -80,6 +80,7 @@ namespace VulkanTest
 		U32 capacity = 0;
 		U32 size = 0;
 		U32 mask = 0;
+		IAllocator* allocator = nullptr;
 
 	private:
 		template <typename HM, typename KK, typename VV>
@@ -154,8 +155,16 @@ namespace VulkanTest
 			init(size);
 		}
 
+		explicit HashMap(IAllocator& allocator_) : allocator(&allocator_) {}
+
+		HashMap(U32 size, IAllocator& allocator_) : allocator(&allocator_)
+		{
+			init(size);
+		}
+
 		HashMap(HashMap&& rhs)
 		{
+			allocator = rhs.allocator;
 			keys = rhs.keys;
 			values = rhs.values;
 			capacity = rhs.capacity;
@@ -180,8 +189,8 @@ namespace VulkanTest
 					keys[i].valid = false;
 				}
 			}
-			CJING_FREE(keys);
-			CJING_FREE(values);
+			freeData(keys);
+			freeData(values);
 		}
 
 		HashMap&& move() {
@@ -201,8 +210,8 @@ namespace VulkanTest
 					keys[i].valid = false;
 				}
 			}
-			CJING_FREE(keys);
-			CJING_FREE(values);
+			freeData(keys);
+			freeData(values);
 			init(8);
 		}
 
@@ -380,8 +389,8 @@ namespace VulkanTest
 
 			size = 0;
 			mask = capacity_ - 1;
-			keys = (Slot*)CJING_MALLOC(sizeof(Slot) * (capacity_ + 1));
-			values = (V*)CJING_MALLOC(sizeof(V) * capacity_);
+			keys = (Slot*)allocData(sizeof(Slot) * (capacity_ + 1));
+			values = (V*)allocData(sizeof(V) * capacity_);
 			capacity = capacity_;
 			for (U32 i = 0; i < capacity; ++i) {
 				keys[i].valid = false;
@@ -419,7 +428,9 @@ namespace VulkanTest
 
 		void grow(U32 newCapacity) 
 		{
-			HashMap<K, V, CustomHasher> tmp(newCapacity);
+			HashMap<K, V, CustomHasher> tmp;
+			tmp.allocator = allocator;
+			tmp.init(newCapacity);
 			if (size > 0) 
 			{
 				for (auto iter = begin(); iter.isValid(); ++iter)
@@ -448,6 +459,26 @@ namespace VulkanTest
 			return pos;
 		}
 
+		// Use the global allocator if no allocator is specified
+		void* allocData(size_t bytes)
+		{
+			if (allocator != nullptr)
+				return CJING_ALLOCATOR_MALLOC((*allocator), bytes);
+			return CJING_MALLOC(bytes);
+		}
+
+		void freeData(void* ptr)
+		{
+			if (allocator != nullptr)
+			{
+				CJING_ALLOCATOR_FREE((*allocator), ptr);
+			}
+			else
+			{
+				CJING_FREE(ptr);
+			}
+		}
+
 		void rehash(U32 pos) 
 		{
 			K& key = *((K*)keys[pos].keyMem);
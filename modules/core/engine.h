@@ -2,6 +2,7 @@
 
 #include "core\common.h"
 #include "core\memory\memory.h"
+#include "core\filesystem\filesystem.h"
 #include "core\scripts\luaUtils.h"
 
 namespace VulkanTest
@@ -14,6 +15,9 @@ namespace VulkanTest
 			const char* workingDir = nullptr;
 			const char* windowTitle = "VULKAN_TEST";
 			Span<const char*> plugins;
+			U32 ioWorkerCount = DEFAULT_IO_WORKER_COUNT;
+			// Seconds spent on the callbacks of finished async loading jobs per frame
+			F32 asyncTimeBudget = DEFAULT_ASYNC_TIME_BUDGET;
 		};
 
 		virtual ~Engine() {}
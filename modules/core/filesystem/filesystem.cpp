@@ -1,8 +1,9 @@
 #include "filesystem.h"
 #include "core\platform\sync.h"
 #include "core\platform\timer.h"
+#include "core\jobsystem\jobsystem.h"
 
-#include <queue>
+#include <deque>
 
 namespace VulkanTest
 {
@@ -10,6 +11,13 @@ namespace VulkanTest
 
 	const AsyncLoadHandle AsyncLoadHandle::INVALID(0xffFFffFF);
 
+	// Adjacent packed files are read by a single request
+	static constexpr U32 MAX_COALESCED_JOB_COUNT = 32;
+	static constexpr U64 MAX_COALESCED_READ_SIZE = 8 * 1024 * 1024;
+	// The compacted pack waits for the active loads before it is swapped in, it is discarded after the retries
+	static constexpr U32 MAX_PACK_SWAP_RETRIES = 100;
+	static constexpr F32 PACK_SWAP_RETRY_INTERVAL = 0.01f;
+
 	struct AsyncLoadJob
 	{
 		enum class State {
@@ -21,10 +29,28 @@ namespace VulkanTest
 		AsyncLoadCallback cb;
 		MaxPathString path;
 		U32 jobID = 0;
+		AsyncLoadPriority priority = AsyncLoadPriority::Normal;
+		AsyncLoadFlags flags = AsyncLoadFlags::NONE;
+		AsyncLoadProcessor processor;
 		OutputMemoryStream data;
+		MappedFile* mappedFile = nullptr;
+		bool isPacked = false;
+		PackEntry packEntry;
+		// Ranged job only loads a part of the file, the whole file is loaded if the size is 0
+		U64 rangeOffset = 0;
+		U64 rangeSize = 0;
+
+		~AsyncLoadJob()
+		{
+			if (mappedFile != nullptr)
+			{
+				mappedFile->Close();
+				CJING_DELETE(mappedFile);
+			}
+		}
 	};
 
-	// Async loading thread
+	// Async loading thread, all tasks share the queues of the backend
 	class AsyncLoadTask final : public Thread
 	{
 	public:
@@ -37,7 +63,7 @@ namespace VulkanTest
 
 	private:
 		DefaultFileSystemBackend& fs;
-		bool isFinished = false;
+		volatile bool isFinished = false;
 	};
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -48,29 +74,68 @@ namespace VulkanTest
 	{
 	public:
 		StaticString<MAX_PATH_LENGTH> basePath;
-		U32 workerCount = 0;
+		U32 activeJobCount = 0;
 		U32 lastJobID = 0;
-		std::queue<AsyncLoadJob> pendingJobs;
-		std::queue<AsyncLoadJob> finishedJobs;
+		std::deque<AsyncLoadJob*> pendingJobs[(U32)AsyncLoadPriority::Count];
+		std::vector<AsyncLoadJob*> loadingJobs;
+		std::deque<AsyncLoadJob*> finishedJobs;
 		Mutex mutex;
 		Semaphore semaphore;
-		AsyncLoadTask* task;
+		std::vector<AsyncLoadTask*> tasks;
+		Mutex bufferMutex;
+		std::vector<OutputMemoryStream> bufferPool;
+		PackFile pack;
+		Jobsystem::JobHandle compactHandle;
+		// Job whose callback is being invoked, its mapped file can be taken by the callback
+		AsyncLoadJob* callbackJob = nullptr;
 
 	public:
-		DefaultFileSystemBackend(const char* basePath) :
+		DefaultFileSystemBackend(const char* basePath, U32 ioWorkerCount) :
 			semaphore(0, 0xFFff)
 		{
 			SetBasePath(basePath);
+			bufferPool.reserve(MAX_POOLED_BUFFER_COUNT);
 
-			task = CJING_NEW(AsyncLoadTask)(*this);
-			task->Create("AsyncFileIO");
+			ioWorkerCount = std::max(ioWorkerCount, 1u);
+			for (U32 i = 0; i < ioWorkerCount; i++)
+			{
+				AsyncLoadTask* task = CJING_NEW(AsyncLoadTask)(*this);
+				task->Create("AsyncFileIO");
+				tasks.push_back(task);
+			}
 		}
 
 		virtual ~DefaultFileSystemBackend()
 		{
-			task->Stop();
-			task->Destroy();
-			CJING_SAFE_DELETE(task);
+			if (compactHandle)
+				Jobsystem::Wait(&compactHandle);
+
+			// Stop all tasks before waking them, a task may consume the signal of another one
+			for (auto task : tasks)
+				task->Stop();
+			for (size_t i = 0; i < tasks.size(); i++)
+				semaphore.Signal();
+
+			for (auto task : tasks)
+			{
+				task->Destroy();
+				CJING_DELETE(task);
+			}
+			tasks.clear();
+
+			for (auto& jobs : pendingJobs)
+			{
+				for (auto job : jobs)
+				{
+					CJING_DELETE(job);
+				}
+				jobs.clear();
+			}
+			for (auto job : finishedJobs)
+			{
+				CJING_DELETE(job);
+			}
+			finishedJobs.clear();
 		}
 
 		void SetBasePath(const char* basePath_)override
@@ -87,7 +152,7 @@ namespace VulkanTest
 
 		bool HasWork()const override
 		{
-			return false;
+			return activeJobCount > 0;
 		}
 
 		bool MoveFile(const char* from, const char* to)override
@@ -112,6 +177,10 @@ namespace VulkanTest
 		
 		bool FileExists(const char* path)override
 		{
+			PackEntry entry;
+			if (FindPacked(path, entry))
+				return true;
+
 			MaxPathString fullPath(basePath, path);
 			return Platform::FileExists(fullPath);
 		}
@@ -134,6 +203,10 @@ namespace VulkanTest
 
 		U64 GetLastModTime(const char* path)override
 		{
+			PackEntry entry;
+			if (FindPacked(path, entry))
+				return entry.modifiedTime;
+
 			MaxPathString fullPath(basePath, path);
 			return Platform::GetLastModTime(fullPath);
 		}
@@ -157,6 +230,23 @@ namespace VulkanTest
 
 		bool LoadContext(const char* path, OutputMemoryStream& mem) override
 		{
+			// Counted as an active job, so the compacted pack isn't swapped in between the lookup and the read
+			PackEntry entry;
+			AddActiveJob();
+			if (FindPacked(path, entry))
+			{
+				mem.Resize(entry.size);
+				const bool ret = pack.Read(entry, mem.Data());
+				RemoveActiveJob();
+				if (!ret)
+				{
+					Logger::Error("Failed to read %s from pack", path);
+					return false;
+				}
+				return true;
+			}
+			RemoveActiveJob();
+
 			auto file = OpenFile(path, FileFlags::DEFAULT_READ);
 			if (file)
 			{
@@ -175,7 +265,7 @@ namespace VulkanTest
 			return false;
 		}
 
-		void ProcessAsync() override
+		void ProcessAsync(F32 timeBudget) override
 		{
 			// Process async loading jobs. Do callback for finished jobs
 
@@ -189,40 +279,445 @@ namespace VulkanTest
 					break;
 				}
 
-				AsyncLoadJob job = std::move(finishedJobs.front());
-				finishedJobs.pop();
+				AsyncLoadJob* job = finishedJobs.front();
+				finishedJobs.pop_front();
 
-				ASSERT(workerCount > 0);
-				workerCount--;
+				ASSERT(activeJobCount > 0);
+				activeJobCount--;
 				mutex.Unlock();
 
-				job.cb.Invoke(
-					job.data.Size(), 
-					(const U8*)job.data.Data(), 
-					job.state != AsyncLoadJob::State::FAILED);
+				if (job->state != AsyncLoadJob::State::CANCELED)
+				{
+					if (job->mappedFile != nullptr)
+					{
+						callbackJob = job;
+						job->cb.Invoke(
+							job->mappedFile->Size(),
+							job->mappedFile->GetMappedData(),
+							job->state != AsyncLoadJob::State::FAILED);
+						callbackJob = nullptr;
+					}
+					else
+					{
+						job->cb.Invoke(
+							job->data.Size(),
+							(const U8*)job->data.Data(),
+							job->state != AsyncLoadJob::State::FAILED);
+					}
+				}
+				// Mapped view is released with the job unless the callback took it
+				ReleaseBuffer(std::move(job->data));
+				CJING_DELETE(job);
 
 				// Cost too much time
-				if (timer.GetTimeSinceStart() > 0.2f)
+				if (timer.GetTimeSinceStart() > timeBudget)
 					break;
 			}
 		}
 
-		AsyncLoadHandle LoadFileAsync(const Path& path, const AsyncLoadCallback& cb) override
+		AsyncLoadHandle LoadFileAsync(const Path& path, const AsyncLoadCallback& cb, AsyncLoadPriority priority, AsyncLoadFlags flags, const AsyncLoadProcessor& processor) override
 		{
 			if (path.IsEmpty())
 				return AsyncLoadHandle::INVALID;
 
+			ASSERT(priority < AsyncLoadPriority::Count);
+			AsyncLoadJob* job = CJING_NEW(AsyncLoadJob)();
+			job->path = path.c_str();
+			job->cb = cb;
+			job->priority = priority;
+			job->flags = flags;
+			job->processor = processor;
+
+			// Counted before the lookup, the found entry is valid until the job is finished
+			AddActiveJob();
+			job->isPacked = FindPacked(path.c_str(), job->packEntry);
+			return PushJob(job);
+		}
+
+		AsyncLoadHandle LoadFileRangeAsync(const Path& path, U64 offset, U64 size, const AsyncLoadCallback& cb, AsyncLoadPriority priority) override
+		{
+			if (path.IsEmpty() || size == 0)
+				return AsyncLoadHandle::INVALID;
+
+			ASSERT(priority < AsyncLoadPriority::Count);
+			AsyncLoadJob* job = CJING_NEW(AsyncLoadJob)();
+			job->path = path.c_str();
+			job->cb = cb;
+			job->priority = priority;
+			job->rangeOffset = offset;
+			job->rangeSize = size;
+
+			// The packed range is read as a smaller entry, so it is still coalesced with the adjacent jobs
+			AddActiveJob();
+			job->isPacked = FindPacked(path.c_str(), job->packEntry);
+			if (job->isPacked)
+			{
+				if (offset + size > job->packEntry.size)
+				{
+					Logger::Error("Invalid range of %s", path.c_str());
+					RemoveActiveJob();
+					CJING_DELETE(job);
+					return AsyncLoadHandle::INVALID;
+				}
+				job->packEntry.offset += offset;
+				job->packEntry.size = size;
+			}
+			return PushJob(job);
+		}
+
+		void AddActiveJob()
+		{
+			ScopedMutex lock(mutex);
+			activeJobCount++;
+		}
+
+		void RemoveActiveJob()
+		{
+			ScopedMutex lock(mutex);
+			ASSERT(activeJobCount > 0);
+			activeJobCount--;
+		}
+
+		// The job is already counted by AddActiveJob
+		AsyncLoadHandle PushJob(AsyncLoadJob* job)
+		{
 			ScopedMutex lock(mutex);
-			workerCount++;
 			lastJobID++;
+			if (lastJobID == AsyncLoadHandle::INVALID.value)
+				lastJobID = 0;
 
-			AsyncLoadJob job = {};
-			job.jobID = lastJobID;
-			job.path = path.c_str();
-			job.cb = cb;
-			pendingJobs.push(job);
+			job->jobID = lastJobID;
+			pendingJobs[(U32)job->priority].push_back(job);
 			semaphore.Signal();
-			return AsyncLoadHandle(lastJobID);
+			return AsyncLoadHandle(job->jobID);
+		}
+
+		UniquePtr<MappedFile> TakeMappedFile() override
+		{
+			if (callbackJob == nullptr || callbackJob->mappedFile == nullptr)
+				return UniquePtr<MappedFile>();
+
+			MappedFile* file = callbackJob->mappedFile;
+			callbackJob->mappedFile = nullptr;
+			return UniquePtr<MappedFile>(file);
+		}
+
+		void CancelAsync(AsyncLoadHandle handle) override
+		{
+			if (!handle.IsValid())
+				return;
+
+			ScopedMutex lock(mutex);
+
+			// Queued job, drop it directly
+			for (auto& jobs : pendingJobs)
+			{
+				for (auto it = jobs.begin(); it != jobs.end(); ++it)
+				{
+					if ((*it)->jobID == handle.value)
+					{
+						CJING_DELETE(*it);
+						jobs.erase(it);
+						ASSERT(activeJobCount > 0);
+						activeJobCount--;
+						return;
+					}
+				}
+			}
+
+			// Loading or finished job, discard the result
+			for (auto job : loadingJobs)
+			{
+				if (job->jobID == handle.value)
+				{
+					job->state = AsyncLoadJob::State::CANCELED;
+					return;
+				}
+			}
+			for (auto job : finishedJobs)
+			{
+				if (job->jobID == handle.value)
+				{
+					job->state = AsyncLoadJob::State::CANCELED;
+					return;
+				}
+			}
+		}
+
+		// Pop the highest priority job, the semaphore may be signaled for a canceled job
+		AsyncLoadJob* PopPendingJob()
+		{
+			ScopedMutex lock(mutex);
+			for (auto& jobs : pendingJobs)
+			{
+				if (!jobs.empty())
+				{
+					AsyncLoadJob* job = jobs.front();
+					jobs.pop_front();
+					loadingJobs.push_back(job);
+					return job;
+				}
+			}
+			return nullptr;
+		}
+
+		bool MountPack(const char* path, bool writable) override
+		{
+			MaxPathString fullPath(basePath, path);
+			if (!pack.Open(fullPath.c_str(), writable))
+			{
+				Logger::Error("Failed to mount pack %s", path);
+				return false;
+			}
+			return true;
+		}
+
+		bool WriteToPack(const char* path, const void* data, U64 size) override
+		{
+			if (!pack.IsOpen())
+				return false;
+
+			return pack.Append(Path(path).GetHashValue(), data, size);
+		}
+
+		bool FlushPack() override
+		{
+			if (!pack.Flush())
+				return false;
+
+			// Rewriting the pack takes long, it runs on the background lane
+			if (compactHandle || !pack.NeedCompact())
+				return true;
+
+			Jobsystem::Run(this, [](void* data) {
+				static_cast<DefaultFileSystemBackend*>(data)->CompactPack();
+			}, &compactHandle, Jobsystem::ANY_WORKER, Jobsystem::Priority::Background);
+			return true;
+		}
+
+		void CompactPack()
+		{
+			U64 compactedVersion = 0;
+			if (!pack.WriteCompacted(compactedVersion))
+				return;
+
+			// Compacting moves the blobs, so it is swapped in when no load holds a pack entry.
+			// The lookups wait for the swap on the mutex and find the new entries
+			for (U32 i = 0; i < MAX_PACK_SWAP_RETRIES; i++)
+			{
+				{
+					ScopedMutex lock(mutex);
+					if (activeJobCount == 0)
+					{
+						pack.SwapCompacted(compactedVersion);
+						return;
+					}
+				}
+				Platform::Sleep(PACK_SWAP_RETRY_INTERVAL);
+			}
+			pack.DiscardCompacted();
+		}
+
+		// The loose file modified after packing replaces the packed one
+		bool FindPacked(const char* path, PackEntry& entry)const
+		{
+			if (!pack.IsOpen() || !pack.Find(Path(path).GetHashValue(), entry))
+				return false;
+
+			MaxPathString fullPath(basePath, path);
+			return Platform::GetLastModTime(fullPath.c_str()) <= entry.modifiedTime;
+		}
+
+		// Pop the pending packed jobs which follow the job in the pack, so they can be read together
+		void PopAdjacentPackedJobs(std::vector<AsyncLoadJob*>& jobs)
+		{
+			ScopedMutex lock(mutex);
+			const U64 rangeBegin = jobs[0]->packEntry.offset;
+			while (jobs.size() < MAX_COALESCED_JOB_COUNT)
+			{
+				const PackEntry& last = jobs.back()->packEntry;
+				const U64 nextOffset = AlignTo(last.offset + last.size, PackFile::ALIGNMENT);
+				AsyncLoadJob* next = nullptr;
+				for (auto& queue : pendingJobs)
+				{
+					for (auto it = queue.begin(); it != queue.end(); ++it)
+					{
+						AsyncLoadJob* job = *it;
+						if (job->isPacked &&
+							job->packEntry.offset == nextOffset &&
+							nextOffset + job->packEntry.size - rangeBegin <= MAX_COALESCED_READ_SIZE)
+						{
+							next = job;
+							queue.erase(it);
+							break;
+						}
+					}
+					if (next != nullptr)
+						break;
+				}
+
+				if (next == nullptr)
+					break;
+
+				loadingJobs.push_back(next);
+				jobs.push_back(next);
+			}
+		}
+
+		void LoadPackedJobs(AsyncLoadJob* job)
+		{
+			std::vector<AsyncLoadJob*> jobs;
+			jobs.push_back(job);
+			PopAdjacentPackedJobs(jobs);
+
+			if (jobs.size() == 1)
+			{
+				OutputMemoryStream mem = AcquireBuffer();
+				mem.Resize(job->packEntry.size);
+				bool success = pack.Read(job->packEntry, mem.Data());
+				CompleteJob(job, nullptr, std::move(mem), success);
+				return;
+			}
+
+			// Read the whole range once, then split it into the jobs
+			const U64 rangeBegin = jobs[0]->packEntry.offset;
+			const U64 rangeEnd = jobs.back()->packEntry.offset + jobs.back()->packEntry.size;
+			OutputMemoryStream range = AcquireBuffer();
+			range.Resize(rangeEnd - rangeBegin);
+			bool success = pack.ReadRange(rangeBegin, range.Data(), rangeEnd - rangeBegin);
+			for (AsyncLoadJob* packedJob : jobs)
+			{
+				OutputMemoryStream mem = AcquireBuffer();
+				if (success)
+				{
+					mem.Resize(packedJob->packEntry.size);
+					memcpy(mem.Data(), range.Data() + packedJob->packEntry.offset - rangeBegin, packedJob->packEntry.size);
+				}
+				CompleteJob(packedJob, nullptr, std::move(mem), success);
+			}
+			ReleaseBuffer(std::move(range));
+		}
+
+		// Process the loaded file, the processed data replaces the file
+		void CompleteJob(AsyncLoadJob* job, MappedFile* mappedFile, OutputMemoryStream&& mem, bool success)
+		{
+			if (success && job->processor.IsValid())
+			{
+				OutputMemoryStream processed = AcquireBuffer();
+				if (mappedFile != nullptr)
+					success = job->processor.Invoke(mappedFile->Size(), mappedFile->GetMappedData(), processed);
+				else
+					success = job->processor.Invoke(mem.Size(), mem.Data(), processed);
+
+				if (success && !processed.Empty())
+				{
+					if (mappedFile != nullptr)
+					{
+						mappedFile->Close();
+						CJING_DELETE(mappedFile);
+						mappedFile = nullptr;
+					}
+					ReleaseBuffer(std::move(mem));
+					mem = std::move(processed);
+				}
+				else
+				{
+					ReleaseBuffer(std::move(processed));
+				}
+			}
+
+			// Push the current job into the finished queue
+			FinishJob(job, mappedFile, std::move(mem), success);
+		}
+
+		OutputMemoryStream AcquireBuffer()
+		{
+			ScopedMutex lock(bufferMutex);
+			if (bufferPool.empty())
+				return OutputMemoryStream();
+
+			OutputMemoryStream ret(std::move(bufferPool.back()));
+			bufferPool.pop_back();
+			return ret;
+		}
+
+		void ReleaseBuffer(OutputMemoryStream&& buffer)
+		{
+			if (buffer.Capacity() == 0 || buffer.Capacity() > MAX_POOLED_BUFFER_SIZE)
+				return;
+
+			ScopedMutex lock(bufferMutex);
+			if (bufferPool.size() < MAX_POOLED_BUFFER_COUNT)
+			{
+				buffer.Clear();
+				bufferPool.push_back(std::move(buffer));
+			}
+		}
+
+		// Map the file if it is large enough, otherwise return nullptr and the file is read as usual
+		MappedFile* MapFile(const char* path)
+		{
+			MaxPathString fullPath(basePath, path);
+			MappedFile* file = CJING_NEW(MappedFile)(fullPath.c_str(), FileFlags::DEFAULT_READ);
+			if (file->IsValid() && file->Size() >= MIN_MEMORY_MAPPED_SIZE && file->Map() != nullptr)
+				return file;
+
+			file->Close();
+			CJING_DELETE(file);
+			return nullptr;
+		}
+
+		bool LoadRange(const char* path, U64 offset, U64 size, OutputMemoryStream& mem)
+		{
+			MaxPathString fullPath(basePath, path);
+			MappedFile file(fullPath.c_str(), FileFlags::DEFAULT_READ);
+			bool ret = file.IsValid() && offset + size <= file.Size();
+			if (ret)
+			{
+				mem.Resize(size);
+				ret = file.ReadAt(offset, mem.Data(), size);
+			}
+			file.Close();
+
+			if (!ret)
+				Logger::Error("Failed to read the range of %s", path);
+			return ret;
+		}
+
+		void FinishJob(AsyncLoadJob* job, MappedFile* mappedFile, OutputMemoryStream&& data, bool success)
+		{
+			ScopedMutex lock(mutex);
+			for (size_t i = 0; i < loadingJobs.size(); i++)
+			{
+				if (loadingJobs[i] == job)
+				{
+					loadingJobs[i] = loadingJobs.back();
+					loadingJobs.pop_back();
+					break;
+				}
+			}
+
+			// Discard the result of the canceled job, it is only released in ProcessAsync
+			if (job->state != AsyncLoadJob::State::CANCELED)
+			{
+				job->mappedFile = mappedFile;
+				mappedFile = nullptr;
+				job->data = std::move(data);
+				if (success == false)
+					job->state = AsyncLoadJob::State::FAILED;
+			}
+			else
+			{
+				ReleaseBuffer(std::move(data));
+			}
+
+			finishedJobs.push_back(job);
+
+			if (mappedFile != nullptr)
+			{
+				mappedFile->Close();
+				CJING_DELETE(mappedFile);
+			}
 		}
 	};
 
@@ -236,29 +731,38 @@ namespace VulkanTest
 				break;
 
 			// Get async loading job
-			MaxPathString filePath;
+			AsyncLoadJob* job = fs.PopPendingJob();
+			if (job == nullptr)
+				continue;
+
+			// Packed files are read from the pack with the adjacent ones
+			if (job->isPacked)
 			{
-				ScopedMutex lock(fs.mutex);
-				ASSERT(!fs.pendingJobs.empty());
-				filePath = fs.pendingJobs.front().path;
+				fs.LoadPackedJobs(job);
+				continue;
 			}
 
-			// Do the job sync
-			OutputMemoryStream mem;
-			bool success = fs.LoadContext(filePath.c_str(), mem);
+			// Only the part of the loose file is read
+			if (job->rangeSize > 0)
+			{
+				OutputMemoryStream mem = fs.AcquireBuffer();
+				bool success = fs.LoadRange(job->path.c_str(), job->rangeOffset, job->rangeSize, mem);
+				fs.CompleteJob(job, nullptr, std::move(mem), success);
+				continue;
+			}
 
-			// Push the current job into the finished queue
+			// Do the job sync, a prefetched mapping is paged in here instead of faulting in the callback on the main thread
+			MappedFile* mappedFile = nullptr;
+			if (FLAG_ANY(job->flags, AsyncLoadFlags::MEMORY_MAPPED))
 			{
-				ScopedMutex lock(fs.mutex);
-				ASSERT(!fs.pendingJobs.empty());
-				AsyncLoadJob finishedJob = std::move(fs.pendingJobs.front());
-				finishedJob.data = std::move(mem);
-				if (success == false)
-					finishedJob.state = AsyncLoadJob::State::FAILED;
-			
-				fs.finishedJobs.push(std::move(finishedJob));
-				fs.pendingJobs.pop();
+				mappedFile = fs.MapFile(job->path.c_str());
+				if (mappedFile != nullptr && FLAG_ANY(job->flags, AsyncLoadFlags::PREFETCH))
+					mappedFile->Prefetch();
 			}
+
+			OutputMemoryStream mem = fs.AcquireBuffer();
+			bool success = mappedFile != nullptr || fs.LoadContext(job->path.c_str(), mem);
+			fs.CompleteJob(job, mappedFile, std::move(mem), success);
 		}
 
 		return 0;
@@ -267,7 +771,6 @@ namespace VulkanTest
 	void AsyncLoadTask::Stop()
 	{
 		isFinished = true;
-		fs.semaphore.Signal();
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -279,9 +782,9 @@ namespace VulkanTest
 		backend.Reset();
 	}
 
-	UniquePtr<FileSystem> FileSystem::Create(const char* basePath)
+	UniquePtr<FileSystem> FileSystem::Create(const char* basePath, U32 ioWorkerCount)
 	{
-		UniquePtr<DefaultFileSystemBackend> backend = CJING_MAKE_UNIQUE<DefaultFileSystemBackend>(basePath);
+		UniquePtr<DefaultFileSystemBackend> backend = CJING_MAKE_UNIQUE<DefaultFileSystemBackend>(basePath, ioWorkerCount);
 		return UniquePtr<FileSystem>(CJING_NEW(FileSystem)(backend.Move()));
 	}
 
@@ -345,14 +848,44 @@ namespace VulkanTest
 		return backend->HasWork();
 	}
 
-	void FileSystem::ProcessAsync()
+	void FileSystem::ProcessAsync(F32 timeBudget)
+	{
+		backend->ProcessAsync(timeBudget);
+	}
+
+	AsyncLoadHandle FileSystem::LoadFileAsync(const Path& path, const AsyncLoadCallback& cb, AsyncLoadPriority priority, AsyncLoadFlags flags, const AsyncLoadProcessor& processor)
+	{
+		return backend->LoadFileAsync(path, cb, priority, flags, processor);
+	}
+
+	AsyncLoadHandle FileSystem::LoadFileRangeAsync(const Path& path, U64 offset, U64 size, const AsyncLoadCallback& cb, AsyncLoadPriority priority)
+	{
+		return backend->LoadFileRangeAsync(path, offset, size, cb, priority);
+	}
+
+	UniquePtr<MappedFile> FileSystem::TakeMappedFile()
+	{
+		return backend->TakeMappedFile();
+	}
+
+	void FileSystem::Cancel(AsyncLoadHandle handle)
+	{
+		backend->CancelAsync(handle);
+	}
+
+	bool FileSystem::MountPack(const char* path, bool writable)
+	{
+		return backend->MountPack(path, writable);
+	}
+
+	bool FileSystem::WriteToPack(const char* path, const void* data, U64 size)
 	{
-		backend->ProcessAsync();
+		return backend->WriteToPack(path, data, size);
 	}
 
-	AsyncLoadHandle FileSystem::LoadFileAsync(const Path& path, const AsyncLoadCallback& cb)
+	bool FileSystem::FlushPack()
 	{
-		return backend->LoadFileAsync(path, cb);
+		return backend->FlushPack();
 	}
 
 	FileSystem::FileSystem(UniquePtr<FileSystemBackend>&& backend_) :
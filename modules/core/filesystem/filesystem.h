@@ -8,6 +8,7 @@
 #include "core\utils\path.h"
 #include "core\utils\delegate.h"
 #include "core\utils\stream.h"
+#include "core\filesystem\pack.h"
 
 namespace VulkanTest
 {
@@ -22,6 +23,37 @@ namespace VulkanTest
 		}
 	};
 	using AsyncLoadCallback = Delegate<void(U64, const U8*, bool)>;
+	// Transform the loaded file on the io thread, e.g. decompression. Write nothing into the output
+	// to keep the file as it is, return false if the file is invalid
+	using AsyncLoadProcessor = Delegate<bool(U64, const U8*, OutputMemoryStream&)>;
+
+	enum class AsyncLoadPriority : U8
+	{
+		High,
+		Normal,
+		Low,
+		Count
+	};
+
+	enum class AsyncLoadFlags : U8
+	{
+		NONE = 0,
+		// Pass a read-only mapping of the file to the callback instead of a copy, the pages are read when touched.
+		// The memory is only valid during the callback unless the callback takes it by FileSystem::TakeMappedFile
+		MEMORY_MAPPED = 1 << 0,
+		// Read all pages of the mapping on the io thread, so the callback doesn't fault them in
+		PREFETCH = 1 << 1,
+
+		MEMORY_MAPPED_PREFETCH = MEMORY_MAPPED | PREFETCH,
+	};
+
+	static constexpr U32 DEFAULT_IO_WORKER_COUNT = 2;
+	static constexpr F32 DEFAULT_ASYNC_TIME_BUDGET = 0.2f;
+	// Small files are still read into memory, mapping them costs more than copying
+	static constexpr U64 MIN_MEMORY_MAPPED_SIZE = 64 * 1024;
+	// Loading buffers are reused by the following async jobs, larger buffers are released directly
+	static constexpr U32 MAX_POOLED_BUFFER_COUNT = 8;
+	static constexpr U64 MAX_POOLED_BUFFER_SIZE = 64 * 1024 * 1024;
 
 	enum class EnumrateMode
 	{
@@ -49,8 +81,15 @@ namespace VulkanTest
 		virtual std::vector<ListEntry> Enumerate(const char* path, int mask = (int)EnumrateMode::All) = 0;
 		virtual bool LoadContext(const char* path, OutputMemoryStream& mem) = 0;
 
-		virtual void ProcessAsync() = 0;
-		virtual AsyncLoadHandle LoadFileAsync(const Path& path, const AsyncLoadCallback& cb) = 0;
+		virtual void ProcessAsync(F32 timeBudget) = 0;
+		virtual AsyncLoadHandle LoadFileAsync(const Path& path, const AsyncLoadCallback& cb, AsyncLoadPriority priority, AsyncLoadFlags flags, const AsyncLoadProcessor& processor) = 0;
+		virtual AsyncLoadHandle LoadFileRangeAsync(const Path& path, U64 offset, U64 size, const AsyncLoadCallback& cb, AsyncLoadPriority priority) = 0;
+		virtual void CancelAsync(AsyncLoadHandle handle) = 0;
+		virtual UniquePtr<MappedFile> TakeMappedFile() = 0;
+
+		virtual bool MountPack(const char* path, bool writable) = 0;
+		virtual bool WriteToPack(const char* path, const void* data, U64 size) = 0;
+		virtual bool FlushPack() = 0;
 	};
 
 	class VULKAN_TEST_API FileSystem
@@ -58,7 +97,7 @@ namespace VulkanTest
 	public:
 		virtual ~FileSystem();
 
-		static UniquePtr<FileSystem> Create(const char* basePath);
+		static UniquePtr<FileSystem> Create(const char* basePath, U32 ioWorkerCount = DEFAULT_IO_WORKER_COUNT);
 
 		bool MoveFile(const char* from, const char* to);
 		bool CopyFile(const char* from, const char* to);
@@ -74,10 +113,44 @@ namespace VulkanTest
 
 		bool LoadContext(const char* path, OutputMemoryStream& mem);
 		bool HasWork()const;
-		void ProcessAsync();
 
-		// Load file asynchronously
-		AsyncLoadHandle LoadFileAsync(const Path& path, const AsyncLoadCallback& cb);
+		// Invoke the callbacks of finished async jobs, stop when the time budget (seconds) is used up
+		void ProcessAsync(F32 timeBudget = DEFAULT_ASYNC_TIME_BUDGET);
+
+		// Load file asynchronously, higher priority jobs are served first.
+		// The optional processor runs on the io thread before the callback
+		AsyncLoadHandle LoadFileAsync(
+			const Path& path, 
+			const AsyncLoadCallback& cb, 
+			AsyncLoadPriority priority = AsyncLoadPriority::Normal, 
+			AsyncLoadFlags flags = AsyncLoadFlags::NONE,
+			const AsyncLoadProcessor& processor = AsyncLoadProcessor());
+
+		// Load the bytes [offset, offset + size) of the file asynchronously, e.g. a part of a streamed resource.
+		// The callback fails if the range is out of the file
+		AsyncLoadHandle LoadFileRangeAsync(
+			const Path& path,
+			U64 offset,
+			U64 size,
+			const AsyncLoadCallback& cb,
+			AsyncLoadPriority priority = AsyncLoadPriority::Normal);
+
+		// Drop the queued job, or discard the result if it is already being loaded.
+		// The callback is never invoked after canceling
+		void Cancel(AsyncLoadHandle handle);
+
+		// Take the mapping passed to the current MEMORY_MAPPED callback, only valid inside the callback.
+		// The view stays valid until the caller closes the file, nullptr if the file is not mapped
+		UniquePtr<MappedFile> TakeMappedFile();
+
+		// Files in the mounted pack are loaded from it, other files and the loose files modified after packing
+		// are loaded from the disk as usual. Only the writable pack accepts WriteToPack, the runtime mounts it read-only
+		bool MountPack(const char* path, bool writable = false);
+		// Add or replace the file in the mounted pack, it is visible after reopening once flushed
+		bool WriteToPack(const char* path, const void* data, U64 size);
+		// Write the pack index, the pack is compacted on a background job when the replaced files take more space
+		// than the live ones. The compacted pack is swapped in once no load is active
+		bool FlushPack();
 
 	private:
 		FileSystem(UniquePtr<FileSystemBackend>&& backend_);
@@ -0,0 +1,321 @@
+#include "pack.h"
+#include "core\platform\platform.h"
+
+#include <ctime>
+#include <algorithm>
+
+namespace VulkanTest
+{
+	static bool CompareEntryHash(const PackEntry& entry, U64 hash)
+	{
+		return entry.hash < hash;
+	}
+
+	PackFile::~PackFile()
+	{
+		Close();
+	}
+
+	bool PackFile::Open(const char* path_, bool writable)
+	{
+		{
+			ScopedMutex lock(mutex);
+			if (file != nullptr && path == path_ && (isWritable || !writable))
+				return true;
+		}
+		Flush();
+
+		ScopedWriteLock fileWriteLock(fileLock);
+		ScopedMutex lock(mutex);
+		CloseFile();
+		path = MaxPathString(path_);
+		return OpenFile(writable);
+	}
+
+	void PackFile::Close()
+	{
+		Flush();
+
+		ScopedWriteLock fileWriteLock(fileLock);
+		ScopedMutex lock(mutex);
+		CloseFile();
+	}
+
+	bool PackFile::IsOpen() const
+	{
+		ScopedMutex lock(mutex);
+		return file != nullptr;
+	}
+
+	bool PackFile::IsWritable() const
+	{
+		ScopedMutex lock(mutex);
+		return file != nullptr && isWritable;
+	}
+
+	bool PackFile::OpenFile(bool writable)
+	{
+		const bool exists = Platform::FileExists(path.c_str());
+		if (!exists && !writable)
+			return false;
+
+		FileFlags flags = FileFlags::READ;
+		if (writable)
+			flags = exists ? FileFlags::READ_WRITE : (FileFlags)((int)FileFlags::READ_WRITE | (int)FileFlags::CREATE);
+
+		file = CJING_NEW(MappedFile)(path.c_str(), flags);
+		if (!file->IsValid())
+		{
+			CJING_DELETE(file);
+			file = nullptr;
+			return false;
+		}
+		isWritable = writable;
+		isDirty = false;
+		version++;
+
+		// Create an empty pack
+		if (!exists || file->Size() == 0)
+		{
+			header = PackHeader();
+			header.indexOffset = ALIGNMENT;
+			entries.clear();
+			writeOffset = ALIGNMENT;
+			return !writable || file->WriteAt(0, &header, sizeof(header));
+		}
+
+		bool ret = file->ReadAt(0, &header, sizeof(header)) &&
+			header.magic == PackHeader::MAGIC &&
+			header.version == PackHeader::VERSION &&
+			header.indexOffset + (U64)header.entryCount * sizeof(PackEntry) <= file->Size();
+		if (ret)
+		{
+			entries.resize(header.entryCount);
+			if (header.entryCount > 0)
+				ret = file->ReadAt(header.indexOffset, entries.data(), entries.size() * sizeof(PackEntry));
+		}
+
+		if (!ret)
+		{
+			Logger::Error("Invalid pack file %s", path.c_str());
+			CloseFile();
+			return false;
+		}
+
+		writeOffset = AlignTo(header.indexOffset + entries.size() * sizeof(PackEntry), ALIGNMENT);
+		return true;
+	}
+
+	void PackFile::CloseFile()
+	{
+		if (file != nullptr)
+		{
+			file->Close();
+			CJING_DELETE(file);
+			file = nullptr;
+		}
+		entries.clear();
+		isWritable = false;
+		isDirty = false;
+	}
+
+	bool PackFile::Find(U64 hash, PackEntry& entry) const
+	{
+		ScopedMutex lock(mutex);
+		auto it = std::lower_bound(entries.begin(), entries.end(), hash, CompareEntryHash);
+		if (it == entries.end() || it->hash != hash)
+			return false;
+
+		entry = *it;
+		return true;
+	}
+
+	bool PackFile::Read(const PackEntry& entry, void* buffer)
+	{
+		return ReadRange(entry.offset, buffer, entry.size);
+	}
+
+	bool PackFile::ReadRange(U64 offset, void* buffer, U64 size)
+	{
+		ScopedReadLock fileReadLock(fileLock);
+		return file != nullptr && file->ReadAt(offset, buffer, size);
+	}
+
+	bool PackFile::Append(U64 hash, const void* data, U64 size)
+	{
+		ScopedMutex lock(mutex);
+		if (file == nullptr || !isWritable)
+			return false;
+
+		PackEntry entry;
+		entry.hash = hash;
+		entry.offset = writeOffset;
+		entry.size = size;
+		entry.modifiedTime = (U64)std::time(nullptr);
+		if (!file->WriteAt(entry.offset, data, size))
+			return false;
+
+		writeOffset = AlignTo(entry.offset + size, ALIGNMENT);
+
+		auto it = std::lower_bound(entries.begin(), entries.end(), hash, CompareEntryHash);
+		if (it != entries.end() && it->hash == hash)
+			*it = entry;
+		else
+			entries.insert(it, entry);
+
+		isDirty = true;
+		version++;
+		return true;
+	}
+
+	bool PackFile::Flush()
+	{
+		ScopedMutex lock(mutex);
+		if (file == nullptr || !isDirty)
+			return true;
+
+		// Write the new index first, the header still points to the old one until it is written
+		const U64 indexOffset = writeOffset;
+		const U64 indexSize = entries.size() * sizeof(PackEntry);
+		if (indexSize > 0 && !file->WriteAt(indexOffset, entries.data(), indexSize))
+			return false;
+
+		header.entryCount = (U32)entries.size();
+		header.indexOffset = indexOffset;
+		if (!file->WriteAt(0, &header, sizeof(header)))
+			return false;
+
+		writeOffset = AlignTo(indexOffset + indexSize, ALIGNMENT);
+		isDirty = false;
+		return true;
+	}
+
+	bool PackFile::Compact()
+	{
+		if (!Flush())
+			return false;
+
+		U64 compactedVersion = 0;
+		return WriteCompacted(compactedVersion) && SwapCompacted(compactedVersion);
+	}
+
+	bool PackFile::WriteCompacted(U64& compactedVersion)
+	{
+		// Copy the live blobs of a snapshot of the index, the blobs are never modified once appended
+		std::vector<PackEntry> compacted;
+		PackHeader compactedHeader;
+		MaxPathString tempPath;
+		{
+			ScopedMutex lock(mutex);
+			if (file == nullptr || !isWritable)
+				return false;
+
+			compacted = entries;
+			compactedHeader = header;
+			compactedVersion = version;
+			tempPath = MaxPathString(path, ".tmp");
+		}
+
+		MappedFile temp(tempPath.c_str(), (FileFlags)((int)FileFlags::READ_WRITE | (int)FileFlags::CREATE));
+		bool ret = temp.IsValid();
+
+		std::vector<U8> buffer;
+		U64 offset = ALIGNMENT;
+		for (PackEntry& entry : compacted)
+		{
+			if (!ret)
+				break;
+
+			if (entry.size > 0)
+			{
+				buffer.resize(entry.size);
+				ret = ReadRange(entry.offset, buffer.data(), entry.size) &&
+					temp.WriteAt(offset, buffer.data(), entry.size);
+			}
+			entry.offset = offset;
+			offset = AlignTo(offset + entry.size, ALIGNMENT);
+		}
+
+		compactedHeader.entryCount = (U32)compacted.size();
+		compactedHeader.indexOffset = offset;
+		if (ret && !compacted.empty())
+			ret = temp.WriteAt(offset, compacted.data(), compacted.size() * sizeof(PackEntry));
+		if (ret)
+			ret = temp.WriteAt(0, &compactedHeader, sizeof(compactedHeader));
+		temp.Close();
+
+		if (!ret)
+		{
+			Logger::Error("Failed to compact pack file %s", path.c_str());
+			Platform::DeleteFile(tempPath.c_str());
+		}
+		return ret;
+	}
+
+	bool PackFile::SwapCompacted(U64 compactedVersion)
+	{
+		ScopedWriteLock fileWriteLock(fileLock);
+		ScopedMutex lock(mutex);
+		const MaxPathString tempPath(path, ".tmp");
+		if (file == nullptr || !isWritable || version != compactedVersion)
+		{
+			Platform::DeleteFile(tempPath.c_str());
+			return false;
+		}
+
+		const U64 oldSize = writeOffset;
+		CloseFile();
+		bool ret = Platform::MoveFile(tempPath.c_str(), path.c_str());
+		if (!ret)
+		{
+			Logger::Error("Failed to compact pack file %s", path.c_str());
+			Platform::DeleteFile(tempPath.c_str());
+		}
+
+		// Reopen the compacted pack, or the old one if it failed
+		if (!OpenFile(true))
+			return false;
+
+		if (ret)
+			Logger::Info("Compact pack file %s, %d KB -> %d KB", path.c_str(), (U32)(oldSize / 1024), (U32)(writeOffset / 1024));
+		return ret;
+	}
+
+	void PackFile::DiscardCompacted()
+	{
+		ScopedMutex lock(mutex);
+		Platform::DeleteFile(MaxPathString(path, ".tmp").c_str());
+	}
+
+	bool PackFile::NeedCompact() const
+	{
+		const U64 deadBytes = GetDeadBytes();
+		ScopedMutex lock(mutex);
+		return isWritable && deadBytes > std::max(GetLiveBytes(), MIN_COMPACT_SIZE);
+	}
+
+	U64 PackFile::GetLiveBytes() const
+	{
+		U64 ret = AlignTo(entries.size() * sizeof(PackEntry), ALIGNMENT);
+		for (const PackEntry& entry : entries)
+			ret += AlignTo(entry.size, ALIGNMENT);
+		return ret;
+	}
+
+	U64 PackFile::GetDeadBytes() const
+	{
+		ScopedMutex lock(mutex);
+		if (file == nullptr)
+			return 0;
+
+		const U64 usedBytes = writeOffset - ALIGNMENT;
+		const U64 liveBytes = GetLiveBytes();
+		return usedBytes > liveBytes ? usedBytes - liveBytes : 0;
+	}
+
+	U32 PackFile::GetEntryCount() const
+	{
+		ScopedMutex lock(mutex);
+		return (U32)entries.size();
+	}
+}
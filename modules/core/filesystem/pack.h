@@ -0,0 +1,104 @@
+#pragma once
+
+#include "core\common.h"
+#include "core\platform\file.h"
+#include "core\platform\sync.h"
+#include "core\utils\path.h"
+
+namespace VulkanTest
+{
+	// Pack file:
+	// ---------------------------
+	// |  PackHeader (4KB)       |
+	// ---------------------------
+	// |  Blobs (4KB aligned)    |
+	// ---------------------------
+	// |  PackEntry[] (by hash)  |
+	// ---------------------------
+	// Appended blobs are written after the current index, and the new index is written
+	// after them on Flush, so the pack stays valid until the header is updated.
+	// Replaced blobs and old indices are dead space, Compact rewrites the pack without them.
+
+	struct PackHeader
+	{
+		static constexpr U32 MAGIC = 'PACK';
+		static constexpr U32 VERSION = 0x01;
+
+		U32 magic = MAGIC;
+		U32 version = VERSION;
+		U32 entryCount = 0;
+		U32 padding = 0;
+		U64 indexOffset = 0;
+	};
+
+	struct PackEntry
+	{
+		U64 hash = 0;
+		U64 offset = 0;
+		U64 size = 0;
+		U64 modifiedTime = 0;
+	};
+
+	class VULKAN_TEST_API PackFile
+	{
+	public:
+		static constexpr U64 ALIGNMENT = 4096;
+		// The pack is compacted once the dead space exceeds both the live data and this size
+		static constexpr U64 MIN_COMPACT_SIZE = 64 * 1024 * 1024;
+
+		PackFile() = default;
+		~PackFile();
+
+		PackFile(const PackFile& rhs) = delete;
+		void operator=(const PackFile& rhs) = delete;
+
+		// Open the pack file, a writable pack is created if it does not exist.
+		// Reopening the opened pack is skipped unless it becomes writable, the reads wait for the reopening
+		bool Open(const char* path, bool writable);
+		void Close();
+		bool IsOpen()const;
+		bool IsWritable()const;
+
+		bool Find(U64 hash, PackEntry& entry)const;
+		bool Read(const PackEntry& entry, void* buffer);
+		bool ReadRange(U64 offset, void* buffer, U64 size);
+
+		// Add or replace a blob, the replaced blob is left unused in the pack
+		bool Append(U64 hash, const void* data, U64 size);
+		// Write the index and the header, appended blobs are not visible after reopening until flushed
+		bool Flush();
+
+		// Rewrite the pack without the dead space. The offsets of the entries are changed,
+		// the entries found before must not be read after compacting
+		bool Compact();
+		bool NeedCompact()const;
+
+		// Compact in two steps, so the pack is only blocked by the swap:
+		// WriteCompacted copies the live blobs into a temporary pack while the pack is still read and appended,
+		// SwapCompacted replaces the pack with it, it is discarded if the pack is appended in the meantime
+		bool WriteCompacted(U64& compactedVersion);
+		bool SwapCompacted(U64 compactedVersion);
+		void DiscardCompacted();
+
+		U32 GetEntryCount()const;
+		U64 GetDeadBytes()const;
+
+	private:
+		bool OpenFile(bool writable);
+		void CloseFile();
+		U64 GetLiveBytes()const;
+
+		MaxPathString path;
+		MappedFile* file = nullptr;
+		// Guard the file against reopening while the io threads read it
+		mutable RWLock fileLock;
+		mutable Mutex mutex;
+		PackHeader header;
+		std::vector<PackEntry> entries;
+		U64 writeOffset = 0;
+		// Changed by every append, the compacted pack is only valid for the version it is written from
+		U64 version = 0;
+		bool isDirty = false;
+		bool isWritable = false;
+	};
+}
@@ -3,7 +3,9 @@
 #include "core\platform\fiber.h"
 #include "core\platform\platform.h"
 #include "core\platform\sync.h"
-#include "core\platform\atomic.h"
+#include "core\utils\profiler.h"
+
+#include <atomic>
 
 #pragma warning( push )
 #pragma warning (disable : 6385)
@@ -19,6 +21,13 @@ namespace Jobsystem
     const U32 HANDLE_ID_MASK = 0x0000ffff;
     const U32 HANDLE_GENERATION_MASK = 0xffff0000;
 
+    // Pooled jobs, more jobs in flight will fallback to heap allocation
+    const U32 MAX_JOB_COUNT = 16384;
+    // Capacity of the per worker work-stealing deque and pinned job queue
+    const U32 WORKER_QUEUE_SIZE = 4096;
+    // Spin count before a worker goes to sleep
+    const U32 WORKER_SPIN_COUNT = 64;
+
 #ifdef _WIN32
     static void __stdcall FiberFunc(void* data);
 #else
@@ -27,47 +36,235 @@ namespace Jobsystem
 
     struct ManagerImpl;
     struct WorkerThread;
+    struct WorkerFiber;
+
+    static WorkerFiber* PopFreeFiber();
 
     struct JobImpl
     {
         JobFunc task = nullptr;
+        JobFuncPtr rawTask = nullptr;
         void* data = nullptr;
-        JobHandle* onFinishedHandle;
-        U8 workerIndex;
+        JobHandle* onFinishedHandle = nullptr;
+        U8 workerIndex = ANY_WORKER;
+        Priority priority = Priority::Normal;
+        bool isPooled = false;
     };
 
     struct WorkerFiber
     {
         U32 index = 0;
         Fiber::Handle handle = Fiber::INVALID_HANDLE;
-        JobImpl currentJob;
+        JobImpl* currentJob = nullptr;
+        // Set after the waiting fiber has really switched out, 
+        // a resumed fiber can't be switched to before that
+        std::atomic<bool> isParked = false;
     };
 
     struct JobWaitor
     {
         JobWaitor* next;
         WorkerFiber* fiber;
+        U32 generation;
     };
 
-    struct JobCounter
+    // Bounded MPMC queue (Dmitry Vyukov)
+    // Used for the global job queue, the pinned job queues and the ready fiber queues
+    // NOTE: Push may fail while a concurrent Pop is in progress on the same cell,
+    // so queues of pooled items use twice the size of the pool
+    template<typename T, U32 N>
+    struct ConcurrentQueue
     {
-        volatile I32 value = 0;
-        JobWaitor* waitor = nullptr;
-        U32 generation = 0;	// use for check
+        static_assert((N & (N - 1)) == 0, "ConcurrentQueue size must be power of 2");
+
+        struct Cell
+        {
+            std::atomic<U32> sequence;
+            T data;
+        };
+
+        alignas(64) std::atomic<U32> enqueuePos;
+        alignas(64) std::atomic<U32> dequeuePos;
+        alignas(64) Cell cells[N];
+
+        ConcurrentQueue()
+        {
+            for (U32 i = 0; i < N; i++)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            enqueuePos.store(0, std::memory_order_relaxed);
+            dequeuePos.store(0, std::memory_order_relaxed);
+        }
+
+        bool Push(const T& value)
+        {
+            U32 pos = enqueuePos.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell& cell = cells[pos & (N - 1)];
+                U32 seq = cell.sequence.load(std::memory_order_acquire);
+                I32 diff = (I32)seq - (I32)pos;
+                if (diff == 0)
+                {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        cell.data = value;
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // Full
+                    return false;
+                }
+                else
+                {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool Pop(T& value)
+        {
+            U32 pos = dequeuePos.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell& cell = cells[pos & (N - 1)];
+                U32 seq = cell.sequence.load(std::memory_order_acquire);
+                I32 diff = (I32)seq - (I32)(pos + 1);
+                if (diff == 0)
+                {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        value = cell.data;
+                        cell.sequence.store(pos + N, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // Empty
+                    return false;
+                }
+                else
+                {
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool Empty()const
+        {
+            return dequeuePos.load(std::memory_order_acquire) == enqueuePos.load(std::memory_order_acquire);
+        }
+
+        U32 Size()const
+        {
+            I32 size = (I32)(enqueuePos.load(std::memory_order_relaxed) - dequeuePos.load(std::memory_order_relaxed));
+            return size > 0 ? (U32)size : 0;
+        }
     };
 
-    static volatile I32 gGeneration = 0;
+    // Chase-Lev work-stealing deque
+    // Only the owner worker can push and pop (LIFO) at the bottom, other workers steal (FIFO) at the top
+    template<typename T, U32 N>
+    struct WorkStealingQueue
+    {
+        static_assert((N & (N - 1)) == 0, "WorkStealingQueue size must be power of 2");
+
+        alignas(64) std::atomic<I64> top = 0;
+        alignas(64) std::atomic<I64> bottom = 0;
+        alignas(64) std::atomic<T> items[N];
+
+        bool Push(T item)
+        {
+            I64 b = bottom.load(std::memory_order_relaxed);
+            I64 t = top.load(std::memory_order_acquire);
+            if (b - t >= (I64)N)
+                return false;
+
+            items[b & (N - 1)].store(item, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool Pop(T& item)
+        {
+            I64 b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            I64 t = top.load(std::memory_order_relaxed);
+            if (t > b)
+            {
+                // Empty
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            item = items[b & (N - 1)].load(std::memory_order_relaxed);
+            if (t == b)
+            {
+                // Last item, race against thieves
+                bool success = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return success;
+            }
+            return true;
+        }
+
+        bool Steal(T& item)
+        {
+            while (true)
+            {
+                I64 t = top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                I64 b = bottom.load(std::memory_order_acquire);
+                if (t >= b)
+                    return false;
+
+                item = items[t & (N - 1)].load(std::memory_order_relaxed);
+                if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    return true;
+            }
+        }
+
+        bool Empty()const
+        {
+            I64 b = bottom.load(std::memory_order_acquire);
+            I64 t = top.load(std::memory_order_acquire);
+            return t >= b;
+        }
+
+        U32 Size()const
+        {
+            I64 b = bottom.load(std::memory_order_relaxed);
+            I64 t = top.load(std::memory_order_relaxed);
+            return b > t ? (U32)(b - t) : 0;
+        }
+    };
 
     struct ManagerImpl
     {
-        Mutex sync;
-        Mutex jobQueueLock;
-
-        std::vector<WorkerFiber*> readyFibers;
-        std::vector<WorkerFiber*> freeFibers;
+        ConcurrentQueue<WorkerFiber*, MAX_FIBER_COUNT * 2> freeFibers;
         WorkerFiber fiberPool[MAX_FIBER_COUNT];
         std::vector<WorkerThread*> workers;
-        std::vector<JobImpl> jobQueue;
+        std::vector<WorkerThread*> backgroundWorkers;
+        WorkerThread* workersByIndex[64] = {};
+
+        // Jobs from non-worker threads or overflowed from worker deques,
+        // background jobs always go to their global queue
+        ConcurrentQueue<JobImpl*, MAX_JOB_COUNT> jobQueues[(U32)Priority::Count];
+        ConcurrentQueue<WorkerFiber*, MAX_FIBER_COUNT * 2> readyFibers;
+        ConcurrentQueue<WorkerFiber*, MAX_FIBER_COUNT * 2> backgroundReadyFibers;
+
+        JobImpl jobPool[MAX_JOB_COUNT];
+        ConcurrentQueue<JobImpl*, MAX_JOB_COUNT * 2> freeJobs;
+
+        // Bit mask of sleeping workers
+        std::atomic<U64> idleWorkers = 0;
+        U64 frameWorkerMask = 0;
+        U64 backgroundWorkerMask = 0;
     };
 
     static LocalPtr<ManagerImpl> gManager;
@@ -83,18 +280,29 @@ namespace Jobsystem
     public:
         ManagerImpl& manager;
         U32 workderIndex;
-        bool isFinished = false;
+        volatile bool isFinished = false;
         bool isEnabled = false;
+        bool isBackground = false;
 
         WorkerFiber* currentFiber = nullptr;
         Fiber::Handle primaryFiber = Fiber::INVALID_HANDLE;
-        std::vector<WorkerFiber*> readyFibers;
-        std::vector<JobImpl> jobQueue;
+        // Fiber switched out from, handled by the next fiber after switching
+        WorkerFiber* fiberToRelease = nullptr;
+        WorkerFiber* fiberToPark = nullptr;
+        ConcurrentQueue<WorkerFiber*, MAX_FIBER_COUNT * 2> readyFibers;
+        ConcurrentQueue<JobImpl*, WORKER_QUEUE_SIZE> pinnedJobs;
+        WorkStealingQueue<JobImpl*, WORKER_QUEUE_SIZE> jobQueues[FRAME_PRIORITY_COUNT];
+
+        Mutex sleepLock;
+        bool wakeupPending = false;
+        U32 randomSeed = 0;
 
     public:
-        WorkerThread(ManagerImpl& manager_, U32 workerIndex_) :
+        WorkerThread(ManagerImpl& manager_, U32 workerIndex_, bool isBackground_) :
             manager(manager_),
-            workderIndex(workerIndex_)
+            workderIndex(workerIndex_),
+            isBackground(isBackground_),
+            randomSeed(workerIndex_ * 7919u + 1u)
         {
         }
 
@@ -104,22 +312,281 @@ namespace Jobsystem
             gWorker = this;
             primaryFiber = Fiber::Create(Fiber::THIS_THREAD);
 
-            gManager->sync.Lock();
-            WorkerFiber* fiber = gManager->freeFibers.back();
-            gManager->freeFibers.pop_back();
-            if (!Fiber::IsValid(fiber->handle))
-                fiber->handle = Fiber::Create(64 * 1024, FiberFunc, fiber);
-
+            WorkerFiber* fiber = PopFreeFiber();
             gWorker->currentFiber = fiber;
             Fiber::SwitchTo(gWorker->primaryFiber, fiber->handle);
             return 0;
         }
+
+        void WaitForWakeup()
+        {
+            ScopedMutex lock(sleepLock);
+            while (!wakeupPending && !isFinished)
+                Sleep(sleepLock);
+            wakeupPending = false;
+        }
+
+        void WakeupFromSleep()
+        {
+            {
+                ScopedMutex lock(sleepLock);
+                wakeupPending = true;
+            }
+            Wakeup();
+        }
+
+        U32 NextRandom()
+        {
+            // xorshift32
+            randomSeed ^= randomSeed << 13;
+            randomSeed ^= randomSeed >> 17;
+            randomSeed ^= randomSeed << 5;
+            return randomSeed;
+        }
     };
 
     //////////////////////////////////////////////////////////////
     // Methods
 
-    bool Initialize(U32 numWorkers)
+    static WorkerFiber* PopFreeFiber()
+    {
+        WorkerFiber* fiber = nullptr;
+        bool ret = gManager->freeFibers.Pop(fiber);
+        ASSERT(ret);
+        if (!Fiber::IsValid(fiber->handle))
+            fiber->handle = Fiber::Create(64 * 1024, FiberFunc, fiber);
+        return fiber;
+    }
+
+    // Called by the new fiber after each switch, the previous fiber
+    // is guaranteed to be switched out at this point
+    static void AfterSwitch()
+    {
+        WorkerThread* worker = GetWorker();
+        if (worker->fiberToRelease != nullptr)
+        {
+            bool ret = gManager->freeFibers.Push(worker->fiberToRelease);
+            ASSERT(ret);
+            worker->fiberToRelease = nullptr;
+        }
+
+        if (worker->fiberToPark != nullptr)
+        {
+            worker->fiberToPark->isParked.store(true, std::memory_order_release);
+            worker->fiberToPark = nullptr;
+        }
+    }
+
+    static void WakeupWorker(WorkerThread* worker)
+    {
+        const U64 bit = 1ull << worker->workderIndex;
+        if (gManager->idleWorkers.fetch_and(~bit) & bit)
+            worker->WakeupFromSleep();
+    }
+
+    static void WakeupIdleWorkers(U32 count, U64 workerMask)
+    {
+        // Make sure the pushed jobs are visible before checking idle workers
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (count > 0)
+        {
+            U64 idleMask = gManager->idleWorkers.load(std::memory_order_relaxed) & workerMask;
+            if (idleMask == 0)
+                return;
+
+            // Only wake up one idle worker for one job, other workers keep sleeping
+            U32 index = 0;
+            while ((idleMask & (1ull << index)) == 0)
+                index++;
+
+            const U64 bit = 1ull << index;
+            if (gManager->idleWorkers.fetch_and(~bit) & bit)
+            {
+                gManager->workersByIndex[index]->WakeupFromSleep();
+                count--;
+            }
+        }
+    }
+
+    static JobImpl* AllocateJob()
+    {
+        JobImpl* job = nullptr;
+        if (gManager->freeJobs.Pop(job))
+            return job;
+
+        job = CJING_NEW(JobImpl);
+        job->isPooled = false;
+        return job;
+    }
+
+    static void ReleaseJob(JobImpl* job)
+    {
+        job->task = nullptr;
+        job->rawTask = nullptr;
+        job->data = nullptr;
+        job->onFinishedHandle = nullptr;
+
+        if (job->isPooled)
+        {
+            bool ret = gManager->freeJobs.Push(job);
+            ASSERT(ret);
+        }
+        else
+        {
+            CJING_DELETE(job);
+        }
+    }
+
+    static void PushJobs(JobImpl** jobs, U32 count, U8 workerIndex, Priority priority)
+    {
+        if (workerIndex != ANY_WORKER)
+        {
+            WorkerThread* worker = gManager->workers[workerIndex];
+            for (U32 i = 0; i < count; i++)
+            {
+                while (!worker->pinnedJobs.Push(jobs[i]))
+                    Platform::YieldCPU();
+            }
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            WakeupWorker(worker);
+            return;
+        }
+
+        if (priority == Priority::Background)
+        {
+            auto& jobQueue = gManager->jobQueues[(U32)Priority::Background];
+            for (U32 i = 0; i < count; i++)
+            {
+                while (!jobQueue.Push(jobs[i]))
+                    Platform::YieldCPU();
+            }
+
+            WakeupIdleWorkers(count, gManager->backgroundWorkerMask);
+            return;
+        }
+
+        // Push to the local deque if we are running on a frame worker,
+        // otherwise push to the global queue
+        WorkerThread* worker = GetWorker();
+        if (worker != nullptr && worker->isBackground)
+            worker = nullptr;
+
+        for (U32 i = 0; i < count; i++)
+        {
+            if (worker == nullptr || !worker->jobQueues[(U32)priority].Push(jobs[i]))
+            {
+                while (!gManager->jobQueues[(U32)priority].Push(jobs[i]))
+                    Platform::YieldCPU();
+            }
+        }
+
+        WakeupIdleWorkers(count, gManager->frameWorkerMask);
+    }
+
+    static void IncrementCounter(JobHandle* handle, U32 count)
+    {
+        if (handle == nullptr)
+            return;
+
+        // Start a new generation when the handle becomes busy again
+        U64 state = handle->state.load(std::memory_order_relaxed);
+        while (true)
+        {
+            U64 counter = state & JobHandle::COUNTER_MASK;
+            U64 generation = state >> 32;
+            if ((counter & ~JobHandle::FINISHING_BIT) == 0)
+                generation = (generation + 1) & JobHandle::COUNTER_MASK;
+
+            U64 newState = (generation << 32) | (counter + count);
+            if (handle->state.compare_exchange_weak(state, newState, std::memory_order_acq_rel, std::memory_order_relaxed))
+                break;
+        }
+    }
+
+    static void ResumeFiber(WorkerFiber* fiber)
+    {
+        U8 workerIndex = fiber->currentJob->workerIndex;
+        if (fiber->currentJob->priority == Priority::Background)
+        {
+            // Background jobs are resumed on background workers
+            bool ret = gManager->backgroundReadyFibers.Push(fiber);
+            ASSERT(ret);
+            WakeupIdleWorkers(1, gManager->backgroundWorkerMask);
+        }
+        else if (workerIndex == ANY_WORKER)
+        {
+            bool ret = gManager->readyFibers.Push(fiber);
+            ASSERT(ret);
+            WakeupIdleWorkers(1, gManager->frameWorkerMask);
+        }
+        else
+        {
+            // Resume the pinned fiber on its own worker
+            WorkerThread* worker = gManager->workers[workerIndex];
+            bool ret = worker->readyFibers.Push(fiber);
+            ASSERT(ret);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            WakeupWorker(worker);
+        }
+    }
+
+    static bool TryGetWork(WorkerThread* worker, WorkerFiber*& fiber, JobImpl*& job)
+    {
+        // Worker
+        if (worker->readyFibers.Pop(fiber))
+            return true;
+        if (worker->pinnedJobs.Pop(job))
+            return true;
+
+        // Background workers only serve the background lane
+        if (worker->isBackground)
+        {
+            if (gManager->backgroundReadyFibers.Pop(fiber))
+                return true;
+            return gManager->jobQueues[(U32)Priority::Background].Pop(job);
+        }
+
+        // Global
+        if (gManager->readyFibers.Pop(fiber))
+            return true;
+
+        // From high to low priority: local deque, global queue, then steal from
+        // other workers starting at a random victim
+        const U32 workerCount = (U32)gManager->workers.size();
+        const U32 start = worker->NextRandom();
+        for (U32 priority = 0; priority < FRAME_PRIORITY_COUNT; priority++)
+        {
+            if (worker->jobQueues[priority].Pop(job))
+                return true;
+            if (gManager->jobQueues[priority].Pop(job))
+                return true;
+
+            for (U32 i = 0; i < workerCount; i++)
+            {
+                WorkerThread* victim = gManager->workers[(start + i) % workerCount];
+                if (victim != worker && victim->jobQueues[priority].Steal(job))
+                    return true;
+            }
+        }
+
+        return false;
+    }
+
+    static WorkerThread* CreateWorker(U32 workerIndex, bool isBackground)
+    {
+        WorkerThread* worker = CJING_NEW(WorkerThread)(*gManager, workerIndex, isBackground);
+        if (!worker->Create(isBackground ? "BackgroundWorker" : "Worker"))
+        {
+            CJING_DELETE(worker);
+            return nullptr;
+        }
+
+        gManager->workersByIndex[workerIndex] = worker;
+        return worker;
+    }
+
+    bool Initialize(U32 numWorkers, U32 numBackgroundWorkers)
     {
         Platform::SetCurrentThreadIndex(0);
 
@@ -130,18 +597,43 @@ namespace Jobsystem
             WorkerFiber* fiber = &gManager->fiberPool[i];
             fiber->index = i;
             fiber->handle = Fiber::INVALID_HANDLE;
-            gManager->freeFibers.push_back(fiber);
+            gManager->freeFibers.Push(fiber);
         }
 
-        numWorkers = std::min(64u, numWorkers);
+        for (int i = 0; i < MAX_JOB_COUNT; i++)
+        {
+            JobImpl* job = &gManager->jobPool[i];
+            job->isPooled = true;
+            gManager->freeJobs.Push(job);
+        }
+
+        numBackgroundWorkers = std::min(8u, numBackgroundWorkers);
+        numWorkers = std::min(64u - numBackgroundWorkers, numWorkers);
+
+        // Worker index is also the bit of the worker in the idle mask
+        U32 workerIndex = 0;
         gManager->workers.reserve(numWorkers);
         for (U32 i = 0; i < numWorkers; i++)
         {
-            WorkerThread* worker = CJING_NEW(WorkerThread)(*gManager, i);
-            if (worker->Create("Worker"))
+            WorkerThread* worker = CreateWorker(workerIndex, false);
+            if (worker != nullptr)
             {
                 gManager->workers.push_back(worker);
+                gManager->frameWorkerMask |= 1ull << workerIndex;
                 worker->SetAffinity((U64)1u << i);
+                workerIndex++;
+            }
+        }
+
+        // Background workers are not bound to a core
+        for (U32 i = 0; i < numBackgroundWorkers; i++)
+        {
+            WorkerThread* worker = CreateWorker(workerIndex, true);
+            if (worker != nullptr)
+            {
+                gManager->backgroundWorkers.push_back(worker);
+                gManager->backgroundWorkerMask |= 1ull << workerIndex;
+                workerIndex++;
             }
         }
 
@@ -153,16 +645,23 @@ namespace Jobsystem
         // Clear workers
         for (auto worker : gManager->workers)
             worker->isFinished = true;
+        for (auto worker : gManager->backgroundWorkers)
+            worker->isFinished = true;
 
-        for (auto worker : gManager->workers)
+        auto DestroyWorkers = [](std::vector<WorkerThread*>& workers)
         {
-            while (!worker->IsFinished())
-                worker->Wakeup();
+            for (auto worker : workers)
+            {
+                while (!worker->IsFinished())
+                    worker->WakeupFromSleep();
 
-            worker->Destroy();
-            CJING_SAFE_DELETE(worker);
-        }
-        gManager->workers.clear();
+                worker->Destroy();
+                CJING_SAFE_DELETE(worker);
+            }
+            workers.clear();
+        };
+        DestroyWorkers(gManager->workers);
+        DestroyWorkers(gManager->backgroundWorkers);
 
         // Clear fibers
         for (auto& fiber : gManager->fiberPool)
@@ -174,148 +673,325 @@ namespace Jobsystem
         gManager.Destroy();
     }
 
-    void RunInternal(JobFunc task, void* data, JobHandle* handle, int workerIndex)
+    static U8 GetTargetWorkerIndex(U8 workerIndex, Priority priority)
     {
-        JobImpl job = {};
-        job.data = data;
-        job.task = task;
-        job.workerIndex = U8(workerIndex != ANY_WORKER ? workerIndex % gManager->workers.size() : ANY_WORKER);
-        job.onFinishedHandle = handle;
+        ASSERT(priority < Priority::Count);
+        ASSERT(workerIndex == ANY_WORKER || priority != Priority::Background);
+        if (workerIndex == ANY_WORKER || priority == Priority::Background)
+            return ANY_WORKER;
 
-        if (handle != nullptr)
-        {
-            ScopedMutex guard(gManager->sync);
-            handle->counter++;
-            if (handle->counter == 1)
-                handle->generation = AtomicIncrement(&gGeneration);
-        }
+        return U8(workerIndex % gManager->workers.size());
+    }
+
+    void RunInternal(JobFunc task, void* data, JobHandle* handle, U8 workerIndex, Priority priority)
+    {
+        JobImpl* job = AllocateJob();
+        job->data = data;
+        job->task = std::move(task);
+        job->workerIndex = GetTargetWorkerIndex(workerIndex, priority);
+        job->priority = priority;
+        job->onFinishedHandle = handle;
 
-        // Push job for worker
-        if (job.workerIndex != ANY_WORKER)
+        IncrementCounter(handle, 1);
+        PushJobs(&job, 1, job->workerIndex, priority);
+    }
+
+    void Run(void*data, JobFunc func, JobHandle* handle, U8 workerIndex, Priority priority)
+    {
+        ASSERT(gManager.Get() != nullptr);
+
+        RunInternal(
+            std::move(func),
+            data,
+            handle,
+            workerIndex,
+            priority
+        );
+    }
+
+    void RunBatch(Span<const JobDecl> jobs, JobHandle* handle, U8 workerIndex, Priority priority)
+    {
+        ASSERT(gManager.Get() != nullptr);
+
+        const U32 count = (U32)jobs.length();
+        if (count == 0)
+            return;
+
+        workerIndex = GetTargetWorkerIndex(workerIndex, priority);
+
+        // Jobs are pushed in chunks to keep the temporary array on stack
+        const U32 CHUNK_SIZE = 256;
+        JobImpl* jobImpls[CHUNK_SIZE];
+
+        IncrementCounter(handle, count);
+        for (U32 offset = 0; offset < count; offset += CHUNK_SIZE)
         {
-            WorkerThread* worker = gManager->workers[job.workerIndex % gManager->workers.size()];
+            const U32 chunkCount = std::min(CHUNK_SIZE, count - offset);
+            for (U32 i = 0; i < chunkCount; i++)
             {
-                ScopedMutex lock(gManager->jobQueueLock);
-                worker->jobQueue.push_back(job);
+                const JobDecl& decl = jobs[offset + i];
+                ASSERT(decl.task != nullptr);
+
+                JobImpl* job = AllocateJob();
+                job->rawTask = decl.task;
+                job->data = decl.data;
+                job->workerIndex = workerIndex;
+                job->priority = priority;
+                job->onFinishedHandle = handle;
+                jobImpls[i] = job;
             }
-            worker->Wakeup();
+            PushJobs(jobImpls, chunkCount, workerIndex, priority);
         }
-        else
-        {
-            {
-                ScopedMutex lock(gManager->jobQueueLock);
-                gManager->jobQueue.push_back(job);
-            }
+    }
+
+    U32 GetQueueDepth(Priority priority)
+    {
+        ASSERT(gManager.Get() != nullptr);
+        ASSERT(priority < Priority::Count);
 
+        U32 depth = gManager->jobQueues[(U32)priority].Size();
+        if (priority != Priority::Background)
+        {
             for (auto worker : gManager->workers)
-                worker->Wakeup();
+                depth += worker->jobQueues[(U32)priority].Size();
         }
+        return depth;
     }
 
-    void Run(void*data, JobFunc func, JobHandle* handle, U8 workerIndex)
+    U32 GetWorkerCount()
     {
         ASSERT(gManager.Get() != nullptr);
+        return (U32)gManager->workers.size();
+    }
 
-        RunInternal(
-            func,
-            data,
-            handle,
-            workerIndex
-        );
+    U32 GetBackgroundWorkerCount()
+    {
+        ASSERT(gManager.Get() != nullptr);
+        return (U32)gManager->backgroundWorkers.size();
     }
 
-    void Wait(JobHandle* handle)
+    struct ForEachContext
+    {
+        ForEachFunc func = nullptr;
+        void* userData = nullptr;
+        U32 count = 0;
+        U32 groupSize = 0;
+        U32 groupCount = 0;
+        std::atomic<U32> nextGroup = 0;
+    };
+
+    static void ForEachGroups(void* data)
+    {
+        // Grab groups until all groups are taken
+        ForEachContext* ctx = static_cast<ForEachContext*>(data);
+        while (true)
+        {
+            U32 group = ctx->nextGroup.fetch_add(1, std::memory_order_relaxed);
+            if (group >= ctx->groupCount)
+                break;
+
+            U32 begin = group * ctx->groupSize;
+            U32 end = std::min(begin + ctx->groupSize, ctx->count);
+            ctx->func(ctx->userData, begin, end);
+        }
+    }
+
+    void ForEachInternal(U32 count, U32 groupSize, ForEachFunc func, void* userData)
     {
         ASSERT(gManager.Get() != nullptr);
 
-        if (handle == nullptr || handle->counter == 0)
+        if (count == 0)
             return;
 
-        gManager->sync.Lock();
-        if (handle->counter == 0)
+        groupSize = std::max(groupSize, 1u);
+        const U32 groupCount = (count + groupSize - 1) / groupSize;
+        if (groupCount == 1)
         {
-            gManager->sync.Unlock();
+            func(userData, 0, count);
             return;
         }
-    
-        // No worker, just sleep
+
+        ForEachContext ctx;
+        ctx.func = func;
+        ctx.userData = userData;
+        ctx.count = count;
+        ctx.groupSize = groupSize;
+        ctx.groupCount = groupCount;
+
+        // One job for each worker at most, the calling thread takes groups too
+        JobDecl decls[64];
+        const U32 jobCount = std::min(groupCount - 1, (U32)gManager->workers.size());
+        for (U32 i = 0; i < jobCount; i++)
+        {
+            decls[i].task = ForEachGroups;
+            decls[i].data = &ctx;
+        }
+
+        JobHandle handle;
+        RunBatch(Span<const JobDecl>(decls, jobCount), &handle);
+        ForEachGroups(&ctx);
+        Wait(&handle);
+    }
+
+    // Claim the waitor list and return the waitors of the finished generations,
+    // the waitors of the pending generation or a newer one are pushed back. The generations wrap
+    static JobWaitor* ClaimFinishedWaitors(JobHandle* handle)
+    {
+        const U64 pendingMask = JobHandle::COUNTER_MASK & ~JobHandle::FINISHING_BIT;
+        JobWaitor* finished = nullptr;
+        U64 state = handle->state.load(std::memory_order_seq_cst);
+        while (true)
+        {
+            const bool isPending = (state & pendingMask) != 0;
+            const U32 generation = U32(state >> 32);
+            JobWaitor* pendingHead = nullptr;
+            JobWaitor* pendingTail = nullptr;
+            JobWaitor* next = handle->waitor.exchange(nullptr, std::memory_order_seq_cst);
+            while (next != nullptr)
+            {
+                JobWaitor* current = next;
+                next = current->next;
+                const I32 age = I32(generation - current->generation);
+                if (age < 0 || (age == 0 && isPending))
+                {
+                    current->next = pendingHead;
+                    pendingHead = current;
+                    if (pendingTail == nullptr)
+                        pendingTail = current;
+                }
+                else
+                {
+                    current->next = finished;
+                    finished = current;
+                }
+            }
+
+            if (pendingHead == nullptr)
+                break;
+
+            pendingTail->next = handle->waitor.load(std::memory_order_relaxed);
+            while (!handle->waitor.compare_exchange_weak(pendingTail->next, pendingHead, std::memory_order_seq_cst, std::memory_order_relaxed)) {}
+
+            // Claim again if the pending generation is finished before the waitors are pushed back
+            const U64 newState = handle->state.load(std::memory_order_seq_cst);
+            if ((newState & pendingMask) != 0 && U32(newState >> 32) == generation)
+                break;
+
+            state = newState;
+        }
+        return finished;
+    }
+
+    void Wait(JobHandle* handle)
+    {
+        ASSERT(gManager.Get() != nullptr);
+
+        if (handle == nullptr)
+            return;
+
+        U64 state = handle->state.load(std::memory_order_acquire);
+        if ((state & JobHandle::COUNTER_MASK) == 0)
+            return;
+
+        // No worker, just yield
         if (GetWorker() == nullptr)
         {
-            while (handle->counter > 0)
+            U32 spinCount = 0;
+            while (handle->GetCounter() > 0)
             {
-                gManager->sync.Unlock();
-                Platform::Sleep(1);
-                gManager->sync.Lock();
+                if (spinCount++ < 1024)
+                    Platform::SwitchToThread();
+                else
+                    Platform::Sleep(0.001f);
             }
-            gManager->sync.Unlock();
             return;
         }
 
         // Set the current fiber as the next waitor of the pending handle
         WorkerFiber* thisFiber = GetWorker()->currentFiber;
+        thisFiber->isParked.store(false, std::memory_order_relaxed);
 
         JobWaitor waitor = {};
         waitor.fiber = thisFiber;
-        waitor.next = handle->waitor;
-        handle->waitor = &waitor;
-            
-        // Get free fiber
-        WorkerFiber* newFiber = gManager->freeFibers.back();
-        gManager->freeFibers.pop_back();
-        if (!Fiber::IsValid(newFiber->handle))
-            newFiber->handle = Fiber::Create(64 * 1024, FiberFunc, newFiber);
+        waitor.generation = U32(state >> 32);
+        waitor.next = handle->waitor.load(std::memory_order_relaxed);
+        while (!handle->waitor.compare_exchange_weak(waitor.next, &waitor, std::memory_order_seq_cst, std::memory_order_relaxed)) {}
 
+        // Check again, the handle may be finished before the waitor is pushed
+        const U64 newState = handle->state.load(std::memory_order_seq_cst);
+        const U64 pendingMask = JobHandle::COUNTER_MASK & ~JobHandle::FINISHING_BIT;
+        if ((newState & pendingMask) == 0 || U32(newState >> 32) != waitor.generation)
+        {
+            // Claim the waitors of the finished generations, resume other waitors and continue if we are claimed,
+            // otherwise the finishing job has claimed us and will resume us
+            bool isClaimed = false;
+            JobWaitor* next = ClaimFinishedWaitors(handle);
+            while (next != nullptr)
+            {
+                JobWaitor* current = next;
+                next = current->next;
+                if (current == &waitor)
+                    isClaimed = true;
+                else
+                    ResumeFiber(current->fiber);
+            }
+
+            if (isClaimed)
+            {
+                // The handle can't be released before the finishing job leaves it
+                while (handle->state.load(std::memory_order_acquire) & JobHandle::FINISHING_BIT)
+                    Platform::YieldCPU();
+                return;
+            }
+        }
+
+        // Switch to a free fiber, this fiber will be parked after switching
+        Profiler::FiberSwitchData profilerData;
+        Profiler::BeforeFiberSwitch(profilerData);
+
+        WorkerFiber* newFiber = PopFreeFiber();
+        GetWorker()->fiberToPark = thisFiber;
         GetWorker()->currentFiber = newFiber;
         Fiber::SwitchTo(thisFiber->handle, newFiber->handle);
+
+        AfterSwitch();
         GetWorker()->currentFiber = thisFiber;
-        gManager->sync.Unlock();
+
+        // May be resumed on another worker
+        Profiler::AfterFiberSwitch(profilerData);
     }
 
     bool Trigger(JobHandle* jobHandle)
     {
-        JobWaitor* waitor = nullptr;
+        // The last job marks the handle as finishing instead of idle, so that
+        // waitors can't return and release the handle while we still touch it
+        U64 state = jobHandle->state.load(std::memory_order_relaxed);
+        while (true)
         {
-            ScopedMutex lock(gManager->sync);
-            jobHandle->counter--;
-            ASSERT(jobHandle->counter >= 0);
-            if (jobHandle->counter > 0)
-                return false;
-
-            waitor = jobHandle->waitor;
-            jobHandle->waitor = nullptr;
+            const U64 counter = state & JobHandle::COUNTER_MASK & ~JobHandle::FINISHING_BIT;
+            ASSERT(counter > 0);
+            const U64 newState = counter == 1 ? (state - 1) | JobHandle::FINISHING_BIT : state - 1;
+            if (jobHandle->state.compare_exchange_weak(state, newState, std::memory_order_seq_cst, std::memory_order_relaxed))
+                break;
         }
 
-        if (waitor == nullptr)
+        if ((state & JobHandle::COUNTER_MASK & ~JobHandle::FINISHING_BIT) != 1)
             return false;
 
-        bool needWakeAll = false;
-        {
-            ScopedMutex lock(gManager->jobQueueLock);
-            while (waitor != nullptr)
-            {
-                JobWaitor* next = waitor->next;
-                U8 workerIndex = waitor->fiber->currentJob.workerIndex; 
-                if (workerIndex == ANY_WORKER)
-                {
-                    gManager->readyFibers.push_back(waitor->fiber);
-                    needWakeAll = true;
+        // The waitors of a new generation started while finishing stay in the list
+        JobWaitor* waitor = ClaimFinishedWaitors(jobHandle);
+        jobHandle->state.fetch_and(~JobHandle::FINISHING_BIT, std::memory_order_seq_cst);
 
-                }
-                else
-                {
-                    WorkerThread* worker = gManager->workers[workerIndex % gManager->workers.size()];
-                    worker->readyFibers.push_back(waitor->fiber);
-                    if (!needWakeAll)
-                        worker->Wakeup();
-                }
-                waitor = next;
-            }
-        }
+        // The handle must not be touched from here
+        if (waitor == nullptr)
+            return false;
 
-        if (needWakeAll)
+        while (waitor != nullptr)
         {
-            for (auto worker : gManager->workers)
-                worker->Wakeup();
+            // The waitor lives on the stack of the waiting fiber, read next before resuming it
+            JobWaitor* next = waitor->next;
+            ResumeFiber(waitor->fiber);
+            waitor = next;
         }
 
         return true;
@@ -324,50 +1000,41 @@ namespace Jobsystem
 #ifdef _WIN32
     static void __stdcall FiberFunc(void* data)
 #else
-    static void FiberFunc(void* data);
+    static void FiberFunc(void* data)
 #endif
     {
-        gManager->sync.Unlock();
+        AfterSwitch();
 
         WorkerFiber* currentFiber = (WorkerFiber*)(data);
         WorkerThread* worker = GetWorker();
         while (!worker->isFinished)
         {
             WorkerFiber* fiber = nullptr;
-            JobImpl job;
+            JobImpl* job = nullptr;
+            U32 spinCount = 0;
             while (!worker->isFinished)
             {
-                ScopedMutex lock(gManager->jobQueueLock);
-
-                // Worker
-                if (!worker->readyFibers.empty())
-                {
-                    fiber = worker->readyFibers.back();
-                    worker->readyFibers.pop_back();
-                    break;
-                }
-                if (!worker->jobQueue.empty())
-                {
-                    job = worker->jobQueue.back();
-                    worker->jobQueue.pop_back();
+                if (TryGetWork(worker, fiber, job))
                     break;
-                }
-                
-                // Global
-                if (!gManager->readyFibers.empty())
+
+                if (spinCount < WORKER_SPIN_COUNT)
                 {
-                    fiber = gManager->readyFibers.back();
-                    gManager->readyFibers.pop_back();
-                    break;
+                    spinCount++;
+                    Platform::YieldCPU();
+                    continue;
                 }
-                if (!gManager->jobQueue.empty())
+
+                // Mark as idle, then check again to avoid missing the wakeup
+                const U64 bit = 1ull << worker->workderIndex;
+                gManager->idleWorkers.fetch_or(bit);
+                if (TryGetWork(worker, fiber, job))
                 {
-                    job = gManager->jobQueue.back();
-                    gManager->jobQueue.pop_back();
+                    gManager->idleWorkers.fetch_and(~bit);
                     break;
                 }
 
-                worker->Sleep(gManager->jobQueueLock);
+                worker->WaitForWakeup();
+                spinCount = 0;
             }
 
             if (worker->isFinished)
@@ -375,26 +1042,37 @@ namespace Jobsystem
 
             if (fiber != nullptr)
             {
-                // Do ready fiber
-                worker->currentFiber = fiber;
+                // Wait until the ready fiber is switched out by its previous worker
+                while (!fiber->isParked.load(std::memory_order_acquire))
+                    Platform::YieldCPU();
+                fiber->isParked.store(false, std::memory_order_relaxed);
 
-                gManager->sync.Lock();
-                gManager->freeFibers.push_back(currentFiber);
+                // Do ready fiber, the current fiber is released after switching
+                worker->currentFiber = fiber;
+                worker->fiberToRelease = currentFiber;
                 Fiber::SwitchTo(currentFiber->handle, fiber->handle);
-                gManager->sync.Unlock();
 
+                AfterSwitch();
                 worker = GetWorker();
                 worker->currentFiber = currentFiber;
             }
-            else if (job.task != nullptr)
+            else if (job != nullptr)
             {
                 // Do target job
                 currentFiber->currentJob = job;
-                job.task(job.data);
-                currentFiber->currentJob.task = nullptr;
+                Profiler::BeginBlock("Job");
+                if (job->rawTask != nullptr)
+                    job->rawTask(job->data);
+                else
+                    job->task(job->data);
+                Profiler::EndBlock();
+                currentFiber->currentJob = nullptr;
+
+                JobHandle* handle = job->onFinishedHandle;
+                ReleaseJob(job);
 
-                if (job.onFinishedHandle)
-                    Trigger(job.onFinishedHandle);
+                if (handle)
+                    Trigger(handle);
 
                 worker = GetWorker();
             }
@@ -405,4 +1083,4 @@ namespace Jobsystem
 }
 }
 
-#pragma warning (pop)
\ No newline at end of file
+#pragma warning (pop)
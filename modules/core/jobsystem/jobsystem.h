@@ -2,35 +2,108 @@
 
 #include "core\common.h"
 
+#include <atomic>
+
 namespace VulkanTest
 {
 namespace Jobsystem
 {
     constexpr U8 ANY_WORKER = 0xff;
 
+    enum class Priority : U8
+    {
+        High,
+        Normal,
+        Low,
+        // Reserved lane for long running work (asset compiling, shader compiling, io),
+        // only served by background workers so it never starves frame jobs
+        Background,
+        Count
+    };
+    constexpr U32 FRAME_PRIORITY_COUNT = (U32)Priority::Background;
+
     using JobFunc = std::function<void(void*)>;
+    using JobFuncPtr = void(*)(void*);
+    using ForEachFunc = void(*)(void* userData, U32 begin, U32 end);
+
+    // Non-allocating job declaration for batched submission
+    struct JobDecl
+    {
+        JobFuncPtr task = nullptr;
+        void* data = nullptr;
+    };
 
     struct JobHandle
     {
+        // Low 32 bits: pending job count, high 32 bits: generation tag
+        // The top bit of the count is set while the last job is finishing the handle
+        static constexpr U64 COUNTER_MASK = 0xffffffffull;
+        static constexpr U64 FINISHING_BIT = 0x80000000ull;
+
+        JobHandle() = default;
         ~JobHandle() 
         {
-            ASSERT(waitor == nullptr);
-            ASSERT(counter == 0);
+            ASSERT(waitor.load() == nullptr);
+            ASSERT(GetCounter() == 0);
+        }
+
+        // Only idle handles can be copied
+        JobHandle(const JobHandle& rhs)
+        {
+            ASSERT(rhs.GetCounter() == 0);
+        }
+
+        JobHandle& operator=(const JobHandle& rhs)
+        {
+            ASSERT(GetCounter() == 0 && rhs.GetCounter() == 0);
+            return *this;
         }
 
         explicit operator bool()const {
-            return counter > 0;
+            return GetCounter() > 0;
+        }
+
+        U32 GetCounter()const {
+            return U32(state.load(std::memory_order_acquire) & COUNTER_MASK);
+        }
+
+        U32 GetGeneration()const {
+            return U32(state.load(std::memory_order_acquire) >> 32);
         }
 
-        volatile I32 counter = 0;
-        struct JobWaitor* waitor = nullptr;
-        I32 generation = 0;
+        std::atomic<U64> state = 0;
+        std::atomic<struct JobWaitor*> waitor = nullptr;
     };
 
-    bool Initialize(U32 numWorkers);
+    bool Initialize(U32 numWorkers, U32 numBackgroundWorkers = 1);
     void Uninitialize();
 
-    void Run(void*data, JobFunc func, JobHandle* handle, U8 workerIndex = ANY_WORKER);
+    // Pinned jobs (workerIndex != ANY_WORKER) are run in order on the target worker,
+    // background jobs can't be pinned
+    void Run(void*data, JobFunc func, JobHandle* handle, U8 workerIndex = ANY_WORKER, Priority priority = Priority::Normal);
     void Wait(JobHandle* handle);
+
+    // Enqueue all jobs with one counter update and one wakeup pass
+    void RunBatch(Span<const JobDecl> jobs, JobHandle* handle, U8 workerIndex = ANY_WORKER, Priority priority = Priority::Normal);
+
+    // Approximate count of queued jobs of the priority, pinned jobs are not included
+    U32 GetQueueDepth(Priority priority);
+
+    U32 GetWorkerCount();
+    U32 GetBackgroundWorkerCount();
+
+    void ForEachInternal(U32 count, U32 groupSize, ForEachFunc func, void* userData);
+
+    // Split [0, count) into groups of groupSize and run func(index) across workers,
+    // the calling thread also takes groups and returns when all are finished
+    template<typename F>
+    void ForEach(U32 count, U32 groupSize, const F& func)
+    {
+        ForEachInternal(count, groupSize, [](void* userData, U32 begin, U32 end) {
+            const F& f = *static_cast<const F*>(userData);
+            for (U32 i = begin; i < end; i++)
+                f(i);
+        }, (void*)&func);
+    }
 }
 }
\ No newline at end of file
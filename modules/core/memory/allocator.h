@@ -42,9 +42,9 @@ namespace VulkanTest
 		virtual void* Allocate(size_t size) = 0;
 		virtual void* Reallocate(void* ptr, size_t newSize) = 0;
 		virtual void  Free(void* ptr) = 0;
-		virtual void* AlignAllocate(size_t size, size_t align) = 0;
-		virtual void* AlignReallocate(void* ptr, size_t newSize, size_t align) = 0;
-		virtual void  AlignFree(void* ptr) = 0;
+		virtual void* AllocateAligned(size_t size, size_t align) = 0;
+		virtual void* ReallocateAligned(void* ptr, size_t newSize, size_t align) = 0;
+		virtual void  FreeAligned(void* ptr) = 0;
 #endif
 
 		// Get the maximum size of a single allocation
@@ -3,15 +3,26 @@
 #include "memory.h"
 #include "platform\platform.h"
 
+#include <atomic>
+
 namespace VulkanTest
 {
 	// Small alloc strategy:
-	// MAX_SMALL_SIZE is 64
-	// According to size divided into 4 free lists: 8 16 32 64
-
-	static constexpr U32 SMALL_ALLOC_MAX_SIZE = 64;
+	// MAX_SMALL_SIZE is 512
+	// According to size divided into 7 free lists: 8 16 32 64 128 256 512
+	// Every thread keeps a magazine of free items for each size class,
+	// magazines are refilled from and returned to the shared pages in batches,
+	// so the mutex is only taken once per batch.
+
+	static constexpr U32 SMALL_ALLOC_MAX_SIZE = 512;
+	static constexpr U32 SMALL_ALLOC_CLASS_COUNT = 7;
 	static constexpr U32 PAGE_SIZE = 4096;
-	static constexpr size_t MAX_PAGE_COUNT = 16384;
+	static constexpr size_t MAX_PAGE_COUNT = 65536;
+
+	static constexpr U32 MAGAZINE_SIZE = 64;
+	static constexpr U32 MAGAZINE_BATCH_SIZE = MAGAZINE_SIZE / 2;
+	static constexpr U32 MAX_CACHED_ALLOCATOR_COUNT = 8;
+	static constexpr U32 INVALID_CACHE_INDEX = 0xffffffff;
 
 	struct DefaultAllocator::MemPage
 	{
@@ -26,16 +37,41 @@ namespace VulkanTest
 		Header header;
 	};
 
+	struct ThreadCache
+	{
+		struct Magazine
+		{
+			U32 count;
+			void* items[MAGAZINE_SIZE];
+		};
+
+		DefaultAllocator* allocator;
+		Magazine magazines[SMALL_ALLOC_CLASS_COUNT];
+	};
+
+	// Trivially destructible, so it is still accessible after the flusher is destroyed
+	struct ThreadCaches
+	{
+		bool isDisabled;
+		ThreadCache caches[MAX_CACHED_ALLOCATOR_COUNT];
+	};
+	static thread_local ThreadCaches gThreadCaches;
+
+	// Allocators which own a cache slot, cleared when the allocator is destroyed
+	static std::atomic<DefaultAllocator*> gCachedAllocators[MAX_CACHED_ALLOCATOR_COUNT];
+	static std::atomic<U32> gCachedAllocatorCount = 0;
+
 	static U32 GetFreeListIndex(size_t size)
 	{
-		// According to size divided into 4 free lists: 8 16 32 64
-		// (0, 8]   => 0; 
-		// (8, 16]  => 1; 
-		// (16, 32] => 2; 
-		// (32, 64] => 3; 
+		// According to size divided into 7 free lists: 8 16 32 64 128 256 512
+		// (0, 8]     => 0;
+		// (8, 16]    => 1;
+		// (16, 32]   => 2;
+		// ...
+		// (256, 512] => 6;
 		ASSERT(size > 0);
 		ASSERT(size <= SMALL_ALLOC_MAX_SIZE);
-		return 31 - LeadingZeroes(((U32)size - 1) >> 2);
+		return 32 - LeadingZeroes(((U32)size - 1) >> 3);
 	}
 
 	static void InitMemPage(DefaultAllocator::MemPage* page, int itemSize)
@@ -58,80 +94,175 @@ namespace VulkanTest
 		return (DefaultAllocator::MemPage*)((UIntPtr)ptr & ~(U64)(PAGE_SIZE - 1));
 	}
 
-	static void* AllocSmall(DefaultAllocator& allocator, size_t size)
+	static U32 AllocSmallBatch(DefaultAllocator& allocator, U32 freeListIndex, void** items, U32 count)
 	{
-		U32 freeListIndex = GetFreeListIndex(size);
 		ScopedMutex lock(allocator.mutex);
 		if (allocator.smallAllocation == nullptr)
 			allocator.smallAllocation = (U8*)Platform::MemReserve(MAX_PAGE_COUNT * PAGE_SIZE);
 
-		DefaultAllocator::MemPage* page = allocator.freeList[freeListIndex];
-		if (page == nullptr)
+		for (U32 i = 0; i < count; i++)
 		{
-			if (allocator.pageCount == MAX_PAGE_COUNT)
-				return nullptr;
+			DefaultAllocator::MemPage* page = allocator.freeList[freeListIndex];
+			if (page == nullptr)
+			{
+				if (allocator.pageCount == MAX_PAGE_COUNT)
+					return i;
+
+				page = (DefaultAllocator::MemPage*)(allocator.smallAllocation + PAGE_SIZE * allocator.pageCount);
+				InitMemPage(page, 8 << freeListIndex);
+				allocator.freeList[freeListIndex] = page;
+				allocator.pageCount++;
+			}
+
+			ASSERT(page->header.itemSize > 0);
+			ASSERT(page->header.firstFree + page->header.itemSize <= sizeof(page->data));
+			void* mem = &page->data[page->header.firstFree];
+			page->header.firstFree = *(U32*)mem;
+			items[i] = mem;
+
+			if (page->header.firstFree + page->header.itemSize > sizeof(page->data))
+			{
+				// If the page is full (dose not have enough mem for next allocation)
+				// Remove it from the freelist, it will reallocate a new page
+				if (allocator.freeList[freeListIndex] == page)
+					allocator.freeList[freeListIndex] = page->header.next;
+
+				if (page->header.next != nullptr)
+					page->header.next->header.prev = page->header.prev;
+				if (page->header.prev != nullptr)
+					page->header.prev->header.next = page->header.next;
+
+				page->header.prev = page->header.next = nullptr;
+			}
+		}
+		return count;
+	}
 
-			page = (DefaultAllocator::MemPage*)(allocator.smallAllocation + PAGE_SIZE * allocator.pageCount);
-			InitMemPage(page, 8 << freeListIndex);
-			allocator.freeList[freeListIndex] = page;
-			allocator.pageCount++;
+	static void FreeSmallBatch(DefaultAllocator& allocator, void** items, U32 count)
+	{
+		ScopedMutex lock(allocator.mutex);
+		for (U32 i = 0; i < count; i++)
+		{
+			void* mem = items[i];
+			DefaultAllocator::MemPage* page = GetMemPage(mem);
+			if (page->header.firstFree + page->header.itemSize > sizeof(page->data))
+			{
+				ASSERT(!page->header.next);
+				ASSERT(!page->header.prev);
+
+				// Page is not full anymore, push it back to the freelist
+				U32 freeListIndex = GetFreeListIndex(page->header.itemSize);
+				page->header.next = allocator.freeList[freeListIndex];
+				if (page->header.next != nullptr)
+					page->header.next->header.prev = page;
+				allocator.freeList[freeListIndex] = page;
+			}
+
+			*(U32*)mem = page->header.firstFree;
+			page->header.firstFree = U32((U8*)mem - page->data);
 		}
+	}
 
-		ASSERT(page->header.itemSize > 0);
-		ASSERT(page->header.firstFree + size < sizeof(page->data));
-		void* mem = &page->data[page->header.firstFree];
-		page->header.firstFree = *(U32*)mem;
+	static ThreadCache* GetThreadCache(DefaultAllocator& allocator)
+	{
+		if (allocator.cacheIndex == INVALID_CACHE_INDEX || gThreadCaches.isDisabled)
+			return nullptr;
 
-		if (page->header.firstFree + page->header.itemSize > sizeof(page->data))
+		// Return the cached items to the owner allocator when the thread exits
+		struct ThreadCacheFlusher
 		{
-			// If the page is full (dose not have enough mem for next allocation)
-			// Set freelist is null, it will reallocate a new page
-			if (allocator.freeList[freeListIndex] == page)
-				allocator.freeList[freeListIndex] = page->header.next;
+			~ThreadCacheFlusher()
+			{
+				gThreadCaches.isDisabled = true;
+				for (U32 i = 0; i < MAX_CACHED_ALLOCATOR_COUNT; i++)
+				{
+					ThreadCache& cache = gThreadCaches.caches[i];
+					if (cache.allocator == nullptr || gCachedAllocators[i].load() != cache.allocator)
+						continue;
+
+					for (auto& magazine : cache.magazines)
+					{
+						FreeSmallBatch(*cache.allocator, magazine.items, magazine.count);
+						magazine.count = 0;
+					}
+				}
+			}
+		};
+		static thread_local ThreadCacheFlusher flusher;
+		(void)flusher;
 
-			if (page->header.next != nullptr)
-				page->header.next->header.prev = page->header.prev;
-			if (page->header.prev != nullptr)
-				page->header.prev->header.next = page->header.next;
+		ThreadCache& cache = gThreadCaches.caches[allocator.cacheIndex];
+		cache.allocator = &allocator;
+		return &cache;
+	}
 
-			page->header.prev = page->header.next = nullptr;
+	static void* AllocSmall(DefaultAllocator& allocator, size_t size)
+	{
+		U32 freeListIndex = GetFreeListIndex(size);
+		ThreadCache* cache = GetThreadCache(allocator);
+		if (cache == nullptr)
+		{
+			void* mem = nullptr;
+			AllocSmallBatch(allocator, freeListIndex, &mem, 1);
+			return mem;
 		}
 
-		return mem;
+		auto& magazine = cache->magazines[freeListIndex];
+		if (magazine.count == 0)
+			magazine.count = AllocSmallBatch(allocator, freeListIndex, magazine.items, MAGAZINE_BATCH_SIZE);
+
+		return magazine.count > 0 ? magazine.items[--magazine.count] : nullptr;
 	}
 
 	static void FreeSmall(DefaultAllocator& allocator, void* mem)
 	{
-		DefaultAllocator::MemPage* page = GetMemPage(mem);
-		ScopedMutex lock(allocator.mutex);
-
-		if (page->header.firstFree + page->header.itemSize > sizeof(page->data))
+		ThreadCache* cache = GetThreadCache(allocator);
+		if (cache == nullptr)
 		{
-			ASSERT(!page->header.next);
-			ASSERT(!page->header.prev);
+			FreeSmallBatch(allocator, &mem, 1);
+			return;
+		}
 
-			U32 freeListIndex = GetFreeListIndex(page->header.itemSize);
-			page->header.next = allocator.freeList[freeListIndex];
-			allocator.freeList[freeListIndex] = page;
+		// Item size of the page never changes, it is safe to read it without lock
+		DefaultAllocator::MemPage* page = GetMemPage(mem);
+		auto& magazine = cache->magazines[GetFreeListIndex(page->header.itemSize)];
+		if (magazine.count == MAGAZINE_SIZE)
+		{
+			magazine.count -= MAGAZINE_BATCH_SIZE;
+			FreeSmallBatch(allocator, magazine.items + magazine.count, MAGAZINE_BATCH_SIZE);
 		}
+		magazine.items[magazine.count++] = mem;
+	}
+
+	static bool IsSmallAlloc(DefaultAllocator& allocator, void* mem)
+	{
+		return allocator.smallAllocation != nullptr &&
+			mem >= allocator.smallAllocation &&
+			mem < (allocator.smallAllocation + MAX_PAGE_COUNT * PAGE_SIZE);
+	}
+
+	// Fallback to the system allocator if the small allocation pages are exhausted
+	static void* Alloc(DefaultAllocator& allocator, size_t size)
+	{
+		void* mem = size <= SMALL_ALLOC_MAX_SIZE ? AllocSmall(allocator, size) : nullptr;
+		return mem != nullptr ? mem : malloc(size);
+	}
 
-		*(U32*)mem = page->header.firstFree;
-		page->header.firstFree = U32((U8*)mem - page->data);
+	static void* AllocAligned(DefaultAllocator& allocator, size_t size, size_t align)
+	{
+		// Items are aligned to the item size (power of 2)
+		void* mem = size <= SMALL_ALLOC_MAX_SIZE && align <= size ? AllocSmall(allocator, size) : nullptr;
+		return mem != nullptr ? mem : _aligned_malloc(size, align);
 	}
 
 	static void* ReallocSmall(DefaultAllocator& allocator, void* mem, size_t size)
 	{
-		// Check itemSize
+		// Keep the item if the size class is not changed
 		DefaultAllocator::MemPage* page = GetMemPage(mem);
-		if (size <= SMALL_ALLOC_MAX_SIZE)
-		{
-			U32 i = GetFreeListIndex(size);
-			DefaultAllocator::MemPage* newPage = allocator.freeList[i];
-			if (newPage != nullptr && newPage->header.itemSize == page->header.itemSize)
-				return mem;
-		}
+		if (size <= SMALL_ALLOC_MAX_SIZE && GetFreeListIndex(size) == GetFreeListIndex(page->header.itemSize))
+			return mem;
 
-		void* newMem = size <= SMALL_ALLOC_MAX_SIZE ? AllocSmall(allocator, size) : malloc(size);
+		void* newMem = Alloc(allocator, size);
 		memcpy(newMem, mem, std::min((size_t)page->header.itemSize, size));
 		FreeSmall(allocator, mem);
 		return newMem;
@@ -139,35 +270,48 @@ namespace VulkanTest
 
 	static void* ReallocSmallAligned(DefaultAllocator& allocator, void* mem, size_t size, size_t align)
 	{
-		// Check itemSize
+		// Keep the item if the size class is not changed
 		DefaultAllocator::MemPage* page = GetMemPage(mem);
-		if (size <= SMALL_ALLOC_MAX_SIZE)
-		{
-			U32 i = GetFreeListIndex(size);
-			if (allocator.freeList[i]->header.itemSize == page->header.itemSize)
-				return mem;
-		}
-		void* newMem = size <= SMALL_ALLOC_MAX_SIZE ? AllocSmall(allocator, size) : _aligned_malloc(size, align);
+		if (size <= SMALL_ALLOC_MAX_SIZE && align <= page->header.itemSize &&
+			GetFreeListIndex(size) == GetFreeListIndex(page->header.itemSize))
+			return mem;
+
+		void* newMem = AllocAligned(allocator, size, align);
 		memcpy(newMem, mem, std::min((size_t)page->header.itemSize, size));
 		FreeSmall(allocator, mem);
 		return newMem;
 	}
 
-	static bool IsSmallAlloc(DefaultAllocator& allocator, void* mem)
+	static void* ReallocAligned(DefaultAllocator& allocator, void* mem, size_t size, size_t align)
 	{
-		return allocator.smallAllocation != nullptr &&
-			mem >= allocator.smallAllocation &&
-			mem < (allocator.smallAllocation + MAX_PAGE_COUNT * PAGE_SIZE);
+		if (mem == nullptr)
+			return AllocAligned(allocator, size, align);
+
+		return IsSmallAlloc(allocator, mem) ? ReallocSmallAligned(allocator, mem, size, align) : _aligned_realloc(mem, size, align);
 	}
 
-	DefaultAllocator::DefaultAllocator()
+	DefaultAllocator::DefaultAllocator(bool enableThreadCache)
 	{
 		pageCount = 0;
 		memset(freeList, 0, sizeof(freeList));
+
+		if (enableThreadCache)
+		{
+			U32 index = gCachedAllocatorCount.fetch_add(1);
+			if (index < MAX_CACHED_ALLOCATOR_COUNT)
+			{
+				cacheIndex = index;
+				gCachedAllocators[index].store(this);
+			}
+		}
 	}
 
 	DefaultAllocator::~DefaultAllocator()
 	{
+		// Cached items of threads are released with the pages
+		if (cacheIndex != INVALID_CACHE_INDEX)
+			gCachedAllocators[cacheIndex].store(nullptr);
+
 		if (smallAllocation != nullptr)
 			Platform::MemRelease(smallAllocation, MAX_PAGE_COUNT * PAGE_SIZE);
 	}
@@ -175,14 +319,14 @@ namespace VulkanTest
 #ifdef VULKAN_MEMORY_TRACKER
 	void* DefaultAllocator::Allocate(size_t size, const char* filename, int line)
 	{
-		void* ptr = size <= SMALL_ALLOC_MAX_SIZE ? AllocSmall(*this, size) : malloc(size);
+		void* ptr = VulkanTest::Alloc(*this, size);
 		MemoryTracker::Get().RecordAlloc(ptr, size, filename, line);
 		return ptr;
 	}
 
 	void* DefaultAllocator::Allocate(size_t size)
 	{
-		return size <= SMALL_ALLOC_MAX_SIZE ? AllocSmall(*this, size) : malloc(size);
+		return VulkanTest::Alloc(*this, size);
 	}
 
 	void* DefaultAllocator::Reallocate(void* ptr, size_t newBytes, const char* filename, int line)
@@ -204,19 +348,14 @@ namespace VulkanTest
 
 	void* DefaultAllocator::AllocateAligned(size_t size, size_t align, const char* filename, int line)
 	{
-		void* ptr = nullptr;
-		if (size <= SMALL_ALLOC_MAX_SIZE && align <= size)
-			ptr = AllocSmall(*this, size);
-		else
-			ptr = _aligned_malloc(size, align);
-
+		void* ptr = VulkanTest::AllocAligned(*this, size, align);
 		MemoryTracker::Get().RecordAlloc(ptr, size, filename, line);
 		return ptr;
 	}
 
 	void* DefaultAllocator::ReallocateAligned(void* ptr, size_t newBytes, size_t align, const char* filename, int line)
 	{
-		void* ret = IsSmallAlloc(*this, ptr) ? ReallocSmallAligned(*this, ptr, newBytes, align) : _aligned_realloc(ptr, newBytes, align);
+		void* ret = VulkanTest::ReallocAligned(*this, ptr, newBytes, align);
 		MemoryTracker::Get().RecordRealloc(ret, ptr, newBytes, filename, line);
 		return ret;
 	}
@@ -234,12 +373,12 @@ namespace VulkanTest
 #else
 	void* DefaultAllocator::Allocate(size_t size)
 	{
-		return size <= SMALL_ALLOC_MAX_SIZE ? AllocSmall(*this, size) : malloc(size);
+		return VulkanTest::Alloc(*this, size);
 	}
 
 	void* DefaultAllocator::Reallocate(void* ptr, size_t newSize)
 	{
-		return IsSmallAlloc(*this, ptr) ? ReallocSmall(*this, ptr, newBytes) : realloc(ptr, newBytes);
+		return IsSmallAlloc(*this, ptr) ? ReallocSmall(*this, ptr, newSize) : realloc(ptr, newSize);
 	}
 
 	void DefaultAllocator::Free(void* ptr)
@@ -252,17 +391,12 @@ namespace VulkanTest
 
 	void* DefaultAllocator::AllocateAligned(size_t size, size_t align)
 	{
-		void* ptr = nullptr;
-		if (size <= SMALL_ALLOC_MAX_SIZE && align <= size)
-			ptr = AllocSmall(*this, size);
-		else
-			ptr = _aligned_malloc(size, align);
-		return ptr;
+		return VulkanTest::AllocAligned(*this, size, align);
 	}
 
 	void* DefaultAllocator::ReallocateAligned(void* ptr, size_t newSize, size_t align)
 	{
-		return IsSmallAlloc(*this, ptr) ? ReallocSmallAligned(*this, ptr, newBytes, align) : _aligned_realloc(ptr, newBytes, align);
+		return VulkanTest::ReallocAligned(*this, ptr, newSize, align);
 	}
 
 	void DefaultAllocator::FreeAligned(void* ptr)
@@ -279,27 +413,98 @@ namespace VulkanTest
 		return std::numeric_limits<size_t>::max();
 	}
 
-	LinearAllocator::LinearAllocator()
+	static constexpr size_t LINEAR_COMMIT_SIZE = 64 * 1024;
+
+	LinearAllocator::LinearAllocator(size_t reserveSize_) :
+		reserveSize(reserveSize_)
 	{
 	}
 
 	LinearAllocator::~LinearAllocator()
 	{
+		if (mem != nullptr)
+			Platform::MemRelease(mem, reserveSize);
 	}
 
+	bool LinearAllocator::Commit(size_t size)
+	{
+		if (size <= committedSize)
+			return true;
+
+		if (size > reserveSize)
+		{
+			ASSERT(false);
+			return false;
+		}
+
+		// Reserve the address range on first use
+		if (mem == nullptr)
+		{
+			mem = (U8*)Platform::MemReserve(reserveSize);
+			if (mem == nullptr)
+				return false;
+		}
+
+		size_t newCommittedSize = std::min(reserveSize, (size_t)AlignTo((U64)size, (U64)LINEAR_COMMIT_SIZE));
+		Platform::MemCommit(mem + committedSize, newCommittedSize - committedSize);
+		committedSize = newCommittedSize;
+		return true;
+	}
+
+	void* LinearAllocator::AllocateImpl(size_t size, size_t align)
+	{
+		const size_t start = (size_t)AlignTo((U64)offset, (U64)align);
+		if (!Commit(start + size))
+			return nullptr;
+
+		offset = start + size;
+		peakBytes = std::max(peakBytes, offset);
+		lastAllocation = mem + start;
+		return lastAllocation;
+	}
+
+	void* LinearAllocator::ReallocateImpl(void* ptr, size_t newSize, size_t align)
+	{
+		if (ptr == nullptr)
+			return AllocateImpl(newSize, align);
+
+		U8* bytes = (U8*)ptr;
+		ASSERT(bytes >= mem && bytes < mem + offset);
+
+		// Grow or shrink the last allocation in place
+		if (bytes == lastAllocation && ((UIntPtr)bytes & (align - 1)) == 0)
+		{
+			const size_t start = bytes - mem;
+			if (!Commit(start + newSize))
+				return nullptr;
+
+			offset = start + newSize;
+			peakBytes = std::max(peakBytes, offset);
+			return ptr;
+		}
+
+		// The old size is unknown, but everything up to the current offset is readable
+		const size_t oldOffset = offset;
+		void* newMem = AllocateImpl(newSize, align);
+		if (newMem != nullptr)
+			memcpy(newMem, ptr, std::min(newSize, (size_t)(mem + oldOffset - bytes)));
+		return newMem;
+	}
+
+#ifdef VULKAN_MEMORY_TRACKER
 	void* LinearAllocator::Allocate(size_t size, const char* filename, int line)
 	{
-		return nullptr;
+		return AllocateImpl(size, DEFAULT_ALIGNMENT);
 	}
 
 	void* LinearAllocator::Allocate(size_t size)
 	{
-		return nullptr;
+		return AllocateImpl(size, DEFAULT_ALIGNMENT);
 	}
 
 	void* LinearAllocator::Reallocate(void* ptr, size_t newBytes, const char* filename, int line)
 	{
-		return nullptr;
+		return ReallocateImpl(ptr, newBytes, DEFAULT_ALIGNMENT);
 	}
 
 	void LinearAllocator::Free(void* ptr)
@@ -308,15 +513,122 @@ namespace VulkanTest
 
 	void* LinearAllocator::AllocateAligned(size_t size, size_t align, const char* filename, int line)
 	{
-		return nullptr;
+		return AllocateImpl(size, align);
 	}
 
 	void* LinearAllocator::ReallocateAligned(void* ptr, size_t newBytes, size_t align, const char* filename, int line)
 	{
-		return nullptr;
+		return ReallocateImpl(ptr, newBytes, align);
 	}
 
 	void LinearAllocator::FreeAligned(void* ptr)
 	{
 	}
+#else
+	void* LinearAllocator::Allocate(size_t size)
+	{
+		return AllocateImpl(size, DEFAULT_ALIGNMENT);
+	}
+
+	void* LinearAllocator::Reallocate(void* ptr, size_t newSize)
+	{
+		return ReallocateImpl(ptr, newSize, DEFAULT_ALIGNMENT);
+	}
+
+	void LinearAllocator::Free(void* ptr)
+	{
+	}
+
+	void* LinearAllocator::AllocateAligned(size_t size, size_t align)
+	{
+		return AllocateImpl(size, align);
+	}
+
+	void* LinearAllocator::ReallocateAligned(void* ptr, size_t newSize, size_t align)
+	{
+		return ReallocateImpl(ptr, newSize, align);
+	}
+
+	void LinearAllocator::FreeAligned(void* ptr)
+	{
+	}
+#endif
+
+	size_t LinearAllocator::GetMaxAllocationSize()
+	{
+		return reserveSize;
+	}
+
+	void LinearAllocator::Rewind(size_t mark)
+	{
+		ASSERT(mark <= offset);
+		offset = mark;
+		lastAllocation = nullptr;
+	}
+
+	void LinearAllocator::Reset()
+	{
+		lastPeakBytes = peakBytes;
+		peakBytes = 0;
+		offset = 0;
+		lastAllocation = nullptr;
+	}
+
+	namespace FrameAllocator
+	{
+		static constexpr U32 MAX_FRAME_ALLOCATOR_COUNT = 64;
+
+		// Stored statically, so they don't depend on the lifetime of the global allocator
+		static LinearAllocator gAllocators[MAX_FRAME_ALLOCATOR_COUNT];
+		static std::atomic<U32> gAllocatorCount = 0;
+		static size_t gMaxPeakBytes = 0;
+		static thread_local LinearAllocator* gCurrentAllocator = nullptr;
+
+		LinearAllocator& Get()
+		{
+			if (gCurrentAllocator == nullptr)
+			{
+				// The slots are never released, running out of them is fatal in all builds
+				U32 index = gAllocatorCount.fetch_add(1);
+				if (index >= MAX_FRAME_ALLOCATOR_COUNT)
+				{
+					Logger::Error("Too many threads use the frame allocator, max:%d", MAX_FRAME_ALLOCATOR_COUNT);
+					abort();
+				}
+				gCurrentAllocator = &gAllocators[index];
+			}
+			return *gCurrentAllocator;
+		}
+
+		void NewFrame()
+		{
+			const U32 count = std::min(gAllocatorCount.load(), MAX_FRAME_ALLOCATOR_COUNT);
+			size_t peakBytes = 0;
+			for (U32 i = 0; i < count; i++)
+			{
+				peakBytes += gAllocators[i].GetPeakBytes();
+				gAllocators[i].Reset();
+			}
+			gMaxPeakBytes = std::max(gMaxPeakBytes, peakBytes);
+		}
+
+		size_t GetPeakBytes()
+		{
+			size_t peakBytes = 0;
+			const U32 count = std::min(gAllocatorCount.load(), MAX_FRAME_ALLOCATOR_COUNT);
+			for (U32 i = 0; i < count; i++)
+				peakBytes += gAllocators[i].GetLastPeakBytes();
+			return peakBytes;
+		}
+
+		size_t GetMaxPeakBytes()
+		{
+			return gMaxPeakBytes;
+		}
+
+		U32 GetAllocatorCount()
+		{
+			return std::min(gAllocatorCount.load(), MAX_FRAME_ALLOCATOR_COUNT);
+		}
+	}
 }
\ No newline at end of file
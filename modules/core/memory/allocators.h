@@ -8,7 +8,8 @@ namespace VulkanTest
 	class VULKAN_TEST_API DefaultAllocator final : public IAllocator
 	{
 	public:
-		DefaultAllocator();
+		// Thread caches are only available for the first few allocators
+		explicit DefaultAllocator(bool enableThreadCache = true);
 		~DefaultAllocator();
 
 #ifdef VULKAN_MEMORY_TRACKER
@@ -34,16 +35,27 @@ namespace VulkanTest
 		Mutex mutex;
 		U8* smallAllocation = nullptr;
 
+		U32 cacheIndex = 0xffffffff;
+
 		struct MemPage;
-		MemPage* freeList[4];
+		MemPage* freeList[7];
 	};
 
-	class VULKAN_TEST_API LinearAllocator final : IAllocator
+	// Bump pointer arena, the memory is reserved once and committed on demand.
+	// Free does nothing, memory is released by Rewind or Reset.
+	// Not thread safe, use one instance per thread (see FrameAllocator)
+	class VULKAN_TEST_API LinearAllocator final : public IAllocator
 	{
 	public:
-		LinearAllocator();
+		static constexpr size_t DEFAULT_RESERVE_SIZE = 64 * 1024 * 1024;
+		static constexpr size_t DEFAULT_ALIGNMENT = 16;
+
+		explicit LinearAllocator(size_t reserveSize_ = DEFAULT_RESERVE_SIZE);
 		~LinearAllocator();
 
+		LinearAllocator(const LinearAllocator& rhs) = delete;
+		void operator=(const LinearAllocator& rhs) = delete;
+
 #ifdef VULKAN_MEMORY_TRACKER
 		void* Allocate(size_t size, const char* filename, int line)override;
 		void* Allocate(size_t size);
@@ -60,7 +72,50 @@ namespace VulkanTest
 		void* ReallocateAligned(void* ptr, size_t newSize, size_t align)override;
 		void  FreeAligned(void* ptr)override;
 #endif
+		size_t GetMaxAllocationSize()override;
+
+		// Release all allocations made after the mark
+		size_t GetMark()const { return offset; }
+		void Rewind(size_t mark);
+
+		// Release all allocations, the peak usage is kept in lastPeakBytes
+		void Reset();
+
+		size_t GetUsedBytes()const { return offset; }
+		size_t GetCommittedBytes()const { return committedSize; }
+		size_t GetPeakBytes()const { return peakBytes; }
+		size_t GetLastPeakBytes()const { return lastPeakBytes; }
+
 	private:
+		void* AllocateImpl(size_t size, size_t align);
+		void* ReallocateImpl(void* ptr, size_t newSize, size_t align);
+		bool Commit(size_t size);
 
+		U8* mem = nullptr;
+		U8* lastAllocation = nullptr;
+		size_t reserveSize = 0;
+		size_t committedSize = 0;
+		size_t offset = 0;
+		size_t peakBytes = 0;
+		size_t lastPeakBytes = 0;
 	};
+
+	// Per-thread linear allocators for temporary data of a frame.
+	// All of them are reset by NewFrame, so the memory must not outlive the frame.
+	// Don't call Jobsystem::Wait between GetMark and Rewind, the job may be resumed on
+	// another thread. Background jobs can run across frames and must not use it.
+	namespace FrameAllocator
+	{
+		LinearAllocator& Get();
+
+		// Frame reset hook, call it when no frame job is running
+		void NewFrame();
+
+		// Sum of the peak bytes of all threads in the last frame
+		size_t GetPeakBytes();
+
+		// Largest sum of the peak bytes of a frame since the start, for sizing the reserve
+		size_t GetMaxPeakBytes();
+		U32 GetAllocatorCount();
+	}
 }
\ No newline at end of file
@@ -17,6 +17,8 @@ namespace VulkanTest
 
 		DEFAULT_READ = READ | MMAP,
 		DEFAULT_WRITE = WRITE | CREATE,
+		// Open an existing file for reading and writing without truncating it
+		READ_WRITE = READ | WRITE,
 	};
 
 	enum class PathType
@@ -159,8 +161,21 @@ namespace VulkanTest
 		bool IsValid() const override;
 		void  Close() override;
 
+		// Positional read and write, the file pointer is not used so they can be called from multiple threads
+		bool ReadAt(U64 offset, void* buffer, size_t bytes);
+		bool WriteAt(U64 offset, const void* buffer, size_t bytes);
+
+		// Map the whole file into a read-only view, the view is valid until Unmap or Close
+		const U8* Map();
+		void Unmap();
+		const U8* GetMappedData()const { return mappedData; }
+		// Touch every page of the view so the following reads do not fault
+		void Prefetch()const;
+
 	private:
-		void* handle;
+		void* handle = (void*)(intptr_t)-1;
+		void* mappingHandle = nullptr;
+		const U8* mappedData = nullptr;
 		size_t size = 0;
 		FileFlags flags = FileFlags::NONE;
 		volatile int mappedCount = 0;
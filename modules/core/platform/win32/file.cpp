@@ -5,7 +5,8 @@ namespace VulkanTest
 {
 #ifdef CJING3D_PLATFORM_WIN32
 
-	MappedFile::MappedFile(const char* path, FileFlags flags)
+	MappedFile::MappedFile(const char* path, FileFlags flags) :
+		flags(flags)
 	{
 		DWORD desiredAccess = 0;
 		DWORD shareMode = 0;
@@ -41,10 +42,8 @@ namespace VulkanTest
 		}
 		else
 		{
-			//DWORD sizeH = 0;
-			//DWORD sizeL = ::GetFileSize(handle, &sizeL);
-			//size = (size_t)(sizeH) << 32ull | sizeL;
-			size = ::GetFileSize((HANDLE)handle, 0);
+			LARGE_INTEGER fileSize;
+			size = ::GetFileSizeEx((HANDLE)handle, &fileSize) ? (size_t)fileSize.QuadPart : 0;
 		}
 	}
 
@@ -96,8 +95,87 @@ namespace VulkanTest
 		return handle != INVALID_HANDLE_VALUE;
 	}
 
+	bool MappedFile::ReadAt(U64 offset, void* buffer, size_t bytes)
+	{
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)(offset & 0xffffffffu);
+		overlapped.OffsetHigh = (DWORD)(offset >> 32u);
+		DWORD readed = 0;
+		BOOL success = ::ReadFile(handle, buffer, (DWORD)bytes, &readed, &overlapped);
+		return success && bytes == readed;
+	}
+
+	bool MappedFile::WriteAt(U64 offset, const void* buffer, size_t bytes)
+	{
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)(offset & 0xffffffffu);
+		overlapped.OffsetHigh = (DWORD)(offset >> 32u);
+		DWORD written = 0;
+		BOOL success = ::WriteFile(handle, buffer, (DWORD)bytes, &written, &overlapped);
+		if (success && bytes == written)
+		{
+			size = std::max(size, (size_t)(offset + bytes));
+			return true;
+		}
+		return false;
+	}
+
+	const U8* MappedFile::Map()
+	{
+		if (mappedData != nullptr)
+			return mappedData;
+
+		// Empty file can not be mapped
+		if (handle == INVALID_HANDLE_VALUE || size == 0 || !FLAG_ANY(flags, FileFlags::READ))
+			return nullptr;
+
+		mappingHandle = ::CreateFileMappingA((HANDLE)handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr)
+		{
+			Logger::Error("Failed to create file mapping, error:%x", ::GetLastError());
+			return nullptr;
+		}
+
+		mappedData = (const U8*)::MapViewOfFile((HANDLE)mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (mappedData == nullptr)
+		{
+			Logger::Error("Failed to map view of file, error:%x", ::GetLastError());
+			::CloseHandle((HANDLE)mappingHandle);
+			mappingHandle = nullptr;
+		}
+		return mappedData;
+	}
+
+	void MappedFile::Prefetch()const
+	{
+		if (mappedData == nullptr)
+			return;
+
+		SYSTEM_INFO info;
+		::GetSystemInfo(&info);
+		volatile U8 sum = 0;
+		for (size_t offset = 0; offset < size; offset += info.dwPageSize)
+			sum += mappedData[offset];
+	}
+
+	void MappedFile::Unmap()
+	{
+		if (mappedData != nullptr)
+		{
+			::UnmapViewOfFile(mappedData);
+			mappedData = nullptr;
+		}
+		if (mappingHandle != nullptr)
+		{
+			::CloseHandle((HANDLE)mappingHandle);
+			mappingHandle = nullptr;
+		}
+	}
+
 	void MappedFile::Close()
 	{
+		Unmap();
+
 		if (handle != INVALID_HANDLE_VALUE)
 		{
 			::FlushFileBuffers(handle);
@@ -46,6 +46,20 @@ namespace VulkanTest
 	{
 		return totalDeltaTime;
 	}
+
+	U64 Timer::GetRawTimestamp()
+	{
+		LARGE_INTEGER n;
+		QueryPerformanceCounter(&n);
+		return n.QuadPart;
+	}
+
+	U64 Timer::GetRawFrequency()
+	{
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		return f.QuadPart;
+	}
 }
 
 #endif
\ No newline at end of file
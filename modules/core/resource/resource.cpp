@@ -1,6 +1,7 @@
 #include "resource.h"
 #include "resourceManager.h"
 #include "core\utils\string.h"
+#include "core\utils\compression.h"
 
 namespace VulkanTest
 {
@@ -113,9 +114,13 @@ namespace VulkanTest
 		AsyncLoadCallback cb;
 		cb.Bind<&Resource::OnFileLoaded>(this);
 
+		// Compressed resource is decompressed on the io thread
+		AsyncLoadProcessor processor;
+		processor.Bind<&Resource::DecompressFile>();
+
 		const U64 pathHash = path.GetHashValue();
 		StaticString<MAX_PATH_LENGTH> fullResPath(".export/resources/", pathHash, ".res");
-		asyncHandle = fileSystem->LoadFileAsync(Path(fullResPath), cb);
+		asyncHandle = fileSystem->LoadFileAsync(Path(fullResPath), cb, AsyncLoadPriority::Normal, GetLoadFlags(), processor);
 	}
 
 	void Resource::DoUnload()
@@ -124,8 +129,7 @@ namespace VulkanTest
 		{
 			// Cancel when res is loading
 			FileSystem* fileSystem = resFactory.GetResourceManager().GetFileSystem();
-			// TODO
-			// fileSystem.Cancel(asyncHandle);
+			fileSystem->Cancel(asyncHandle);
 			asyncHandle = AsyncLoadHandle::INVALID;
 		}
 
@@ -177,6 +181,11 @@ namespace VulkanTest
 		emptyDepCount = 0;
 	}
 
+	AsyncLoadFlags Resource::GetLoadFlags()const
+	{
+		return AsyncLoadFlags::MEMORY_MAPPED_PREFETCH;
+	}
+
 #if DEBUG
 	bool Resource::NeedExport()const
 	{
@@ -237,8 +246,22 @@ namespace VulkanTest
 
 		if (resHeader->isCompressed)
 		{
-			ASSERT(0);
-			// TODO: Support LZ4 decompress
+			// Only the sync loading gets the compressed data
+			OutputMemoryStream decompressed;
+			if (!DecompressFile(size, mem, decompressed))
+			{
+				Logger::Error("Failed to decompress resource %s", GetPath().c_str());
+				failedDepCount++;
+				goto CHECK_STATE;
+			}
+
+			bool ret = OnLoaded(decompressed.Size() - sizeof(*resHeader), decompressed.Data() + sizeof(*resHeader));
+			if (ret == false)
+			{
+				Logger::Error("Failed to load resource %s", GetPath().c_str());
+				failedDepCount++;
+			}
+			resSize = resHeader->originSize;
 		}
 		else
 		{
@@ -258,6 +281,37 @@ namespace VulkanTest
 		asyncHandle = AsyncLoadHandle::INVALID;		
 	}
 
+	bool Resource::DecompressFile(U64 size, const U8* mem, OutputMemoryStream& output)
+	{
+		// Invalid header is reported in OnFileLoaded
+		if (size < sizeof(CompiledResourceHeader))
+			return true;
+
+		CompiledResourceHeader header;
+		memcpy(&header, mem, sizeof(header));
+		if (header.magic != CompiledResourceHeader::MAGIC ||
+			header.version != CompiledResourceHeader::VERSION ||
+			!header.isCompressed)
+			return true;
+
+		// Output is the uncompressed compiled resource
+		header.isCompressed = false;
+		output.Resize(sizeof(header) + header.originSize);
+		memcpy(output.Data(), &header, sizeof(header));
+
+		const I32 decompressedSize = LZ4::Decompress(
+			mem + sizeof(header),
+			output.Data() + sizeof(header),
+			(I32)(size - sizeof(header)),
+			(I32)header.originSize);
+		if (decompressedSize != (I32)header.originSize)
+		{
+			output.Clear();
+			return false;
+		}
+		return true;
+	}
+
 	void Resource::OnStateChanged(State oldState, State newState, Resource& res)
 	{
 		ASSERT(oldState != newState);
@@ -33,6 +33,9 @@ namespace VulkanTest
 		StringID type;
 	};
 
+	// Compiled resources are packed into it, loose files in .export/resources are the fallback
+	static constexpr const char* RESOURCE_PACK_PATH = ".export/resources/resources.pack";
+
 	struct VULKAN_TEST_API CompiledResourceHeader
 	{
 		static constexpr U32 MAGIC = 'FUCK';
@@ -111,6 +114,9 @@ namespace VulkanTest
 		using StateChangedCallback = DelegateList<void(State, State, Resource&)>;
 		StateChangedCallback& GetStateChangedCallback() { return cb; }
 
+		// Decompress the compiled resource file, the output is left empty if the file is not compressed
+		static bool DecompressFile(U64 size, const U8* mem, OutputMemoryStream& output);
+
 	protected:
 		Resource(const Path& path_, ResourceFactory& resFactory_);
 	
@@ -122,6 +128,9 @@ namespace VulkanTest
 		virtual bool OnLoaded(U64 size, const U8* mem) = 0;
 		virtual void OnUnLoaded() = 0;
 
+		// Flags of the async loading, the whole file is read on the io thread by default
+		virtual AsyncLoadFlags GetLoadFlags()const;
+
 #if DEBUG
 		virtual bool NeedExport()const;
 #endif
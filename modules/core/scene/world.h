@@ -92,7 +92,7 @@ namespace VulkanTest
 		template<typename T, typename Func>
 		void SetComponenetOnAdded(Func&& func)
 		{
-			world->SetComponenetOnAdded(ECS_MOV(func));
+			world->SetComponenetOnAdded<T>(ECS_MOV(func));
 		}
 
 		template<typename T, typename Func>
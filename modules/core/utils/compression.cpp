@@ -0,0 +1,371 @@
+#include "compression.h"
+#include "core\memory\memory.h"
+
+#include <memory>
+
+namespace VulkanTest
+{
+namespace LZ4
+{
+	static constexpr I32 MIN_MATCH = 4;
+	// The last 5 bytes are always literals and the last match starts 12 bytes before the end
+	static constexpr I32 LAST_LITERALS = 5;
+	static constexpr I32 MF_LIMIT = 12;
+	static constexpr I32 MAX_DISTANCE = 65535;
+	static constexpr U32 ML_MASK = 15;
+	static constexpr U32 RUN_MASK = 15;
+
+	static constexpr I32 WILD_COPY_LENGTH = 16;
+
+	static constexpr U32 HASH_LOG = 16;
+	static constexpr U32 HC_HASH_LOG = 15;
+	static constexpr U32 HC_CHAIN_SIZE = 1 << 16;
+
+	static inline U32 Read32(const U8* ptr)
+	{
+		U32 ret;
+		memcpy(&ret, ptr, sizeof(ret));
+		return ret;
+	}
+
+	static inline U32 HashSequence(U32 sequence, U32 hashLog)
+	{
+		return (sequence * 2654435761u) >> (32 - hashLog);
+	}
+
+	static inline I32 CountMatch(const U8* ip, const U8* ref, const U8* limit)
+	{
+		const U8* start = ip;
+		while (ip + 4 <= limit)
+		{
+			const U32 diff = Read32(ip) ^ Read32(ref);
+			if (diff != 0)
+				return (I32)(ip - start) + (I32)(TrailingZeroes(diff) >> 3);
+			ip += 4;
+			ref += 4;
+		}
+		while (ip < limit && *ip == *ref)
+		{
+			ip++;
+			ref++;
+		}
+		return (I32)(ip - start);
+	}
+
+	static inline U8* WriteLength(U8* op, U32 length)
+	{
+		while (length >= 255)
+		{
+			*op++ = 255;
+			length -= 255;
+		}
+		*op++ = (U8)length;
+		return op;
+	}
+
+	// Return nullptr if the dst capacity is not enough
+	static U8* WriteSequence(U8* op, const U8* oend, const U8* anchor, U32 literalLength, U32 offset, U32 matchLength)
+	{
+		// token + literal length + literals + offset + match length
+		const U64 maxSize = 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+		if ((U64)(oend - op) < maxSize)
+			return nullptr;
+
+		U8* token = op++;
+		if (literalLength >= RUN_MASK)
+		{
+			*token = (U8)(RUN_MASK << 4);
+			op = WriteLength(op, literalLength - RUN_MASK);
+		}
+		else
+		{
+			*token = (U8)(literalLength << 4);
+		}
+		memcpy(op, anchor, literalLength);
+		op += literalLength;
+
+		*op++ = (U8)offset;
+		*op++ = (U8)(offset >> 8);
+
+		matchLength -= MIN_MATCH;
+		if (matchLength >= ML_MASK)
+		{
+			*token |= (U8)ML_MASK;
+			op = WriteLength(op, matchLength - ML_MASK);
+		}
+		else
+		{
+			*token |= (U8)matchLength;
+		}
+		return op;
+	}
+
+	static U8* WriteLastLiterals(U8* op, const U8* oend, const U8* anchor, U32 literalLength)
+	{
+		const U64 maxSize = 1 + literalLength / 255 + 1 + literalLength;
+		if ((U64)(oend - op) < maxSize)
+			return nullptr;
+
+		if (literalLength >= RUN_MASK)
+		{
+			*op++ = (U8)(RUN_MASK << 4);
+			op = WriteLength(op, literalLength - RUN_MASK);
+		}
+		else
+		{
+			*op++ = (U8)(literalLength << 4);
+		}
+		memcpy(op, anchor, literalLength);
+		return op + literalLength;
+	}
+
+	// Greedy matching with a single entry hash table
+	static I32 CompressFast(const U8* src, U8* dst, I32 srcSize, I32 dstCapacity)
+	{
+		const U8* ip = src;
+		const U8* anchor = src;
+		const U8* iend = src + srcSize;
+		U8* op = dst;
+		const U8* oend = dst + dstCapacity;
+
+		if (srcSize > MF_LIMIT)
+		{
+			const U8* mflimit = iend - MF_LIMIT;
+			const U8* matchLimit = iend - LAST_LITERALS;
+			std::unique_ptr<I32[]> hashTable(new I32[1 << HASH_LOG]);
+			for (U32 i = 0; i < (1 << HASH_LOG); i++)
+				hashTable[i] = -1;
+
+			U32 searchCount = 0;
+			ip++;
+			while (ip < mflimit)
+			{
+				const U32 h = HashSequence(Read32(ip), HASH_LOG);
+				const I32 refPos = hashTable[h];
+				hashTable[h] = (I32)(ip - src);
+
+				if (refPos < 0 || (ip - src) - refPos > MAX_DISTANCE || Read32(src + refPos) != Read32(ip))
+				{
+					// Skip faster over incompressible data
+					ip += 1 + (searchCount++ >> 6);
+					continue;
+				}
+				searchCount = 0;
+
+				const U8* ref = src + refPos;
+				while (ip > anchor && ref > src && ip[-1] == ref[-1])
+				{
+					ip--;
+					ref--;
+				}
+
+				const I32 matchLength = MIN_MATCH + CountMatch(ip + MIN_MATCH, ref + MIN_MATCH, matchLimit);
+				op = WriteSequence(op, oend, anchor, (U32)(ip - anchor), (U32)(ip - ref), (U32)matchLength);
+				if (op == nullptr)
+					return 0;
+
+				ip += matchLength;
+				anchor = ip;
+
+				if (ip < mflimit)
+					hashTable[HashSequence(Read32(ip - 2), HASH_LOG)] = (I32)(ip - 2 - src);
+			}
+		}
+
+		op = WriteLastLiterals(op, oend, anchor, (U32)(iend - anchor));
+		return op != nullptr ? (I32)(op - dst) : 0;
+	}
+
+	// Search the longest match in the hash chains, the search depth grows with the level
+	static I32 CompressHC(const U8* src, U8* dst, I32 srcSize, I32 dstCapacity, I32 level)
+	{
+		const U8* ip = src;
+		const U8* anchor = src;
+		const U8* iend = src + srcSize;
+		U8* op = dst;
+		const U8* oend = dst + dstCapacity;
+
+		if (srcSize > MF_LIMIT)
+		{
+			const U8* mflimit = iend - MF_LIMIT;
+			const U8* matchLimit = iend - LAST_LITERALS;
+			const U32 maxAttempts = 1u << (std::min(level, MAX_HC_LEVEL) - 1);
+			std::unique_ptr<I32[]> hashTable(new I32[1 << HC_HASH_LOG]);
+			std::unique_ptr<U16[]> chainTable(new U16[HC_CHAIN_SIZE]);
+			for (U32 i = 0; i < (1 << HC_HASH_LOG); i++)
+				hashTable[i] = -1;
+			memset(chainTable.get(), 0, sizeof(U16) * HC_CHAIN_SIZE);
+
+			I32 nextToUpdate = 0;
+			while (ip < mflimit)
+			{
+				const I32 pos = (I32)(ip - src);
+				for (; nextToUpdate < pos; nextToUpdate++)
+				{
+					const U32 h = HashSequence(Read32(src + nextToUpdate), HC_HASH_LOG);
+					const I32 delta = hashTable[h] < 0 ? 0 : nextToUpdate - hashTable[h];
+					chainTable[nextToUpdate & (HC_CHAIN_SIZE - 1)] = (U16)std::min(delta, MAX_DISTANCE);
+					hashTable[h] = nextToUpdate;
+				}
+
+				const U32 sequence = Read32(ip);
+				I32 candidate = hashTable[HashSequence(sequence, HC_HASH_LOG)];
+				I32 bestLength = 0;
+				const U8* bestRef = nullptr;
+				for (U32 attempts = 0; attempts < maxAttempts && candidate >= 0 && pos - candidate <= MAX_DISTANCE; attempts++)
+				{
+					const U8* ref = src + candidate;
+					if (Read32(ref) == sequence && ref[bestLength] == ip[bestLength])
+					{
+						const I32 length = MIN_MATCH + CountMatch(ip + MIN_MATCH, ref + MIN_MATCH, matchLimit);
+						if (length > bestLength)
+						{
+							bestLength = length;
+							bestRef = ref;
+						}
+					}
+
+					const U16 delta = chainTable[candidate & (HC_CHAIN_SIZE - 1)];
+					if (delta == 0)
+						break;
+					candidate -= delta;
+				}
+
+				if (bestRef == nullptr)
+				{
+					ip++;
+					continue;
+				}
+
+				const U8* ref = bestRef;
+				while (ip > anchor && ref > src && ip[-1] == ref[-1])
+				{
+					ip--;
+					ref--;
+					bestLength++;
+				}
+
+				op = WriteSequence(op, oend, anchor, (U32)(ip - anchor), (U32)(ip - ref), (U32)bestLength);
+				if (op == nullptr)
+					return 0;
+
+				ip += bestLength;
+				anchor = ip;
+			}
+		}
+
+		op = WriteLastLiterals(op, oend, anchor, (U32)(iend - anchor));
+		return op != nullptr ? (I32)(op - dst) : 0;
+	}
+
+	I32 CompressBound(I32 inputSize)
+	{
+		if (inputSize < 0 || inputSize > MAX_INPUT_SIZE)
+			return 0;
+		return inputSize + inputSize / 255 + 16;
+	}
+
+	I32 Compress(const void* src, void* dst, I32 srcSize, I32 dstCapacity, I32 level)
+	{
+		if (srcSize < 0 || srcSize > MAX_INPUT_SIZE || dstCapacity <= 0)
+			return 0;
+
+		if (level >= MIN_HC_LEVEL)
+			return CompressHC((const U8*)src, (U8*)dst, srcSize, dstCapacity, level);
+		return CompressFast((const U8*)src, (U8*)dst, srcSize, dstCapacity);
+	}
+
+	I32 Decompress(const void* src, void* dst, I32 srcSize, I32 dstCapacity)
+	{
+		const U8* ip = (const U8*)src;
+		const U8* iend = ip + srcSize;
+		U8* op = (U8*)dst;
+		U8* oend = op + dstCapacity;
+
+		if (srcSize <= 0 || dstCapacity < 0)
+			return -1;
+
+		while (true)
+		{
+			const U32 token = *ip++;
+
+			// Literals
+			size_t length = token >> 4;
+			if (length == RUN_MASK)
+			{
+				U8 s;
+				do
+				{
+					if (ip >= iend)
+						return -1;
+					s = *ip++;
+					length += s;
+				} while (s == 255);
+			}
+			if ((size_t)(iend - ip) < length || (size_t)(oend - op) < length)
+				return -1;
+
+			// Short literals are copied in a fixed size block when there is enough room
+			if (length <= WILD_COPY_LENGTH && iend - ip >= WILD_COPY_LENGTH && oend - op >= WILD_COPY_LENGTH)
+				memcpy(op, ip, WILD_COPY_LENGTH);
+			else
+				memcpy(op, ip, length);
+			ip += length;
+			op += length;
+
+			// The last sequence only has literals
+			if (ip == iend)
+				break;
+
+			// Match
+			if (iend - ip < 2)
+				return -1;
+			const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > (size_t)(op - (U8*)dst))
+				return -1;
+
+			length = token & ML_MASK;
+			if (length == ML_MASK)
+			{
+				U8 s;
+				do
+				{
+					if (ip >= iend)
+						return -1;
+					s = *ip++;
+					length += s;
+				} while (s == 255);
+			}
+			length += MIN_MATCH;
+			if ((size_t)(oend - op) < length)
+				return -1;
+
+			const U8* match = op - offset;
+			if (offset >= 8 && (size_t)(oend - op) >= length + 8)
+			{
+				// Copy 8 bytes at a time, the source is always at least 8 bytes behind
+				U8* copyEnd = op + length;
+				do
+				{
+					memcpy(op, match, 8);
+					op += 8;
+					match += 8;
+				} while (op < copyEnd);
+				op = copyEnd;
+			}
+			else
+			{
+				// Overlapped copy repeats the pattern
+				for (size_t i = 0; i < length; i++)
+					*op++ = *match++;
+			}
+
+			if (ip >= iend)
+				return -1;
+		}
+
+		return (I32)(op - (U8*)dst);
+	}
+}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "core\common.h"
+
+namespace VulkanTest
+{
+	// LZ4 block format compressor, the output is compatible with LZ4_decompress_safe
+	namespace LZ4
+	{
+		static constexpr I32 MAX_INPUT_SIZE = 0x7E000000;
+		// Level 0 is the fast greedy compressor, levels [MIN_HC_LEVEL, MAX_HC_LEVEL] search hash chains
+		static constexpr I32 DEFAULT_LEVEL = 0;
+		static constexpr I32 MIN_HC_LEVEL = 1;
+		static constexpr I32 DEFAULT_HC_LEVEL = 9;
+		static constexpr I32 MAX_HC_LEVEL = 12;
+
+		VULKAN_TEST_API I32 CompressBound(I32 inputSize);
+
+		// Return the compressed size, or 0 if the dst capacity is not enough
+		VULKAN_TEST_API I32 Compress(const void* src, void* dst, I32 srcSize, I32 dstCapacity, I32 level = DEFAULT_LEVEL);
+
+		// Return the decompressed size, or -1 if the input is malformed or the dst capacity is not enough
+		VULKAN_TEST_API I32 Decompress(const void* src, void* dst, I32 srcSize, I32 dstCapacity);
+	}
+}
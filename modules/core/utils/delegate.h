@@ -50,6 +50,11 @@ namespace VulkanTest
 			func = &ClassMethod<C, Func>;
 		}
 
+		bool IsValid()const
+		{
+			return func != nullptr;
+		}
+
 		R Invoke(Args... args)const
 		{
 			ASSERT(func != nullptr);
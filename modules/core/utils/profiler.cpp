@@ -1,16 +1,54 @@
 #include "profiler.h"
 #include "platform\platform.h"
 #include "platform\sync.h"
+#include "platform\timer.h"
+#include "platform\file.h"
 #include "string.h"
+#include "stream.h"
 #include "core\memory\memory.h"
 
+#include <atomic>
+
 namespace VulkanTest
 {
+	enum class ProfileEventType : U8
+	{
+		BeginBlock,
+		EndBlock,
+		Frame
+	};
+
+	struct ProfileEvent
+	{
+		U64 time;
+		const char* name;
+		ProfileEventType type;
+	};
+
+	// Single producer ring buffer, the oldest events are overwritten when it is full
+	static constexpr U32 EVENT_BUFFER_SIZE = 1 << 15;
+	static constexpr U32 EVENT_BUFFER_MASK = EVENT_BUFFER_SIZE - 1;
+	static constexpr U32 MAX_OPEN_BLOCK_COUNT = 64;
+
 	struct ThreadLocalContext
 	{
 		StaticString<64> name;
 		Mutex mutex;
 		U32 threadID = 0;
+
+		// Only written by the owner thread
+		ProfileEvent events[EVENT_BUFFER_SIZE];
+		std::atomic<U64> eventEnd = 0;
+
+		const char* openBlocks[MAX_OPEN_BLOCK_COUNT];
+		U32 openBlockCount = 0;
+	};
+
+	struct ThreadSnapshot
+	{
+		StaticString<64> name;
+		U32 threadID = 0;
+		std::vector<ProfileEvent> events;
 	};
 
 	struct ProfilerImpl
@@ -18,18 +56,30 @@ namespace VulkanTest
 		Mutex mutex;
 		std::vector<ThreadLocalContext*> contexts;
 		DefaultAllocator allocator;
+		std::atomic<bool> isEnabled = true;
+		U64 frequency = 1;
+
+		std::atomic<bool> isSnapshotRequested = false;
+		std::vector<ThreadSnapshot> snapshot;
 
 		ProfilerImpl()
 		{
+			frequency = Timer::GetRawFrequency();
 		}
 
 		~ProfilerImpl()
 		{
+			for (auto ctx : contexts)
+			{
+				ctx->~ThreadLocalContext();
+				allocator.Free(ctx);
+			}
+			contexts.clear();
 		}
 
 		ThreadLocalContext* GetThreadLocalContext()
 		{
-			thread_local ThreadLocalContext* ctx = [&]() 
+			thread_local ThreadLocalContext* ctx = [&]()
 			{
 				void* mem = allocator.Allocate(sizeof(ThreadLocalContext));
 				ThreadLocalContext* newCtx = new(mem) ThreadLocalContext();
@@ -40,28 +90,235 @@ namespace VulkanTest
 			}();
 			return ctx;
 		}
+
+		void TakeSnapshot()
+		{
+			ScopedMutex lock(mutex);
+			snapshot.clear();
+			snapshot.resize(contexts.size());
+			for (size_t i = 0; i < contexts.size(); i++)
+			{
+				ThreadLocalContext* ctx = contexts[i];
+				ThreadSnapshot& threadSnapshot = snapshot[i];
+				{
+					ScopedMutex nameLock(ctx->mutex);
+					threadSnapshot.name = ctx->name;
+				}
+				threadSnapshot.threadID = ctx->threadID;
+
+				const U64 end = ctx->eventEnd.load(std::memory_order_acquire);
+				U64 begin = end > EVENT_BUFFER_SIZE ? end - EVENT_BUFFER_SIZE : 0;
+				threadSnapshot.events.resize(end - begin);
+				for (U64 pos = begin; pos < end; pos++)
+					threadSnapshot.events[pos - begin] = ctx->events[pos & EVENT_BUFFER_MASK];
+
+				// Drop the events which may be overwritten by the owner thread during copying
+				const U64 newEnd = ctx->eventEnd.load(std::memory_order_acquire);
+				if (newEnd + 1 > begin + EVENT_BUFFER_SIZE)
+				{
+					const U64 overwritten = std::min(end - begin, newEnd + 1 - EVENT_BUFFER_SIZE - begin);
+					threadSnapshot.events.erase(threadSnapshot.events.begin(), threadSnapshot.events.begin() + overwritten);
+				}
+			}
+		}
 	};
 	ProfilerImpl gImpl;
 
+	static void PushEvent(ThreadLocalContext* ctx, ProfileEventType type, const char* name)
+	{
+		const U64 pos = ctx->eventEnd.load(std::memory_order_relaxed);
+		ProfileEvent& ev = ctx->events[pos & EVENT_BUFFER_MASK];
+		ev.time = Timer::GetRawTimestamp();
+		ev.name = name;
+		ev.type = type;
+		ctx->eventEnd.store(pos + 1, std::memory_order_release);
+	}
+
 	void Profiler::SetThreadName(const char* name)
 	{
 		ThreadLocalContext* ctx = gImpl.GetThreadLocalContext();
+		ScopedMutex lock(ctx->mutex);
 		ctx->name = name;
 	}
 
+	void Profiler::SetEnabled(bool enabled)
+	{
+		gImpl.isEnabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool Profiler::IsEnabled()
+	{
+		return gImpl.isEnabled.load(std::memory_order_relaxed);
+	}
+
 	void Profiler::BeginFrame()
 	{
+		if (!gImpl.isEnabled.load(std::memory_order_relaxed))
+			return;
+
+		PushEvent(gImpl.GetThreadLocalContext(), ProfileEventType::Frame, "Frame");
 	}
 
 	void Profiler::EndFrame()
 	{
+		if (gImpl.isSnapshotRequested.exchange(false))
+			gImpl.TakeSnapshot();
 	}
+
 	void Profiler::BeginBlock(const char* name)
 	{
+		if (!gImpl.isEnabled.load(std::memory_order_relaxed))
+			return;
+
+		ThreadLocalContext* ctx = gImpl.GetThreadLocalContext();
+		if (ctx->openBlockCount < MAX_OPEN_BLOCK_COUNT)
+			ctx->openBlocks[ctx->openBlockCount] = name;
+		ctx->openBlockCount++;
+		PushEvent(ctx, ProfileEventType::BeginBlock, name);
 	}
+
 	void Profiler::EndBlock()
 	{
+		if (!gImpl.isEnabled.load(std::memory_order_relaxed))
+			return;
+
+		// Ignore the blocks which began before the profiler is enabled
+		ThreadLocalContext* ctx = gImpl.GetThreadLocalContext();
+		if (ctx->openBlockCount == 0)
+			return;
+
+		ctx->openBlockCount--;
+		PushEvent(ctx, ProfileEventType::EndBlock, nullptr);
 	}
-}
 
+	void Profiler::BeforeFiberSwitch(FiberSwitchData& data)
+	{
+		ThreadLocalContext* ctx = gImpl.GetThreadLocalContext();
+		const U32 count = std::min(ctx->openBlockCount, MAX_OPEN_BLOCK_COUNT);
+		data.count = std::min(count, MAX_FIBER_BLOCK_COUNT);
+		for (U32 i = 0; i < data.count; i++)
+			data.blocks[i] = ctx->openBlocks[count - data.count + i];
+
+		for (U32 i = 0; i < ctx->openBlockCount; i++)
+			PushEvent(ctx, ProfileEventType::EndBlock, nullptr);
+		ctx->openBlockCount = 0;
+	}
+
+	void Profiler::AfterFiberSwitch(const FiberSwitchData& data)
+	{
+		for (U32 i = 0; i < data.count; i++)
+			BeginBlock(data.blocks[i]);
+	}
+
+	void Profiler::RequestSnapshot()
+	{
+		gImpl.isSnapshotRequested = true;
+	}
+
+	bool Profiler::HasSnapshot()
+	{
+		ScopedMutex lock(gImpl.mutex);
+		return !gImpl.snapshot.empty();
+	}
+
+	size_t Profiler::GetEventBufferBytes()
+	{
+		ScopedMutex lock(gImpl.mutex);
+		return gImpl.contexts.size() * sizeof(ThreadLocalContext);
+	}
+
+	static void WriteJsonString(OutputMemoryStream& stream, const char* str)
+	{
+		stream << "\"";
+		for (const char* c = str; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				stream << "\\";
+			stream.Write(c, 1);
+		}
+		stream << "\"";
+	}
+
+	static void WriteTimestamp(OutputMemoryStream& stream, U64 time, U64 startTime)
+	{
+		// Microseconds with nanosecond precision
+		const U64 ns = (U64)((F64)(time - startTime) * 1000000000.0 / (F64)gImpl.frequency);
+		char fraction[4] = {
+			char('0' + (ns / 100) % 10),
+			char('0' + (ns / 10) % 10),
+			char('0' + ns % 10),
+			'\0'
+		};
+		stream << (ns / 1000) << "." << fraction;
+	}
+
+	bool Profiler::ExportChromeTrace(const char* path)
+	{
+		ScopedMutex lock(gImpl.mutex);
+		if (gImpl.snapshot.empty())
+			return false;
+
+		U64 startTime = std::numeric_limits<U64>::max();
+		for (const auto& threadSnapshot : gImpl.snapshot)
+		{
+			if (!threadSnapshot.events.empty())
+				startTime = std::min(startTime, threadSnapshot.events[0].time);
+		}
+
+		OutputMemoryStream stream;
+		stream << "{\"traceEvents\":[\n";
+		bool isFirst = true;
+		for (const auto& threadSnapshot : gImpl.snapshot)
+		{
+			if (!isFirst)
+				stream << ",\n";
+			isFirst = false;
+
+			stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threadSnapshot.threadID << ",\"args\":{\"name\":";
+			WriteJsonString(stream, threadSnapshot.name.empty() ? "Thread" : threadSnapshot.name.c_str());
+			stream << "}}";
+
+			// Skip end events whose begin events are already overwritten
+			U32 depth = 0;
+			for (const auto& ev : threadSnapshot.events)
+			{
+				switch (ev.type)
+				{
+				case ProfileEventType::BeginBlock:
+					stream << ",\n{\"name\":";
+					WriteJsonString(stream, ev.name);
+					stream << ",\"ph\":\"B\",\"pid\":0,\"tid\":" << threadSnapshot.threadID << ",\"ts\":";
+					WriteTimestamp(stream, ev.time, startTime);
+					stream << "}";
+					depth++;
+					break;
+				case ProfileEventType::EndBlock:
+					if (depth == 0)
+						break;
+					stream << ",\n{\"ph\":\"E\",\"pid\":0,\"tid\":" << threadSnapshot.threadID << ",\"ts\":";
+					WriteTimestamp(stream, ev.time, startTime);
+					stream << "}";
+					depth--;
+					break;
+				case ProfileEventType::Frame:
+					stream << ",\n{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":" << threadSnapshot.threadID << ",\"ts\":";
+					WriteTimestamp(stream, ev.time, startTime);
+					stream << "}";
+					break;
+				}
+			}
+		}
+		stream << "\n]}\n";
 
+		MappedFile file(path, FileFlags::DEFAULT_WRITE);
+		if (!file.IsValid())
+		{
+			Logger::Error("Failed to export profiler trace:%s", path);
+			return false;
+		}
+
+		bool ret = file.Write(stream.Data(), stream.Size());
+		file.Close();
+		return ret;
+	}
+}
@@ -6,12 +6,36 @@ namespace VulkanTest
 {
 	namespace Profiler
 	{
+		static constexpr U32 MAX_FIBER_BLOCK_COUNT = 16;
+
 		void SetThreadName(const char* name);
+		void SetEnabled(bool enabled);
+		bool IsEnabled();
 		void BeginFrame();
 		void EndFrame();
 		void BeginBlock(const char* name);
 		void EndBlock();
 
+		// Blocks are recorded per thread, a fiber closes its open blocks before it is switched out
+		// and reopens them on the thread it is resumed on
+		struct FiberSwitchData
+		{
+			U32 count = 0;
+			const char* blocks[MAX_FIBER_BLOCK_COUNT];
+		};
+		void BeforeFiberSwitch(FiberSwitchData& data);
+		void AfterFiberSwitch(const FiberSwitchData& data);
+
+		// Copy the recorded events of all threads at the end of the current frame
+		void RequestSnapshot();
+		bool HasSnapshot();
+
+		// Export the last snapshot as chrome trace json (chrome://tracing)
+		bool ExportChromeTrace(const char* path);
+
+		// Memory of the event ring buffers of all recorded threads
+		size_t GetEventBufferBytes();
+
 		struct Scope
 		{
 			explicit Scope(const char* name) { BeginBlock(name); }
@@ -121,8 +121,8 @@ namespace VulkanTest
 		if (rhs.capacity > 0)
 		{
 			data = (U8*)CJING_MALLOC(rhs.capacity);
-			Memory::Memcpy(data, rhs.data, capacity);
 			capacity = rhs.capacity;
+			Memory::Memcpy(data, rhs.data, capacity);
 		}
 		else
 		{
@@ -145,8 +145,8 @@ namespace VulkanTest
 		if (rhs.capacity > 0)
 		{
 			data = (U8*)CJING_MALLOC(rhs.capacity);
-			Memory::Memcpy(data, rhs.data, capacity);
 			capacity = rhs.capacity;
+			Memory::Memcpy(data, rhs.data, capacity);
 		}
 		else
 		{
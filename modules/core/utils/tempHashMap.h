@@ -1,25 +1,24 @@
 #pragma once
 
-#include <list>
 #include <vector>
-#include <unordered_map>
 
 #include "math\hash.h"
 #include "objectPool.h"
+#include "core\collections\intrusiveHashMap.hpp"
 
 namespace VulkanTest
 {
     namespace Util
     {
         template <typename T>
-        class TempHashMapItem
+        class TempHashMapItem : public IntrusiveListNode<T>
         {
         public:
             void SetHash(HashValue hash_)
             {
                 hash = hash_;
             }
-            HashValue GetHash()
+            HashValue GetHash() const
             {
                 return hash;
             }
@@ -38,15 +37,27 @@ namespace VulkanTest
             unsigned index = 0;
         };
 
+        // Temporary objects which are released if they are not requested during RingSize frames.
+        // Objects are linked into the ring of the frame they were last requested in, a hit is
+        // relinked into the current ring in O(1), lookup is done by a linear probing table.
         template <typename T, size_t RingSize, bool Reuse = false>
         class TempHashMap
         {
         private:
+            static const U32 INITIAL_CAPACITY = 64;
+
+            struct Slot
+            {
+                HashValue hash = 0;
+                T* node = nullptr;
+            };
+
             U32 ringIndex = 0;
             ObjectPool<T> objectPool;
-            std::unordered_map<HashValue, T *> hashMap;
+            std::vector<Slot> slots;
+            U32 count = 0;
             std::vector<T *> vacants;
-            std::list<T *> rings[RingSize];
+            IntrusiveList<T> rings[RingSize];
 
             template <bool reuse>
             struct ReuseTag
@@ -63,6 +74,102 @@ namespace VulkanTest
                 vacants.push_back(object);
             }
 
+            U32 GetHashMask() const
+            {
+                return (U32)slots.size() - 1;
+            }
+
+            T* Find(HashValue hash) const
+            {
+                if (slots.empty())
+                    return nullptr;
+
+                const U32 mask = GetHashMask();
+                for (U32 pos = hash & mask; slots[pos].node != nullptr; pos = (pos + 1) & mask)
+                {
+                    if (slots[pos].hash == hash)
+                        return slots[pos].node;
+                }
+                return nullptr;
+            }
+
+            void InsertInner(T* node)
+            {
+                const U32 mask = GetHashMask();
+                const HashValue hash = node->GetHash();
+                U32 pos = hash & mask;
+                while (slots[pos].node != nullptr)
+                    pos = (pos + 1) & mask;
+
+                slots[pos].hash = hash;
+                slots[pos].node = node;
+            }
+
+            void Insert(T* node)
+            {
+                ASSERT(Find(node->GetHash()) == nullptr);
+
+                // Keep the load factor under 0.5, so the probe sequences are short
+                if ((count + 1) * 2 > slots.size())
+                {
+                    std::vector<Slot> oldSlots = std::move(slots);
+                    slots.clear();
+                    slots.resize(oldSlots.empty() ? INITIAL_CAPACITY : oldSlots.size() * 2);
+                    for (const Slot& slot : oldSlots)
+                    {
+                        if (slot.node != nullptr)
+                            InsertInner(slot.node);
+                    }
+                }
+
+                InsertInner(node);
+                count++;
+            }
+
+            void Erase(T* node)
+            {
+                const U32 mask = GetHashMask();
+                U32 pos = node->GetHash() & mask;
+                while (slots[pos].node != node)
+                {
+                    ASSERT(slots[pos].node != nullptr);
+                    pos = (pos + 1) & mask;
+                }
+
+                // Shift the following entries back instead of leaving a tombstone
+                U32 next = pos;
+                while (true)
+                {
+                    next = (next + 1) & mask;
+                    if (slots[next].node == nullptr)
+                        break;
+
+                    // Move the entry if its home slot is not in the range (pos, next]
+                    const U32 home = slots[next].hash & mask;
+                    const bool inRange = pos <= next ? (pos < home && home <= next) : (pos < home || home <= next);
+                    if (!inRange)
+                    {
+                        slots[pos] = slots[next];
+                        pos = next;
+                    }
+                }
+
+                slots[pos] = Slot();
+                count--;
+            }
+
+            void FreeRing(IntrusiveList<T>& ring)
+            {
+                auto it = ring.begin();
+                while (it != ring.end())
+                {
+                    T* node = it.get();
+                    it = ring.erase(it);
+                    objectPool.free(node);
+                }
+                ring.clear();
+            }
+
         public:
             ~TempHashMap()
             {
@@ -71,30 +178,31 @@ namespace VulkanTest
 
             void Clear()
             {
-                for (std::list<T *> &list : rings)
-                {
-                    for (auto &obj : list)
-                        objectPool.free(static_cast<T *>(obj));
-                    list.clear();
-                }
+                for (IntrusiveList<T> &ring : rings)
+                    FreeRing(ring);
 
                 for (auto &vacant : vacants)
                     objectPool.free(static_cast<T *>(vacant));
                 vacants.clear();
 
                 objectPool.clear();
-                hashMap.clear();
+                slots.clear();
+                count = 0;
             }
 
             void BeginFrame()
             {
-                ringIndex = (ringIndex + 1) % (RingSize - 1);
-                for (auto node : rings[ringIndex])
+                ringIndex = (ringIndex + 1) % RingSize;
+                IntrusiveList<T>& ring = rings[ringIndex];
+                auto it = ring.begin();
+                while (it != ring.end())
                 {
-                    hashMap.erase(node->GetHash());
+                    T* node = it.get();
+                    it = ring.erase(it);
+                    Erase(node);
                     FreeObject(node, ReuseTag<Reuse>());
                 }
-                rings[ringIndex].clear();
+                ring.clear();
             }
 
             template <typename... Args>
@@ -106,20 +214,15 @@ namespace VulkanTest
 
             T *Requset(HashValue hash)
             {
-                auto it = hashMap.find(hash);
-                if (it == hashMap.end())
+                T* ret = Find(hash);
+                if (ret == nullptr)
                     return nullptr;
 
-                T *ret = it->second;
                 if (ret->GetIndex() != ringIndex)
                 {
-                    auto it = std::find(rings[ret->GetIndex()].begin(), rings[ret->GetIndex()].end(), ret);
-                    if (it != rings[ret->GetIndex()].end())
-                    {
-                        rings[ret->GetIndex()].erase(it);
-                        rings[ringIndex].push_back(ret);
-                        ret->SetIndex(ringIndex);
-                    }
+                    rings[ret->GetIndex()].erase(ret);
+                    rings[ringIndex].insert_back(ret);
+                    ret->SetIndex(ringIndex);
                 }
 
                 return ret;
@@ -134,8 +237,8 @@ namespace VulkanTest
                 vacants.pop_back();
                 top->SetIndex(ringIndex);
                 top->SetHash(hash);
-                hashMap.insert(std::make_pair(hash, top));
-                rings[ringIndex].push_back(top);
+                Insert(top);
+                rings[ringIndex].insert_back(top);
                 return top;
             }
 
@@ -145,10 +248,15 @@ namespace VulkanTest
                 auto obj = objectPool.allocate(std::forward<Args>(args)...);
                 obj->SetHash(hash);
                 obj->SetIndex(ringIndex);
-                hashMap[hash] = obj;
-                rings[ringIndex].push_back(obj);
+                Insert(obj);
+                rings[ringIndex].insert_back(obj);
                 return obj;
             }
+
+            U32 Size() const
+            {
+                return count;
+            }
         };
     }
-}
\ No newline at end of file
+}
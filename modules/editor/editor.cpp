@@ -18,11 +18,14 @@
 #include "imgui-docking\imgui.h"
 #include "renderer\imguiRenderer.h"
 #include "renderer\model.h"
+#include "renderer\renderScene.h"
 
 namespace VulkanTest
 {
 namespace Editor
 {
+    static const char* PROFILER_TRACE_PATH = ".export/profiler_trace.json";
+
     class EditorAppImpl final : public EditorApp
     {
     public:
@@ -326,6 +329,7 @@ namespace Editor
         {
             PROFILE_BLOCK("Update");
             ProcessDeferredDestroyWindows();
+            UpdateProfilerTrace();
            
             // Begin imgui frame
             ImGuiRenderer::BeginFrame();
@@ -563,6 +567,15 @@ namespace Editor
                 fpsTxt << (U32)rect.width << "x" << (U32)rect.height;
                 fpsTxt << " FPS: ";
                 fpsTxt << (U32)(fps + 0.5f);
+
+                // Bytes copied to the GPU scene buffers by the last frame
+                World* world = worldEditor->GetWorld();
+                RenderScene* scene = world != nullptr ? dynamic_cast<RenderScene*>(world->GetScene("Renderer")) : nullptr;
+                if (scene != nullptr)
+                {
+                    fpsTxt << " | Upload: ";
+                    fpsTxt << (U32)(scene->GetUploadedBytes() / 1024) << "KB";
+                }
                 auto stats_size = ImGui::CalcTextSize(fpsTxt);
                 ImGui::SameLine(ImGui::GetContentRegionMax().x - stats_size.x);
                 ImGui::Text("%s", (const char*)fpsTxt);
@@ -593,6 +606,8 @@ namespace Editor
             ImGui::MenuItem(ICON_FA_COMMENT_ALT "Log", nullptr, &logWidget->isOpen);
             ImGui::MenuItem(ICON_FA_STREAM "EntityList", nullptr, &entityListWidget->isOpen);
             ImGui::MenuItem(ICON_FA_STREAM "EditorSetting", nullptr, &settings.isOpen);
+            ImGui::Separator();
+            OnActionMenuItem("CaptureProfilerTrace");
             ImGui::EndMenu();
         }
 
@@ -649,6 +664,29 @@ namespace Editor
                 isSelected.Bind<&Gizmo::Config::IsRotateMode>(&gizmoConfig);
             AddAction<&EditorAppImpl::SetScaleGizmoMode>("SetScaleGizmoMode", ICON_FA_EXPAND_ALT, "Set scale mode").
                 isSelected.Bind<&Gizmo::Config::IsScaleMode>(&gizmoConfig);
+
+            // Profiler
+            AddAction<&EditorAppImpl::CaptureProfilerTrace>("CaptureProfilerTrace").shortcut = Platform::Keycode::F11;
+        }
+
+        void UpdateProfilerTrace()
+        {
+            // The shortcut triggers once per press
+            Utils::Action* captureAction = GetAction("CaptureProfilerTrace");
+            const bool isCaptureDown = captureAction != nullptr && captureAction->IsActive();
+            if (isCaptureDown && !isCaptureKeyDown)
+                captureAction->func.Invoke();
+            isCaptureKeyDown = isCaptureDown;
+
+            // The snapshot is taken at the end of the frame of the request
+            if (traceExportCountdown > 0 && --traceExportCountdown == 0)
+            {
+                if (Profiler::ExportChromeTrace(PROFILER_TRACE_PATH))
+                {
+                    Logger::Info("Profiler trace exported to %s, event buffers:%d KB",
+                        PROFILER_TRACE_PATH, (U32)(Profiler::GetEventBufferBytes() / 1024));
+                }
+            }
         }
 
         void LoadPlugins()
@@ -768,6 +806,12 @@ namespace Editor
             gizmoConfig.mode = Gizmo::Config::Mode::SCALE;
         }
 
+        void CaptureProfilerTrace()
+        {
+            Profiler::RequestSnapshot();
+            traceExportCountdown = 1;
+        }
+
     private:
         Array<EditorPlugin*> plugins;
         Array<EditorWidget*> widgets;
@@ -777,6 +821,8 @@ namespace Editor
         Array<Utils::Action*> actions;
         Settings settings;
         Gizmo::Config gizmoConfig;
+        bool isCaptureKeyDown = false;
+        U32 traceExportCountdown = 0;
 
         // Windows
         Platform::WindowType mainWindow;
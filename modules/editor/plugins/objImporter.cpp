@@ -454,6 +454,30 @@ namespace Editor
 		editor.GetAssetCompiler().WriteCompiled(filepath, Span(outMem.Data(), outMem.Size()));
 	}
 
+	// The import config of the texture is written into its meta file
+	void OBJImporter::WriteTextureMeta(const ImportTexture& texture)
+	{
+		if (!texture.isValid || !texture.import || texture.path.empty())
+			return;
+
+		FileSystem& fs = editor.GetEngine().GetFileSystem();
+		const StaticString<MAX_PATH_LENGTH> metaPath(texture.path.c_str(), ".meta");
+		if (fs.FileExists(metaPath))
+			return;
+
+		auto file = fs.OpenFile(metaPath, FileFlags::DEFAULT_WRITE);
+		if (!file->IsValid())
+		{
+			Logger::Error("Failed to create meta file %s", metaPath.c_str());
+			return;
+		}
+
+		// Normal maps are not color data
+		file->Write(texture.toDDS ? "compress = true\n" : "compress = false\n");
+		file->Write(texture.type == Texture::NORMAL ? "srgb = false\n" : "srgb = true\n");
+		file->Close();
+	}
+
 	void OBJImporter::WriteMaterials(const char* filepath, const ImportConfig& cfg)
 	{
 		PROFILE_FUNCTION();
@@ -465,6 +489,9 @@ namespace Editor
 			if (!material.import)
 				continue;
 
+			for (const auto& texture : material.textures)
+				WriteTextureMeta(texture);
+
 			const auto& matName = material.material->name;
 			StaticString<MAX_PATH_LENGTH> matPath(pathInfo.dir, matName, ".mat");
 			if (fs.FileExists(matPath.c_str()))
@@ -48,7 +48,7 @@ namespace Editor
 		{
 			Texture::TextureType type;
 			bool import = true;
-			bool toDDS = true;
+			bool toDDS = true;	// Block compressed by the texture importer
 			bool isValid = false;
 			StaticString<MAX_PATH_LENGTH> path;
 		};
@@ -71,6 +71,7 @@ namespace Editor
 		void WriteMesh(const char* src, const ImportMesh& mesh);
 		void WriteMeshes(const char* src, I32 meshIdx, const ImportConfig& cfg);
 		void WriteGeometry(const ImportConfig& cfg);
+		void WriteTextureMeta(const ImportTexture& texture);
 		bool AreIndices16Bit(const ImportMesh& mesh) const;
 		I32 GetAttributeCount(const ImportMesh& mesh)const;
 
@@ -5,6 +5,7 @@
 #include "renderer\model.h"
 #include "renderer\material.h"
 #include "objImporter.h"
+#include "textureImporter.h"
 
 namespace VulkanTest
 {
@@ -28,6 +29,11 @@ namespace Editor
 			return app.GetAssetCompiler().CopyCompile(path);
 		}
 
+		bool IsThreadSafe()const override
+		{
+			return true;
+		}
+
 		std::vector<const char*> GetSupportExtensions()
 		{
 			return { "mat" };
@@ -96,6 +102,44 @@ namespace Editor
 		}
 	};
 
+	// Texture editor plugin
+	struct TexturePlugin final : AssetCompiler::IPlugin
+	{
+	private:
+		EditorApp& app;
+		TextureImporter textureImporter;
+
+	public:
+		TexturePlugin(EditorApp& app_) :
+			app(app_),
+			textureImporter(app_)
+		{
+			for (const char* ext : GetSupportExtensions())
+				app_.GetAssetCompiler().RegisterExtension(ext, Texture::ResType);
+		}
+
+		bool Compile(const Path& path)override
+		{
+			const TextureImporter::ImportConfig cfg = textureImporter.GetImportConfig(path);
+			if (!textureImporter.Import(path, cfg))
+			{
+				Logger::Error("Failed to import %s", path.c_str());
+				return false;
+			}
+			return true;
+		}
+
+		bool IsThreadSafe()const override
+		{
+			return true;
+		}
+
+		std::vector<const char*> GetSupportExtensions()
+		{
+			return { "png", "jpg", "tga", "bmp" };
+		}
+	};
+
 	struct RenderPlugin : EditorPlugin
 	{
 	private:
@@ -104,12 +148,14 @@ namespace Editor
 
 		ModelPlugin modelPlugin;
 		MaterialPlugin materialPlugin;
+		TexturePlugin texturePlugin;
 
 	public:
 		RenderPlugin(EditorApp& app_) :
 			app(app_),
 			modelPlugin(app_),
 			materialPlugin(app_),
+			texturePlugin(app_),
 			sceneView(app_)
 		{
 		}
@@ -119,6 +165,7 @@ namespace Editor
 			AssetCompiler& assetCompiler = app.GetAssetCompiler();
 			assetCompiler.RemovePlugin(modelPlugin);
 			assetCompiler.RemovePlugin(materialPlugin);
+			assetCompiler.RemovePlugin(texturePlugin);
 
 			app.RemoveWidget(sceneView);
 		}
@@ -128,6 +175,7 @@ namespace Editor
 			AssetCompiler& assetCompiler = app.GetAssetCompiler();
 			assetCompiler.AddPlugin(modelPlugin);
 			assetCompiler.AddPlugin(materialPlugin);
+			assetCompiler.AddPlugin(texturePlugin);
 
 			app.AddWidget(sceneView);
 
@@ -0,0 +1,389 @@
+#include "textureImporter.h"
+#include "editor\editor.h"
+#include "editor\widgets\assetCompiler.h"
+#include "core\filesystem\filesystem.h"
+#include "core\scripts\luaUtils.h"
+#include "core\utils\profiler.h"
+#include "gpu\vulkan\TextureFormatLayout.h"
+
+#include "stb\stb_image_include.h"
+
+#include <climits>
+
+namespace VulkanTest
+{
+namespace Editor
+{
+	struct MipImage
+	{
+		U32 width = 0;
+		U32 height = 0;
+		std::vector<U8> pixels;	// RGBA8
+
+		const U8* GetPixel(U32 x, U32 y)const
+		{
+			return pixels.data() + (y * width + x) * 4;
+		}
+	};
+
+	static F32 SrgbToLinear(U8 v)
+	{
+		static const auto table = []() {
+			std::array<F32, 256> ret;
+			for (U32 i = 0; i < 256; i++)
+			{
+				const F32 c = i / 255.0f;
+				ret[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return ret;
+		}();
+		return table[v];
+	}
+
+	static U8 LinearToSrgb(F32 v)
+	{
+		const F32 c = v <= 0.0031308f ? v * 12.92f : 1.055f * powf(v, 1.0f / 2.4f) - 0.055f;
+		return (U8)std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f);
+	}
+
+	// 2x2 box filter, the color channels are filtered in linear space for srgb textures
+	static void GenerateMip(const MipImage& src, MipImage& dst, bool srgb)
+	{
+		dst.width = std::max(src.width >> 1, 1u);
+		dst.height = std::max(src.height >> 1, 1u);
+		dst.pixels.resize(dst.width * dst.height * 4);
+
+		for (U32 y = 0; y < dst.height; y++)
+		{
+			const U32 y0 = std::min(y * 2, src.height - 1);
+			const U32 y1 = std::min(y * 2 + 1, src.height - 1);
+			for (U32 x = 0; x < dst.width; x++)
+			{
+				const U32 x0 = std::min(x * 2, src.width - 1);
+				const U32 x1 = std::min(x * 2 + 1, src.width - 1);
+				const U8* samples[4] = {
+					src.GetPixel(x0, y0),
+					src.GetPixel(x1, y0),
+					src.GetPixel(x0, y1),
+					src.GetPixel(x1, y1)
+				};
+
+				U8* out = dst.pixels.data() + (y * dst.width + x) * 4;
+				for (U32 c = 0; c < 4; c++)
+				{
+					if (srgb && c < 3)
+					{
+						F32 sum = 0.0f;
+						for (const U8* sample : samples)
+							sum += SrgbToLinear(sample[c]);
+						out[c] = LinearToSrgb(sum * 0.25f);
+					}
+					else
+					{
+						U32 sum = 0;
+						for (const U8* sample : samples)
+							sum += sample[c];
+						out[c] = (U8)((sum + 2) / 4);
+					}
+				}
+			}
+		}
+	}
+
+	static U16 ToRGB565(const U8* color)
+	{
+		return (U16)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+	}
+
+	static void FromRGB565(U16 v, U8* color)
+	{
+		const U32 r = (v >> 11) & 31;
+		const U32 g = (v >> 5) & 63;
+		const U32 b = v & 31;
+		color[0] = (U8)((r << 3) | (r >> 2));
+		color[1] = (U8)((g << 2) | (g >> 4));
+		color[2] = (U8)((b << 3) | (b >> 2));
+	}
+
+	// BC1 color block in the 4 colors mode, endpoints are the inset bounding box of the block
+	static void EncodeColorBlock(const U8* block, U8* out)
+	{
+		U8 minColor[3] = { 255, 255, 255 };
+		U8 maxColor[3] = { 0, 0, 0 };
+		for (U32 i = 0; i < 16; i++)
+		{
+			for (U32 c = 0; c < 3; c++)
+			{
+				minColor[c] = std::min(minColor[c], block[i * 4 + c]);
+				maxColor[c] = std::max(maxColor[c], block[i * 4 + c]);
+			}
+		}
+
+		for (U32 c = 0; c < 3; c++)
+		{
+			const U8 inset = (U8)((maxColor[c] - minColor[c]) >> 4);
+			minColor[c] += inset;
+			maxColor[c] -= inset;
+		}
+
+		U16 c0 = ToRGB565(maxColor);
+		U16 c1 = ToRGB565(minColor);
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		U32 indices = 0;
+		if (c0 != c1)
+		{
+			I32 palette[4][3];
+			U8 color[3];
+			FromRGB565(c0, color);
+			for (U32 c = 0; c < 3; c++)
+				palette[0][c] = color[c];
+			FromRGB565(c1, color);
+			for (U32 c = 0; c < 3; c++)
+				palette[1][c] = color[c];
+			for (U32 c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (U32 i = 0; i < 16; i++)
+			{
+				U32 bestIndex = 0;
+				I32 bestDist = INT_MAX;
+				for (U32 p = 0; p < 4; p++)
+				{
+					I32 dist = 0;
+					for (U32 c = 0; c < 3; c++)
+					{
+						const I32 d = block[i * 4 + c] - palette[p][c];
+						dist += d * d;
+					}
+					if (dist < bestDist)
+					{
+						bestDist = dist;
+						bestIndex = p;
+					}
+				}
+				indices |= bestIndex << (i * 2);
+			}
+		}
+
+		memcpy(out, &c0, 2);
+		memcpy(out + 2, &c1, 2);
+		memcpy(out + 4, &indices, 4);
+	}
+
+	// BC3 alpha block in the 8 alphas mode
+	static void EncodeAlphaBlock(const U8* block, U8* out)
+	{
+		U8 a0 = 0;
+		U8 a1 = 255;
+		for (U32 i = 0; i < 16; i++)
+		{
+			a0 = std::max(a0, block[i * 4 + 3]);
+			a1 = std::min(a1, block[i * 4 + 3]);
+		}
+
+		U64 indices = 0;
+		if (a0 != a1)
+		{
+			I32 palette[8];
+			palette[0] = a0;
+			palette[1] = a1;
+			for (I32 i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+			for (U32 i = 0; i < 16; i++)
+			{
+				U64 bestIndex = 0;
+				I32 bestDist = INT_MAX;
+				for (U32 p = 0; p < 8; p++)
+				{
+					const I32 dist = std::abs(block[i * 4 + 3] - palette[p]);
+					if (dist < bestDist)
+					{
+						bestDist = dist;
+						bestIndex = p;
+					}
+				}
+				indices |= bestIndex << (i * 3);
+			}
+		}
+
+		out[0] = a0;
+		out[1] = a1;
+		for (U32 i = 0; i < 6; i++)
+			out[2 + i] = (U8)(indices >> (i * 8));
+	}
+
+	static void CompressMip(const MipImage& mip, bool hasAlpha, U8* dst)
+	{
+		const U32 blocksX = (mip.width + 3) / 4;
+		const U32 blocksY = (mip.height + 3) / 4;
+		const U32 blockStride = hasAlpha ? 16 : 8;
+		U8 block[16 * 4];
+		for (U32 by = 0; by < blocksY; by++)
+		{
+			for (U32 bx = 0; bx < blocksX; bx++)
+			{
+				// Edge blocks repeat the last row and column
+				for (U32 y = 0; y < 4; y++)
+				{
+					for (U32 x = 0; x < 4; x++)
+					{
+						const U8* pixel = mip.GetPixel(std::min(bx * 4 + x, mip.width - 1), std::min(by * 4 + y, mip.height - 1));
+						memcpy(block + (y * 4 + x) * 4, pixel, 4);
+					}
+				}
+
+				U8* out = dst + (by * blocksX + bx) * blockStride;
+				if (hasAlpha)
+				{
+					EncodeAlphaBlock(block, out);
+					EncodeColorBlock(block, out + 8);
+				}
+				else
+				{
+					EncodeColorBlock(block, out);
+				}
+			}
+		}
+	}
+
+	TextureImporter::TextureImporter(EditorApp& editor_) :
+		editor(editor_)
+	{
+	}
+
+	TextureImporter::~TextureImporter()
+	{
+	}
+
+	TextureImporter::ImportConfig TextureImporter::GetImportConfig(const Path& path)const
+	{
+		// Meta file:
+		// compress = true
+		// srgb = false
+		// mips = true
+		ImportConfig cfg = {};
+		FileSystem& fs = editor.GetEngine().GetFileSystem();
+		const StaticString<MAX_PATH_LENGTH> metaPath(path.c_str(), ".meta");
+		OutputMemoryStream mem;
+		if (!fs.FileExists(metaPath) || !fs.LoadContext(metaPath, mem))
+			return cfg;
+
+		lua_State* l = luaL_newstate();
+		if (LuaUtils::LoadBuffer(l, (const char*)mem.Data(), mem.Size(), metaPath.c_str()))
+		{
+			auto GetBool = [l](const char* name, bool& value) {
+				lua_getglobal(l, name);
+				if (lua_type(l, -1) == LUA_TBOOLEAN)
+					value = lua_toboolean(l, -1) != 0;
+				lua_pop(l, 1);
+			};
+			GetBool("compress", cfg.compress);
+			GetBool("srgb", cfg.srgb);
+			GetBool("mips", cfg.mips);
+		}
+		else
+		{
+			Logger::Error("Failed to load meta file %s:%s", metaPath.c_str(), lua_tostring(l, -1));
+		}
+		lua_close(l);
+		return cfg;
+	}
+
+	bool TextureImporter::Import(const Path& path, const ImportConfig& cfg)
+	{
+		PROFILE_FUNCTION();
+		FileSystem& fs = editor.GetEngine().GetFileSystem();
+		OutputMemoryStream mem;
+		if (!fs.LoadContext(path.c_str(), mem))
+		{
+			Logger::Error("Failed to read texture %s", path.c_str());
+			return false;
+		}
+
+		int width = 0;
+		int height = 0;
+		int comp = 0;
+		stbi_uc* data = stbi_load_from_memory(mem.Data(), (int)mem.Size(), &width, &height, &comp, 4);
+		if (data == nullptr)
+		{
+			Logger::Error("Failed to decode texture %s:%s", path.c_str(), stbi_failure_reason());
+			return false;
+		}
+
+		Array<MipImage> mips;
+		mips.reserve(Texture::MAX_MIP_LEVELS);
+		MipImage& base = mips.emplace();
+		base.width = (U32)width;
+		base.height = (U32)height;
+		base.pixels.assign(data, data + width * height * 4);
+		stbi_image_free(data);
+
+		bool hasAlpha = false;
+		for (U32 i = 3; i < base.pixels.size() && !hasAlpha; i += 4)
+			hasAlpha = base.pixels[i] != 255;
+
+		if (cfg.mips)
+		{
+			while (mips.size() < Texture::MAX_MIP_LEVELS && (mips.back().width > 1 || mips.back().height > 1))
+			{
+				MipImage mip;
+				GenerateMip(mips.back(), mip, cfg.srgb);
+				mips.push_back(std::move(mip));
+			}
+		}
+
+		VkFormat format;
+		if (cfg.compress)
+		{
+			if (hasAlpha)
+				format = cfg.srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+			else
+				format = cfg.srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		}
+		else
+		{
+			format = cfg.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+		}
+
+		GPU::TextureFormatLayout layout;
+		layout.SetTexture2D(format, base.width, base.height, 1, mips.size());
+
+		Texture::FileHeader header;
+		header.magic = Texture::FILE_MAGIC;
+		header.version = Texture::FILE_VERSION;
+		header.format = (U32)format;
+		header.width = base.width;
+		header.height = base.height;
+		header.layers = 1;
+		header.levels = mips.size();
+		header.dataSize = layout.GetRequiredSize();
+		// Textures with mips are streamed, so they are stored uncompressed for the ranged reads
+		header.flags = mips.size() > 1 ? Texture::FILE_FLAG_STREAMABLE : 0;
+
+		OutputMemoryStream output;
+		output.Resize(sizeof(header) + header.dataSize);
+		memcpy(output.Data(), &header, sizeof(header));
+		memset(output.Data() + sizeof(header), 0, header.dataSize);
+		layout.SetBuffer(output.Data() + sizeof(header), header.dataSize);
+
+		// Write mips in the layout of the staging buffer
+		for (U32 level = 0; level < mips.size(); level++)
+		{
+			U8* dst = static_cast<U8*>(layout.Data(0, level));
+			if (cfg.compress)
+				CompressMip(mips[level], hasAlpha, dst);
+			else
+				memcpy(dst, mips[level].pixels.data(), mips[level].pixels.size());
+		}
+
+		const bool streamable = header.flags & Texture::FILE_FLAG_STREAMABLE;
+		return editor.GetAssetCompiler().WriteCompiled(path.c_str(), Span(output.Data(), output.Size()), !streamable);
+	}
+}
+}
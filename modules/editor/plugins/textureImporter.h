@@ -0,0 +1,33 @@
+#pragma once
+
+#include "editorPlugin.h"
+#include "renderer\texture.h"
+
+namespace VulkanTest
+{
+namespace Editor
+{
+	// Compile the source images (png, jpg, tga, bmp) into the compiled texture format,
+	// the mip chain is generated and block compressed offline
+	class TextureImporter
+	{
+	public:
+		TextureImporter(class EditorApp& editor_);
+		~TextureImporter();
+
+		// Import config, read from the meta file of the texture
+		struct ImportConfig
+		{
+			bool compress = true;	// BC1 or BC3 according to the alpha channel
+			bool srgb = true;
+			bool mips = true;
+		};
+
+		ImportConfig GetImportConfig(const Path& path)const;
+		bool Import(const Path& path, const ImportConfig& cfg);
+
+	private:
+		EditorApp& editor;
+	};
+}
+}
@@ -1,6 +1,9 @@
 #include "assetCompiler.h"
 #include "editor\editor.h"
 #include "core\platform\platform.h"
+#include "core\utils\compression.h"
+#include "core\jobsystem\jobsystem.h"
+#include "core\platform\timer.h"
 #include "imgui-docking\imgui.h"
 
 namespace VulkanTest
@@ -21,16 +24,26 @@ namespace Editor
     class AssetCompilerImpl;
 
     constexpr U32 COMPRESSION_SIZE_LIMIT = 4096;
+    // Keep the raw data if the compressed data is not small enough
+    constexpr F32 COMPRESSION_RATIO_LIMIT = 0.9f;
     constexpr U32 MAX_PROCESS_COMPILED_JOB_COUNT = 16;
+    // Part of the content hash, increase it to recompile all resources
+    constexpr U32 COMPILER_VERSION = 2;
+    constexpr U32 HASH_CACHE_VERSION = 2;
 
     #define EXPORT_RESOURCE_LIST ".export/resources/_list.list"
     #define EXPORT_RESOURCE_LIST_TEMP ".export/resources/_list.list_temp"
     #define EXPORT_RESOURCE_VERSION ".export/resources/_version.vs"
+    #define EXPORT_RESOURCE_HASH_CACHE ".export/resources/_hash.cache"
 
     struct CompileJob
     {
-        U32 generation;
+        U32 generation = 0;
         Path path;
+
+        bool operator==(const CompileJob& rhs)const {
+            return generation == rhs.generation && path == rhs.path;
+        }
     };
 
     struct LoadHook : public ResourceManager::LoadHook
@@ -41,17 +54,21 @@ namespace Editor
         AssetCompilerImpl& compiler;
     };
 
-    class CompilerTask final : public Thread
+    // The content hash of the compiled resource and the modified time of its source when the hash was checked,
+    // a source touched but unchanged is still up to date after the check
+    struct HashCacheEntry
     {
-    public:
-        CompilerTask(AssetCompilerImpl& impl_) :
-            impl(impl_)
-        {}
-
-        I32 Task() override;
+        U64 contentHash = 0;
+        U64 checkedTime = 0;
+    };
 
-        AssetCompilerImpl& impl;
-        bool isFinished = false;
+    struct PluginStats
+    {
+        AssetCompiler::IPlugin* plugin = nullptr;
+        const char* name = "";
+        U32 compiledCount = 0;
+        U32 skippedCount = 0;
+        F32 time = 0.0f;
     };
 
     class AssetCompilerImpl : public AssetCompiler
@@ -63,16 +80,38 @@ namespace Editor
         HashMap<U32, ResourceType> registeredExts;
 
         Array<CompileJob> toCompileJobs;
+        Array<CompileJob> compilingJobs;
+        Array<IPlugin*> compilingPlugins;
         Array<CompileJob> compiledJobs;
         Mutex toCompileMutex;
         Mutex compiledMutex;
-        HashMap<Path, Array<Path>> dependencies;
         U32 batchCompileCount = 0;
         U32 batchRemainningCount = 0;
 
+        // Compile tasks run on the background lane of the job system
+        Jobsystem::JobHandle compileHandle;
+        U32 runningTaskCount = 0;
+        U32 maxTaskCount = 1;
+        bool isFinished = false;
+
+        Mutex depMutex;
+        HashMap<Path, Array<Path>> dependencies;
+        // Reversed dependencies, the files which list the key as a dependent
+        HashMap<Path, Array<Path>> dependencyParents;
+
+        // Resources waiting for compiling, key is the path hash
+        Mutex hookedMutex;
+        HashMap<U64, Resource*> hookedResources;
+
+        // Content hash of the compiled resources, key is the path hash
+        Mutex hashCacheMutex;
+        HashMap<U64, HashCacheEntry> hashCache;
+
+        Mutex statsMutex;
+        Array<PluginStats> pluginStats;
+        Timer batchTimer;
+
         Mutex mutex;
-        CompilerTask compilerTask;
-        Semaphore semaphore;
         LoadHook lookHook;
 
         UniquePtr<Platform::FileSystemWatcher> watcher;
@@ -89,13 +128,12 @@ namespace Editor
 
         Path inprogressRes;
         bool initialized = false;
+        I32 compressionLevel = LZ4::DEFAULT_LEVEL;
 
     public:
         AssetCompilerImpl(EditorApp& editor_) : 
             editor(editor_),
-            lookHook(*this),
-            semaphore(0, 0xFFff),
-            compilerTask(*this)
+            lookHook(*this)
         {
             Engine& engine = editor.GetEngine();
             FileSystem& fs = engine.GetFileSystem();
@@ -103,8 +141,7 @@ namespace Editor
             watcher = Platform::FileSystemWatcher::Create(fs.GetBasePath());
             watcher->GetCallback().Bind<&AssetCompilerImpl::OnFileChanged>(this);
 
-            // Setup compiler task
-            compilerTask.Create("CompilerTask");
+            maxTaskCount = std::max(1u, Jobsystem::GetBackgroundWorkerCount());
 
             // Check the export director
             const char* basePath = fs.GetBasePath();
@@ -129,6 +166,9 @@ namespace Editor
                 file->Close();
             }
 
+            // Compiled resources are appended into the pack, the read-only pack of the engine is reopened as writable
+            fs.MountPack(RESOURCE_PACK_PATH, true);
+
             // Check the version file
             auto file = fs.OpenFile(EXPORT_RESOURCE_VERSION, FileFlags::DEFAULT_READ);
             if (!file->IsValid())
@@ -145,6 +185,8 @@ namespace Editor
                 return;
             }
 
+            LoadHashCache();
+
             // Set load hook of the resource manager
             ResourceManager& resManager = engine.GetResourceManager();
             resManager.SetLoadHook(&lookHook);
@@ -152,8 +194,29 @@ namespace Editor
 
         ~AssetCompilerImpl()
         {
+            // Wait for the running compile tasks
+            {
+                ScopedMutex lock(toCompileMutex);
+                isFinished = true;
+            }
+            Jobsystem::Wait(&compileHandle);
+
+            // Release the resources still waiting for compiling
+            {
+                ScopedMutex lock(hookedMutex);
+                for (Resource* res : hookedResources)
+                    res->Release();
+                hookedResources.clear();
+            }
+
             Engine& engine = editor.GetEngine();
             FileSystem& fs = engine.GetFileSystem();
+            fs.FlushPack();
+            SaveHashCache();
+
+            ResourceManager& resManager = engine.GetResourceManager();
+            resManager.SetLoadHook(nullptr);
+
             auto file = fs.OpenFile(EXPORT_RESOURCE_LIST_TEMP, FileFlags::DEFAULT_WRITE);
             if (!file->IsValid())
             {
@@ -197,13 +260,62 @@ namespace Editor
             file->Close();
             fs.DeleteFile(EXPORT_RESOURCE_LIST);
             fs.MoveFile(EXPORT_RESOURCE_LIST_TEMP, EXPORT_RESOURCE_LIST);
+        }
 
-            compilerTask.isFinished = true;
-            semaphore.Signal();
-            compilerTask.Destroy();
+        void LoadHashCache()
+        {
+            FileSystem& fs = editor.GetEngine().GetFileSystem();
+            if (!fs.FileExists(EXPORT_RESOURCE_HASH_CACHE))
+                return;
 
-            ResourceManager& resManager = engine.GetResourceManager();
-            resManager.SetLoadHook(nullptr);
+            auto file = fs.OpenFile(EXPORT_RESOURCE_HASH_CACHE, FileFlags::DEFAULT_READ);
+            if (!file->IsValid())
+                return;
+
+            U32 version = 0;
+            U32 count = 0;
+            file->Read(version);
+            file->Read(count);
+            if (version == HASH_CACHE_VERSION)
+            {
+                ScopedMutex lock(hashCacheMutex);
+                for (U32 i = 0; i < count; i++)
+                {
+                    U64 pathHash = 0;
+                    HashCacheEntry entry;
+                    file->Read(pathHash);
+                    file->Read(entry.contentHash);
+                    file->Read(entry.checkedTime);
+                    hashCache.insert(pathHash, entry);
+                }
+            }
+            file->Close();
+        }
+
+        void SaveHashCache()
+        {
+            FileSystem& fs = editor.GetEngine().GetFileSystem();
+            auto file = fs.OpenFile(EXPORT_RESOURCE_HASH_CACHE, FileFlags::DEFAULT_WRITE);
+            if (!file->IsValid())
+            {
+                Logger::Error("Failed to save the hash cache of resources");
+                return;
+            }
+
+            ScopedMutex lock(hashCacheMutex);
+            U32 count = 0;
+            for (auto it = hashCache.begin(); it != hashCache.end(); ++it)
+                count++;
+
+            file->Write(HASH_CACHE_VERSION);
+            file->Write(count);
+            for (auto it = hashCache.begin(); it != hashCache.end(); ++it)
+            {
+                file->Write(it.key());
+                file->Write(it.value().contentHash);
+                file->Write(it.value().checkedTime);
+            }
+            file->Close();
         }
 
         void InitFinished() override
@@ -260,7 +372,7 @@ namespace Editor
                             else
                             {
                                 // Remove the export file if the original dose not exist
-                                MaxPathString exportPath(".export/Resources/", p.GetHashValue(), ".res");
+                                MaxPathString exportPath(".export/resources/", p.GetHashValue(), ".res");
                             }
                         }
                     });
@@ -276,6 +388,7 @@ namespace Editor
                     if (lua_type(l, -1) != LUA_TTABLE)
                         return;
 
+                    ScopedMutex lock(depMutex);
                     lua_pushnil(l);
                     while (lua_next(l, -2) != 0)
                     {
@@ -289,8 +402,9 @@ namespace Editor
                         const char* key = lua_tostring(l, -2);
                         const Path path(key);
                         Array<Path>& deps = dependencies.emplace(path).value();
-                        LuaUtils::ForEachArrayItem<Path>(l, -1, "path list expected", [&deps](const Path& p) {
+                        LuaUtils::ForEachArrayItem<Path>(l, -1, "path list expected", [&](const Path& p) {
                             deps.push_back(p);
+                            AddDependencyParent(path, p);
                         });
                         lua_pop(l, 1);
                     }
@@ -304,43 +418,39 @@ namespace Editor
         void Update(F32 dt) override
         {
             // Process compiled jobs
-            for (int i = 0; i < MAX_PROCESS_COMPILED_JOB_COUNT; i++)
-            {
-                CompileJob compiled = PopCompiledQueue();
-                if (compiled.path.IsEmpty())
-                    break;
+            Array<CompileJob> compiledList;
+            PopCompiledQueue(compiledList, MAX_PROCESS_COMPILED_JOB_COUNT);
 
-                // Check the current generation of resource
-                U32 generation = 0;
+            // Remove the expired jobs
+            {
+                ScopedMutex lock(toCompileMutex);
+                for (I32 i = (I32)compiledList.size() - 1; i >= 0; i--)
                 {
-                    ScopedMutex lock(toCompileMutex);
-                    auto it = resGenerations.find(compiled.path.GetHashValue());
-                    generation = it.isValid() ? it.value() : 0;
+                    auto it = resGenerations.find(compiledList[i].path.GetHashValue());
+                    const U32 generation = it.isValid() ? it.value() : 0;
+                    if (generation != compiledList[i].generation)
+                        compiledList.swapAndPop(i);
                 }
-                if (generation != compiled.generation)
-                    continue;
+            }
 
+            Array<Path> dependents;
+            for (const CompileJob& compiled : compiledList)
+            {
                 // Continue loading resource
-                ScopedMutex lock(compiledMutex);
-                for (const auto& it : resources)
+                Resource* res = PopHookedResource(compiled.path);
+                if (res != nullptr)
                 {
-                    if (!EndsWith(it.path.c_str(), compiled.path.c_str()))
-                        continue;
-
-                    Resource* res = GetResource(compiled.path);
-                    if (res && res->IsHooked() && (!res->IsFailure() || !res->IsReady()))
+                    if (res->IsHooked() && (!res->IsFailure() || !res->IsReady()))
                         lookHook.ContinueLoad(*res);
+                    res->Release();
                 }
 
-                // Compile remaining dependents
-                auto it = dependencies.find(compiled.path);
-                if (it.isValid())
-                {
-                    for (const Path& dep : it.value())
-                        PushToCompileQueue(dep);
-                }
+                GetDependents(compiled.path, dependents);
             }
 
+            // Compile remaining dependents
+            PushToCompileQueue(dependents);
+
             // Handle changed dirs
             HandleChangedDirs();
 
@@ -435,18 +545,27 @@ namespace Editor
                 }
                 else
                 {
-                    auto it = dependencies.find(targetPath);
-                    if (it.isValid())
-                    {
-                        for (const Path& dep : it.value())
-                            PushToCompileQueue(dep);
-                    }
+                    Array<Path> dependents;
+                    GetDependents(targetPath, dependents);
+                    PushToCompileQueue(dependents);
                 }
             }
         }
 
+        void GetDependents(const Path& parent, Array<Path>& dependents)
+        {
+            ScopedMutex lock(depMutex);
+            auto it = dependencies.find(parent);
+            if (it.isValid())
+            {
+                for (const Path& dep : it.value())
+                    dependents.push_back(dep);
+            }
+        }
+
         void AddDependency(const Path& parent, const Path& dep)override
         {
+            ScopedMutex lock(depMutex);
             auto it = dependencies.find(parent);
             if (!it.isValid())
             {
@@ -456,8 +575,25 @@ namespace Editor
 
             Array<Path>& deps = it.value();
             if (deps.indexOf(dep) < 0)
+            {
                 deps.push_back(dep);
-            
+                AddDependencyParent(parent, dep);
+            }
+        }
+
+        // Must be called with the depMutex locked
+        void AddDependencyParent(const Path& parent, const Path& dep)
+        {
+            auto it = dependencyParents.find(dep);
+            if (!it.isValid())
+            {
+                dependencyParents.insert(dep, std::move(Array<Path>()));
+                it = dependencyParents.find(dep);
+            }
+
+            Array<Path>& parents = it.value();
+            if (parents.indexOf(parent) < 0)
+                parents.push_back(parent);
         }
 
         void EndFrame() override
@@ -488,13 +624,13 @@ namespace Editor
                 ImGui::Text("%s", "Compiling resources...");
                 ImGui::ProgressBar(((float)batchCompileCount - batchRemainningCount) / batchCompileCount);
 
-                // Show the current res in progress
-                StaticString<MAX_PATH_LENGTH> path;
+                // Show the current res in progress, it is written by the compile tasks
+                Path path;
                 {
                     ScopedMutex lock(toCompileMutex);
-                    path = inprogressRes.c_str();
+                    path = inprogressRes;
                 }
-                ImGui::TextWrapped("%s", path.data);
+                ImGui::TextWrapped("%s", path.c_str());
             }
             ImGui::End();
             ImGui::PopStyleVar();
@@ -559,6 +695,138 @@ namespace Editor
             return plugin->Compile(path);
         }
 
+        // Hash of the source, the meta file, the direct dependencies and the compiler version
+        bool ComputeContentHash(const Path& path, U64& hash)
+        {
+            FileSystem& fs = editor.GetEngine().GetFileSystem();
+            OutputMemoryStream mem;
+            if (!fs.LoadContext(path.c_str(), mem))
+                return false;
+
+            Array<U64> hashes;
+            hashes.push_back(COMPILER_VERSION);
+            hashes.push_back(CompiledResourceHeader::VERSION);
+            hashes.push_back(RuntimeHash(mem.Data(), (U32)mem.Size()).GetHashValue());
+
+            const StaticString<MAX_PATH_LENGTH> metaPath(path.c_str(), ".meta");
+            mem.Clear();
+            if (fs.FileExists(metaPath) && fs.LoadContext(metaPath, mem))
+                hashes.push_back(RuntimeHash(mem.Data(), (U32)mem.Size()).GetHashValue());
+
+            // Resources depend on the files which list them as dependents
+            Array<Path> parents;
+            {
+                ScopedMutex lock(depMutex);
+                auto it = dependencyParents.find(path);
+                if (it.isValid())
+                {
+                    for (const Path& parent : it.value())
+                        parents.push_back(parent);
+                }
+            }
+
+            const U32 parentBegin = hashes.size();
+            for (const Path& parent : parents)
+            {
+                mem.Clear();
+                if (fs.LoadContext(parent.c_str(), mem))
+                    hashes.push_back(RuntimeHash(mem.Data(), (U32)mem.Size()).GetHashValue());
+            }
+            std::sort(hashes.begin() + parentBegin, hashes.end());
+
+            hash = RuntimeHash(hashes.data(), hashes.size() * (U32)sizeof(U64)).GetHashValue();
+            return true;
+        }
+
+        bool IsCompiledUpToDate(const Path& path, U64 contentHash)
+        {
+            {
+                ScopedMutex lock(hashCacheMutex);
+                auto it = hashCache.find(path.GetHashValue());
+                if (!it.isValid() || it.value().contentHash != contentHash)
+                    return false;
+            }
+
+            FileSystem& fs = editor.GetEngine().GetFileSystem();
+            const StaticString<MAX_PATH_LENGTH> dstPath(".export/resources/", path.GetHashValue(), ".res");
+            return fs.FileExists(dstPath);
+        }
+
+        void CompileAsset(const CompileJob& job)
+        {
+            PROFILE_BLOCK("Compile asset");
+            Timer timer;
+
+            // Taken before hashing, so the source modified while hashing is checked again
+            HashCacheEntry entry;
+            entry.checkedTime = GetSourceModTime(job.path);
+            const bool isHashed = ComputeContentHash(job.path, entry.contentHash);
+            const bool isSkipped = isHashed && IsCompiledUpToDate(job.path, entry.contentHash);
+            const bool ret = isSkipped || Compile(job.path);
+            if (!ret)
+                Logger::Error("Failed to compile resource:%s", job.path.c_str());
+
+            // The checked time is refreshed by the skipped resource too, so it isn't hashed again on the next launch
+            {
+                ScopedMutex lock(hashCacheMutex);
+                auto it = hashCache.find(job.path.GetHashValue());
+                if (ret && isHashed)
+                {
+                    if (it.isValid())
+                        it.value() = entry;
+                    else
+                        hashCache.insert(job.path.GetHashValue(), entry);
+                }
+                else if (it.isValid())
+                {
+                    hashCache.erase(it);
+                }
+            }
+
+            IPlugin* plugin = GetPlugin(job.path);
+            if (plugin != nullptr)
+            {
+                ScopedMutex lock(statsMutex);
+                for (PluginStats& stats : pluginStats)
+                {
+                    if (stats.plugin != plugin)
+                        continue;
+
+                    if (isSkipped)
+                        stats.skippedCount++;
+                    else
+                        stats.compiledCount++;
+                    stats.time += timer.GetTimeSinceStart();
+                    break;
+                }
+            }
+        }
+
+        void ReportBatchStats()
+        {
+            ScopedMutex lock(statsMutex);
+            U32 compiledCount = 0;
+            U32 skippedCount = 0;
+            for (const PluginStats& stats : pluginStats)
+            {
+                compiledCount += stats.compiledCount;
+                skippedCount += stats.skippedCount;
+            }
+            if (compiledCount + skippedCount == 0)
+                return;
+
+            Logger::Info("Compiled %d resources, %d up to date, %.2fs", compiledCount, skippedCount, batchTimer.GetTimeSinceTick());
+            for (PluginStats& stats : pluginStats)
+            {
+                if (stats.compiledCount + stats.skippedCount > 0)
+                    Logger::Info("  %s: compiled %d, up to date %d, %.2fms", stats.name, stats.compiledCount, stats.skippedCount, stats.time * 1000.0f);
+
+                stats.compiledCount = 0;
+                stats.skippedCount = 0;
+                stats.time = 0.0f;
+            }
+        }
+
         bool CopyCompile(const Path& path)override
         {
             FileSystem& fs = editor.GetEngine().GetFileSystem();
@@ -572,46 +840,63 @@ namespace Editor
             return WriteCompiled(path.c_str(), Span(mem.Data(), mem.Size()));
         }
 
-        bool WriteCompiled(const char* path, Span<const U8> data)override
+        bool WriteCompiled(const char* path, Span<const U8> data, bool compress = true)override
         {
             FileSystem& fs = editor.GetEngine().GetFileSystem();
             OutputMemoryStream compressedData;
             U64 compressedSize = 0;
-            if (data.length() > COMPRESSION_SIZE_LIMIT)
+            if (compress && data.length() > COMPRESSION_SIZE_LIMIT)
             {
                 // Compress data if data is too large
-                ASSERT(0);
-                // TODO
+                const I32 maxCompressedSize = LZ4::CompressBound((I32)data.length());
+                compressedData.Resize(maxCompressedSize);
+                const I32 size = LZ4::Compress(data.data(), compressedData.Data(), (I32)data.length(), maxCompressedSize, compressionLevel);
+                if (size > 0 && size < data.length() * COMPRESSION_RATIO_LIMIT)
+                    compressedSize = size;
             }
 
             Path filePath(path);
-            MaxPathString exportPath(".export/Resources/", filePath.GetHashValue(), ".res");
-            auto file = fs.OpenFile(exportPath.c_str(), FileFlags::DEFAULT_WRITE);
-            if (!file)
-            {
-                Logger::Error("Failed to create export asset %s", path);
-                return false;
-            }
+            MaxPathString exportPath(".export/resources/", filePath.GetHashValue(), ".res");
 
             CompiledResourceHeader header;
             header.version = CompiledResourceHeader::VERSION;
             header.originSize = (U32)data.length();
             header.isCompressed = compressedSize > 0;
+
+            // Append to the pack, write the loose file if the pack is not available
+            OutputMemoryStream blob;
+            blob.Reserve(sizeof(header) + (header.isCompressed ? compressedSize : data.length()));
+            blob.Write(&header, sizeof(header));
             if (header.isCompressed)
-            {
-                file->Write(&header, sizeof(header));
-                file->Write(compressedData.Data(), compressedSize);
-            }
+                blob.Write(compressedData.Data(), compressedSize);
             else
+                blob.Write(data.data(), data.length());
+
+            if (fs.WriteToPack(exportPath.c_str(), blob.Data(), blob.Size()))
+                return true;
+
+            auto file = fs.OpenFile(exportPath.c_str(), FileFlags::DEFAULT_WRITE);
+            if (!file)
             {
-                file->Write(&header, sizeof(header));
-                file->Write(data.data(), data.length());
+                Logger::Error("Failed to create export asset %s", path);
+                return false;
             }
 
+            file->Write(blob.Data(), blob.Size());
             file->Close();
             return true;
         }
 
+        void SetCompressionLevel(I32 level)override
+        {
+            compressionLevel = std::clamp(level, LZ4::DEFAULT_LEVEL, LZ4::MAX_HC_LEVEL);
+        }
+
+        I32 GetCompressionLevel()const override
+        {
+            return compressionLevel;
+        }
+
         ResourceType GetResourceType(const char* path) const override
         {
             Span<const char> ext = Path::GetExtension(Span(path, StringLength(path)));
@@ -687,6 +972,14 @@ namespace Editor
                 ScopedMutex lock(mutex);
                 plugins.insert(hash.GetHashValue(), &plugin);
             }
+
+            ScopedMutex lock(statsMutex);
+            if (pluginStats.find([&](const PluginStats& stats) { return stats.plugin == &plugin; }) < 0)
+            {
+                PluginStats& stats = pluginStats.emplace();
+                stats.plugin = &plugin;
+                stats.name = exts.empty() ? "" : exts[0];
+            }
         }
 
         void AddPlugin(IPlugin& plugin) override
@@ -713,6 +1006,11 @@ namespace Editor
                 }
             } 
             while (!finished);
+
+            ScopedMutex statsLock(statsMutex);
+            const int index = pluginStats.find([&](const PluginStats& stats) { return stats.plugin == &plugin; });
+            if (index >= 0)
+                pluginStats.eraseAt(index);
         }
 
         // Get a taget plugin according to the extension of path
@@ -728,6 +1026,31 @@ namespace Editor
         void PushToCompileQueue(const Path& path)
         {
             ScopedMutex lock(toCompileMutex);
+            AddCompileJob(path);
+            StartCompileTasks();
+        }
+
+        void PushToCompileQueue(const Array<Path>& paths)
+        {
+            if (paths.empty())
+                return;
+
+            // Dependents shared by several parents are queued once
+            HashMap<U64, bool> queued;
+            ScopedMutex lock(toCompileMutex);
+            for (const Path& path : paths)
+            {
+                if (queued.find(path.GetHashValue()).isValid())
+                    continue;
+
+                queued.insert(path.GetHashValue(), true);
+                AddCompileJob(path);
+            }
+            StartCompileTasks();
+        }
+
+        void AddCompileJob(const Path& path)
+        {
             auto it = resGenerations.find(path.GetHashValue());
             if (it.isValid() == false)
                 it = resGenerations.insert(path.GetHashValue(), 0);
@@ -739,25 +1062,168 @@ namespace Editor
             job.path = path;
 
             toCompileJobs.push_back(job);
+            if (batchCompileCount == 0)
+                batchTimer.Tick();
             batchCompileCount++;
             batchRemainningCount++;
-            semaphore.Signal();
         }
 
-        CompileJob PopCompiledQueue()
+        // Start new compile tasks if all tasks are busy
+        void StartCompileTasks()
+        {
+            while (!isFinished && runningTaskCount < maxTaskCount && runningTaskCount < toCompileJobs.size())
+            {
+                runningTaskCount++;
+                Jobsystem::Run(this, [](void* data) {
+                    static_cast<AssetCompilerImpl*>(data)->CompileTask();
+                }, &compileHandle, Jobsystem::ANY_WORKER, Jobsystem::Priority::Background);
+            }
+        }
+
+        // A job can't be compiled with its parents or with the same plugin if the plugin is not thread safe
+        bool CanCompile(const CompileJob& job, IPlugin* plugin)
+        {
+            if (plugin != nullptr && !plugin->IsThreadSafe() && compilingPlugins.indexOf(plugin) >= 0)
+                return false;
+
+            ScopedMutex lock(depMutex);
+            for (const CompileJob& compiling : compilingJobs)
+            {
+                if (compiling.path == job.path)
+                    return false;
+
+                auto it = dependencies.find(compiling.path);
+                if (it.isValid() && it.value().indexOf(job.path) >= 0)
+                    return false;
+            }
+            return true;
+        }
+
+        // Get the next job to compile, the task is finished if there is no job can be compiled now
+        bool PopCompileJob(CompileJob& job, IPlugin*& plugin, Array<CompileJob>& expiredJobs)
+        {
+            ScopedMutex lock(toCompileMutex);
+            for (I32 i = (I32)toCompileJobs.size() - 1; i >= 0 && !isFinished; i--)
+            {
+                const CompileJob temp = toCompileJobs[i];
+                auto it = resGenerations.find(temp.path.GetHashValue());
+                if (temp.path.IsEmpty() || !it.isValid() || it.value() != temp.generation)
+                {
+                    toCompileJobs.eraseAt(i);
+                    expiredJobs.push_back(temp);
+                    continue;
+                }
+
+                IPlugin* targetPlugin = GetPlugin(temp.path);
+                if (!CanCompile(temp, targetPlugin))
+                    continue;
+
+                toCompileJobs.eraseAt(i);
+                compilingJobs.push_back(temp);
+                if (targetPlugin != nullptr)
+                    compilingPlugins.push_back(targetPlugin);
+
+                inprogressRes = temp.path;
+                job = temp;
+                plugin = targetPlugin;
+                return true;
+            }
+
+            runningTaskCount--;
+            return false;
+        }
+
+        void CompileTask()
+        {
+            Array<CompileJob> expiredJobs;
+            CompileJob job;
+            IPlugin* plugin = nullptr;
+            for (;;)
+            {
+                const bool ret = PopCompileJob(job, plugin, expiredJobs);
+                if (!expiredJobs.empty())
+                {
+                    // Expired jobs are dropped in Update, but still count for the batch
+                    ScopedMutex lock(compiledMutex);
+                    for (const CompileJob& expired : expiredJobs)
+                        compiledJobs.push_back(expired);
+                    expiredJobs.clear();
+                }
+
+                if (!ret)
+                    break;
+
+                CompileAsset(job);
+
+                {
+                    ScopedMutex lock(toCompileMutex);
+                    compilingJobs.eraseAt(compilingJobs.indexOf(job));
+                    if (plugin != nullptr)
+                        compilingPlugins.eraseAt(compilingPlugins.indexOf(plugin));
+                    if (inprogressRes == job.path)
+                        inprogressRes = compilingJobs.empty() ? Path() : compilingJobs.back().path;
+                }
+
+                ScopedMutex lock(compiledMutex);
+                compiledJobs.push_back(job);
+            }
+        }
+
+        void PopCompiledQueue(Array<CompileJob>& compiledList, U32 maxCount)
         {
             ScopedMutex lock(compiledMutex);
             if (compiledJobs.empty())
-                return {};
+                return;
 
-            CompileJob compiled = compiledJobs.back();
-            compiledJobs.pop_back();
+            const U32 count = std::min(maxCount, compiledJobs.size());
+            for (U32 i = 0; i < count; i++)
+            {
+                compiledList.push_back(compiledJobs.back());
+                compiledJobs.pop_back();
+            }
 
-            batchRemainningCount--;
+            batchRemainningCount -= count;
             if (batchRemainningCount == 0)
+            {
                 batchCompileCount = 0;
 
-            return compiled;
+                // Make the compiled resources visible in the pack index
+                editor.GetEngine().GetFileSystem().FlushPack();
+                ReportBatchStats();
+            }
+        }
+
+        // The hooked resource is referenced until it is popped
+        void AddHookedResource(Resource& res)
+        {
+            ScopedMutex lock(hookedMutex);
+            auto it = hookedResources.find(res.GetPath().GetHashValue());
+            if (it.isValid())
+            {
+                if (it.value() == &res)
+                    return;
+
+                it.value()->Release();
+                it.value() = &res;
+            }
+            else
+            {
+                hookedResources.insert(res.GetPath().GetHashValue(), &res);
+            }
+            res.AddReference();
+        }
+
+        // The caller takes over the reference of the popped resource
+        Resource* PopHookedResource(const Path& path)
+        {
+            ScopedMutex lock(hookedMutex);
+            auto it = hookedResources.find(path.GetHashValue());
+            if (!it.isValid())
+                return nullptr;
+
+            Resource* res = it.value();
+            hookedResources.erase(it);
+            return res;
         }
 
         void RegisterResource(const char* path)
@@ -771,6 +1237,20 @@ namespace Editor
             it.value()->RegisterResource(*this, path);
         }
 
+        U64 GetSourceModTime(const Path& path)
+        {
+            FileSystem& fs = editor.GetEngine().GetFileSystem();
+            const StaticString<MAX_PATH> metaPath(path.c_str(), ".meta");
+            return std::max(fs.GetLastModTime(path.c_str()), fs.GetLastModTime(metaPath));
+        }
+
+        U64 GetCheckedTime(const Path& path)
+        {
+            ScopedMutex lock(hashCacheMutex);
+            auto it = hashCache.find(path.GetHashValue());
+            return it.isValid() ? it.value().checkedTime : 0;
+        }
+
         ResourceManager::LoadHook::Action OnBeforeLoad(Resource& res)
         {
             FileSystem& fs = editor.GetEngine().GetFileSystem();
@@ -783,15 +1263,15 @@ namespace Editor
          
             const U64 hash = res.GetPath().GetHashValue();
             const StaticString<MAX_PATH> dstPath(".export/resources/", hash, ".res");
-            const StaticString<MAX_PATH> metaPath(filePath, ".meta");
 
-            // It is a new resource or expired
+            // It is a new resource or expired, the source checked by the content hash after compiling is still valid
             if (!fs.FileExists(dstPath) || 
-                fs.GetLastModTime(dstPath) < fs.GetLastModTime(filePath) ||
-                fs.GetLastModTime(dstPath) < fs.GetLastModTime(metaPath))
+                std::max(fs.GetLastModTime(dstPath), GetCheckedTime(res.GetPath())) < GetSourceModTime(res.GetPath()))
             {
                 if (GetPlugin(res.GetPath()) == nullptr)
-                    ResourceManager::LoadHook::Action::IMMEDIATE;
+                    return ResourceManager::LoadHook::Action::IMMEDIATE;
+
+                AddHookedResource(res);
 
                 // Will process after initialized
                 if (initialized == false)
@@ -859,47 +1339,6 @@ namespace Editor
         return compiler.OnBeforeLoad(res);
     }
 
-    I32 CompilerTask::Task()
-    {
-        while (!isFinished)
-        {
-            impl.semaphore.Wait();
-
-            CompileJob job;
-            {
-                // Get the next job to compile
-                ScopedMutex lock(impl.toCompileMutex);
-                if (!impl.toCompileJobs.empty())
-                {
-                    CompileJob temp = impl.toCompileJobs.back();
-                    impl.toCompileJobs.pop_back();
-
-                    if (temp.path.IsEmpty())
-                        continue;
-
-                    auto it = impl.resGenerations.find(temp.path.GetHashValue());
-                    if (it.isValid() && it.value() == temp.generation) 
-                    {
-                        impl.inprogressRes = temp.path;
-                        job = temp;
-                    }   
-                }
-            }
-
-            if (!job.path.IsEmpty())
-            {
-                PROFILE_BLOCK("Compile asset");
-                if (!impl.Compile(job.path))
-                    Logger::Error("Failed to compile resource:%s", job.path.c_str());
-
-                ScopedMutex lock(impl.compiledMutex);
-                impl.compiledJobs.push_back(job);
-            }
-        }
-
-        return 0;
-    }
-
     void AssetCompiler::IPlugin::RegisterResource(AssetCompiler& compiler, const char* path)
     {
         ResourceType type = compiler.GetResourceType(path);
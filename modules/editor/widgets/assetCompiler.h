@@ -20,6 +20,8 @@ namespace Editor
             virtual ~IPlugin() {}
             virtual bool Compile(const Path& path) = 0;
             virtual void RegisterResource(AssetCompiler& compiler, const char* path);
+            // Resources of the plugin can be compiled concurrently
+            virtual bool IsThreadSafe()const { return false; }
             virtual std::vector<const char*> GetSupportExtensions() = 0;
         };
 
@@ -40,7 +42,11 @@ namespace Editor
         virtual void AddDependency(const Path& parent, const Path& dep) = 0;
         virtual bool Compile(const Path& path) = 0;
         virtual bool CopyCompile(const Path& path) = 0;
-        virtual bool WriteCompiled(const char* path, Span<const U8>data) = 0;
+        // Uncompressed resources can be read by ranges, e.g. the streamed mips of textures
+        virtual bool WriteCompiled(const char* path, Span<const U8>data, bool compress = true) = 0;
+        // LZ4 level of compiled resources, 0 is the fast mode, [1, 12] are the HC levels
+        virtual void SetCompressionLevel(I32 level) = 0;
+        virtual I32 GetCompressionLevel()const = 0;
         virtual ResourceType GetResourceType(const char* path) const = 0;
         virtual void RegisterExtension(const char* extension, ResourceType type) = 0;
         virtual void AddResource(ResourceType type, const char* path) = 0;
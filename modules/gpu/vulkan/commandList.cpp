@@ -129,6 +129,8 @@ CommandPool::~CommandPool()
 {
     if (!buffers.empty())
         vkFreeCommandBuffers(device->device, pool, (U32)buffers.size(), buffers.data());
+    if (!secondaryBuffers.empty())
+        vkFreeCommandBuffers(device->device, pool, (U32)secondaryBuffers.size(), secondaryBuffers.data());
 
     if (pool != VK_NULL_HANDLE)
         vkDestroyCommandPool(device->device, pool, nullptr);
@@ -146,16 +148,22 @@ CommandPool& CommandPool::operator=(CommandPool&& other) noexcept
         device = other.device;
         if (!buffers.empty())
             vkFreeCommandBuffers(device->device, pool, (U32)buffers.size(), buffers.data());
+        if (!secondaryBuffers.empty())
+            vkFreeCommandBuffers(device->device, pool, (U32)secondaryBuffers.size(), secondaryBuffers.data());
         if (pool != VK_NULL_HANDLE)
             vkDestroyCommandPool(device->device, pool, nullptr);
 
         pool = VK_NULL_HANDLE;
         buffers.clear();
+        secondaryBuffers.clear();
         usedIndex = other.usedIndex;
         other.usedIndex = 0;
+        usedSecondaryIndex = other.usedSecondaryIndex;
+        other.usedSecondaryIndex = 0;
 
         std::swap(pool, other.pool);
         std::swap(buffers, other.buffers);
+        std::swap(secondaryBuffers, other.secondaryBuffers);
     }
 
     return *this;
@@ -182,14 +190,36 @@ VkCommandBuffer CommandPool::RequestCommandBuffer()
     return cmd;
 }
 
+VkCommandBuffer CommandPool::RequestSecondaryCommandBuffer()
+{
+    ASSERT(pool != VK_NULL_HANDLE);
+    if (usedSecondaryIndex < secondaryBuffers.size())
+        return secondaryBuffers[usedSecondaryIndex++];
+
+    VkCommandBuffer cmd;
+    VkCommandBufferAllocateInfo info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    info.commandPool = pool;
+    info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    info.commandBufferCount = 1;
+
+    VkResult res = vkAllocateCommandBuffers(device->device, &info, &cmd);
+    ASSERT(res == VK_SUCCESS);
+
+    secondaryBuffers.push_back(cmd);
+    usedSecondaryIndex++;
+
+    return cmd;
+}
+
 void CommandPool::BeginFrame()
 {
     if (pool == VK_NULL_HANDLE)
         return;
 
-    if (usedIndex > 0)
+    if (usedIndex > 0 || usedSecondaryIndex > 0)
         vkResetCommandPool(device->device, pool, 0);
     usedIndex = 0;
+    usedSecondaryIndex = 0;
 }
 
 void CommandListDeleter::operator()(CommandList* cmd)
@@ -284,12 +314,40 @@ void CommandList::BeginRenderPass(const RenderPassInfo& renderPassInfo, VkSubpas
     beginInfo.clearValueCount = numClearColor;
     beginInfo.pClearValues = clearColors;
 
-    vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(cmd, &beginInfo, contents);
 
     subpassContents = contents;
     BeginGraphics();
 }
 
+void CommandList::BeginSecondaryRenderPass(const CommandList& primary)
+{
+    ASSERT(isSecondary);
+    ASSERT(primary.frameBuffer != nullptr);
+
+    // Inherit the render pass state of the primary, the secondary continues the current subpass
+    frameBuffer = primary.frameBuffer;
+    compatibleRenderPass = primary.compatibleRenderPass;
+    renderPass = primary.renderPass;
+    memcpy(frameBufferAttachments, primary.frameBufferAttachments, sizeof(frameBufferAttachments));
+    pipelineState.subpassIndex = primary.pipelineState.subpassIndex;
+    viewport = primary.viewport;
+    scissor = primary.scissor;
+    subpassContents = VK_SUBPASS_CONTENTS_INLINE;
+    BeginGraphics();
+}
+
+void CommandList::SubmitSecondary(CommandListPtr secondary)
+{
+    ASSERT(!isSecondary);
+    ASSERT(secondary->isSecondary);
+    ASSERT(frameBuffer != nullptr);
+    ASSERT(subpassContents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    ASSERT(secondary->pipelineState.subpassIndex == pipelineState.subpassIndex);
+
+    device.SubmitSecondary(*this, secondary);
+}
+
 void CommandList::EndRenderPass()
 {
     vkCmdEndRenderPass(cmd);
@@ -498,6 +556,10 @@ void CommandList::ResetCommandContext()
     memset(&indexState, 0, sizeof(indexState));
     pipelineState.shaderProgram = nullptr;
     currentPipeline = VK_NULL_HANDLE;
+    isPipelinePending = false;
+    pendingPipelineHash = 0;
+    pendingFallbackHash = 0;
+    pendingFallbackPipeline = VK_NULL_HANDLE;
     currentPipelineLayout = VK_NULL_HANDLE;
     currentLayout = nullptr;
 }
@@ -710,6 +772,11 @@ void CommandList::CopyBuffer(const Buffer& dst, VkDeviceSize dstOffset, const Bu
     vkCmdCopyBuffer(cmd, src.GetBuffer(), dst.GetBuffer(), 1, &region);
 }
 
+void CommandList::CopyBuffer(const Buffer& dst, const Buffer& src, const VkBufferCopy* regions, U32 regionCount)
+{
+    vkCmdCopyBuffer(cmd, src.GetBuffer(), dst.GetBuffer(), regionCount, regions);
+}
+
 void CommandList::FillBuffer(const BufferPtr& buffer, U32 value)
 {
 }
@@ -1028,7 +1095,8 @@ bool CommandList::FlushRenderState()
         pipelineState.shaderProgram->IsEmpty())
         return false;
 
-    if (currentPipeline == VK_NULL_HANDLE)
+    // Check the pending pipeline again until it is compiled
+    if (currentPipeline == VK_NULL_HANDLE || isPipelinePending)
         SetDirty(CommandListDirtyBits::COMMAND_LIST_DIRTY_PIPELINE_BIT);
 
     // flush pipeline
@@ -1149,8 +1217,33 @@ bool CommandList::FlushGraphicsPipeline()
         currentPipeline = pipelineState.shaderProgram->GetPipeline(pipelineState.hash);
     }
 
+    const bool wasPipelinePending = isPipelinePending;
+    isPipelinePending = false;
     if (currentPipeline == VK_NULL_HANDLE)
-        currentPipeline = BuildGraphicsPipeline(pipelineState);
+    {
+        // Only the programs with a fallback are compiled asynchronously, the draws of the others can't be dropped
+        ShaderProgram* fallback = pipelineState.shaderProgram->GetFallback();
+        if (device.IsAsyncPipelineCompilation() && fallback != nullptr)
+        {
+            // Don't stall the recording, draw with the fallback program or skip the draw until the pipeline is ready
+            if (!wasPipelinePending || pendingPipelineHash != pipelineState.hash)
+            {
+                device.CompileGraphicsPipelineAsync(GetGraphicsPipelineDesc(pipelineState));
+                pendingPipelineHash = pipelineState.hash;
+                pendingFallbackPipeline = GetFallbackGraphicsPipeline(pendingFallbackHash);
+            }
+            else if (pendingFallbackPipeline == VK_NULL_HANDLE && pendingFallbackHash != 0)
+            {
+                pendingFallbackPipeline = fallback->GetPipeline(pendingFallbackHash);
+            }
+            currentPipeline = pendingFallbackPipeline;
+            isPipelinePending = true;
+        }
+        else
+        {
+            currentPipeline = BuildGraphicsPipeline(device, GetGraphicsPipelineDesc(pipelineState));
+        }
+    }
 
     return currentPipeline != VK_NULL_HANDLE;
 }
@@ -1354,8 +1447,59 @@ void CommandList::FlushDescriptorDynamicSet(U32 set)
         currentPipelineLayout, set, 1, &allocatedSets[set], numDynamicOffsets, dynamicOffsets);
 }
 
-VkPipeline CommandList::BuildGraphicsPipeline(const CompiledPipelineState& pipelineState)
+GraphicsPipelineDesc CommandList::GetGraphicsPipelineDesc(const CompiledPipelineState& pipelineState)const
+{
+    GraphicsPipelineDesc desc;
+    desc.pipelineState = pipelineState;
+    desc.renderPass = compatibleRenderPass;
+    memcpy(desc.strides, vbos.strides, sizeof(desc.strides));
+    memcpy(desc.inputRates, vbos.inputRate, sizeof(desc.inputRates));
+    return desc;
+}
+
+VkPipeline CommandList::GetFallbackGraphicsPipeline(HashValue& fallbackHash)
+{
+    fallbackHash = 0;
+    ShaderProgram* fallback = pipelineState.shaderProgram->GetFallback();
+    if (fallback == nullptr)
+        return VK_NULL_HANDLE;
+
+    // Descriptor sets are bound with the layout of the required program
+    if (fallback->GetPipelineLayout()->GetHash() != pipelineState.shaderProgram->GetPipelineLayout()->GetHash())
+        return VK_NULL_HANDLE;
+
+    CompiledPipelineState fallbackState = pipelineState;
+    fallbackState.shaderProgram = fallback;
+    UpdateGraphicsPipelineHash(fallbackState, activeVBOs);
+    fallbackHash = fallbackState.hash;
+
+    // The fallback is queued too when it is missed, the draws are skipped until one of them is ready
+    VkPipeline pipeline = fallback->GetPipeline(fallbackState.hash);
+    if (pipeline == VK_NULL_HANDLE)
+        device.CompileGraphicsPipelineAsync(GetGraphicsPipelineDesc(fallbackState));
+
+    return pipeline;
+}
+
+VkPipeline CommandList::BuildGraphicsPipeline(DeviceVulkan& device, const GraphicsPipelineDesc& desc)
 {
+    VkPipeline pipeline = CreateGraphicsPipeline(device, desc);
+    if (pipeline == VK_NULL_HANDLE)
+        return VK_NULL_HANDLE;
+
+    // Handle pipeline by shader program
+    desc.pipelineState.shaderProgram->AddPipeline(desc.pipelineState.hash, pipeline);
+
+#ifdef VULKAN_TEST_FOSSILIZE
+    device.RecordGraphicsPipeline(desc);
+#endif
+    return pipeline;
+}
+
+VkPipeline CommandList::CreateGraphicsPipeline(DeviceVulkan& device, const GraphicsPipelineDesc& desc)
+{
+    const CompiledPipelineState& pipelineState = desc.pipelineState;
+    const RenderPass* compatibleRenderPass = desc.renderPass;
     U32 subpassIndex = pipelineState.subpassIndex;
 
     VkPipelineViewportStateCreateInfo viewportState = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
@@ -1474,8 +1618,8 @@ VkPipeline CommandList::BuildGraphicsPipeline(const CompiledPipelineState& pipel
     ForEachBit(bindingMask, [&](U32 binding) {
         VkVertexInputBindingDescription& bind = bindings[numBindings++];
         bind.binding = binding;
-        bind.inputRate = vbos.inputRate[binding];
-        bind.stride = (U32)vbos.strides[binding];
+        bind.inputRate = desc.inputRates[binding];
+        bind.stride = (U32)desc.strides[binding];
      });
 
     vertexInputInfo.vertexBindingDescriptionCount = numBindings;
@@ -1582,9 +1726,6 @@ VkPipeline CommandList::BuildGraphicsPipeline(const CompiledPipelineState& pipel
         return VK_NULL_HANDLE;
     }
 
-    // Handle pipeline by shader program
-    pipelineState.shaderProgram->AddPipeline(pipelineState.hash, retPipeline);
-
     return retPipeline;
 }
 
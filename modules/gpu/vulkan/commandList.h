@@ -80,6 +80,16 @@ struct CompiledPipelineState
     bool isOwnedByCommandList = true;
 };
 
+// Everything required to build a graphics pipeline outside of the recording command list,
+// used by the async compilation and the pre-warming
+struct GraphicsPipelineDesc
+{
+    CompiledPipelineState pipelineState;
+    const RenderPass* renderPass = nullptr;
+    VkDeviceSize strides[VULKAN_NUM_VERTEX_BUFFERS] = {};
+    VkVertexInputRate inputRates[VULKAN_NUM_VERTEX_BUFFERS] = {};
+};
+
 struct DynamicState
 {
     U8 frontReference = 0;
@@ -99,13 +109,16 @@ public:
     void operator=(const CommandPool& rhs) = delete;
 
     VkCommandBuffer RequestCommandBuffer();
+    VkCommandBuffer RequestSecondaryCommandBuffer();
     void BeginFrame();
 
 private:
     U32 usedIndex = 0;
+    U32 usedSecondaryIndex = 0;
     DeviceVulkan* device;
     VkCommandPool pool = VK_NULL_HANDLE;
     std::vector<VkCommandBuffer> buffers;
+    std::vector<VkCommandBuffer> secondaryBuffers;
 };
 
 class CommandList;
@@ -124,6 +137,10 @@ private:
     VkRect2D scissor = {};
     VkPipeline currentPipeline = VK_NULL_HANDLE;              
     VkPipelineLayout currentPipelineLayout = VK_NULL_HANDLE;
+    bool isPipelinePending = false;     // The required pipeline is compiling, currentPipeline is the fallback
+    HashValue pendingPipelineHash = 0;  // The compiling pipeline has been queued, the later draws only poll the program
+    HashValue pendingFallbackHash = 0;  // The fallback pipeline may be compiling too, the draws are skipped until it is ready
+    VkPipeline pendingFallbackPipeline = VK_NULL_HANDLE;
 
     DeviceVulkan& device;
     VkCommandBuffer cmd;
@@ -158,6 +175,7 @@ private:
 
     U32 threadIndex = 0;
     bool isEnded = false;
+    bool isSecondary = false;
 
 public:
     CommandList(DeviceVulkan& device_, VkCommandBuffer buffer_, QueueType type_, VkPipelineCache cache_);
@@ -165,6 +183,10 @@ public:
 
     void BeginRenderPass(const RenderPassInfo& renderPassInfo, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
     void EndRenderPass();
+
+    // Execute the secondary command list recorded for the current subpass, which must be begun
+    // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. The secondaries are executed in submission order
+    void SubmitSecondary(IntrusivePtr<CommandList> secondary);
 #if 0
     void BindPipelineState(const CompiledPipelineState& pipelineState_);
 #endif
@@ -202,6 +224,7 @@ public:
     void CopyToImage(const Image& image, const Buffer& buffer, U32 numBlits, const VkBufferImageCopy* blits);
     void CopyBuffer(const Buffer& dst, const Buffer& src);
     void CopyBuffer(const Buffer& dst, VkDeviceSize dstOffset, const Buffer& src, VkDeviceSize srcOffset, VkDeviceSize size);
+    void CopyBuffer(const Buffer& dst, const Buffer& src, const VkBufferCopy* regions, U32 regionCount);
     void FillBuffer(const BufferPtr& buffer, U32 value);
     void SetBindless(U32 set, VkDescriptorSet descriptorSet);
     void SetSampler(U32 set, U32 binding, const Sampler& sampler);
@@ -281,6 +304,11 @@ public:
         return storageBlock;
     }
 
+    bool IsSecondary()const
+    {
+        return isSecondary;
+    }
+
     DeviceVulkan& GetDevice()
     {
         return device;
@@ -297,11 +325,17 @@ public:
     void SetProgram(const Shader* vertex, const Shader* fragment);
     void SetProgram(const Shader* compute);
 
+    // Build the graphics pipeline and add it to the shader program, it is thread safe
+    static VkPipeline BuildGraphicsPipeline(DeviceVulkan& device, const GraphicsPipelineDesc& desc);
+    // Only create the graphics pipeline, the caller owns it
+    static VkPipeline CreateGraphicsPipeline(DeviceVulkan& device, const GraphicsPipelineDesc& desc);
+
 private:
     friend class DeviceVulkan;
 
     void ResetCommandContext();
     void EndCommandBuffer();
+    void BeginSecondaryRenderPass(const CommandList& primary);
 
     void SetTextureImpl(U32 set, U32 binding, VkImageView imageView, VkImageLayout layout, U64 cookie, DescriptorSetType setType);
 
@@ -315,7 +349,8 @@ private:
     void UpdateGraphicsPipelineHash(CompiledPipelineState& pipeline, U32& activeVbos);
     void UpdateComputePipelineHash(CompiledPipelineState& pipeline);
 
-    VkPipeline BuildGraphicsPipeline(const CompiledPipelineState& pipelineState);
+    GraphicsPipelineDesc GetGraphicsPipelineDesc(const CompiledPipelineState& pipelineState)const;
+    VkPipeline GetFallbackGraphicsPipeline(HashValue& fallbackHash);
     VkPipeline BuildComputePipeline(const CompiledPipelineState& pipelineState);
 
     void BeginCompute();
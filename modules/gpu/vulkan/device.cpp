@@ -30,6 +30,18 @@ namespace
 #define DRAIN_FRAME_LOCK()  ((void)0)
 #endif
 
+    std::string GetPipelineCachePath()
+    {
+        static const std::string PIPELINE_CACHE_PATH = ".export/pipeline_cache.bin";
+        return PIPELINE_CACHE_PATH;
+    }
+
+    std::string GetShaderCachePath()
+    {
+        static const std::string SHADER_CACHE_PATH = ".export/shader_cache.bin";
+        return SHADER_CACHE_PATH;
+    }
+
 	static const QueueIndices QUEUE_FLUSH_ORDER[] = {
         QUEUE_INDEX_TRANSFER,
 		QUEUE_INDEX_GRAPHICS,
@@ -268,8 +280,13 @@ DeviceVulkan::DeviceVulkan() :
 
 DeviceVulkan::~DeviceVulkan()
 {
+    WaitPipelineCompilation();
     WaitIdle();
 
+#ifdef VULKAN_TEST_FOSSILIZE
+    DeinitPipelineRecording();
+#endif
+
     wsi.Clear();
 
     if (pipelineCache!= VK_NULL_HANDLE)
@@ -636,6 +653,64 @@ IntrusivePtr<CommandList> DeviceVulkan::RequestCommandListNolock(int threadIndex
     return cmdPtr;
 }
 
+IntrusivePtr<CommandList> DeviceVulkan::RequestSecondaryCommandList(const CommandList& primary)
+{
+    return RequestSecondaryCommandListForThread(GetThreadIndex(), primary);
+}
+
+IntrusivePtr<CommandList> DeviceVulkan::RequestSecondaryCommandListForThread(int threadIndex, const CommandList& primary)
+{
+    LOCK();
+    return RequestSecondaryCommandListNolock(threadIndex, primary);
+}
+
+IntrusivePtr<CommandList> DeviceVulkan::RequestSecondaryCommandListNolock(int threadIndex, const CommandList& primary)
+{
+    ASSERT(primary.frameBuffer != nullptr);
+    QueueIndices queueIndex = GetQueueIndexFromQueueType(primary.GetQueueType());
+    auto& pools = CurrentFrameResource().cmdPools[(int)queueIndex];
+
+    ASSERT_MSG(threadIndex >= 0 && threadIndex < pools.size(), (std::string("Unknown thread index") + std::to_string(threadIndex)).c_str());
+    CommandPool& pool = pools[threadIndex];
+    VkCommandBuffer cmd = pool.RequestSecondaryCommandBuffer();
+    if (cmd == VK_NULL_HANDLE)
+        return IntrusivePtr<CommandList>();
+
+    // The secondary continues the current subpass of the primary
+    VkCommandBufferInheritanceInfo inheritanceInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+    inheritanceInfo.renderPass = primary.renderPass->GetRenderPass();
+    inheritanceInfo.subpass = primary.pipelineState.subpassIndex;
+    inheritanceInfo.framebuffer = primary.frameBuffer->GetFrameBuffer();
+
+    VkCommandBufferBeginInfo info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    info.pInheritanceInfo = &inheritanceInfo;
+    VkResult res = vkBeginCommandBuffer(cmd, &info);
+    assert(res == VK_SUCCESS);
+    AddFrameCounter();
+
+    IntrusivePtr<CommandList> cmdPtr(commandListPool.allocate(*this, cmd, primary.GetQueueType(), pipelineCache));
+    cmdPtr->SetThreadIndex(threadIndex);
+    cmdPtr->isSecondary = true;
+    cmdPtr->BeginSecondaryRenderPass(primary);
+    return cmdPtr;
+}
+
+void DeviceVulkan::SubmitSecondary(CommandList& primary, CommandListPtr& secondary)
+{
+    LOCK();
+    // The secondary may be ended on the recording thread by EndCommandBufferForThread,
+    // the transient buffer blocks are returned here
+    secondary->EndCommandBuffer();
+
+    VkCommandBuffer secondaryCmd = secondary->GetCommandBuffer();
+    vkCmdExecuteCommands(primary.GetCommandBuffer(), 1, &secondaryCmd);
+    primary.SetSwapchainStages(secondary->GetSwapchainStages());
+    secondary.reset();
+
+    DecrementFrameCounter();
+}
+
 QueueIndices DeviceVulkan::GetPhysicalQueueType(QueueType type) const
 {
     return static_cast<QueueIndices>(type);
@@ -686,6 +761,9 @@ RenderPassInfo DeviceVulkan::GetSwapchianRenderPassInfo(const SwapChain* swapcha
 
 void DeviceVulkan::InitShaderManagerCache()
 {
+    // Compiled shader variants and the pipeline cache are loaded from the shader cache
+    if (!shaderManager.LoadShaderCache(GetShaderCachePath().c_str()))
+        Logger::Info("Shader cache is not available, shaders will be compiled.");
 }
 
 #endif
@@ -764,6 +842,9 @@ RenderPass& DeviceVulkan::RequestRenderPass(const RenderPassInfo& renderPassInfo
 
     RenderPass& renderPass = *renderPasses.emplace(hash.Get(), *this, renderPassInfo);
     renderPass.SetHash(hash.Get());
+#ifdef VULKAN_TEST_FOSSILIZE
+    RecordRenderPass(renderPass);
+#endif
     return renderPass;
 }
 
@@ -835,6 +916,9 @@ Shader* DeviceVulkan::RequestShader(ShaderStage stage, const void* pShaderByteco
 
     Shader* shader = shaders.emplace(hash.Get(), *this, stage, pShaderBytecode, bytecodeLength, layout);
     shader->SetHash(hash.Get());
+#ifdef VULKAN_TEST_FOSSILIZE
+    RecordShader(*shader, pShaderBytecode, bytecodeLength);
+#endif
     return shader;
 }
 
@@ -907,6 +991,9 @@ ShaderProgram* DeviceVulkan::RequestProgram(const Shader* shaders[static_cast<U3
 
     ShaderProgram* program = programs.emplace(hasher.Get(), this, info);
     program->SetHash(hasher.Get());
+#ifdef VULKAN_TEST_FOSSILIZE
+    RecordProgram(*program);
+#endif
     return program;
 }
 
@@ -1158,16 +1245,16 @@ InitialImageBuffer DeviceVulkan::CreateImageStagingBuffer(const ImageCreateInfo&
     {
         layout.SetBuffer(mapped, layout.GetRequiredSize());
 
+        // Initial datas are ordered by level, then by layer
         U32 index = 0;
-        U32 blockStride = layout.GetBlockStride();
-        for (U32 level = 0; level < copyLevels; level++, index++)
+        for (U32 level = 0; level < copyLevels; level++)
         {
             // Calculate dst stride
             const auto& mipInfo = layout.GetMipInfo(level);
             U32 dstRowSize = layout.GetRowSize(level);
             U32 dstHeightStride = layout.GetLayerSize(level);
 
-            for (U32 layer = 0; layer < createInfo.layers; layer++)
+            for (U32 layer = 0; layer < createInfo.layers; layer++, index++)
             {
                 U32 srcRowLength = pInitialData[index].rowLength ? pInitialData[index].rowLength : mipInfo.rowLength;
                 U32 srcImageHeight = pInitialData[index].imageHeight ? pInitialData[index].imageHeight : mipInfo.imageHeight;
@@ -1177,6 +1264,13 @@ InitialImageBuffer DeviceVulkan::CreateImageStagingBuffer(const ImageCreateInfo&
                 U8* dst = static_cast<uint8_t*>(layout.Data(layer, level));
                 const U8* src = static_cast<const uint8_t*>(pInitialData[index].data);
 
+                // Data already laid out as TextureFormatLayout (e.g. compiled textures) is copied at once
+                if (srcRowStride == dstRowSize && srcHeightStride == dstHeightStride)
+                {
+                    memcpy(dst, src, (size_t)mipInfo.depth * dstHeightStride);
+                    continue;
+                }
+
                 for (U32 depth = 0; depth < mipInfo.depth; depth++)
                     for (U32 y = 0; y < mipInfo.blockH; y++)
                         memcpy(dst + depth * dstHeightStride + y * dstRowSize, src + depth * srcHeightStride + y * srcRowStride, dstRowSize);
@@ -2746,14 +2840,9 @@ BindlessDescriptorHeap* DeviceVulkan::GetBindlessDescriptorHeap(BindlessReosurce
     return nullptr;
 }
 
-std::string GetPipelineCachePath()
-{
-    static const std::string PIPELINE_CACHE_PATH = ".export/pipeline_cache.bin";
-    return PIPELINE_CACHE_PATH;
-}
-
 void DeviceVulkan::InitPipelineCache()
 {
+#ifndef VULKAN_TEST_FILESYSTEM
     // TODO: use filesystem to replace Helper::ReadFile
     std::vector<uint8_t> pipelineData;
     if (Helper::FileRead(GetPipelineCachePath(), pipelineData))
@@ -2765,10 +2854,11 @@ void DeviceVulkan::InitPipelineCache()
             return;
         }
     }
+#endif
 
+    // With the filesystem, the pipeline cache data is stored in the shader cache, see InitShaderManagerCache
     if (!InitPipelineCache(nullptr, 0))
         Logger::Warning("Failed to init pipeline cache.");
-  
 }
 
 bool DeviceVulkan::InitPipelineCache(const U8* data, size_t size)
@@ -2830,22 +2920,101 @@ bool DeviceVulkan::InitPipelineCache(const U8* data, size_t size)
     return vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache) == VK_SUCCESS;
 }
 
-void DeviceVulkan::FlushPipelineCache()
+bool DeviceVulkan::GetPipelineCacheData(std::vector<uint8_t>& data)
 {
-    // TODO: use filesystem to replace Helper::FileWrite
     // Get size of pipeline cache
     size_t size{};
     VkResult res = vkGetPipelineCacheData(device, pipelineCache, &size, nullptr);
-    assert(res == VK_SUCCESS);
+    if (res != VK_SUCCESS)
+        return false;
 
     // Get data of pipeline cache 
-    std::vector<uint8_t> data(size);
+    data.resize(size);
     res = vkGetPipelineCacheData(device, pipelineCache, &size, data.data());
-    assert(res == VK_SUCCESS);
+    data.resize(size);
+    return res == VK_SUCCESS;
+}
+
+void DeviceVulkan::FlushPipelineCache()
+{
+#ifdef VULKAN_TEST_FILESYSTEM
+    // Save the pipeline cache with the compiled shader variants
+    shaderManager.SaveShaderCache(GetShaderCachePath().c_str());
+#else
+    // TODO: use filesystem to replace Helper::FileWrite
+    std::vector<uint8_t> data;
+    if (!GetPipelineCacheData(data))
+        return;
 
     // Write pipeline cache data to a file in binary format
     std::string cachePath = GetPipelineCachePath();
-    Helper::FileWrite(cachePath, data.data(), size);
+    Helper::FileWrite(cachePath, data.data(), data.size());
+#endif
+}
+
+void DeviceVulkan::CompileGraphicsPipelineAsync(const GraphicsPipelineDesc& desc)
+{
+    ASSERT(desc.pipelineState.shaderProgram != nullptr && desc.renderPass != nullptr);
+    const HashValue hash = desc.pipelineState.hash;
+
+    // The command lists are recorded in parallel, the shared handle is only started under the lock
+    ScopedMutex lock(pipelineCompileLock);
+    if (!pendingPipelines.insert(hash).second)
+        return;
+
+    // The job holds a reference of the program, the render passes are owned by the device cache
+    // and the device waits for the pending jobs before destroying them
+    struct CompileJobData
+    {
+        GraphicsPipelineDesc desc;
+        ShaderProgramPtr program;
+    };
+    CompileJobData* jobData = CJING_NEW(CompileJobData);
+    jobData->desc = desc;
+    jobData->desc.pipelineState.cache = pipelineCache;
+    desc.pipelineState.shaderProgram->AddReference();
+    jobData->program = ShaderProgramPtr(desc.pipelineState.shaderProgram);
+
+    Jobsystem::Run(jobData, [this](void* data) {
+        CompileJobData* jobData = static_cast<CompileJobData*>(data);
+        const CompiledPipelineState& pipelineState = jobData->desc.pipelineState;
+        if (jobData->program->GetPipeline(pipelineState.hash) == VK_NULL_HANDLE)
+            CommandList::BuildGraphicsPipeline(*this, jobData->desc);
+
+        // Remove it after the pipeline is added to the program, so it is never compiled twice
+        {
+            ScopedMutex lock(pipelineCompileLock);
+            pendingPipelines.erase(pipelineState.hash);
+        }
+        CJING_DELETE(jobData);
+    }, &pipelineCompileHandle, Jobsystem::ANY_WORKER, Jobsystem::Priority::Background);
+}
+
+void DeviceVulkan::PrewarmGraphicsPipelines(const GraphicsPipelineDesc* descs, U32 count, bool wait)
+{
+    for (U32 i = 0; i < count; i++)
+    {
+        const GraphicsPipelineDesc& desc = descs[i];
+        if (desc.pipelineState.shaderProgram->GetPipeline(desc.pipelineState.hash) != VK_NULL_HANDLE)
+            continue;
+
+        CompileGraphicsPipelineAsync(desc);
+    }
+
+    if (wait)
+        WaitPipelineCompilation();
+}
+
+void DeviceVulkan::WaitPipelineCompilation()
+{
+    if (pipelineCompileHandle)
+        Jobsystem::Wait(&pipelineCompileHandle);
+}
+
+U32 DeviceVulkan::GetPendingPipelineCount()
+{
+    ScopedMutex lock(pipelineCompileLock);
+    return (U32)pendingPipelines.size();
 }
 
 void DeviceVulkan::SyncPendingBufferBlocks()
@@ -18,10 +18,12 @@
 #include "event.h"
 
 #include "core\platform\sync.h"
+#include "core\jobsystem\jobsystem.h"
 
 #include <array>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace VulkanTest
 {
@@ -319,6 +321,10 @@ public:
 
     CommandListPtr RequestCommandList(QueueType queueType);
     CommandListPtr RequestCommandListForThread(int threadIndex, QueueType queueType);
+    // Secondary command list continuing the current subpass of the primary, it can be recorded on any thread
+    // and is executed by CommandList::SubmitSecondary on the thread recording the primary
+    CommandListPtr RequestSecondaryCommandList(const CommandList& primary);
+    CommandListPtr RequestSecondaryCommandListForThread(int threadIndex, const CommandList& primary);
     RenderPass& RequestRenderPass(const RenderPassInfo& renderPassInfo, bool isCompatible = false);
     FrameBuffer& RequestFrameBuffer(const RenderPassInfo& renderPassInfo);
     PipelineLayout* RequestPipelineLayout(const CombinedResourceLayout& resLayout);
@@ -418,6 +424,8 @@ public:
 
     RenderPassInfo GetSwapchianRenderPassInfo(const SwapChain* swapchain, SwapchainRenderPassType swapchainRenderPassType = SwapchainRenderPassType::DepthStencil);  
     CommandListPtr RequestCommandListNolock(int threadIndex, QueueType queueType);
+    CommandListPtr RequestSecondaryCommandListNolock(int threadIndex, const CommandList& primary);
+    void SubmitSecondary(CommandList& primary, CommandListPtr& secondary);
 
     QueueIndices GetPhysicalQueueType(QueueType type)const;
     VkFormat GetDefaultDepthStencilFormat() const;
@@ -429,23 +437,63 @@ public:
 
     void InitPipelineCache();
     bool InitPipelineCache(const U8* data, size_t size);
+    bool GetPipelineCacheData(std::vector<uint8_t>& data);
     void FlushPipelineCache();
     VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 
+    // The missed graphics pipelines of the programs with a fallback are compiled on the background job lane
+    // instead of the recording thread, the draws use the fallback program or are skipped until the pipelines are ready.
+    // The pipelines of the other programs are still compiled in place
+    void SetAsyncPipelineCompilation(bool enabled) { asyncPipelineCompilation = enabled; }
+    bool IsAsyncPipelineCompilation()const { return asyncPipelineCompilation; }
+    void CompileGraphicsPipelineAsync(const GraphicsPipelineDesc& desc);
+    // Compile the recorded pipelines at load time
+    void PrewarmGraphicsPipelines(const GraphicsPipelineDesc* descs, U32 count, bool wait = true);
+    void WaitPipelineCompilation();
+    U32 GetPendingPipelineCount();
+
     static bool InitRenderdocCapture();
 
     static constexpr U32 IMMUTABLE_SAMPLER_SLOT_BEGIN = 100;
 
+#ifdef VULKAN_TEST_FOSSILIZE
+    // Pipeline state recorder, the unique shaders, programs, render passes and graphics pipelines
+    // created after it is initialized are saved to the pipeline database
+    static constexpr const char* PIPELINE_DATABASE_PATH = ".export/pipeline_database.bin";
+    void InitPipelineRecording(const char* path = PIPELINE_DATABASE_PATH);
+    bool FlushPipelineRecording();
+    // Recreate the recorded shaders, programs and render passes, the recorded graphics pipelines are
+    // returned for PrewarmGraphicsPipelines
+    bool LoadPipelineDatabase(const char* path, std::vector<GraphicsPipelineDesc>& descs);
+#endif
+
 private:
 #ifdef VULKAN_TEST_FILESYSTEM
     void InitShaderManagerCache();
 #endif
 
+#ifdef VULKAN_TEST_FOSSILIZE
+    struct PipelineRecorder;
+    PipelineRecorder* pipelineRecorder = nullptr;
+
+    void DeinitPipelineRecording();
+    void RecordShader(const Shader& shader, const void* pShaderBytecode, size_t bytecodeLength);
+    void RecordProgram(const ShaderProgram& program);
+    void RecordRenderPass(const RenderPass& renderPass);
+    void RecordGraphicsPipeline(const GraphicsPipelineDesc& desc);
+#endif
+
 private:
     friend class CommandList;
 
     U64 FRAMECOUNT = 0;
 
+    // async pipeline compilation
+    bool asyncPipelineCompilation = false;
+    Mutex pipelineCompileLock;
+    std::unordered_set<HashValue> pendingPipelines;
+    Jobsystem::JobHandle pipelineCompileHandle;
+
     void AddFrameCounter();
     void DecrementFrameCounter();
 
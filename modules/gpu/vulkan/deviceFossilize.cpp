@@ -2,6 +2,8 @@
 #include "math\hash.h"
 #include "memory.h"
 #include "TextureFormatLayout.h"
+#include "core\utils\helper.h"
+#include "core\utils\stream.h"
 
 #ifdef VULKAN_TEST_FOSSILIZE
 
@@ -9,7 +11,338 @@ namespace VulkanTest
 {
 namespace GPU
 {
+namespace
+{
+    struct PipelineDatabaseHeader
+    {
+        static constexpr U32 MAGIC = 0x42445350; // 'PSDB'
+        static constexpr U32 VERSION = 0x01;
+
+        U32 magic = MAGIC;
+        U32 version = VERSION;
+        U32 shaderCount = 0;
+        U32 programCount = 0;
+        U32 renderPassCount = 0;
+        U32 pipelineCount = 0;
+    };
+
+    struct ShaderRecord
+    {
+        ShaderStage stage = ShaderStage::Count;
+        ShaderResourceLayout layout;
+        std::vector<U8> spirv;
+    };
+
+    struct ProgramRecord
+    {
+        HashValue shaders[static_cast<U32>(ShaderStage::Count)] = {};
+    };
+
+    // Everything hashed by CommandList::UpdateGraphicsPipelineHash
+    struct PipelineRecord
+    {
+        HashValue programHash = 0;
+        HashValue renderPassHash = 0;
+        BlendState blendState = {};
+        RasterizerState rasterizerState = {};
+        DepthStencilState depthStencilState = {};
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VertexAttribState attribs[VULKAN_NUM_VERTEX_ATTRIBS] = {};
+        U32 subpassIndex = 0;
+        VkDeviceSize strides[VULKAN_NUM_VERTEX_BUFFERS] = {};
+        VkVertexInputRate inputRates[VULKAN_NUM_VERTEX_BUFFERS] = {};
+    };
+}
+
+struct DeviceVulkan::PipelineRecorder
+{
+    std::string path;
+    Mutex lock;
+    std::unordered_map<HashValue, ShaderRecord> shaders;
+    std::unordered_map<HashValue, ProgramRecord> programs;
+    std::unordered_map<HashValue, RenderPassCreateInfoData> renderPasses;
+    std::unordered_map<HashValue, PipelineRecord> pipelines;
+};
+
+void DeviceVulkan::InitPipelineRecording(const char* path)
+{
+    ASSERT(pipelineRecorder == nullptr);
+    pipelineRecorder = CJING_NEW(PipelineRecorder);
+    pipelineRecorder->path = path;
+}
+
+void DeviceVulkan::DeinitPipelineRecording()
+{
+    if (pipelineRecorder == nullptr)
+        return;
+
+    FlushPipelineRecording();
+    CJING_DELETE(pipelineRecorder);
+    pipelineRecorder = nullptr;
+}
+
+bool DeviceVulkan::FlushPipelineRecording()
+{
+    if (pipelineRecorder == nullptr)
+        return false;
+
+    ScopedMutex lock(pipelineRecorder->lock);
+    OutputMemoryStream stream;
+    PipelineDatabaseHeader header;
+    stream.Write(header);
+
+    // Objects created before the recording was initialized are missing, skip everything using them
+    for (const auto& kvp : pipelineRecorder->shaders)
+    {
+        const ShaderRecord& record = kvp.second;
+        stream.Write(kvp.first);
+        stream.Write(record.stage);
+        stream.Write(record.layout);
+        stream.Write((U32)record.spirv.size());
+        stream.Write(record.spirv.data(), record.spirv.size());
+        header.shaderCount++;
+    }
+
+    std::unordered_set<HashValue> validPrograms;
+    for (const auto& kvp : pipelineRecorder->programs)
+    {
+        bool isValid = true;
+        for (HashValue shaderHash : kvp.second.shaders)
+        {
+            if (shaderHash != 0 && pipelineRecorder->shaders.find(shaderHash) == pipelineRecorder->shaders.end())
+                isValid = false;
+        }
+        if (!isValid)
+            continue;
+
+        stream.Write(kvp.first);
+        stream.Write(kvp.second);
+        validPrograms.insert(kvp.first);
+        header.programCount++;
+    }
+
+    for (const auto& kvp : pipelineRecorder->renderPasses)
+    {
+        stream.Write(kvp.first);
+        kvp.second.Write(stream);
+        header.renderPassCount++;
+    }
+
+    for (const auto& kvp : pipelineRecorder->pipelines)
+    {
+        const PipelineRecord& record = kvp.second;
+        if (validPrograms.find(record.programHash) == validPrograms.end() ||
+            pipelineRecorder->renderPasses.find(record.renderPassHash) == pipelineRecorder->renderPasses.end())
+            continue;
+
+        stream.Write(kvp.first);
+        stream.Write(record);
+        header.pipelineCount++;
+    }
+
+    memcpy(stream.Data(), &header, sizeof(header));
+
+    const std::string& path = pipelineRecorder->path;
+    Helper::DirectoryCreate(Helper::GetDirectoryFromPath(path));
+    if (!Helper::FileWrite(path, stream.Data(), stream.Size()))
+    {
+        Logger::Warning("Failed to save pipeline database %s", path.c_str());
+        return false;
+    }
+
+    Logger::Info("Pipeline database saved, %d pipelines", header.pipelineCount);
+    return true;
+}
+
+bool DeviceVulkan::LoadPipelineDatabase(const char* path, std::vector<GraphicsPipelineDesc>& descs)
+{
+    std::vector<uint8_t> data;
+    if (!Helper::FileRead(path, data) || data.empty())
+        return false;
+
+    InputMemoryStream stream(data.data(), data.size());
+    PipelineDatabaseHeader header;
+    if (!stream.Read(&header, sizeof(header)) ||
+        header.magic != PipelineDatabaseHeader::MAGIC ||
+        header.version != PipelineDatabaseHeader::VERSION)
+    {
+        Logger::Warning("Invalid pipeline database %s", path);
+        return false;
+    }
+
+    // Shaders
+    for (U32 i = 0; i < header.shaderCount; i++)
+    {
+        HashValue hash = 0;
+        ShaderRecord record;
+        U32 spirvSize = 0;
+        bool ret = stream.Read(&hash, sizeof(hash)) &&
+            stream.Read(&record.stage, sizeof(record.stage)) &&
+            stream.Read(&record.layout, sizeof(record.layout)) &&
+            stream.Read(&spirvSize, sizeof(spirvSize)) &&
+            stream.GetPos() + spirvSize <= stream.Size();
+        if (!ret)
+        {
+            Logger::Warning("Invalid pipeline database %s", path);
+            return false;
+        }
+
+        record.spirv.resize(spirvSize);
+        stream.Read(record.spirv.data(), spirvSize);
 
+        Shader* shader = RequestShader(record.stage, record.spirv.data(), record.spirv.size(), &record.layout);
+        if (shader == nullptr || shader->GetHash() != hash)
+            Logger::Warning("Mismatched shader in pipeline database %s", path);
+    }
+
+    // Programs
+    for (U32 i = 0; i < header.programCount; i++)
+    {
+        HashValue hash = 0;
+        ProgramRecord record;
+        if (!stream.Read(&hash, sizeof(hash)) || !stream.Read(&record, sizeof(record)))
+        {
+            Logger::Warning("Invalid pipeline database %s", path);
+            return false;
+        }
+
+        const Shader* shaders[static_cast<U32>(ShaderStage::Count)] = {};
+        bool isValid = true;
+        for (U32 stage = 0; stage < static_cast<U32>(ShaderStage::Count); stage++)
+        {
+            if (record.shaders[stage] == 0)
+                continue;
+
+            shaders[stage] = RequestShaderByHash(record.shaders[stage]);
+            if (shaders[stage] == nullptr)
+                isValid = false;
+        }
+
+        if (!isValid)
+            continue;
+
+        if (RequestProgram(shaders)->GetHash() != hash)
+            Logger::Warning("Mismatched program in pipeline database %s", path);
+    }
+
+    // Render passes, only the compatibility matters for the pipelines
+    for (U32 i = 0; i < header.renderPassCount; i++)
+    {
+        HashValue hash = 0;
+        RenderPassCreateInfoData createInfoData;
+        if (!stream.Read(&hash, sizeof(hash)) || !createInfoData.Read(stream))
+        {
+            Logger::Warning("Invalid pipeline database %s", path);
+            return false;
+        }
+
+        if (renderPasses.find(hash) != nullptr)
+            continue;
+
+        std::vector<VkSubpassDescription> subpassDescs;
+        VkRenderPassCreateInfo createInfo = createInfoData.Get(subpassDescs);
+        RenderPass& renderPass = *renderPasses.emplace(hash, *this, createInfo);
+        renderPass.SetHash(hash);
+        RecordRenderPass(renderPass);
+    }
+
+    // Graphics pipelines
+    descs.reserve(descs.size() + header.pipelineCount);
+    for (U32 i = 0; i < header.pipelineCount; i++)
+    {
+        HashValue hash = 0;
+        PipelineRecord record;
+        if (!stream.Read(&hash, sizeof(hash)) || !stream.Read(&record, sizeof(record)))
+        {
+            Logger::Warning("Invalid pipeline database %s", path);
+            return false;
+        }
+
+        ShaderProgram* program = programs.find(record.programHash);
+        RenderPass* renderPass = renderPasses.find(record.renderPassHash);
+        if (program == nullptr || renderPass == nullptr)
+            continue;
+
+        GraphicsPipelineDesc& desc = descs.emplace_back();
+        desc.pipelineState.shaderProgram = program;
+        desc.pipelineState.blendState = record.blendState;
+        desc.pipelineState.rasterizerState = record.rasterizerState;
+        desc.pipelineState.depthStencilState = record.depthStencilState;
+        desc.pipelineState.topology = record.topology;
+        memcpy(desc.pipelineState.attribs, record.attribs, sizeof(record.attribs));
+        desc.pipelineState.subpassIndex = record.subpassIndex;
+        desc.pipelineState.hash = hash;
+        desc.pipelineState.cache = pipelineCache;
+        desc.renderPass = renderPass;
+        memcpy(desc.strides, record.strides, sizeof(record.strides));
+        memcpy(desc.inputRates, record.inputRates, sizeof(record.inputRates));
+    }
+
+    Logger::Info("Pipeline database loaded, %d pipelines", (U32)descs.size());
+    return true;
+}
+
+void DeviceVulkan::RecordShader(const Shader& shader, const void* pShaderBytecode, size_t bytecodeLength)
+{
+    if (pipelineRecorder == nullptr)
+        return;
+
+    ScopedMutex lock(pipelineRecorder->lock);
+    ShaderRecord& record = pipelineRecorder->shaders[shader.GetHash()];
+    if (!record.spirv.empty())
+        return;
+
+    record.stage = shader.GetStage();
+    record.layout = shader.GetLayout();
+    record.spirv.assign(static_cast<const U8*>(pShaderBytecode), static_cast<const U8*>(pShaderBytecode) + bytecodeLength);
+}
+
+void DeviceVulkan::RecordProgram(const ShaderProgram& program)
+{
+    if (pipelineRecorder == nullptr)
+        return;
+
+    ProgramRecord record;
+    for (U32 stage = 0; stage < static_cast<U32>(ShaderStage::Count); stage++)
+    {
+        const Shader* shader = program.GetShader(static_cast<ShaderStage>(stage));
+        record.shaders[stage] = shader != nullptr ? shader->GetHash() : 0;
+    }
+
+    ScopedMutex lock(pipelineRecorder->lock);
+    pipelineRecorder->programs.emplace(program.GetHash(), record);
+}
+
+void DeviceVulkan::RecordRenderPass(const RenderPass& renderPass)
+{
+    if (pipelineRecorder == nullptr)
+        return;
+
+    ScopedMutex lock(pipelineRecorder->lock);
+    pipelineRecorder->renderPasses.emplace(renderPass.GetHash(), renderPass.GetCreateInfoData());
+}
+
+void DeviceVulkan::RecordGraphicsPipeline(const GraphicsPipelineDesc& desc)
+{
+    if (pipelineRecorder == nullptr)
+        return;
+
+    const CompiledPipelineState& pipelineState = desc.pipelineState;
+    PipelineRecord record;
+    record.programHash = pipelineState.shaderProgram->GetHash();
+    record.renderPassHash = desc.renderPass->GetHash();
+    record.blendState = pipelineState.blendState;
+    record.rasterizerState = pipelineState.rasterizerState;
+    record.depthStencilState = pipelineState.depthStencilState;
+    record.topology = pipelineState.topology;
+    memcpy(record.attribs, pipelineState.attribs, sizeof(record.attribs));
+    record.subpassIndex = pipelineState.subpassIndex;
+    memcpy(record.strides, desc.strides, sizeof(record.strides));
+    memcpy(record.inputRates, desc.inputRates, sizeof(record.inputRates));
+
+    ScopedMutex lock(pipelineRecorder->lock);
+    pipelineRecorder->pipelines.emplace(pipelineState.hash, record);
+}
 
 }
 }
@@ -75,6 +75,129 @@ namespace {
 	};
 }
 
+#ifdef VULKAN_TEST_FOSSILIZE
+namespace {
+	template<typename T>
+	void WriteArray(OutputMemoryStream& stream, const std::vector<T>& data)
+	{
+		stream.Write((U32)data.size());
+		stream.Write(data.data(), data.size() * sizeof(T));
+	}
+
+	template<typename T>
+	bool ReadArray(InputMemoryStream& stream, std::vector<T>& data)
+	{
+		U32 count = 0;
+		if (!stream.Read(&count, sizeof(count)) || stream.GetPos() + count * sizeof(T) > stream.Size())
+			return false;
+
+		data.resize(count);
+		return stream.Read(data.data(), count * sizeof(T));
+	}
+}
+
+void RenderPassCreateInfoData::Set(const VkRenderPassCreateInfo& info)
+{
+	attachments.assign(info.pAttachments, info.pAttachments + info.attachmentCount);
+	dependencies.assign(info.pDependencies, info.pDependencies + info.dependencyCount);
+
+	subpasses.resize(info.subpassCount);
+	for (U32 i = 0; i < info.subpassCount; i++)
+	{
+		const VkSubpassDescription& desc = info.pSubpasses[i];
+		SubPass& subpass = subpasses[i];
+		subpass.flags = desc.flags;
+		subpass.pipelineBindPoint = desc.pipelineBindPoint;
+		subpass.inputAttachments.assign(desc.pInputAttachments, desc.pInputAttachments + desc.inputAttachmentCount);
+		subpass.colorAttachments.assign(desc.pColorAttachments, desc.pColorAttachments + desc.colorAttachmentCount);
+		if (desc.pResolveAttachments)
+			subpass.resolveAttachments.assign(desc.pResolveAttachments, desc.pResolveAttachments + desc.colorAttachmentCount);
+		else
+			subpass.resolveAttachments.clear();
+		subpass.preserveAttachments.assign(desc.pPreserveAttachments, desc.pPreserveAttachments + desc.preserveAttachmentCount);
+		subpass.hasDepthStencil = desc.pDepthStencilAttachment != nullptr;
+		if (subpass.hasDepthStencil)
+			subpass.depthStencilAttachment = *desc.pDepthStencilAttachment;
+	}
+}
+
+VkRenderPassCreateInfo RenderPassCreateInfoData::Get(std::vector<VkSubpassDescription>& subpassDescs)const
+{
+	subpassDescs.resize(subpasses.size());
+	for (size_t i = 0; i < subpasses.size(); i++)
+	{
+		const SubPass& subpass = subpasses[i];
+		VkSubpassDescription& desc = subpassDescs[i];
+		desc = {};
+		desc.flags = subpass.flags;
+		desc.pipelineBindPoint = subpass.pipelineBindPoint;
+		desc.inputAttachmentCount = (U32)subpass.inputAttachments.size();
+		desc.pInputAttachments = subpass.inputAttachments.data();
+		desc.colorAttachmentCount = (U32)subpass.colorAttachments.size();
+		desc.pColorAttachments = subpass.colorAttachments.data();
+		desc.pResolveAttachments = subpass.resolveAttachments.empty() ? nullptr : subpass.resolveAttachments.data();
+		desc.preserveAttachmentCount = (U32)subpass.preserveAttachments.size();
+		desc.pPreserveAttachments = subpass.preserveAttachments.data();
+		desc.pDepthStencilAttachment = subpass.hasDepthStencil ? &subpass.depthStencilAttachment : nullptr;
+	}
+
+	VkRenderPassCreateInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+	info.attachmentCount = (U32)attachments.size();
+	info.pAttachments = attachments.data();
+	info.subpassCount = (U32)subpassDescs.size();
+	info.pSubpasses = subpassDescs.data();
+	info.dependencyCount = (U32)dependencies.size();
+	info.pDependencies = dependencies.empty() ? nullptr : dependencies.data();
+	return info;
+}
+
+void RenderPassCreateInfoData::Write(OutputMemoryStream& stream)const
+{
+	WriteArray(stream, attachments);
+	WriteArray(stream, dependencies);
+	stream.Write((U32)subpasses.size());
+	for (const SubPass& subpass : subpasses)
+	{
+		stream.Write(subpass.flags);
+		stream.Write(subpass.pipelineBindPoint);
+		WriteArray(stream, subpass.inputAttachments);
+		WriteArray(stream, subpass.colorAttachments);
+		WriteArray(stream, subpass.resolveAttachments);
+		WriteArray(stream, subpass.preserveAttachments);
+		stream.Write(subpass.hasDepthStencil);
+		stream.Write(subpass.depthStencilAttachment);
+	}
+}
+
+bool RenderPassCreateInfoData::Read(InputMemoryStream& stream)
+{
+	U32 subpassCount = 0;
+	if (!ReadArray(stream, attachments) ||
+		!ReadArray(stream, dependencies) ||
+		!stream.Read(&subpassCount, sizeof(subpassCount)))
+		return false;
+
+	subpasses.resize(subpassCount);
+	for (SubPass& subpass : subpasses)
+	{
+		U8 hasDepthStencil = 0;
+		bool ret = stream.Read(&subpass.flags, sizeof(subpass.flags)) &&
+			stream.Read(&subpass.pipelineBindPoint, sizeof(subpass.pipelineBindPoint)) &&
+			ReadArray(stream, subpass.inputAttachments) &&
+			ReadArray(stream, subpass.colorAttachments) &&
+			ReadArray(stream, subpass.resolveAttachments) &&
+			ReadArray(stream, subpass.preserveAttachments) &&
+			stream.Read(&hasDepthStencil, sizeof(hasDepthStencil)) &&
+			stream.Read(&subpass.depthStencilAttachment, sizeof(subpass.depthStencilAttachment));
+		if (!ret)
+			return false;
+
+		subpass.hasDepthStencil = hasDepthStencil != 0;
+	}
+	return true;
+}
+#endif
+
 void RenderPass::SetupSubPasses(const VkRenderPassCreateInfo& info)
 {
 	for (U32 i = 0; i < info.subpassCount; i++)
@@ -592,10 +715,37 @@ RenderPass::RenderPass(DeviceVulkan& device_, const RenderPassInfo& info) :
 	// Setup subpasses
 	SetupSubPasses(rpInfo);
 
+#ifdef VULKAN_TEST_FOSSILIZE
+	createInfoData.Set(rpInfo);
+#endif
+
 	VkResult res = vkCreateRenderPass(device.device, &rpInfo, nullptr, &renderPass);
 	assert(res == VK_SUCCESS);
 }
 
+RenderPass::RenderPass(DeviceVulkan& device_, const VkRenderPassCreateInfo& createInfo) :
+	device(device_)
+{
+	U32 numColorAttachments = 0;
+	for (U32 i = 0; i < createInfo.attachmentCount; i++)
+	{
+		VkFormat format = createInfo.pAttachments[i].format;
+		if (formatToAspectMask(format) & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
+			depthStencil = format;
+		else if (numColorAttachments < VULKAN_NUM_ATTACHMENTS)
+			colorAttachments[numColorAttachments++] = format;
+	}
+
+	SetupSubPasses(createInfo);
+
+#ifdef VULKAN_TEST_FOSSILIZE
+	createInfoData.Set(createInfo);
+#endif
+
+	VkResult res = vkCreateRenderPass(device.device, &createInfo, nullptr, &renderPass);
+	assert(res == VK_SUCCESS);
+}
+
 RenderPass::~RenderPass()
 {
 	if (renderPass != VK_NULL_HANDLE)
@@ -2,6 +2,10 @@
 
 #include "image.h"
 
+#ifdef VULKAN_TEST_FOSSILIZE
+#include "core\utils\stream.h"
+#endif
+
 namespace VulkanTest
 {
 namespace GPU
@@ -48,6 +52,34 @@ struct RenderPassInfo
     unsigned numSubPasses = 0;
 };
 
+#ifdef VULKAN_TEST_FOSSILIZE
+// Copy of VkRenderPassCreateInfo which owns its arrays, saved by the pipeline state recorder
+struct RenderPassCreateInfoData
+{
+    struct SubPass
+    {
+        VkSubpassDescriptionFlags flags = 0;
+        VkPipelineBindPoint pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        std::vector<VkAttachmentReference> inputAttachments;
+        std::vector<VkAttachmentReference> colorAttachments;
+        std::vector<VkAttachmentReference> resolveAttachments;
+        std::vector<U32> preserveAttachments;
+        VkAttachmentReference depthStencilAttachment = { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+        bool hasDepthStencil = false;
+    };
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<SubPass> subpasses;
+    std::vector<VkSubpassDependency> dependencies;
+
+    void Set(const VkRenderPassCreateInfo& info);
+    // The returned create info points to this data and the subpass descriptions
+    VkRenderPassCreateInfo Get(std::vector<VkSubpassDescription>& subpassDescs)const;
+
+    void Write(OutputMemoryStream& stream)const;
+    bool Read(InputMemoryStream& stream);
+};
+#endif
+
 class RenderPass : public Util::IntrusiveHashMapEnabled<RenderPass>
 {
 private:
@@ -71,8 +103,14 @@ private:
 
     void SetupSubPasses(const VkRenderPassCreateInfo& info);
 
+#ifdef VULKAN_TEST_FOSSILIZE
+    RenderPassCreateInfoData createInfoData;
+#endif
+
 public:
     RenderPass(DeviceVulkan& device_, const RenderPassInfo& info);
+    // Create from the raw create info, used to replay the recorded render passes
+    RenderPass(DeviceVulkan& device_, const VkRenderPassCreateInfo& createInfo);
     ~RenderPass();
 
     RenderPass(const RenderPass&) = delete;
@@ -83,6 +121,13 @@ public:
         return renderPass;
     }
 
+#ifdef VULKAN_TEST_FOSSILIZE
+    const RenderPassCreateInfoData& GetCreateInfoData()const
+    {
+        return createInfoData;
+    }
+#endif
+
     U32 GetNumColorAttachments(U32 subpass)const
     {
         ASSERT(subpass < initedSubpassInfos.size());
@@ -100,6 +100,11 @@ namespace GPU
 			return layout;
 		}
 
+		ShaderStage GetStage()const
+		{
+			return shaderStage;
+		}
+
 	private:
 		bool ReflectShader(ShaderResourceLayout& layout, const U32* spirvData, size_t spirvSize);
 		
@@ -145,6 +150,18 @@ namespace GPU
 			pipelineLayout = layout;
 		}
 
+		// The fallback is drawn while the pipelines of this program are compiled asynchronously,
+		// it must have the same resource layout as this program
+		void SetFallback(ShaderProgram* fallback_)
+		{
+			fallback = fallback_;
+		}
+
+		ShaderProgram* GetFallback()const
+		{
+			return fallback;
+		}
+
 		void AddPipeline(HashValue hash, VkPipeline pipeline);
 		VkPipeline GetPipeline(HashValue hash);
 		void MoveToReadOnly();
@@ -160,6 +177,7 @@ namespace GPU
 		PipelineLayout* pipelineLayout = nullptr;
 		const Shader* shaders[UINT(ShaderStage::Count)] = {};
 		U32 shaderCount = 0;
+		ShaderProgram* fallback = nullptr;
 		VulkanCache<Util::IntrusivePODWrapper<VkPipeline>> pipelines;
 	};
 	using ShaderProgramPtr = IntrusivePtr<ShaderProgram>;
@@ -5,6 +5,7 @@
 #include "core\utils\archive.h"
 #include "core\utils\helper.h"
 #include "core\utils\path.h"
+#include "core\utils\stream.h"
 
 #include <unordered_set>
 #include <filesystem>
@@ -27,6 +28,45 @@ namespace {
 	const std::string EXPORT_SHADER_PATH = ".export/shaders/";
 	const std::string SOURCE_SHADER_PATH = "shaders/";
 
+	// Shader cache file:
+	// ---------------------------
+	// |  ShaderCacheHeader      |
+	// ---------------------------
+	// |  Variants               |
+	// ---------------------------
+	// |  VkPipelineCache data   |
+	// ---------------------------
+	struct ShaderCacheHeader
+	{
+		static constexpr U32 MAGIC = 0x48434853; // 'SHCH'
+		static constexpr U32 VERSION = 0x01;
+
+		U32 magic = MAGIC;
+		U32 version = VERSION;
+		U32 vendorID = 0;
+		U32 deviceID = 0;
+		U32 driverVersion = 0;
+		U8 pipelineCacheUUID[VK_UUID_SIZE] = {};
+		U32 variantCount = 0;
+		U64 pipelineCacheSize = 0;
+	};
+
+	void WriteString(OutputMemoryStream& stream, const std::string& str)
+	{
+		stream.Write((U32)str.size());
+		stream.Write(str.data(), str.size());
+	}
+
+	bool ReadString(InputMemoryStream& stream, std::string& str)
+	{
+		U32 size = 0;
+		if (!stream.Read(&size, sizeof(size)) || stream.GetPos() + size > stream.Size())
+			return false;
+
+		str.resize(size);
+		return stream.Read(str.data(), size);
+	}
+
 	std::mutex locker;
 	std::unordered_set<std::string> registeredShaders;
 	std::unordered_map<HashValue, HashValue> shaderCache;
@@ -47,6 +87,27 @@ namespace {
 #endif
 	}
 
+	// Get the absolute paths of the source files from the metadata of the exported shader
+	bool GetShaderDependencies(const std::string& shaderfilename, std::vector<std::string>& dependencies)
+	{
+		std::string dependencylibrarypath = Helper::ReplaceExtension(shaderfilename, "shadermeta");
+		if (!Helper::FileExists(dependencylibrarypath))
+			return false;
+
+		Archive dependencyLibrary(dependencylibrarypath);
+		if (!dependencyLibrary.IsOpen())
+			return false;
+
+		std::string rootdir = dependencyLibrary.GetSourceDirectory();
+		dependencyLibrary >> dependencies;
+		for (auto& x : dependencies)
+		{
+			x = rootdir + x;
+			Helper::MakePathAbsolute(x);
+		}
+		return true;
+	}
+
 	bool IsShaderOutdated(const std::string& shaderfilename)
 	{
 #ifdef RUNTIME_SHADERCOMPILER_ENABLED
@@ -55,31 +116,21 @@ namespace {
 		if (!Helper::FileExists(filepath))
 			return true; // no shader file = outdated shader, apps can attempt to rebuild it
 
-		std::string dependencylibrarypath = Helper::ReplaceExtension(shaderfilename, "shadermeta");
-		if (!Helper::FileExists(dependencylibrarypath))
-			return false; // no metadata file = no dependency, up to date (for example packaged builds)
+		// no metadata file = no dependency, up to date (for example packaged builds)
+		std::vector<std::string> dependencies;
+		if (!GetShaderDependencies(shaderfilename, dependencies))
+			return false;
 
 		const auto tim = std::filesystem::last_write_time(filepath);
-
-		Archive dependencyLibrary(dependencylibrarypath);
-		if (dependencyLibrary.IsOpen())
+		for (auto& dependencypath : dependencies)
 		{
-			std::string rootdir = dependencyLibrary.GetSourceDirectory();
-			std::vector<std::string> dependencies;
-			dependencyLibrary >> dependencies;
-
-			for (auto& x : dependencies)
+			if (Helper::FileExists(dependencypath))
 			{
-				std::string dependencypath = rootdir + x;
-				Helper::MakePathAbsolute(dependencypath);
-				if (Helper::FileExists(dependencypath))
-				{
-					const auto dep_tim = std::filesystem::last_write_time(dependencypath);
+				const auto dep_tim = std::filesystem::last_write_time(dependencypath);
 
-					if (tim < dep_tim)
-					{
-						return true;
-					}
+				if (tim < dep_tim)
+				{
+					return true;
 				}
 			}
 		}
@@ -125,6 +176,8 @@ ShaderTemplate::ShaderTemplate(DeviceVulkan& device_, ShaderStage stage_, const
 
 ShaderTemplate::~ShaderTemplate()
 {
+	if (recompileHandle)
+		Jobsystem::Wait(&recompileHandle);
 }
 
 bool ShaderTemplate::Initialize()
@@ -138,11 +191,19 @@ bool ShaderTemplate::Initialize()
 }
 
 void ShaderTemplate::Recompile()
-{	
+{
+	// Compiling takes seconds, the variants are recompiled on the background lane
+	// and picked up by their new instance. The previous recompilation is finished first
+	if (recompileHandle)
+		Jobsystem::Wait(&recompileHandle);
+
+	auto recompileFunc = [this](void* data) {
+		RecompileVariant(*static_cast<ShaderTemplateVariant*>(data));
+	};
 	for (auto& variant : variants.GetReadOnly())
-		RecompileVariant(variant);
+		Jobsystem::Run(&variant, recompileFunc, &recompileHandle, Jobsystem::ANY_WORKER, Jobsystem::Priority::Background);
 	for (auto& variant : variants.GetReadWrite())
-		RecompileVariant(variant);
+		Jobsystem::Run(&variant, recompileFunc, &recompileHandle, Jobsystem::ANY_WORKER, Jobsystem::Priority::Background);
 }
 
 ShaderTemplateVariant* ShaderTemplate::RegisterVariant(const ShaderVariantMap& defines)
@@ -161,7 +222,7 @@ ShaderTemplateVariant* ShaderTemplate::RegisterVariant(const ShaderVariantMap& d
 
 	ShaderTemplateVariant* ret = variants.allocate();
 	ret->hash = completeHash;
-	if (!CompileShader(ret, defines))
+	if (!CompileShader(ret, defines, true))
 		return nullptr;
 
 	ret->instance++;
@@ -176,7 +237,8 @@ ShaderTemplateVariant* ShaderTemplate::RegisterVariant(const ShaderVariantMap& d
 
 void ShaderTemplate::RecompileVariant(ShaderTemplateVariant& variant)
 {
-	if (!CompileShader(&variant, variant.defines))
+	// Sources are changed, the cache is skipped
+	if (!CompileShader(&variant, variant.defines, false))
 	{
 		Logger::Error("Failed to compile shader:%s", path.c_str());
 		for (auto& define : variant.defines)
@@ -187,13 +249,19 @@ void ShaderTemplate::RecompileVariant(ShaderTemplateVariant& variant)
 	variant.instance++;
 }
 
-bool ShaderTemplate::CompileShader(ShaderTemplateVariant* variant, const ShaderVariantMap& defines)
+bool ShaderTemplate::CompileShader(ShaderTemplateVariant* variant, const ShaderVariantMap& defines, bool useCache)
 {
+	// Warm start, neither the compiler nor the reflection is required
+	ShaderManager& shaderManager = device.GetShaderManager();
+	if (useCache && shaderManager.LoadCachedVariant(*variant))
+		return true;
+
 #ifdef RUNTIME_SHADERCOMPILER_ENABLED
 	{		
 		ScopedMutex holder(lock);
 		std::string exportShaderPath = EXPORT_SHADER_PATH + path + "." + std::to_string(variant->hash);
 		RegisterShader(exportShaderPath);
+		variant->hasLayout = false;
 
 		if (IsShaderOutdated(exportShaderPath))
 		{
@@ -227,6 +295,7 @@ bool ShaderTemplate::CompileShader(ShaderTemplateVariant* variant, const ShaderV
 
 				variant->spirv.resize(output.shadersize);
 				memcpy(variant->spirv.data(), output.shaderdata, output.shadersize);
+				variant->dependencies = output.dependencies;
 			}
 			else
 			{
@@ -245,8 +314,13 @@ bool ShaderTemplate::CompileShader(ShaderTemplateVariant* variant, const ShaderV
 				Logger::Error("Failed to load export shader:%s", exportShaderPath.c_str());
 				return false;
 			}
+
+			variant->dependencies.clear();
+			GetShaderDependencies(exportShaderPath, variant->dependencies);
 		}
 	}
+
+	shaderManager.UpdateSourceHash(*variant);
 	return true;
 #else
 	ASSERT(false);
@@ -333,7 +407,14 @@ Shader* ShaderTemplateProgramVariant::GetShader(ShaderStage stage)
 				stage,
 				variant->spirv.data(),
 				variant->spirv.size(),
-				nullptr);
+				variant->hasLayout ? &variant->layout : nullptr);
+
+			// Keep the reflected layout for the shader cache
+			if (newShader != nullptr && !variant->hasLayout)
+			{
+				variant->layout = newShader->GetLayout();
+				variant->hasLayout = true;
+			}
 
 #if 0
 			// TODO: TEMP
@@ -442,11 +523,19 @@ ShaderProgram* ShaderTemplateProgramVariant::GetProgramGraphics()
 			Shader* newShader = nullptr;
 			if (!shaderVariants[i]->spirv.empty())
 			{
+				ShaderTemplateVariant* variant = shaderVariants[i];
 				newShader = device.RequestShader(
 					static_cast<ShaderStage>(i),
-					shaderVariants[i]->spirv.data(),
-					shaderVariants[i]->spirv.size(),
-					nullptr);			
+					variant->spirv.data(),
+					variant->spirv.size(),
+					variant->hasLayout ? &variant->layout : nullptr);
+
+				// Keep the reflected layout for the shader cache
+				if (newShader != nullptr && !variant->hasLayout)
+				{
+					variant->layout = newShader->GetLayout();
+					variant->hasLayout = true;
+				}
 #if 0
 				// TODO: TEMP
 				if (newShader && newShader->GetHash() != 0)
@@ -568,7 +657,189 @@ ShaderTemplate* ShaderManager::GetTemplate(ShaderStage stage, const std::string
 
 bool ShaderManager::LoadShaderCache(const char* path)
 {
-	return false;
+	std::vector<uint8_t> data;
+	if (!Helper::FileRead(path, data) || data.empty())
+		return false;
+
+	InputMemoryStream stream(data.data(), data.size());
+	ShaderCacheHeader header;
+	if (!stream.Read(&header, sizeof(header)) ||
+		header.magic != ShaderCacheHeader::MAGIC ||
+		header.version != ShaderCacheHeader::VERSION)
+	{
+		Logger::Warning("Invalid shader cache %s", path);
+		return false;
+	}
+
+	// The cache is only valid for the device and the driver which created it
+	const auto features = device.GetFeatures();
+	const auto& properties = features.properties2.properties;
+	if (header.vendorID != properties.vendorID ||
+		header.deviceID != properties.deviceID ||
+		header.driverVersion != properties.driverVersion ||
+		memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		Logger::Info("Shader cache is created by another device, ignore it");
+		return false;
+	}
+
+	std::unordered_map<HashValue, ShaderCacheEntry> entries;
+	for (U32 i = 0; i < header.variantCount; i++)
+	{
+		HashValue hash = 0;
+		ShaderCacheEntry entry;
+		U32 dependencyCount = 0;
+		U32 spirvSize = 0;
+		bool ret = stream.Read(&hash, sizeof(hash)) &&
+			stream.Read(&entry.sourceHash, sizeof(entry.sourceHash)) &&
+			stream.Read(&entry.layout, sizeof(entry.layout)) &&
+			stream.Read(&dependencyCount, sizeof(dependencyCount));
+		for (U32 dep = 0; ret && dep < dependencyCount; dep++)
+			ret = ReadString(stream, entry.dependencies.emplace_back());
+
+		ret = ret && stream.Read(&spirvSize, sizeof(spirvSize)) && stream.GetPos() + spirvSize <= stream.Size();
+		if (!ret)
+		{
+			Logger::Warning("Invalid shader cache %s", path);
+			return false;
+		}
+
+		entry.spirv.resize(spirvSize);
+		stream.Read(entry.spirv.data(), spirvSize);
+		entries[hash] = std::move(entry);
+	}
+
+	if (stream.GetPos() + header.pipelineCacheSize > stream.Size())
+	{
+		Logger::Warning("Invalid shader cache %s", path);
+		return false;
+	}
+
+	if (header.pipelineCacheSize > 0)
+	{
+		if (!device.InitPipelineCache(data.data() + stream.GetPos(), header.pipelineCacheSize))
+			Logger::Warning("Failed to init pipeline cache.");
+	}
+
+	ScopedMutex holder(cacheLock);
+	cachedVariants = std::move(entries);
+	Logger::Info("Shader cache loaded, %d variants", header.variantCount);
+	return true;
+}
+
+bool ShaderManager::SaveShaderCache(const char* path)
+{
+	ScopedMutex holder(cacheLock);
+
+	// Compiled variants of this run replace the loaded ones
+	auto saveVariant = [&](const ShaderTemplateVariant& variant) {
+		if (variant.spirv.empty() || !variant.hasLayout || variant.sourceHash == 0)
+			return;
+
+		ShaderCacheEntry& entry = cachedVariants[variant.hash];
+		entry.sourceHash = variant.sourceHash;
+		entry.dependencies = variant.dependencies;
+		entry.spirv = variant.spirv;
+		entry.layout = variant.layout;
+	};
+	auto saveTemplate = [&](ShaderTemplate& shaderTemplate) {
+		for (auto& variant : shaderTemplate.variants.GetReadOnly())
+			saveVariant(variant);
+		for (auto& variant : shaderTemplate.variants.GetReadWrite())
+			saveVariant(variant);
+	};
+	for (auto& shaderTemplate : shaders.GetReadOnly())
+		saveTemplate(shaderTemplate);
+	for (auto& shaderTemplate : shaders.GetReadWrite())
+		saveTemplate(shaderTemplate);
+
+	std::vector<uint8_t> pipelineCacheData;
+	if (!device.GetPipelineCacheData(pipelineCacheData))
+		pipelineCacheData.clear();
+
+	const auto features = device.GetFeatures();
+	const auto& properties = features.properties2.properties;
+	ShaderCacheHeader header;
+	header.vendorID = properties.vendorID;
+	header.deviceID = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.variantCount = (U32)cachedVariants.size();
+	header.pipelineCacheSize = pipelineCacheData.size();
+
+	OutputMemoryStream stream;
+	stream.Write(header);
+	for (const auto& kvp : cachedVariants)
+	{
+		const ShaderCacheEntry& entry = kvp.second;
+		stream.Write(kvp.first);
+		stream.Write(entry.sourceHash);
+		stream.Write(entry.layout);
+		stream.Write((U32)entry.dependencies.size());
+		for (const auto& dependency : entry.dependencies)
+			WriteString(stream, dependency);
+		stream.Write((U32)entry.spirv.size());
+		stream.Write(entry.spirv.data(), entry.spirv.size());
+	}
+	stream.Write(pipelineCacheData.data(), pipelineCacheData.size());
+
+	Helper::DirectoryCreate(Helper::GetDirectoryFromPath(path));
+	if (!Helper::FileWrite(path, stream.Data(), stream.Size()))
+	{
+		Logger::Warning("Failed to save shader cache %s", path);
+		return false;
+	}
+	return true;
+}
+
+void ShaderManager::UpdateSourceHash(ShaderTemplateVariant& variant)
+{
+	// Sources may be changed since they were hashed
+	ScopedMutex holder(cacheLock);
+	for (const auto& dependency : variant.dependencies)
+		sourceHashes.erase(dependency);
+	variant.sourceHash = ComputeSourceHash(variant.dependencies);
+}
+
+bool ShaderManager::LoadCachedVariant(ShaderTemplateVariant& variant)
+{
+	ScopedMutex holder(cacheLock);
+	auto it = cachedVariants.find(variant.hash);
+	if (it == cachedVariants.end())
+		return false;
+
+	const ShaderCacheEntry& entry = it->second;
+	const HashValue sourceHash = ComputeSourceHash(entry.dependencies);
+	if (sourceHash != entry.sourceHash)
+		return false;
+
+	variant.spirv = entry.spirv;
+	variant.layout = entry.layout;
+	variant.hasLayout = true;
+	variant.dependencies = entry.dependencies;
+	variant.sourceHash = sourceHash;
+	return true;
+}
+
+HashValue ShaderManager::ComputeSourceHash(const std::vector<std::string>& dependencies)
+{
+	// Included files are shared by variants, so the hash of each file is computed once
+	HashCombiner hasher;
+	for (const auto& dependency : dependencies)
+	{
+		auto it = sourceHashes.find(dependency);
+		if (it == sourceHashes.end())
+		{
+			std::vector<uint8_t> source;
+			if (!Helper::FileRead(dependency, source))
+				return 0;
+
+			HashValue fileHash = RuntimeHash(source.data(), (U32)source.size()).GetHashValue();
+			it = sourceHashes.emplace(dependency, fileHash).first;
+		}
+		hasher.HashCombine(it->second);
+	}
+	return hasher.Get();
 }
 
 void ShaderManager::MoveToReadOnly()
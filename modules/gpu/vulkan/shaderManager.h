@@ -3,8 +3,11 @@
 #include "definition.h"
 #include "shader.h"
 #include "core\platform\sync.h"
+#include "core\jobsystem\jobsystem.h"
 #include "rwSpinLock.h"
 
+#include <unordered_map>
+
 namespace VulkanTest
 {
 namespace GPU
@@ -20,6 +23,22 @@ struct ShaderTemplateVariant : public Util::IntrusiveHashMapEnabled<ShaderTempla
 	std::vector<uint8_t> spirv;
 	ShaderVariantMap defines;
 	volatile U32 instance = 0;
+
+	// Source files of the variant and the hash of their contents, used to validate the shader cache
+	HashValue sourceHash = 0;
+	std::vector<std::string> dependencies;
+	// Reflected layout, the reflection is skipped if it is loaded from the shader cache
+	ShaderResourceLayout layout;
+	bool hasLayout = false;
+};
+
+// Persistent shader cache, variants are keyed by the hash of the path and defines
+struct ShaderCacheEntry
+{
+	HashValue sourceHash = 0;
+	std::vector<std::string> dependencies;
+	std::vector<uint8_t> spirv;
+	ShaderResourceLayout layout;
 };
 
 class ShaderTemplate : public Util::IntrusiveHashMapEnabled<ShaderTemplate>
@@ -40,15 +59,17 @@ public:
 
 private:
 	friend class ShaderTemplateProgram;
+	friend class ShaderManager;
 
 	void RecompileVariant(ShaderTemplateVariant& variant);
-	bool CompileShader(ShaderTemplateVariant* variant, const ShaderVariantMap& defines);
+	bool CompileShader(ShaderTemplateVariant* variant, const ShaderVariantMap& defines, bool useCache);
 
 	DeviceVulkan& device;
 	std::string path;
 	HashValue pathHash;
 	VulkanCache<ShaderTemplateVariant> variants;
 	ShaderStage stage;
+	Jobsystem::JobHandle recompileHandle;
 
 #ifdef VULKAN_MT
 	Mutex lock;
@@ -131,17 +152,29 @@ public:
 	 */
 	ShaderTemplateProgram* RegisterGraphics(const std::string& vertex, const std::string& fragment, const ShaderVariantMap& defines);
 
+	/**
+	 * Load the compiled variants and the pipeline cache, the cache is dropped if it is created by another device.
+	 */
 	bool LoadShaderCache(const char* path);
+	bool SaveShaderCache(const char* path);
+	// Fill the variant from the cache if its sources are not changed
+	bool LoadCachedVariant(ShaderTemplateVariant& variant);
+	void UpdateSourceHash(ShaderTemplateVariant& variant);
 	void MoveToReadOnly();
 
 private:
 	ShaderTemplate* GetTemplate(ShaderStage stage, const std::string filePath);
+	HashValue ComputeSourceHash(const std::vector<std::string>& dependencies);
 
 private:
 	VulkanCache<ShaderTemplate> shaders;
 	VulkanCache<ShaderTemplateProgram> programs;
 	DeviceVulkan& device;
 
+	Mutex cacheLock;
+	std::unordered_map<HashValue, ShaderCacheEntry> cachedVariants;
+	std::unordered_map<std::string, HashValue> sourceHashes;
+
 #ifdef VULKAN_MT
 	Mutex lock;
 #endif
@@ -30,6 +30,11 @@ bool WSI::Initialize(U32 numThread)
 
     // init gpu
     deviceVulkan = CJING_NEW(GPU::DeviceVulkan);
+#ifdef VULKAN_TEST_FOSSILIZE
+    // Record the pipeline states of this run for the offline replay, it is off by default
+    if (pipelineRecording)
+        deviceVulkan->InitPipelineRecording();
+#endif
     deviceVulkan->SetContext(*vulkanContext);
 
     // init surface
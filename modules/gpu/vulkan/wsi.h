@@ -68,6 +68,8 @@ public:
 	void UpdateFrameBuffer(U32 width, U32 height);
 	void SetPlatform(WSIPlatform* platform_);
 	WSIPlatform* GetPlatform();
+	// Save the pipeline states created by the device to the pipeline database, must be set before Initialize
+	void SetPipelineRecording(bool enabled) { pipelineRecording = enabled; }
 
 	GPU::DeviceVulkan* GetDevice();
 	GPU::VulkanContext* GetContext();
@@ -83,6 +85,7 @@ private:
 
 	WSIPlatform* platform = nullptr;
 	bool isExternal = false;
+	bool pipelineRecording = false;
 
 	GPU::VulkanContext* vulkanContext = nullptr;
 	VkSurfaceKHR surface = VK_NULL_HANDLE;
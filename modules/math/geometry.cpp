@@ -1,5 +1,6 @@
 #include "geometry.h"
 #include "vMath_impl.hpp"
+#include "simd.h"
 
 namespace VulkanTest
 {
@@ -149,6 +150,147 @@ namespace VulkanTest
 		planes[3] = StoreF32x4(PlaneNormalize(VectorAdd(t.r[3], t.r[1])));
 	}
 
+	Frustum::BoxFrustumIntersect Frustum::CheckBox(const AABB& box) const
+	{
+		VECTOR max = LoadF32x3(box.max);
+		VECTOR min = LoadF32x3(box.min);
+		VECTOR zero = VectorZero();
+		bool isInside = true;
+		for (size_t p = 0; p < 6; ++p)
+		{
+			VECTOR plane = LoadF32x4(planes[p]);
+			VECTOR lt = VectorLess(plane, zero);
+			VECTOR furthestFromPlane = VectorSelect(max, min, lt);
+			if (VectorGetX(PlaneDotCoord(plane, furthestFromPlane)) < 0.0f)
+				return BOX_FRUSTUM_OUTSIDE;
+
+			// The box is inside only if the nearest corner is in front of every plane
+			VECTOR nearestToPlane = VectorSelect(min, max, lt);
+			if (VectorGetX(PlaneDotCoord(plane, nearestToPlane)) < 0.0f)
+				isInside = false;
+		}
+		return isInside ? BOX_FRUSTUM_INSIDE : BOX_FRUSTUM_INTERSECTS;
+	}
+
+#if defined(__AVX__)
+	// 8 boxes at once, returns the count of the checked boxes
+	static U32 CheckBoxesAVX(const F32x4* planes, const BoxArraySoA& boxes, U32 count, U32* visibleMask)
+	{
+		U32 i = 0;
+
+		__m256 nx[6], ny[6], nz[6], nd[6], ax[6], ay[6], az[6];
+		for (U32 p = 0; p < 6; p++)
+		{
+			nx[p] = _mm256_set1_ps(planes[p].x);
+			ny[p] = _mm256_set1_ps(planes[p].y);
+			nz[p] = _mm256_set1_ps(planes[p].z);
+			nd[p] = _mm256_set1_ps(planes[p].w);
+			ax[p] = _mm256_set1_ps(std::abs(planes[p].x));
+			ay[p] = _mm256_set1_ps(std::abs(planes[p].y));
+			az[p] = _mm256_set1_ps(std::abs(planes[p].z));
+		}
+
+		const __m256 zero = _mm256_setzero_ps();
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 cx = _mm256_loadu_ps(boxes.centerX + i);
+			const __m256 cy = _mm256_loadu_ps(boxes.centerY + i);
+			const __m256 cz = _mm256_loadu_ps(boxes.centerZ + i);
+			const __m256 ex = _mm256_loadu_ps(boxes.extentX + i);
+			const __m256 ey = _mm256_loadu_ps(boxes.extentY + i);
+			const __m256 ez = _mm256_loadu_ps(boxes.extentZ + i);
+
+			__m256 outside = zero;
+			for (U32 p = 0; p < 6; p++)
+			{
+				__m256 dist = _mm256_add_ps(_mm256_mul_ps(nx[p], cx), nd[p]);
+				dist = _mm256_add_ps(_mm256_mul_ps(ny[p], cy), dist);
+				dist = _mm256_add_ps(_mm256_mul_ps(nz[p], cz), dist);
+				dist = _mm256_add_ps(_mm256_mul_ps(ax[p], ex), dist);
+				dist = _mm256_add_ps(_mm256_mul_ps(ay[p], ey), dist);
+				dist = _mm256_add_ps(_mm256_mul_ps(az[p], ez), dist);
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, zero, _CMP_LT_OQ));
+			}
+
+			const U32 visible = ~(U32)_mm256_movemask_ps(outside) & 0xFF;
+			visibleMask[i >> 5] |= visible << (i & 31);
+		}
+
+		// Avoid the AVX to SSE transition penalty in the remaining loops
+		_mm256_zeroupper();
+		return i;
+	}
+#endif
+
+	void Frustum::CheckBoxes(const BoxArraySoA& boxes, U32 count, U32* visibleMask) const
+	{
+		memset(visibleMask, 0, ((count + 31) / 32) * sizeof(U32));
+
+		// The box is outside when the distance of its furthest corner along the normal is negative:
+		// dot(n, center) + d + dot(|n|, extent) < 0
+		U32 i = 0;
+#if defined(__AVX__)
+		if (IsAVXSupported())
+			i = CheckBoxesAVX(planes, boxes, count, visibleMask);
+#endif
+#if defined(CJING_SIMD_SSE)
+		FVector nx[6], ny[6], nz[6], nd[6], ax[6], ay[6], az[6];
+		for (U32 p = 0; p < 6; p++)
+		{
+			nx[p] = FVSplat(planes[p].x);
+			ny[p] = FVSplat(planes[p].y);
+			nz[p] = FVSplat(planes[p].z);
+			nd[p] = FVSplat(planes[p].w);
+			ax[p] = FVAbs(nx[p]);
+			ay[p] = FVAbs(ny[p]);
+			az[p] = FVAbs(nz[p]);
+		}
+
+		const FVector zero = FVZero();
+		for (; i + 4 <= count; i += 4)
+		{
+			const FVector cx = FVLoadUnaligned(boxes.centerX + i);
+			const FVector cy = FVLoadUnaligned(boxes.centerY + i);
+			const FVector cz = FVLoadUnaligned(boxes.centerZ + i);
+			const FVector ex = FVLoadUnaligned(boxes.extentX + i);
+			const FVector ey = FVLoadUnaligned(boxes.extentY + i);
+			const FVector ez = FVLoadUnaligned(boxes.extentZ + i);
+
+			FVector outside = zero;
+			for (U32 p = 0; p < 6; p++)
+			{
+				FVector dist = FVMulAdd(nx[p], cx, nd[p]);
+				dist = FVMulAdd(ny[p], cy, dist);
+				dist = FVMulAdd(nz[p], cz, dist);
+				dist = FVMulAdd(ax[p], ex, dist);
+				dist = FVMulAdd(ay[p], ey, dist);
+				dist = FVMulAdd(az[p], ez, dist);
+				outside = FVOr(outside, FVLess(dist, zero));
+			}
+
+			const U32 visible = ~FVMoveMask(outside) & 0xF;
+			visibleMask[i >> 5] |= visible << (i & 31);
+		}
+#endif
+
+		// Remaining boxes, or all of them without SIMD
+		for (; i < count; i++)
+		{
+			bool isOutside = false;
+			for (U32 p = 0; p < 6 && !isOutside; p++)
+			{
+				const F32x4& plane = planes[p];
+				const F32 dist =
+					plane.x * boxes.centerX[i] + plane.y * boxes.centerY[i] + plane.z * boxes.centerZ[i] + plane.w +
+					std::abs(plane.x) * boxes.extentX[i] + std::abs(plane.y) * boxes.extentY[i] + std::abs(plane.z) * boxes.extentZ[i];
+				isOutside = dist < 0.0f;
+			}
+
+			if (!isOutside)
+				visibleMask[i >> 5] |= 1u << (i & 31);
+		}
+	}
+
 	bool Frustum::CheckBoxFast(const AABB& box) const
 	{
 		VECTOR max = LoadF32x3(box.max);
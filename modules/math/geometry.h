@@ -56,6 +56,17 @@ namespace VulkanTest
 		bool Intersects(const Ray& ray) const;
 	};
 
+	// Structure of arrays view of boxes given by their centers and half extents
+	struct BoxArraySoA
+	{
+		const F32* centerX = nullptr;
+		const F32* centerY = nullptr;
+		const F32* centerZ = nullptr;
+		const F32* extentX = nullptr;
+		const F32* extentY = nullptr;
+		const F32* extentZ = nullptr;
+	};
+
 	struct Frustum
 	{
 		enum class Planes
@@ -84,6 +95,10 @@ namespace VulkanTest
 		BoxFrustumIntersect CheckBox(const AABB& box) const;
 		bool CheckBoxFast(const AABB& box) const;
 
+		// Same test as CheckBoxFast for count boxes, 8 at once when the CPU supports AVX, 4 with SSE, one by one otherwise.
+		// Bit i of visibleMask is set when the box i is not outside, it holds (count + 31) / 32 words
+		void CheckBoxes(const BoxArraySoA& boxes, U32 count, U32* visibleMask) const;
+
 		const F32x4& GetPlane(Planes plane) const
 		{
 			return planes[(U32)plane];
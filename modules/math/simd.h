@@ -25,9 +25,33 @@
 #include <arm_neon.h>
 #endif
 
+#if defined(CJING3D_PLATFORM_WIN32) || defined(__SSE__)
+#define CJING_SIMD_SSE 1
+#endif
+
 namespace VulkanTest
 {
-#ifdef CJING3D_PLATFORM_WIN32
+#if defined(__AVX__)
+	// The AVX kernels are built without /arch:AVX, they are selected at runtime
+	// when the CPU supports AVX and the OS saves the YMM registers
+	inline bool IsAVXSupported()
+	{
+		static const bool supported = []() {
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+			return __builtin_cpu_supports("avx") != 0;
+#endif
+		}();
+		return supported;
+	}
+#endif
+
+#ifdef CJING_SIMD_SSE
 	using FVector = __m128;
 
 	CJING_FORCE_INLINE FVector FVLoadUnaligned(const void* src)
@@ -67,6 +91,49 @@ namespace VulkanTest
 		FVector r = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 3));
 		return _mm_cvtss_f32(r);
 	}
+
+	CJING_FORCE_INLINE FVector FVZero()
+	{
+		return _mm_setzero_ps();
+	}
+
+	CJING_FORCE_INLINE FVector FVAdd(FVector a, FVector b)
+	{
+		return _mm_add_ps(a, b);
+	}
+
+	CJING_FORCE_INLINE FVector FVMul(FVector a, FVector b)
+	{
+		return _mm_mul_ps(a, b);
+	}
+
+	// a * b + c
+	CJING_FORCE_INLINE FVector FVMulAdd(FVector a, FVector b, FVector c)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, b), c);
+	}
+
+	CJING_FORCE_INLINE FVector FVAbs(FVector v)
+	{
+		return _mm_andnot_ps(_mm_set_ps1(-0.0f), v);
+	}
+
+	CJING_FORCE_INLINE FVector FVOr(FVector a, FVector b)
+	{
+		return _mm_or_ps(a, b);
+	}
+
+	// All bits of the component are set when a < b
+	CJING_FORCE_INLINE FVector FVLess(FVector a, FVector b)
+	{
+		return _mm_cmplt_ps(a, b);
+	}
+
+	// Sign bits of the components, x is the lowest bit
+	CJING_FORCE_INLINE U32 FVMoveMask(FVector v)
+	{
+		return (U32)_mm_movemask_ps(v);
+	}
 #else
 	struct FVector
 	{
@@ -1,29 +1,96 @@
 #include "culling.h"
 #include "renderer.h"
 #include "renderScene.h"
+#include "sceneBVH.h"
+#include "core\jobsystem\jobsystem.h"
+#include "core\utils\profiler.h"
 
 namespace VulkanTest
 {   
     class CullingSystemImpl : public CullingSystem
     {
     public:
-        void Cull(Visibility& vis, RenderScene& scene) override
+        // Smaller scenes are culled on the calling thread
+        static const U32 PARALLEL_OBJECT_COUNT = 4096;
+        static const U32 TASKS_PER_WORKER = 4;
+
+        // Each task culls one subtree of the BVH for all views into its own lists,
+        // the lists are concatenated in the task order so the result doesn't depend on the scheduling
+        struct CullTask
+        {
+            U32 root = 0;
+            Array<ECS::EntityID> objects[SceneBVH::MAX_CULL_VIEWS];
+        };
+
+        void CullViews(Span<Visibility*> views, const SceneBVH& bvh, const Array<ECS::EntityID>& bvhObjects) override
+        {
+            PROFILE_FUNCTION();
+            for (Visibility* vis : views)
+            {
+                if (vis->camera != nullptr)
+                    vis->frustum = vis->camera->frustum;
+            }
+
+            if (bvh.IsEmpty())
+                return;
+
+            U32 taskCount = 1;
+            if (bvh.GetItemCount() >= PARALLEL_OBJECT_COUNT)
+                taskCount = (Jobsystem::GetWorkerCount() + 1) * TASKS_PER_WORKER;
+
+            bvh.GetSubtrees(taskCount, subtrees);
+            tasks.resize(subtrees.size());
+            for (U32 i = 0; i < subtrees.size(); i++)
+                tasks[i].root = subtrees[i];
+
+            for (U32 viewOffset = 0; viewOffset < views.length(); viewOffset += SceneBVH::MAX_CULL_VIEWS)
+            {
+                const U32 viewCount = std::min((U32)views.length() - viewOffset, SceneBVH::MAX_CULL_VIEWS);
+                CullViewGroup(bvh, bvhObjects, Span<Visibility*>(views.data() + viewOffset, viewCount));
+            }
+        }
+
+    private:
+        void CullViewGroup(const SceneBVH& bvh, const Array<ECS::EntityID>& bvhObjects, Span<Visibility*> views)
         {
-            vis.frustum = vis.camera->frustum;
+            const U32 viewCount = (U32)views.length();
+            Frustum frustums[SceneBVH::MAX_CULL_VIEWS];
+            for (U32 view = 0; view < viewCount; view++)
+                frustums[view] = views[view]->frustum;
 
-            scene.ForEachObjects([&](ECS::EntityID entity, ObjectComponent& obj) 
+            Jobsystem::ForEach(tasks.size(), 1, [&](U32 taskIndex) {
+                CullTask& task = tasks[taskIndex];
+                for (U32 view = 0; view < viewCount; view++)
+                    task.objects[view].clear();
+
+                bvh.CullViews(frustums, viewCount, task.root, [&](U32 view, U32 index) {
+                    task.objects[view].push_back(bvhObjects[index]);
+                });
+            });
+
+            for (U32 view = 0; view < viewCount; view++)
             {
-                if (obj.mesh != ECS::INVALID_ENTITY)
+                Array<ECS::EntityID>& objects = views[view]->objects;
+                U32 offset = objects.size();
+                U32 count = 0;
+                for (const CullTask& task : tasks)
+                    count += task.objects[view].size();
+
+                objects.resize(offset + count);
+                for (const CullTask& task : tasks)
                 {
-                    if (vis.frustum.CheckBoxFast(obj.aabb))
-                        vis.objects.push_back(entity);
+                    for (const ECS::EntityID& entity : task.objects[view])
+                        objects[offset++] = entity;
                 }
-            });
+            }
         }
+
+        Array<U32> subtrees;
+        Array<CullTask> tasks;
     };
 
     UniquePtr<CullingSystem> CullingSystem::Create()
     {
         return CJING_MAKE_UNIQUE<CullingSystemImpl>();
     }
-}
\ No newline at end of file
+}
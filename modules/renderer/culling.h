@@ -41,6 +41,21 @@ namespace VulkanTest
 
         static UniquePtr<CullingSystem> Create();
 
-        virtual void Cull(Visibility& vis, RenderScene& scene) = 0;
+        void Cull(Visibility& vis, RenderScene& scene)
+        {
+            Visibility* views[] = { &vis };
+            CullViews(Span<Visibility*>(views), scene);
+        }
+
+        // Cull several views in one pass (main camera, shadow cascades...), the views without camera
+        // use their own frustum. The objects are appended to the lists of the views
+        void CullViews(Span<Visibility*> views, RenderScene& scene)
+        {
+            CullViews(views, scene.GetObjectBVH(), scene.GetBVHObjects());
+        }
+
+        // Same as above with the BVH and its objects, the objects of each view are appended in the item
+        // order of the BVH whatever the worker count
+        virtual void CullViews(Span<Visibility*> views, const SceneBVH& bvh, const Array<ECS::EntityID>& bvhObjects) = 0;
     };
 }
\ No newline at end of file
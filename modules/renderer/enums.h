@@ -36,6 +36,7 @@ namespace VulkanTest
 		SHADERTYPE_CS_POSTPROCESS_BLUR_GAUSSIAN,
 
 		SHADERTYPE_PS_OBJECT,
+		SHADERTYPE_PS_OBJECT_FALLBACK,
 		SHADERTYPE_PS_PREPASS,
 		SHADERTYPE_PS_VERTEXCOLOR,
 		SHADERTYPE_PS_POSTPROCESS_OUTLINE,
@@ -20,6 +20,11 @@ namespace VulkanTest
 
 		int texture(lua_State* l)
 		{
+			const char* path = lua_tostring(l, 1);
+			lua_getglobal(l, "this");
+			Material* material = (Material*)lua_touserdata(l, -1);
+			lua_pop(l, 1);
+			material->AddTexture(path);
 			return 0;
 		}
 	}
@@ -60,6 +65,7 @@ namespace VulkanTest
 	{
 		PROFILE_FUNCTION();
 
+		textureCount = 0;
 		MaterialFactory& factory = static_cast<MaterialFactory&>(GetResourceFactoyr());
 		LuaConfig& luaConfig = factory.GetLuaConfig();
 		luaConfig.AddLightUserdata("this", this);
@@ -74,6 +80,21 @@ namespace VulkanTest
 
 	void Material::OnUnLoaded()
 	{
+		for (auto& texture : textures)
+			texture.reset();
+		textureCount = 0;
+
 		Logger::Print("Material unloaded %s", GetPath().c_str());
 	}
+
+	void Material::AddTexture(const char* path)
+	{
+		if (textureCount >= Texture::COUNT)
+			return;
+
+		// Textures are not dependencies, the streamer only uses the loaded ones
+		const U32 index = textureCount++;
+		if (path != nullptr && path[0] != '\0')
+			textures[index] = GetResourceManager().LoadResourcePtr<Texture>(Path(path));
+	}
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "core\scripts\luaConfig.h"
 #include "math\color.h"
 #include "renderer\shader.h"
+#include "renderer\texture.h"
 #include "enums.h"
 
 namespace VulkanTest
@@ -49,6 +50,10 @@ namespace VulkanTest
 		bool IsCastingShadow() const { return flags & CAST_SHADOW; }
 		bool IsDoubleSided() const { return  flags & DOUBLE_SIDED; }
 
+		// The texture lines of the material are in the order of the texture types, an empty path keeps the slot empty
+		void AddTexture(const char* path);
+		Texture* GetTexture(Texture::TextureType type) { return textures[type] ? textures[type].get() : nullptr; }
+
 	protected:
 		bool OnLoaded(U64 size, const U8* mem) override;
 		void OnUnLoaded() override;
@@ -58,5 +63,7 @@ namespace VulkanTest
 		BlendMode blendMode = BlendMode::BLENDMODE_OPAQUE;
 		U32 flags = EMPTY;
 		ResPtr<Shader> shader;
+		ResPtr<Texture> textures[Texture::COUNT];
+		U32 textureCount = 0;
 	};
 }
\ No newline at end of file
@@ -98,6 +98,7 @@ namespace VulkanTest
         GPU::SemaphorePtr computeSemaphore;
 
         std::vector<VkSubpassContents> subpassContents;
+        std::vector<U32> parallelCounts;
 
         Jobsystem::JobHandle renderingDependency;
         Jobsystem::JobHandle submissionHandle;
@@ -150,6 +151,7 @@ namespace VulkanTest
         void HandleFlushBarrier(const Barrier& barrier, GPUPassSubmissionState& state);  
         void DoGraphicsCommands(GPU::CommandList& cmd, const PhysicalPass& physicalPass, GPUPassSubmissionState* state);
         void DoComputeCommands(GPU::CommandList& cmd, const PhysicalPass& physicalPass, GPUPassSubmissionState* state);
+        void DoParallelGraphicsCommands(GPU::CommandList& cmd, RenderPass& pass, U32 count);
         void TransferOwnership(const PhysicalPass& physicalPass);
         void HandleTimelineGPU(GPU::DeviceVulkan& device, const PhysicalPass& physicalPass, GPUPassSubmissionState* state, U8 index);
         void EnqueueRenderPass(PhysicalPass& physicalPass, GPUPassSubmissionState& state);
@@ -1602,19 +1604,29 @@ namespace VulkanTest
             physicalPass.depthClearRequest.pass->GetClearDepthStencil(physicalPass.depthClearRequest.target);
 
         // Begin render pass
-        cmd.BeginRenderPass(physicalPass.renderPassInfo);
+        cmd.BeginRenderPass(physicalPass.renderPassInfo, state->subpassContents[0]);
 
         // Handle subpasses
         for (U32 i = 0; i < physicalPass.passes.size(); i++)
         {
             auto& passIndex = physicalPass.passes[i];
             auto& pass = *renderPasses[passIndex];
-            cmd.BeginEvent(pass.GetName().c_str());
-            pass.BuildRenderPass(cmd);
-            cmd.EndEvent();
+            if (state->subpassContents[i] == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+            {
+                DoParallelGraphicsCommands(cmd, pass, state->parallelCounts[i]);
+            }
+            else
+            {
+                cmd.BeginEvent(pass.GetName().c_str());
+                if (pass.IsParallel())
+                    pass.BuildRenderPass(cmd, 0, state->parallelCounts[i]);
+                else
+                    pass.BuildRenderPass(cmd);
+                cmd.EndEvent();
+            }
 
             if (i < (physicalPass.passes.size() - 1))
-                cmd.NextSubpass(VK_SUBPASS_CONTENTS_INLINE);
+                cmd.NextSubpass(state->subpassContents[i + 1]);
         }
 
         // End render pass
@@ -1623,12 +1635,40 @@ namespace VulkanTest
         cmd.EndEvent();
     }
 
+    void RenderGraphImpl::DoParallelGraphicsCommands(GPU::CommandList& cmd, RenderPass& pass, U32 count)
+    {
+        // One secondary command list for each group, the calling worker records groups too
+        const U32 groupSize = pass.GetParallelGroupSize();
+        const U32 groupCount = std::min((count + groupSize - 1) / groupSize, Jobsystem::GetWorkerCount() + 1);
+        std::vector<GPU::CommandListPtr> secondaries(groupCount);
+        Jobsystem::ForEach(groupCount, 1, [&](U32 group) {
+            const U32 begin = U32((U64)count * group / groupCount);
+            const U32 end = U32((U64)count * (group + 1) / groupCount);
+
+            GPU::CommandListPtr secondary = cmd.GetDevice().RequestSecondaryCommandList(cmd);
+            secondary->BeginEvent(pass.GetName().c_str());
+            pass.BuildRenderPass(*secondary, begin, end);
+            secondary->EndEvent();
+
+            // We end this cmd on a same thread we requested it on
+            secondary->EndCommandBufferForThread();
+            secondaries[group] = secondary;
+        });
+
+        // Stitch the secondaries in submission order
+        for (auto& secondary : secondaries)
+            cmd.SubmitSecondary(secondary);
+    }
+
     void RenderGraphImpl::DoComputeCommands(GPU::CommandList& cmd, const PhysicalPass& physicalPass, GPUPassSubmissionState* state)
     {
         ASSERT(physicalPass.passes.size() == 1);
         auto& pass = *renderPasses[physicalPass.passes[0]];
         cmd.BeginEvent(pass.GetName().c_str());
-        pass.BuildRenderPass(cmd);
+        if (pass.IsParallel())
+            pass.BuildRenderPass(cmd, 0, state->parallelCounts[0]);
+        else
+            pass.BuildRenderPass(cmd);
         cmd.EndEvent();
     }
 
@@ -1650,7 +1690,7 @@ namespace VulkanTest
 
     void RenderGraphImpl::HandleTimelineGPU(GPU::DeviceVulkan& device, const PhysicalPass& physicalPass, GPUPassSubmissionState* state, U8 index)
     {
-        ASSERT(state->renderingDependency.counter == 0);
+        ASSERT(state->renderingDependency.GetCounter() == 0);
         Jobsystem::Run(state, [this, &device, &physicalPass](void* data)->void {
             GPUPassSubmissionState* state = (GPUPassSubmissionState*)data;
             if (state == nullptr)
@@ -1673,7 +1713,8 @@ namespace VulkanTest
             Logger::Print("Pass %s execute", state->name);
 #endif
 
-        // TODO: need to limit worker index?
+        // The job is pinned, the command pools are owned by threads and the job may be resumed
+        // after waiting on the parallel recording. The index wraps around the workers
         }, & state->renderingDependency, index);
     }
 
@@ -1745,12 +1786,23 @@ namespace VulkanTest
         state.subpassContents.resize(physicalPass.passes.size());
         for (auto& c : state.subpassContents)
             c = VK_SUBPASS_CONTENTS_INLINE;
+        state.parallelCounts.resize(physicalPass.passes.size());
+        for (auto& count : state.parallelCounts)
+            count = 0;
 
         // Prepare render passes
-        for (auto& passIndex : physicalPass.passes)
+        for (U32 i = 0; i < physicalPass.passes.size(); i++)
         {
-            RenderPass& subpass = *renderPasses[passIndex];
+            RenderPass& subpass = *renderPasses[physicalPass.passes[i]];
             subpass.EnqueuePrepareRenderPass();
+
+            // Large graphics passes are recorded into secondary command lists in parallel
+            if (subpass.IsParallel())
+            {
+                state.parallelCounts[i] = subpass.GetParallelCount();
+                if (state.isGraphics && state.parallelCounts[i] > subpass.GetParallelGroupSize())
+                    state.subpassContents[i] = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+            }
         }
 
         state.active = true;
@@ -1840,15 +1892,17 @@ namespace VulkanTest
             EnqueueRenderPass(physicalPass, state);
         }
 
+        // Record the active passes in parallel, spread over the workers
+        U32 activeCount = 0;
         for (U32 i = 0; i < submissionStates.size(); i++)
         {
             auto& state = submissionStates[i];
             if (state.active)
-                HandleTimelineGPU(device, physicalPasses[i], &state, (U8)i);
+                HandleTimelineGPU(device, physicalPasses[i], &state, U8(activeCount++ % Jobsystem::GetWorkerCount()));
         }
 
         // Sequential submit all states
-        ASSERT(submitHandle.counter == 0);
+        ASSERT(submitHandle.GetCounter() == 0);
         Jobsystem::Run(nullptr, [this](void* data)->void {
             for (auto& state : submissionStates)
             {
@@ -265,6 +265,8 @@ private:
 
 using EnqueuePrepareFunc = std::function<void()>;
 using BuildRenderPassFunc = std::function<void(GPU::CommandList&)>;
+using GetParallelCountFunc = std::function<U32()>;
+using BuildRenderPassParallelFunc = std::function<void(GPU::CommandList&, U32 begin, U32 end)>;
 using ClearDepthStencilFunc = std::function<bool(VkClearDepthStencilValue* value)>;
 using ClearColorFunc = std::function<bool(U32 index, VkClearColorValue* value)>;
 
@@ -272,6 +274,7 @@ class VULKAN_TEST_API RenderPass
 {
 public:
     enum { Unused = ~0u };
+    static const U32 DEFAULT_PARALLEL_GROUP_SIZE = 256;
 
     struct AccessedResource
     {
@@ -302,6 +305,16 @@ public:
         buildRenderPassCallback = std::move(func);
     }
 
+    // The pass records the items [0, countFunc()) which are split into secondary command lists recorded
+    // on the job system workers, the ranges are executed in order. func is called concurrently with
+    // disjoint ranges and must not wait on jobs. Graphics passes with at most groupSize items are recorded inline
+    void SetParallelBuildCallback(GetParallelCountFunc countFunc, BuildRenderPassParallelFunc func, U32 groupSize = DEFAULT_PARALLEL_GROUP_SIZE)
+    {
+        parallelCountCallback = std::move(countFunc);
+        buildRenderPassParallelCallback = std::move(func);
+        parallelGroupSize = std::max(groupSize, 1u);
+    }
+
     void SetClearDepthStencilCallback(ClearDepthStencilFunc func)
     {
         clearDepthStencilCallback = std::move(func);
@@ -336,6 +349,29 @@ public:
     {
         if (buildRenderPassCallback != nullptr)
             return buildRenderPassCallback(cmd);
+        if (buildRenderPassParallelCallback != nullptr)
+            return buildRenderPassParallelCallback(cmd, 0, GetParallelCount());
+    }
+
+    void BuildRenderPass(GPU::CommandList& cmd, U32 begin, U32 end)
+    {
+        if (buildRenderPassParallelCallback != nullptr)
+            return buildRenderPassParallelCallback(cmd, begin, end);
+    }
+
+    bool IsParallel()const
+    {
+        return buildRenderPassCallback == nullptr && buildRenderPassParallelCallback != nullptr;
+    }
+
+    U32 GetParallelCount()const
+    {
+        return parallelCountCallback != nullptr ? parallelCountCallback() : 0;
+    }
+
+    U32 GetParallelGroupSize()const
+    {
+        return parallelGroupSize;
     }
 
     bool NeedRenderPass() const
@@ -466,6 +502,9 @@ private:
 
     EnqueuePrepareFunc enqueuePrepareCallback;
     BuildRenderPassFunc buildRenderPassCallback;
+    GetParallelCountFunc parallelCountCallback;
+    BuildRenderPassParallelFunc buildRenderPassParallelCallback;
+    U32 parallelGroupSize = DEFAULT_PARALLEL_GROUP_SIZE;
     ClearDepthStencilFunc clearDepthStencilCallback;
     ClearColorFunc clearColorCallback;
 
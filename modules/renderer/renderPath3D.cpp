@@ -72,14 +72,14 @@ namespace VulkanTest
 		auto& preDepthPass = renderGraph.AddRenderPass("PreDepth", RenderGraphQueueFlag::Graphics);
 		preDepthPass.WriteDepthStencil(SetDepthStencil("depth"), depth);
 		preDepthPass.SetClearDepthStencilCallback(DefaultClearDepthFunc);
-		preDepthPass.SetBuildCallback([&](GPU::CommandList& cmd) {
+		preDepthPass.SetParallelBuildCallback([&]() { return (U32)visibility.objects.size(); }, [&](GPU::CommandList& cmd, U32 begin, U32 end) {
 
 			GPU::Viewport viewport;
 			viewport.width = (F32)backbufferDim.width;
 			viewport.height = (F32)backbufferDim.height;
 			cmd.SetViewport(viewport);
 			Renderer::BindCameraCB(*camera, cmd);
-			Renderer::DrawScene(cmd, visibility, RENDERPASS_PREPASS);
+			Renderer::DrawScene(cmd, visibility, RENDERPASS_PREPASS, begin, end);
 		});
 
 		///////////////////////////////////////////////////////////////////////////////////////////////
@@ -89,7 +89,7 @@ namespace VulkanTest
 		opaquePass.SetClearColorCallback(DefaultClearColorFunc);
 		opaquePass.ReadDepthStencil(GetDepthStencil());
 		opaquePass.AddProxyOutput("opaque", VK_PIPELINE_STAGE_NONE_KHR);
-		opaquePass.SetBuildCallback([&](GPU::CommandList& cmd) {
+		opaquePass.SetParallelBuildCallback([&]() { return (U32)visibility.objects.size(); }, [&](GPU::CommandList& cmd, U32 begin, U32 end) {
 
 			GPU::Viewport viewport;
 			viewport.width = (F32)backbufferDim.width;
@@ -97,7 +97,7 @@ namespace VulkanTest
 			cmd.SetViewport(viewport);
 
 			Renderer::BindCameraCB(*camera, cmd);
-			Renderer::DrawScene(cmd, visibility, RENDERPASS_MAIN);
+			Renderer::DrawScene(cmd, visibility, RENDERPASS_MAIN, begin, end);
 		});
 
 		///////////////////////////////////////////////////////////////////////////////////////////////
@@ -1,8 +1,10 @@
 #include "RenderScene.h"
 #include "renderer.h"
 #include "culling.h"
+#include "transformHierarchy.h"
 #include "gpu\vulkan\wsi.h"
 #include "core\scene\reflection.h"
+#include "core\utils\profiler.h"
 
 namespace VulkanTest
 {
@@ -32,9 +34,17 @@ namespace VulkanTest
         up = StoreF32x3(Vector3Normalize(Vector3TransformNormal(XMVectorSet(0, 1, 0, 0), mat)));
     }
 
+    // GPU array of the scene data with stable slots, the freed slots are reused.
+    // The data is kept on the CPU and only the dirty slots are copied through the upload buffer of the frame
     template<typename T>
     struct RenderSceneBuffer
     {
+        struct FreeRange
+        {
+            U32 offset;
+            U32 count;
+        };
+
         String name;
         String uploadName;
 
@@ -43,6 +53,11 @@ namespace VulkanTest
         GPU::BufferPtr uploadBuffers[2];
         GPU::BindlessDescriptorPtr bindless;
 
+        Array<T> data;
+        Array<FreeRange> freeRanges;
+        Array<U32> dirtyBits;
+        Array<VkBufferCopy> copyRegions;
+
         RenderSceneBuffer(const char* name_) :
             name(name_),
             uploadName(name_)
@@ -55,8 +70,85 @@ namespace VulkanTest
             return buffer && arraySize > 0;
         }
 
-        void UpdateBuffer(GPU::DeviceVulkan& device, U32 arraySize_)
+        U32 Allocate(U32 count)
+        {
+            ASSERT(count > 0);
+            U32 offset = INVALID_SCENE_SLOT;
+            for (U32 i = 0; i < freeRanges.size(); i++)
+            {
+                FreeRange& range = freeRanges[i];
+                if (range.count < count)
+                    continue;
+
+                offset = range.offset;
+                range.offset += count;
+                range.count -= count;
+                if (range.count == 0)
+                    freeRanges.swapAndPop(i);
+                break;
+            }
+
+            if (offset == INVALID_SCENE_SLOT)
+            {
+                offset = data.size();
+                data.resize(offset + count);
+            }
+
+            // The GPU content of the new or reused slots is undefined
+            for (U32 slot = offset; slot < offset + count; slot++)
+                MarkDirty(slot);
+            return offset;
+        }
+
+        void Free(U32 offset, U32 count)
+        {
+            if (offset == INVALID_SCENE_SLOT || count == 0)
+                return;
+
+            // Merge the adjacent free ranges, so the freed slots can be reused by larger allocations
+            for (I32 i = (I32)freeRanges.size() - 1; i >= 0; i--)
+            {
+                const FreeRange range = freeRanges[i];
+                if (range.offset + range.count == offset)
+                {
+                    offset = range.offset;
+                    count += range.count;
+                    freeRanges.swapAndPop(i);
+                }
+                else if (offset + count == range.offset)
+                {
+                    count += range.count;
+                    freeRanges.swapAndPop(i);
+                }
+            }
+            freeRanges.push_back({ offset, count });
+        }
+
+        void MarkDirty(U32 slot)
         {
+            const U32 word = slot >> 5;
+            if (word >= dirtyBits.size())
+            {
+                const U32 oldSize = dirtyBits.size();
+                dirtyBits.resize(word + 1);
+                memset(dirtyBits.data() + oldSize, 0, (dirtyBits.size() - oldSize) * sizeof(U32));
+            }
+            dirtyBits[word] |= 1u << (slot & 31);
+        }
+
+        // The slot is uploaded only when its content is changed
+        void Write(U32 slot, const T& value)
+        {
+            if (memcmp(&data[slot], &value, sizeof(T)) == 0)
+                return;
+
+            memcpy(&data[slot], &value, sizeof(T));
+            MarkDirty(slot);
+        }
+
+        void UpdateBuffer(GPU::DeviceVulkan& device)
+        {
+            const U32 arraySize_ = data.size();
             if (arraySize_ == arraySize)
                 return;
 
@@ -85,37 +177,76 @@ namespace VulkanTest
                 }
 
                 bindless = device.CreateBindlessStroageBuffer(*buffer, 0, buffer->GetCreateInfo().size);
+
+                // New buffer, everything is uploaded again
+                for (U32 slot = 0; slot < arraySize; slot++)
+                    MarkDirty(slot);
             }
         }
 
-        void UploadBuffer(GPU::DeviceVulkan& device, GPU::CommandList& cmd)
+        // Copy the runs of dirty slots in one vkCmdCopyBuffer, return the uploaded bytes
+        U64 UploadBuffer(GPU::DeviceVulkan& device, GPU::CommandList& cmd)
         {
-            if (buffer && arraySize > 0)
-            {
-                auto uploadBuffer = uploadBuffers[device.GetFrameIndex()];
-                if (uploadBuffer)
+            if (!buffer || arraySize == 0)
+                return 0;
+
+            auto uploadBuffer = uploadBuffers[device.GetFrameIndex()];
+            if (!uploadBuffer)
+                return 0;
+
+            copyRegions.clear();
+            U32 runBegin = 0;
+            U32 runEnd = 0;
+            auto FlushRun = [&]() {
+                if (runEnd > runBegin)
                 {
-                    cmd.CopyBuffer(
-                        *buffer,
-                        0,
-                        *uploadBuffer,
-                        0,
-                        arraySize * sizeof(T)
-                    );
-                    cmd.BufferBarrier(*buffer,
-                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                        VK_ACCESS_TRANSFER_WRITE_BIT,
-                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                        VK_ACCESS_SHADER_READ_BIT);
+                    VkBufferCopy& region = copyRegions.emplace();
+                    region.srcOffset = runBegin * sizeof(T);
+                    region.dstOffset = runBegin * sizeof(T);
+                    region.size = (runEnd - runBegin) * sizeof(T);
                 }
+            };
+
+            const U32 wordCount = std::min(dirtyBits.size(), (arraySize + 31) / 32);
+            for (U32 word = 0; word < wordCount; word++)
+            {
+                ForEachBit(dirtyBits[word], [&](U32 bit) {
+                    const U32 slot = word * 32 + bit;
+                    if (slot >= arraySize)
+                        return;
+
+                    if (slot != runEnd)
+                    {
+                        FlushRun();
+                        runBegin = slot;
+                    }
+                    runEnd = slot + 1;
+                });
+
+                // The slots beyond the buffer stay dirty until it is resized
+                const U32 uploadedBits = std::min(arraySize - word * 32, 32u);
+                dirtyBits[word] &= uploadedBits < 32 ? ~((1u << uploadedBits) - 1) : 0;
             }
-        }
+            FlushRun();
 
-        T* Mapping(GPU::DeviceVulkan& device)
-        {
-            if (uploadBuffers[device.GetFrameIndex()])
-                return (T*)uploadBuffers[device.GetFrameIndex()]->GetAllcation().hostBase;
-            return nullptr;
+            if (copyRegions.empty())
+                return 0;
+
+            U8* mapped = (U8*)uploadBuffer->GetAllcation().hostBase;
+            U64 uploadedBytes = 0;
+            for (const VkBufferCopy& region : copyRegions)
+            {
+                memcpy(mapped + region.srcOffset, (const U8*)data.data() + region.srcOffset, region.size);
+                uploadedBytes += region.size;
+            }
+
+            cmd.CopyBuffer(*buffer, *uploadBuffer, copyRegions.data(), copyRegions.size());
+            cmd.BufferBarrier(*buffer,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                VK_ACCESS_SHADER_READ_BIT);
+            return uploadedBytes;
         }
 
         I32 GetBindlessIndex()
@@ -129,6 +260,10 @@ namespace VulkanTest
             uploadBuffers[0].reset();
             uploadBuffers[1].reset();
             bindless.reset();
+            data.clear();
+            freeRanges.clear();
+            dirtyBits.clear();
+            arraySize = 0;
         }
     };
 
@@ -143,6 +278,7 @@ namespace VulkanTest
         UniquePtr<CullingSystem> cullingSystem;
 
         EntityMap<Model*> modelEntityMap;
+        ECS::Query<TransformComponent> transformQuery;
         ECS::Query<ObjectComponent> objectQuery;
         ECS::Query<MeshComponent> meshQuery;
         ECS::Query<MaterialComponent> materialQuery;
@@ -152,11 +288,19 @@ namespace VulkanTest
         RenderSceneBuffer<ShaderGeometry> geometryBuffer;
         RenderSceneBuffer<ShaderMaterial> materialBuffer;
 
-        ShaderMeshInstance* instanceMapped = nullptr;
-        ShaderMaterial* materialMapped = nullptr;
-        ShaderGeometry* geometryMapped = nullptr;
-
         ShaderSceneCB sceneCB;
+        U64 uploadedBytes = 0;
+
+        // Transform hierarchy, rebuilt when the transforms are added or removed or the order of the entities is changed
+        TransformHierarchy transformHierarchy;
+        Array<ECS::EntityID> hierarchyEntities;
+        Array<ECS::EntityID> hierarchyParents;
+        bool isHierarchyDirty = true;
+
+        // Culling BVH, the bounds are compared to find the moved objects
+        SceneBVH objectBVH;
+        Array<ECS::EntityID> bvhObjects;
+        Array<AABB> bvhAABBs;
 
     public:
         RenderSceneImpl(RendererPlugin& rendererPlugin_, Engine& engine_, World& world_) :
@@ -172,14 +316,32 @@ namespace VulkanTest
 
             cullingSystem = CullingSystem::Create();
 
+            transformQuery = world.CreateQuery<TransformComponent>().Build();
             objectQuery = world.CreateQuery<ObjectComponent>().Build();
             meshQuery = world.CreateQuery<MeshComponent>().Build();
             materialQuery = world.CreateQuery<MaterialComponent>().Build();
 
+            world.SetComponenetOnAdded<TransformComponent>([&](ECS::EntityID entity, TransformComponent& transComp) {
+                isHierarchyDirty = true;
+            });
+            world.SetComponenetOnRemoved<TransformComponent>([&](ECS::EntityID entity, TransformComponent& transComp) {
+                isHierarchyDirty = true;
+            });
             world.SetComponenetOnRemoved<LoadModelComponent>([&](ECS::EntityID entity, LoadModelComponent& model) {
                 if (model.model)
                     modelEntityMap.erase(model.model.get());
             });
+
+            // Release the slots of the scene buffers
+            world.SetComponenetOnRemoved<ObjectComponent>([&](ECS::EntityID entity, ObjectComponent& obj) {
+                instanceBuffer.Free(obj.index, 1);
+            });
+            world.SetComponenetOnRemoved<MaterialComponent>([&](ECS::EntityID entity, MaterialComponent& mat) {
+                materialBuffer.Free(mat.materialIndex, 1);
+            });
+            world.SetComponenetOnRemoved<MeshComponent>([&](ECS::EntityID entity, MeshComponent& meshComp) {
+                geometryBuffer.Free(meshComp.geometryOffset, meshComp.geometryCount);
+            });
         }
 
         virtual ~RenderSceneImpl()
@@ -204,8 +366,13 @@ namespace VulkanTest
                 CJING_SAFE_DELETE(system);
             systems.clear();
 
-            // TODO: unbind the callback
-            // world.SetComponenetOnRemoved<MeshComponent>(nullptr);
+            // Unbind the hooks capturing this scene, the world removes the remaining components after the scene is destroyed
+            world.SetComponenetOnAdded<TransformComponent>([](ECS::EntityID entity, TransformComponent& transComp) {});
+            world.SetComponenetOnRemoved<TransformComponent>([](ECS::EntityID entity, TransformComponent& transComp) {});
+            world.SetComponenetOnRemoved<LoadModelComponent>([](ECS::EntityID entity, LoadModelComponent& model) {});
+            world.SetComponenetOnRemoved<ObjectComponent>([](ECS::EntityID entity, ObjectComponent& obj) {});
+            world.SetComponenetOnRemoved<MaterialComponent>([](ECS::EntityID entity, MaterialComponent& mat) {});
+            world.SetComponenetOnRemoved<MeshComponent>([](ECS::EntityID entity, MeshComponent& meshComp) {});
 
             for (auto kvp : modelEntityMap)
             {
@@ -255,6 +422,11 @@ namespace VulkanTest
             cullingSystem->Cull(vis, *this);
         }
 
+        void UpdateVisibility(Span<struct Visibility*> views)
+        {
+            cullingSystem->CullViews(views, *this);
+        }
+
         ECS::EntityID CreateObject(const char* name)override
         {
             return world.CreateEntity(name)
@@ -263,6 +435,16 @@ namespace VulkanTest
                 .entity;
         }
 
+        void SetObjectMesh(ECS::EntityID entity, ECS::EntityID mesh)override
+        {
+            ObjectComponent* obj = world.GetComponent<ObjectComponent>(entity);
+            if (obj == nullptr || obj->mesh == mesh)
+                return;
+
+            obj->mesh = mesh;
+            obj->isDirty = true;
+        }
+
         bool IsSceneValid()const
         {
             return 
@@ -280,6 +462,174 @@ namespace VulkanTest
                 objectQuery.ForEach(func);
         }
 
+        const SceneBVH& GetObjectBVH()const override
+        {
+            return objectBVH;
+        }
+
+        const Array<ECS::EntityID>& GetBVHObjects()const override
+        {
+            return bvhObjects;
+        }
+
+        void UpdateTransforms()
+        {
+            PROFILE_FUNCTION();
+            if (!transformQuery.Valid())
+                return;
+
+            // The hooks only see the added or removed transforms, the order of the entities is still compared
+            // since the query order is changed when the entities move to other archetypes
+            U32 count = 0;
+            bool isChanged = isHierarchyDirty;
+            transformQuery.ForEach([&](ECS::EntityID entity, TransformComponent& transComp) {
+                if (isChanged)
+                    return;
+
+                if (count >= hierarchyEntities.size() || hierarchyEntities[count] != entity)
+                {
+                    isChanged = true;
+                    return;
+                }
+
+                Transform& transform = transComp.transform;
+                if (transform.isDirty)
+                {
+                    transform.isDirty = false;
+                    transformHierarchy.SetLocalMatrix(count, StoreFMat4x4(transform.GetMatrix()));
+                }
+                count++;
+            });
+
+            if (isChanged || count != hierarchyEntities.size())
+                RebuildTransformHierarchy();
+
+            if (!transformHierarchy.IsDirty())
+                return;
+
+            transformHierarchy.Update();
+
+            U32 node = 0;
+            transformQuery.ForEach([&](ECS::EntityID entity, TransformComponent& transComp) {
+                if (transformHierarchy.IsUpdated(node))
+                {
+                    transComp.transform.world = transformHierarchy.GetWorldMatrix(node);
+                    transComp.version++;
+                }
+                node++;
+            });
+        }
+
+        void RebuildTransformHierarchy()
+        {
+            PROFILE_FUNCTION();
+            Array<ECS::EntityID> entities;
+            Array<ECS::EntityID> parents;
+            transformQuery.ForEach([&](ECS::EntityID entity, TransformComponent& transComp) {
+                entities.push_back(entity);
+                parents.push_back(world.GetEntityParent(entity));
+            });
+
+            const U32 count = (U32)entities.size();
+            std::unordered_map<ECS::EntityID, U32> entityNodes;
+            entityNodes.reserve(count);
+            for (U32 i = 0; i < count; i++)
+                entityNodes[entities[i]] = i;
+
+            std::unordered_map<ECS::EntityID, U32> previousEntityNodes;
+            previousEntityNodes.reserve(hierarchyEntities.size());
+            for (U32 i = 0; i < hierarchyEntities.size(); i++)
+                previousEntityNodes[hierarchyEntities[i]] = i;
+
+            // The parents without transform are ignored, the nodes with the same parent keep their matrices
+            Array<U32> parentNodes;
+            Array<U32> previousNodes;
+            parentNodes.resize(count);
+            previousNodes.resize(count);
+            for (U32 i = 0; i < count; i++)
+            {
+                auto it = entityNodes.find(parents[i]);
+                parentNodes[i] = it != entityNodes.end() ? it->second : TransformHierarchy::INVALID_NODE;
+                if (parentNodes[i] == TransformHierarchy::INVALID_NODE)
+                    parents[i] = ECS::INVALID_ENTITY;
+
+                auto previousIt = previousEntityNodes.find(entities[i]);
+                const bool isKept = previousIt != previousEntityNodes.end() && hierarchyParents[previousIt->second] == parents[i];
+                previousNodes[i] = isKept ? previousIt->second : TransformHierarchy::INVALID_NODE;
+            }
+            transformHierarchy.Build(parentNodes.data(), count, previousNodes.data());
+
+            hierarchyEntities = std::move(entities);
+            hierarchyParents = std::move(parents);
+            isHierarchyDirty = false;
+
+            // The new nodes are set with their local matrices
+            U32 node = 0;
+            transformQuery.ForEach([&](ECS::EntityID entity, TransformComponent& transComp) {
+                Transform& transform = transComp.transform;
+                if (transform.isDirty || previousNodes[node] == TransformHierarchy::INVALID_NODE)
+                {
+                    transform.isDirty = false;
+                    transformHierarchy.SetLocalMatrix(node, StoreFMat4x4(transform.GetMatrix()));
+                }
+                node++;
+            });
+        }
+
+        void UpdateObjectBVH()
+        {
+            PROFILE_FUNCTION();
+            if (!IsSceneValid() || !objectQuery.Valid())
+            {
+                objectBVH.Clear();
+                bvhObjects.clear();
+                bvhAABBs.clear();
+                return;
+            }
+
+            // Rebuild when the objects are added or removed, otherwise refit when any of them is moved
+            U32 count = 0;
+            bool isChanged = false;
+            bool isMoved = false;
+            objectQuery.ForEach([&](ECS::EntityID entity, ObjectComponent& obj) {
+                if (obj.mesh == ECS::INVALID_ENTITY || !obj.aabb.IsValid())
+                    return;
+
+                if (count >= bvhObjects.size())
+                {
+                    bvhObjects.push_back(entity);
+                    bvhAABBs.push_back(obj.aabb);
+                    isChanged = true;
+                }
+                else
+                {
+                    if (bvhObjects[count] != entity)
+                    {
+                        bvhObjects[count] = entity;
+                        isChanged = true;
+                    }
+                    if (memcmp(&bvhAABBs[count], &obj.aabb, sizeof(AABB)) != 0)
+                    {
+                        bvhAABBs[count] = obj.aabb;
+                        isMoved = true;
+                    }
+                }
+                count++;
+            });
+
+            if (count != bvhObjects.size())
+            {
+                bvhObjects.resize(count);
+                bvhAABBs.resize(count);
+                isChanged = true;
+            }
+
+            if (isChanged)
+                objectBVH.Build(bvhAABBs.data(), count);
+            else if (isMoved)
+                objectBVH.Refit(bvhAABBs.data(), count);
+        }
+
         ECS::EntityID CreateMesh(const char* name) override
         {
             return world.CreateEntity(name)
@@ -368,8 +718,7 @@ namespace VulkanTest
                 }
 
                 auto objectEntity = CreateObject(world.GetEntityName(entity));
-                ObjectComponent* obj = world.GetComponent<ObjectComponent>(objectEntity);
-                obj->mesh = meshEntity;
+                SetObjectMesh(objectEntity, meshEntity);
             }
 
             RemoveFromModelEntityMap(model, entity);
@@ -415,9 +764,10 @@ namespace VulkanTest
         void UpdateRenderData(GPU::CommandList& cmd)
         {
             auto& device = cmd.GetDevice();
-            instanceBuffer.UploadBuffer(device, cmd);
-            geometryBuffer.UploadBuffer(device, cmd);
-            materialBuffer.UploadBuffer(device, cmd);
+            uploadedBytes = 0;
+            uploadedBytes += instanceBuffer.UploadBuffer(device, cmd);
+            uploadedBytes += geometryBuffer.UploadBuffer(device, cmd);
+            uploadedBytes += materialBuffer.UploadBuffer(device, cmd);
         }
 
         const ShaderSceneCB& GetShaderScene()const override
@@ -425,55 +775,28 @@ namespace VulkanTest
             return sceneCB;
         }
 
+        U64 GetUploadedBytes()const override
+        {
+            return uploadedBytes;
+        }
+
         void Update(float dt, bool paused)override
         {
             GPU::DeviceVulkan& device = *engine.GetWSI().GetDevice();
 
-            // Update scene buffers
+            // The world matrices are ready before the systems
+            UpdateTransforms();
 
-            // Update instance buffer
-            U32 instanceArraySize = 0;
-            if (objectQuery.Valid())
-            {
-                objectQuery.ForEach([&](ECS::EntityID entity, ObjectComponent& obj) {
-                    obj.index = instanceArraySize;
-                    instanceArraySize++;
-                });
-            }
-            instanceBuffer.UpdateBuffer(device, instanceArraySize);
-            instanceMapped = instanceBuffer.Mapping(device);
-            
-            // Update material buffer
-            U32 materialArraySize = 0;
-            if (materialQuery.Valid())
-            {
-                materialQuery.ForEach([&](ECS::EntityID entity, MaterialComponent& mat) {
-                    mat.materialIndex = materialArraySize;
-                    materialArraySize++;
-                });
-            }
-            materialBuffer.UpdateBuffer(device, materialArraySize);
-            materialMapped = materialBuffer.Mapping(device);
-
-            // Update geometry buffer
-            U32 geometryArraySize = 0;
-            if (meshQuery.Valid())
-            {
-                meshQuery.ForEach([&](ECS::EntityID entity, MeshComponent& meshComp) {
-                    if (meshComp.mesh != nullptr)
-                    {
-                        meshComp.geometryOffset = geometryArraySize;
-                        geometryArraySize += meshComp.mesh->subsets.size();
-                    }
-                });
-            }
-            geometryBuffer.UpdateBuffer(device, geometryArraySize);
-            geometryMapped = geometryBuffer.Mapping(device);
-
-            // Update systems
+            // Update systems, the slots of the scene buffers are allocated and written by the systems
             for (auto system : systems)
                 system->UpdateSystem();
 
+            instanceBuffer.UpdateBuffer(device);
+            materialBuffer.UpdateBuffer(device);
+            geometryBuffer.UpdateBuffer(device);
+
+            UpdateObjectBVH();
+
             // Update shader scene
             sceneCB.instancebuffer = instanceBuffer.GetBindlessIndex();
             sceneCB.geometrybuffer = geometryBuffer.GetBindlessIndex();
@@ -481,18 +804,6 @@ namespace VulkanTest
         }
     };
 
-    class TransformUpdateSystem : public ISystem
-    {
-    public:
-        TransformUpdateSystem(RenderSceneImpl& scene) : ISystem(scene)
-        {
-            system = scene.GetWorld().CreateSystem<TransformComponent>()
-                .ForEach([&](ECS::EntityID entity, TransformComponent& transComp) {
-                transComp.transform.UpdateTransform();
-            });
-        }
-    };
-
     class MaterialUpdateSystem : public ISystem
     {
     public:
@@ -501,14 +812,16 @@ namespace VulkanTest
             system = scene.GetWorld().CreateSystem<MaterialComponent>()
                 .ForEach([&](ECS::EntityID entity, MaterialComponent& materialComp) {
 
-                auto materialMapped = scene.materialMapped;
-                if (!materialMapped || !materialComp.material)
+                if (!materialComp.material)
                     return;
 
+                if (materialComp.materialIndex == INVALID_SCENE_SLOT)
+                    materialComp.materialIndex = scene.materialBuffer.Allocate(1);
+
+                // The material resource may be edited, the slot is uploaded only when it differs
                 ShaderMaterial shaderMaterial;
                 shaderMaterial.baseColor = materialComp.material->GetColor().ToFloat4();
-
-                memcpy(materialMapped + materialComp.materialIndex, &shaderMaterial, sizeof(ShaderMaterial));
+                scene.materialBuffer.Write(materialComp.materialIndex, shaderMaterial);
             });
         }
     };
@@ -521,23 +834,27 @@ namespace VulkanTest
             system = scene.GetWorld().CreateSystem<MeshComponent>()
                 .ForEach([&](ECS::EntityID entity, MeshComponent& meshComp) {
 
-                auto geometryMapped = scene.geometryMapped;
-                if (!geometryMapped || !meshComp.mesh)
+                if (!meshComp.mesh || !meshComp.isDirty)
                     return;
 
                 Mesh& mesh = *meshComp.mesh;
+                const U32 subsetCount = (U32)mesh.subsets.size();
+                if (subsetCount != meshComp.geometryCount)
+                {
+                    scene.geometryBuffer.Free(meshComp.geometryOffset, meshComp.geometryCount);
+                    meshComp.geometryOffset = subsetCount > 0 ? scene.geometryBuffer.Allocate(subsetCount) : INVALID_SCENE_SLOT;
+                    meshComp.geometryCount = subsetCount;
+                }
+                meshComp.isDirty = false;
+
                 ShaderGeometry geometry;
                 geometry.vbPos = mesh.vbPos.srv->GetIndex();
                 geometry.vbNor = mesh.vbNor.srv->GetIndex();
                 geometry.vbUVs = mesh.vbUVs.srv->GetIndex();
                 geometry.ib = 0;
 
-                U32 subsetIndex = 0;
-                for (auto& subset : mesh.subsets)
-                {
-                    memcpy(geometryMapped + meshComp.geometryOffset + subsetIndex, &geometry, sizeof(ShaderGeometry));
-                    subsetIndex++;
-                }
+                for (U32 subsetIndex = 0; subsetIndex < subsetCount; subsetIndex++)
+                    scene.geometryBuffer.Write(meshComp.geometryOffset + subsetIndex, geometry);
             });
         }
     };
@@ -550,16 +867,26 @@ namespace VulkanTest
             system = scene.GetWorld().CreateSystem<ObjectComponent>()
                 .ForEach([&](ECS::EntityID entity, ObjectComponent& objComp) {
 
-                auto instanceMapped = scene.instanceMapped;
-                if (!instanceMapped)
+                // Objects without a transform are not placed in the scene
+                auto transform = scene.GetComponent<TransformComponent>(entity);
+                if (transform == nullptr)
                     return;
 
+                if (objComp.index == INVALID_SCENE_SLOT)
+                    objComp.index = scene.instanceBuffer.Allocate(1);
+
+                // Static objects are skipped, their instance is already uploaded
+                if (!objComp.isDirty && transform->version == objComp.transformVersion)
+                    return;
+
+                objComp.isDirty = false;
+                objComp.transformVersion = transform->version;
+
                 AABB& aabb = objComp.aabb;
                 aabb = AABB();
 
                 if (objComp.mesh != ECS::INVALID_ENTITY)
                 {
-                    auto transform = scene.GetComponent<TransformComponent>(entity);
                     auto meshComp = scene.GetComponent<MeshComponent>(objComp.mesh);
                     ASSERT(meshComp->mesh != nullptr);
                  
@@ -571,7 +898,7 @@ namespace VulkanTest
                     inst.init();
                     inst.transform.Create(transform->transform.world);
 
-                    memcpy(instanceMapped + objComp.index, &inst, sizeof(ShaderMeshInstance));
+                    scene.instanceBuffer.Write(objComp.index, inst);
                 }
             });
         }
@@ -579,7 +906,6 @@ namespace VulkanTest
 
     void RenderSceneImpl::InitSystems()
     {
-        AddSystem(CJING_NEW(TransformUpdateSystem)(*this));
         AddSystem(CJING_NEW(MaterialUpdateSystem)(*this));
         AddSystem(CJING_NEW(MeshUpdateSystem)(*this));
         AddSystem(CJING_NEW(ObjectUpdateSystem)(*this));
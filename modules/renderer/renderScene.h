@@ -9,14 +9,19 @@
 #include "shaderInterop_renderer.h"
 #include "enums.h"
 #include "model.h"
+#include "sceneBVH.h"
 
 namespace VulkanTest
 {
 	struct RendererPlugin;
 
+	// Slot not allocated yet in the GPU scene buffers
+	static const U32 INVALID_SCENE_SLOT = ~0u;
+
 	struct TransformComponent
 	{
 		Transform transform;
+		U32 version = 0;	// Increased when the world matrix is updated
 	};
 
 	struct CameraComponent
@@ -52,14 +57,16 @@ namespace VulkanTest
 	struct MaterialComponent
 	{
 		ResPtr<Material> material;
-		U32 materialIndex = 0;
+		U32 materialIndex = INVALID_SCENE_SLOT;
 	};
 
 	struct MeshComponent
 	{
 		ResPtr<Model> model;
 		Mesh* mesh = nullptr;
-		U32 geometryOffset = 0;
+		U32 geometryOffset = INVALID_SCENE_SLOT;
+		U32 geometryCount = 0;
+		bool isDirty = true;
 	};
 
 	struct ObjectComponent
@@ -67,7 +74,9 @@ namespace VulkanTest
 		ECS::EntityID mesh = ECS::INVALID_ENTITY;
 		F32x3 center = F32x3(0, 0, 0);
 		AABB aabb;
-		U32 index = 0;
+		U32 index = INVALID_SCENE_SLOT;
+		U32 transformVersion = 0;
+		bool isDirty = true;	// Set by SetObjectMesh, the transform is tracked by its version
 		U8 stencilRef = 1;
 	};
 
@@ -97,10 +106,14 @@ namespace VulkanTest
 		static void Reflect(World* world);
 
 		virtual void UpdateVisibility(struct Visibility& vis) = 0;
+		virtual void UpdateVisibility(Span<struct Visibility*> views) = 0;
 		virtual void UpdateRenderData(GPU::CommandList& cmd) = 0;
 
 		virtual const ShaderSceneCB& GetShaderScene()const = 0;
 
+		// Bytes copied to the GPU scene buffers by the last UpdateRenderData, only the changed slots are uploaded
+		virtual U64 GetUploadedBytes()const = 0;
+
 		virtual ECS::EntityID CreateEntity(const char* name) = 0;
 		virtual void DestroyEntity(ECS::EntityID entity) = 0;
 
@@ -118,8 +131,14 @@ namespace VulkanTest
 
 		// Object
 		virtual ECS::EntityID CreateObject(const char* name) = 0;
+		virtual void SetObjectMesh(ECS::EntityID entity, ECS::EntityID mesh) = 0;
 		virtual void ForEachObjects(std::function<void(ECS::EntityID, ObjectComponent&)> func) = 0;
 
+		// BVH of the objects with a mesh, the items are the indices of GetBVHObjects.
+		// It is rebuilt when the objects are changed and refitted when they are moved
+		virtual const SceneBVH& GetObjectBVH()const = 0;
+		virtual const Array<ECS::EntityID>& GetBVHObjects()const = 0;
+
 		template<typename C>
 		C* GetComponent(ECS::EntityID entity)
 		{
@@ -11,6 +11,7 @@
 #include "material.h"
 #include "texture.h"
 #include "textureHelper.h"
+#include "textureStreamer.h"
 #include "imageUtil.h"
 
 namespace VulkanTest
@@ -31,6 +32,12 @@ public:
 		Renderer::Initialize(engine);
 	}
 
+	void Update(F32 delta) override
+	{
+		// Stream the texture mips requested by the main draw passes of the last frame
+		TextureStreamer::Update();
+	}
+
 	GPU::DeviceVulkan* GetDevice() override
 	{
 		return engine.GetWSI().GetDevice();
@@ -98,6 +105,9 @@ namespace Renderer
 
 	struct RenderQueue
 	{
+		RenderQueue() = default;
+		explicit RenderQueue(IAllocator& allocator) : batches(allocator) {}
+
 		void SortOpaque()
 		{
 			std::sort(batches.begin(), batches.end(), std::less<RenderBatch>());
@@ -268,11 +278,33 @@ namespace Renderer
 		shaders[SHADERTYPE_CS_POSTPROCESS_BLUR_GAUSSIAN] = PreloadShader(GPU::ShaderStage::CS, "blurGaussianCS.hlsl");
 
 		shaders[SHADERTYPE_PS_OBJECT] = PreloadShader(GPU::ShaderStage::PS, "objectPS.hlsl", { "OBJECTSHADER_LAYOUT_COMMON" });
+		shaders[SHADERTYPE_PS_OBJECT_FALLBACK] = PreloadShader(GPU::ShaderStage::PS, "objectPS.hlsl", { "OBJECTSHADER_LAYOUT_COMMON", "OBJECTSHADER_FALLBACK" });
 		shaders[SHADERTYPE_PS_PREPASS] = PreloadShader(GPU::ShaderStage::PS, "objectPS.hlsl", { "OBJECTSHADER_LAYOUT_PREPASS" });
 		shaders[SHADERTYPE_PS_VERTEXCOLOR] = PreloadShader(GPU::ShaderStage::PS, "vertexColorPS.hlsl");
 		shaders[SHADERTYPE_PS_POSTPROCESS_OUTLINE] = PreloadShader(GPU::ShaderStage::PS, "outlinePS.hlsl");
 	}
 
+	void InitAsyncPipelineCompilation()
+	{
+		GPU::DeviceVulkan& device = *GetDevice();
+
+		// The missed pipelines of the object shader are compiled in the background, the objects are drawn
+		// with the flat fallback until they are ready. The programs without a fallback are compiled in place
+		device.SetAsyncPipelineCompilation(true);
+		if (shaders[SHADERTYPE_VS_OBJECT] == nullptr ||
+			shaders[SHADERTYPE_PS_OBJECT] == nullptr ||
+			shaders[SHADERTYPE_PS_OBJECT_FALLBACK] == nullptr)
+			return;
+
+		const GPU::Shader* programShaders[(U32)GPU::ShaderStage::Count] = {};
+		programShaders[(U32)GPU::ShaderStage::VS] = shaders[SHADERTYPE_VS_OBJECT];
+		programShaders[(U32)GPU::ShaderStage::PS] = shaders[SHADERTYPE_PS_OBJECT];
+		GPU::ShaderProgram* program = device.RequestProgram(programShaders);
+
+		programShaders[(U32)GPU::ShaderStage::PS] = shaders[SHADERTYPE_PS_OBJECT_FALLBACK];
+		program->SetFallback(device.RequestProgram(programShaders));
+	}
+
 	ShaderType GetVSType(RENDERPASS renderPass)
 	{
 		switch (renderPass)
@@ -381,6 +413,7 @@ namespace Renderer
 		InitStockStates();
 		LoadShaders();
 		LoadPipelineStates();
+		InitAsyncPipelineCompilation();
 
 		// Create built-in constant buffers
 		auto device = GetDevice();
@@ -402,6 +435,9 @@ namespace Renderer
 
 		// Initialize texture helper
 		TextureHelper::Initialize(&resManager);
+
+		// Initialize texture streamer
+		TextureStreamer::Initialize();
 	}
 
 	void Renderer::Uninitialize()
@@ -414,6 +450,7 @@ namespace Renderer
 		materialFactory.Uninitialize();
 		modelFactory.Uninitialize();
 		textureFactory.Uninitialize();
+		TextureStreamer::Uninitialize();
 
 		rendererPlugin = nullptr;
 		Logger::Info("Render uninitialized");
@@ -606,36 +643,71 @@ namespace Renderer
 	}
 
 	void DrawScene(GPU::CommandList& cmd, const Visibility& vis, RENDERPASS pass)
+	{
+		DrawScene(cmd, vis, pass, 0, (U32)vis.objects.size());
+	}
+
+	// Request the mips of the material textures by the projected size of the object
+	void AddTextureDemand(RenderScene& scene, const ObjectComponent& obj, const CameraComponent& camera, F32 distance)
+	{
+		MeshComponent* meshCmp = scene.GetComponent<MeshComponent>(obj.mesh);
+		if (meshCmp == nullptr || meshCmp->mesh == nullptr)
+			return;
+
+		const F32 diameter = Distance(obj.aabb.min, obj.aabb.max);
+		const F32 screenSize = diameter * camera.height / (2.0f * std::max(distance, camera.nearZ) * std::tan(camera.fov * 0.5f));
+		for (auto& subset : meshCmp->mesh->subsets)
+		{
+			if (!subset.material)
+				continue;
+
+			for (U32 type = 0; type < Texture::COUNT; type++)
+			{
+				Texture* texture = subset.material->GetTexture((Texture::TextureType)type);
+				if (texture != nullptr)
+					TextureStreamer::AddDemand(*texture, screenSize);
+			}
+		}
+	}
+
+	void DrawScene(GPU::CommandList& cmd, const Visibility& vis, RENDERPASS pass, U32 begin, U32 end)
 	{
 		RenderScene* scene = vis.scene;
-		if (!scene)
+		if (!scene || begin >= end)
 			return;
 
 		cmd.BeginEvent("DrawScene");
 
 		BindCommonResources(cmd);
 
-#if 0
-		static thread_local RenderQueue queue;
-#else
-		RenderQueue queue;
-#endif
-		queue.Clear();
-		for (auto objectID : vis.objects)
+		// Render queue is temporary, allocate it from the frame allocator
+		LinearAllocator& frameAllocator = FrameAllocator::Get();
+		const size_t frameMark = frameAllocator.GetMark();
 		{
-			ObjectComponent* obj = scene->GetComponent<ObjectComponent>(objectID);
-			if (obj == nullptr || obj->mesh == ECS::INVALID_ENTITY)
-				continue;
+			RenderQueue queue(frameAllocator);
+			queue.batches.reserve(end - begin);
+			for (U32 i = begin; i < end; i++)
+			{
+				const ECS::EntityID objectID = vis.objects[i];
+				ObjectComponent* obj = scene->GetComponent<ObjectComponent>(objectID);
+				if (obj == nullptr || obj->mesh == ECS::INVALID_ENTITY)
+					continue;
 
-			const F32 distance = Distance(vis.camera->eye, obj->center);
-			queue.Add(obj->mesh, objectID, distance);
-		}
+				const F32 distance = Distance(vis.camera->eye, obj->center);
+				queue.Add(obj->mesh, objectID, distance);
 
-		if (!queue.Empty())
-		{
-			queue.SortOpaque();
-			DrawMeshes(cmd, queue, vis, pass, 0);
+				// The main pass draws each visible object once
+				if (pass == RENDERPASS_MAIN)
+					AddTextureDemand(*scene, *obj, *vis.camera, distance);
+			}
+
+			if (!queue.Empty())
+			{
+				queue.SortOpaque();
+				DrawMeshes(cmd, queue, vis, pass, 0);
+			}
 		}
+		frameAllocator.Rewind(frameMark);
 
 		cmd.EndEvent();
 	}
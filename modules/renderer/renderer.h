@@ -56,6 +56,8 @@ namespace VulkanTest
 		};
 
 		void DrawScene(GPU::CommandList& cmd, const Visibility& vis, RENDERPASS pass);
+		// Draw the visible objects [begin, end), it can be called concurrently with different command lists
+		void DrawScene(GPU::CommandList& cmd, const Visibility& vis, RENDERPASS pass, U32 begin, U32 end);
 
 		// TODO
 		void SetupPostprocessBlurGaussian(RenderGraph& graph, const String& input, String& out, const AttachmentInfo& attchment);
@@ -0,0 +1,259 @@
+#include "sceneBVH.h"
+#include "core\utils\profiler.h"
+
+#include <algorithm>
+
+namespace VulkanTest
+{
+	static const U32 BIN_COUNT = 16;
+
+	static F32 GetHalfArea(const AABB& aabb)
+	{
+		if (!aabb.IsValid())
+			return 0.0f;
+
+		const F32 dx = aabb.max.x - aabb.min.x;
+		const F32 dy = aabb.max.y - aabb.min.y;
+		const F32 dz = aabb.max.z - aabb.min.z;
+		return dx * dy + dy * dz + dz * dx;
+	}
+
+	static F32 GetAxis(const F32x3& v, U32 axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	static F32 GetCentroid(const AABB& aabb, U32 axis)
+	{
+		return (GetAxis(aabb.min, axis) + GetAxis(aabb.max, axis)) * 0.5f;
+	}
+
+	void SceneBVH::Build(const AABB* aabbs, U32 count)
+	{
+		PROFILE_FUNCTION();
+		Clear();
+		if (count == 0)
+			return;
+
+		itemIndices.resize(count);
+		for (U32 i = 0; i < count; i++)
+			itemIndices[i] = i;
+
+		nodes.reserve(count * 2);
+		Node& root = nodes.emplace();
+		root.itemOffset = 0;
+		root.itemCount = count;
+
+		struct BuildTask
+		{
+			U32 nodeIndex;
+			U32 depth;
+		};
+		Array<BuildTask> tasks;
+		tasks.push_back({ 0, 0 });
+		while (!tasks.empty())
+		{
+			const BuildTask task = tasks.back();
+			tasks.pop_back();
+
+			// The node array may grow, don't keep the reference across emplace
+			const U32 itemOffset = nodes[task.nodeIndex].itemOffset;
+			const U32 itemCount = nodes[task.nodeIndex].itemCount;
+			U32* items = itemIndices.data() + itemOffset;
+
+			AABB bounds;
+			AABB centroidBounds;
+			for (U32 i = 0; i < itemCount; i++)
+			{
+				const AABB& aabb = aabbs[items[i]];
+				bounds = AABB::Merge(bounds, aabb);
+				centroidBounds.AddPoint(aabb.GetCenter());
+			}
+			nodes[task.nodeIndex].aabb = bounds;
+
+			if (itemCount <= MAX_LEAF_SIZE || task.depth >= MAX_DEPTH)
+				continue;
+
+			// Split the largest axis of the centroids
+			U32 axis = 0;
+			F32 extent = 0.0f;
+			for (U32 i = 0; i < 3; i++)
+			{
+				const F32 axisExtent = GetAxis(centroidBounds.max, i) - GetAxis(centroidBounds.min, i);
+				if (axisExtent > extent)
+				{
+					axis = i;
+					extent = axisExtent;
+				}
+			}
+
+			U32 mid = 0;
+			if (extent > 0.0f)
+			{
+				// Bin the centroids and find the split with the lowest SAH cost
+				const F32 axisMin = GetAxis(centroidBounds.min, axis);
+				const F32 scale = BIN_COUNT / extent;
+				auto GetBin = [&](U32 item) {
+					const U32 bin = U32((GetCentroid(aabbs[item], axis) - axisMin) * scale);
+					return std::min(bin, BIN_COUNT - 1);
+				};
+
+				// The bins may be empty, AABB::Merge(a, b) keeps the empty bounds unchanged unlike the member Merge
+				AABB binBounds[BIN_COUNT];
+				U32 binCounts[BIN_COUNT] = {};
+				for (U32 i = 0; i < itemCount; i++)
+				{
+					const U32 bin = GetBin(items[i]);
+					binBounds[bin] = AABB::Merge(binBounds[bin], aabbs[items[i]]);
+					binCounts[bin]++;
+				}
+
+				F32 rightCosts[BIN_COUNT] = {};
+				AABB rightBounds;
+				U32 rightCount = 0;
+				for (U32 i = BIN_COUNT - 1; i > 0; i--)
+				{
+					rightBounds = AABB::Merge(rightBounds, binBounds[i]);
+					rightCount += binCounts[i];
+					rightCosts[i] = GetHalfArea(rightBounds) * rightCount;
+				}
+
+				U32 bestSplit = 0;
+				F32 bestCost = std::numeric_limits<F32>::max();
+				AABB leftBounds;
+				U32 leftCount = 0;
+				for (U32 i = 1; i < BIN_COUNT; i++)
+				{
+					leftBounds = AABB::Merge(leftBounds, binBounds[i - 1]);
+					leftCount += binCounts[i - 1];
+					const F32 cost = GetHalfArea(leftBounds) * leftCount + rightCosts[i];
+					if (leftCount > 0 && leftCount < itemCount && cost < bestCost)
+					{
+						bestSplit = i;
+						bestCost = cost;
+					}
+				}
+
+				if (bestSplit > 0)
+				{
+					U32* split = std::partition(items, items + itemCount, [&](U32 item) {
+						return GetBin(item) < bestSplit;
+					});
+					mid = U32(split - items);
+				}
+			}
+
+			// All centroids in one bin, split by the count
+			if (mid == 0 || mid == itemCount)
+			{
+				mid = itemCount / 2;
+				std::nth_element(items, items + mid, items + itemCount, [&](U32 a, U32 b) {
+					return GetCentroid(aabbs[a], axis) < GetCentroid(aabbs[b], axis);
+				});
+			}
+
+			const U32 child = nodes.size();
+			Node& left = nodes.emplace();
+			left.itemOffset = itemOffset;
+			left.itemCount = mid;
+			Node& right = nodes.emplace();
+			right.itemOffset = itemOffset + mid;
+			right.itemCount = itemCount - mid;
+			nodes[task.nodeIndex].child = child;
+
+			tasks.push_back({ child, task.depth + 1 });
+			tasks.push_back({ child + 1, task.depth + 1 });
+		}
+
+		UpdateItemBounds(aabbs);
+	}
+
+	void SceneBVH::Refit(const AABB* aabbs, U32 count)
+	{
+		PROFILE_FUNCTION();
+		ASSERT(count == itemIndices.size());
+
+		UpdateItemBounds(aabbs);
+
+		// The children are always after their parent
+		for (U32 i = nodes.size(); i-- > 0;)
+		{
+			Node& node = nodes[i];
+			if (node.child != 0)
+			{
+				node.aabb = AABB::Merge(nodes[node.child].aabb, nodes[node.child + 1].aabb);
+				continue;
+			}
+
+			node.aabb = AABB();
+			for (U32 j = node.itemOffset; j < node.itemOffset + node.itemCount; j++)
+				node.aabb = AABB::Merge(node.aabb, aabbs[itemIndices[j]]);
+		}
+	}
+
+	void SceneBVH::Clear()
+	{
+		nodes.clear();
+		itemIndices.clear();
+		for (U32 axis = 0; axis < 3; axis++)
+		{
+			itemCenters[axis].clear();
+			itemExtents[axis].clear();
+		}
+	}
+
+	void SceneBVH::GetSubtrees(U32 count, Array<U32>& roots) const
+	{
+		roots.clear();
+		if (nodes.empty())
+			return;
+
+		// Split the largest subtree until there are enough, the children replace their parent in place
+		roots.push_back(0);
+		while (roots.size() < count)
+		{
+			U32 largest = 0;
+			U32 largestCount = 0;
+			for (U32 i = 0; i < roots.size(); i++)
+			{
+				const Node& node = nodes[roots[i]];
+				if (node.child != 0 && node.itemCount > largestCount)
+				{
+					largest = i;
+					largestCount = node.itemCount;
+				}
+			}
+
+			if (largestCount == 0)
+				break;
+
+			const U32 child = nodes[roots[largest]].child;
+			roots[largest] = child;
+			roots.push_back(child + 1);
+			for (U32 i = roots.size() - 1; i > largest + 1; i--)
+				std::swap(roots[i], roots[i - 1]);
+		}
+	}
+
+	void SceneBVH::UpdateItemBounds(const AABB* aabbs)
+	{
+		const U32 count = itemIndices.size();
+		for (U32 axis = 0; axis < 3; axis++)
+		{
+			itemCenters[axis].resize(count);
+			itemExtents[axis].resize(count);
+		}
+
+		for (U32 i = 0; i < count; i++)
+		{
+			const AABB& aabb = aabbs[itemIndices[i]];
+			for (U32 axis = 0; axis < 3; axis++)
+			{
+				const F32 min = GetAxis(aabb.min, axis);
+				const F32 max = GetAxis(aabb.max, axis);
+				itemCenters[axis][i] = (min + max) * 0.5f;
+				itemExtents[axis][i] = (max - min) * 0.5f;
+			}
+		}
+	}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "core\common.h"
+#include "core\collections\array.h"
+#include "math\geometry.h"
+
+namespace VulkanTest
+{
+	// Bounding volume hierarchy of the scene objects, built with the binned SAH.
+	// The items are referenced by their index in the bounds passed to Build, the items of a subtree
+	// are contiguous so a subtree inside the frustum is accepted without visiting its nodes
+	class VULKAN_TEST_API SceneBVH
+	{
+	public:
+		static const U32 MAX_LEAF_SIZE = 4;
+		static const U32 MAX_DEPTH = 48;
+		static const U32 MAX_CULL_VIEWS = 8;
+
+		void Build(const AABB* aabbs, U32 count);
+
+		// Update the node bounds without changing the topology, aabbs is in the order of the last build
+		void Refit(const AABB* aabbs, U32 count);
+		void Clear();
+
+		// Call func(index) for each item whose bounds intersects the frustum
+		template<typename F>
+		void Cull(const Frustum& frustum, F&& func) const;
+
+		// Call func(view, index) for each item of the subtree whose bounds intersects the frustum of the view,
+		// the views are tested in the same traversal. The items of a view are visited in the item order, so the
+		// subtrees of GetSubtrees can be culled concurrently and concatenated into the result of the whole tree
+		template<typename F>
+		void CullViews(const Frustum* frustums, U32 viewCount, U32 root, F&& func) const;
+
+		// Split the tree into at least count subtrees when there are enough nodes, in the item order
+		void GetSubtrees(U32 count, Array<U32>& roots) const;
+
+		U32 GetItemCount()const { return itemIndices.size(); }
+		U32 GetNodeCount()const { return nodes.size(); }
+		bool IsEmpty()const { return nodes.empty(); }
+
+	private:
+		struct Node
+		{
+			AABB aabb;
+			U32 child = 0;		// Index of the left child, the right one follows, 0 for the leaves
+			U32 itemOffset = 0;
+			U32 itemCount = 0;
+		};
+
+		void UpdateItemBounds(const AABB* aabbs);
+
+		Array<Node> nodes;
+		Array<U32> itemIndices;
+
+		// Structure of arrays bounds in the order of itemIndices for Frustum::CheckBoxes
+		Array<F32> itemCenters[3];
+		Array<F32> itemExtents[3];
+	};
+
+	template<typename F>
+	void SceneBVH::Cull(const Frustum& frustum, F&& func) const
+	{
+		CullViews(&frustum, 1, 0, [&](U32 view, U32 index) {
+			func(index);
+		});
+	}
+
+	template<typename F>
+	void SceneBVH::CullViews(const Frustum* frustums, U32 viewCount, U32 root, F&& func) const
+	{
+		ASSERT(viewCount > 0 && viewCount <= MAX_CULL_VIEWS);
+		if (nodes.empty())
+			return;
+
+		// The intersecting leaves are visited in the item order, the adjacent ones of a view are tested in one batch
+		U32 rangeBegin[MAX_CULL_VIEWS] = {};
+		U32 rangeEnd[MAX_CULL_VIEWS] = {};
+		auto FlushRange = [&](U32 view) {
+			static const U32 BATCH_SIZE = 256;
+			U32 visibleMask[BATCH_SIZE / 32];
+			for (U32 batchBegin = rangeBegin[view]; batchBegin < rangeEnd[view]; batchBegin += BATCH_SIZE)
+			{
+				const U32 batchCount = std::min(rangeEnd[view] - batchBegin, BATCH_SIZE);
+				BoxArraySoA boxes;
+				boxes.centerX = itemCenters[0].data() + batchBegin;
+				boxes.centerY = itemCenters[1].data() + batchBegin;
+				boxes.centerZ = itemCenters[2].data() + batchBegin;
+				boxes.extentX = itemExtents[0].data() + batchBegin;
+				boxes.extentY = itemExtents[1].data() + batchBegin;
+				boxes.extentZ = itemExtents[2].data() + batchBegin;
+				frustums[view].CheckBoxes(boxes, batchCount, visibleMask);
+
+				for (U32 word = 0; word < (batchCount + 31) / 32; word++)
+				{
+					const U32 wordBegin = batchBegin + word * 32;
+					ForEachBit(visibleMask[word], [&](U32 bit) {
+						func(view, itemIndices[wordBegin + bit]);
+					});
+				}
+			}
+			rangeBegin[view] = rangeEnd[view] = 0;
+		};
+
+		// Each entry keeps the views still intersecting its parent, a node is loaded once for all of them
+		struct StackEntry
+		{
+			U32 node;
+			U32 viewMask;
+		};
+		StackEntry stack[MAX_DEPTH + 1];
+		U32 stackSize = 0;
+		stack[stackSize++] = { root, (1u << viewCount) - 1 };
+		while (stackSize > 0)
+		{
+			const StackEntry entry = stack[--stackSize];
+			const Node& node = nodes[entry.node];
+			U32 intersectMask = 0;
+			ForEachBit(entry.viewMask, [&](U32 view) {
+				const Frustum::BoxFrustumIntersect intersect = frustums[view].CheckBox(node.aabb);
+				if (intersect == Frustum::BOX_FRUSTUM_OUTSIDE)
+					return;
+
+				// Accept the whole subtree, after the pending items before it
+				if (intersect == Frustum::BOX_FRUSTUM_INSIDE)
+				{
+					FlushRange(view);
+					for (U32 i = node.itemOffset; i < node.itemOffset + node.itemCount; i++)
+						func(view, itemIndices[i]);
+					return;
+				}
+
+				if (node.child == 0)
+				{
+					if (node.itemOffset != rangeEnd[view])
+					{
+						FlushRange(view);
+						rangeBegin[view] = node.itemOffset;
+					}
+					rangeEnd[view] = node.itemOffset + node.itemCount;
+					return;
+				}
+
+				intersectMask |= 1u << view;
+			});
+
+			if (intersectMask == 0)
+				continue;
+
+			ASSERT(stackSize + 2 <= ARRAYSIZE(stack));
+			stack[stackSize++] = { node.child + 1, intersectMask };
+			stack[stackSize++] = { node.child, intersectMask };
+		}
+
+		for (U32 view = 0; view < viewCount; view++)
+			FlushRange(view);
+	}
+}
@@ -1,11 +1,16 @@
 #include "texture.h"
 #include "renderer.h"
-#include "gpu\vulkan\TextureFormatLayout.h"
+#include "textureStreamer.h"
+#include "core\utils\profiler.h"
+#include "core\resource\resourceManager.h"
 
 namespace VulkanTest
 {
 	DEFINE_RESOURCE(Texture);
 
+	const U32 Texture::FILE_MAGIC = 0x5f584554;
+	const U32 Texture::FILE_VERSION = 0x02;
+
 	Texture::Texture(const Path& path_, ResourceFactory& resFactory_) :
 		Resource(path_, resFactory_)
 	{
@@ -39,13 +44,196 @@ namespace VulkanTest
 
 	bool Texture::OnLoaded(U64 size, const U8* mem)
 	{
-		// TODO
-		ASSERT(false);
-		return false;
+		PROFILE_FUNCTION();
+		if (size < sizeof(header))
+		{
+			Logger::Warning("Invalid texture file %s", GetPath().c_str());
+			return false;
+		}
+
+		memcpy(&header, mem, sizeof(header));
+		if (header.magic != FILE_MAGIC)
+		{
+			Logger::Warning("Unsupported texture file %s", GetPath().c_str());
+			return false;
+		}
+
+		if (header.version != FILE_VERSION)
+		{
+			Logger::Warning("Unsupported version of texture %s", GetPath().c_str());
+			return false;
+		}
+
+		if (header.levels == 0 || header.levels > MAX_MIP_LEVELS || header.layers == 0)
+		{
+			Logger::Warning("Invalid texture file %s", GetPath().c_str());
+			return false;
+		}
+
+		layout.SetTexture2D((VkFormat)header.format, header.width, header.height, header.layers, header.levels);
+		if (header.dataSize != layout.GetRequiredSize() || size < sizeof(header) + header.dataSize)
+		{
+			Logger::Warning("Invalid texture file %s", GetPath().c_str());
+			return false;
+		}
+
+		// Streamable texture only creates the tail mips, the mapped file is not prefetched so only they are paged in
+		tailMip = 0;
+		if (header.flags & FILE_FLAG_STREAMABLE)
+		{
+			while (tailMip + 1 < header.levels &&
+				std::max(header.width >> tailMip, header.height >> tailMip) > STREAMING_TAIL_SIZE)
+				tailMip++;
+		}
+
+		const U8* data = mem + sizeof(header);
+		if (!CreateMipChain(tailMip, data + layout.GetMipInfo(tailMip).offset))
+		{
+			Logger::Warning("Failed to create texture %s", GetPath().c_str());
+			return false;
+		}
+
+		residentMip = tailMip;
+		pendingMip = tailMip;
+		streamable = tailMip > 0;
+		if (streamable)
+		{
+			// Keep the tail mips to drop the streamed mips without reading the file
+			const U64 tailSize = GetMipChainSize(tailMip);
+			tailData.Clear();
+			tailData.Write(data + layout.GetMipInfo(tailMip).offset, tailSize);
+			TextureStreamer::Register(*this);
+		}
+		return true;
 	}
 
 	void Texture::OnUnLoaded()
 	{
+		if (streamable)
+		{
+			TextureStreamer::Unregister(*this);
+			streamable = false;
+		}
+
+		if (streamingHandle.IsValid())
+		{
+			GetResourceManager().GetFileSystem()->Cancel(streamingHandle);
+			streamingHandle = AsyncLoadHandle::INVALID;
+		}
+
+		tailData.Clear();
 		handle.reset();
 	}
-}
\ No newline at end of file
+
+	AsyncLoadFlags Texture::GetLoadFlags()const
+	{
+		// Streamable is only known from the header, the mips are paged in when they are uploaded
+		return AsyncLoadFlags::MEMORY_MAPPED;
+	}
+
+	U64 Texture::GetMipChainSize(U32 mip) const
+	{
+		ASSERT(mip < header.levels);
+		return layout.GetRequiredSize() - layout.GetMipInfo(mip).offset;
+	}
+
+	bool Texture::StreamMips(U32 mip)
+	{
+		ASSERT(streamable);
+		if (streamingHandle.IsValid() || mip == residentMip || mip > tailMip)
+			return false;
+
+		// Mips [mip, levels) are the contiguous tail of the compiled file
+		// CompiledResource:
+		// | CompiledResourceHeader | FileHeader | Mip 0 | ... | Mip levels-1 |
+		const U64 offset = sizeof(CompiledResourceHeader) + sizeof(FileHeader) + layout.GetMipInfo(mip).offset;
+		StaticString<MAX_PATH_LENGTH> fullResPath(".export/resources/", GetPath().GetHashValue(), ".res");
+
+		AsyncLoadCallback cb;
+		cb.Bind<&Texture::OnMipsLoaded>(this);
+		FileSystem* fileSystem = GetResourceManager().GetFileSystem();
+		streamingHandle = fileSystem->LoadFileRangeAsync(Path(fullResPath), offset, GetMipChainSize(mip), cb, AsyncLoadPriority::Low);
+		if (!streamingHandle.IsValid())
+			return false;
+
+		pendingMip = mip;
+		return true;
+	}
+
+	void Texture::DropMips()
+	{
+		ASSERT(streamable);
+		if (residentMip == tailMip)
+			return;
+
+		if (!CreateMipChain(tailMip, tailData.Data()))
+		{
+			Logger::Warning("Failed to drop the mips of texture %s", GetPath().c_str());
+			return;
+		}
+
+		residentMip = tailMip;
+		if (!streamingHandle.IsValid())
+			pendingMip = tailMip;
+	}
+
+	bool Texture::CreateMipChain(U32 mip, const U8* data)
+	{
+		// The data starts from the given mip, it has the same layout as the staging buffer
+		const U32 levels = header.levels - mip;
+		const U32 baseOffset = layout.GetMipInfo(mip).offset;
+		std::vector<GPU::SubresourceData> resDatas(levels * header.layers);
+		U32 index = 0;
+		for (U32 level = mip; level < header.levels; level++)
+		{
+			const auto& mipInfo = layout.GetMipInfo(level);
+			for (U32 layer = 0; layer < header.layers; layer++)
+			{
+				GPU::SubresourceData& resData = resDatas[index++];
+				resData.data = data + (mipInfo.offset - baseOffset) + (U64)layer * layout.GetLayerSize(level);
+				resData.rowLength = mipInfo.rowLength;
+				resData.imageHeight = mipInfo.imageHeight;
+			}
+		}
+
+		GPU::ImageCreateInfo newInfo = GPU::ImageCreateInfo::ImmutableImage2D(
+			std::max(header.width >> mip, 1u),
+			std::max(header.height >> mip, 1u),
+			(VkFormat)header.format);
+		newInfo.levels = levels;
+		newInfo.layers = header.layers;
+
+		GPU::DeviceVulkan* device = Renderer::GetDevice();
+		GPU::ImagePtr newHandle = device->CreateImage(newInfo, resDatas.data());
+		if (!newHandle)
+			return false;
+
+		// The old image is released by the device once the frames using it are finished
+		info = newInfo;
+		handle = newHandle;
+		return true;
+	}
+
+	void Texture::OnMipsLoaded(U64 size, const U8* mem, bool success)
+	{
+		ASSERT(streamingHandle.IsValid());
+		streamingHandle = AsyncLoadHandle::INVALID;
+
+		const U32 mip = pendingMip;
+		pendingMip = residentMip;
+		if (!success || size != GetMipChainSize(mip))
+		{
+			Logger::Warning("Failed to stream the mips of texture %s", GetPath().c_str());
+			return;
+		}
+
+		if (!CreateMipChain(mip, mem))
+		{
+			Logger::Warning("Failed to stream the mips of texture %s", GetPath().c_str());
+			return;
+		}
+
+		residentMip = mip;
+		pendingMip = mip;
+	}
+}
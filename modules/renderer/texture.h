@@ -1,12 +1,15 @@
 #pragma once
 
 #include "core\resource\resource.h"
+#include "core\collections\intrusiveHashMap.hpp"
 #include "gpu\vulkan\device.h"
+#include "gpu\vulkan\TextureFormatLayout.h"
 #include "math\color.h"
 
 namespace VulkanTest
 {
-	class VULKAN_TEST_API Texture final : public Resource
+	// Streamable textures are linked in the LRU list of the TextureStreamer
+	class VULKAN_TEST_API Texture final : public Resource, public Util::IntrusiveListNode<Texture>
 	{
 	public:
 		DECLARE_RESOURCE(Texture);
@@ -23,6 +26,42 @@ namespace VulkanTest
 			COUNT
 		};
 
+		// Compiled texture format:
+		// ---------------------------
+		// |  FileHeader             |
+		// ---------------------------
+		// |  Mip 0 (all layers)     |
+		// |  Mip 1 ...              |
+		// ---------------------------
+		// Mips are laid out as TextureFormatLayout, so the data is copied into the staging buffer as is,
+		// and the smaller mips are a contiguous tail of the file
+#pragma pack(1)
+		struct FileHeader
+		{
+			U32 magic;
+			U32 version;
+			U32 format;
+			U32 width;
+			U32 height;
+			U32 layers;
+			U32 levels;
+			U32 dataSize;
+			U32 flags;
+		};
+#pragma pack()
+		static const U32 FILE_MAGIC;
+		static const U32 FILE_VERSION;
+		static const U32 MAX_MIP_LEVELS = 16;
+
+		enum FileFlags : U32
+		{
+			// The compiled file is not compressed, so the mips can be read by ranges
+			FILE_FLAG_STREAMABLE = 1 << 0,
+		};
+
+		// Streamable textures are loaded with the mips not larger than it, the others are streamed in on demand
+		static const U32 STREAMING_TAIL_SIZE = 64;
+
 		Texture(const Path& path_, ResourceFactory& resFactory_);
 		virtual ~Texture();
 
@@ -36,12 +75,61 @@ namespace VulkanTest
 			return info;
 		}
 
+		// Mip streaming, the image only contains the mips [residentMip, levels)
+		bool IsStreamable()const {
+			return streamable;
+		}
+		U32 GetWidth()const {
+			return header.width;
+		}
+		U32 GetHeight()const {
+			return header.height;
+		}
+		U32 GetTailMip()const {
+			return tailMip;
+		}
+		U32 GetResidentMip()const {
+			return residentMip;
+		}
+		U32 GetPendingMip()const {
+			return pendingMip;
+		}
+		bool IsStreaming()const {
+			return streamingHandle.IsValid();
+		}
+		// Size of the mips [mip, levels)
+		U64 GetMipChainSize(U32 mip)const;
+
+		// Read the mips [mip, levels) by a ranged read and recreate the image with them
+		bool StreamMips(U32 mip);
+		// Recreate the image with the tail mips which are kept in memory
+		void DropMips();
+
+		// Bookkeeping of the TextureStreamer, the demand of the frame is packed as (frame << 8) | mip
+		// and merged into lastDemandFrame and demandedMip by the update of the streamer
+		volatile I64 frameDemand = 0;
+		U64 lastDemandFrame = 0;
+		U32 demandedMip = 0;
+
 	protected:
 		bool OnLoaded(U64 size, const U8* mem) override;
 		void OnUnLoaded() override;
+		AsyncLoadFlags GetLoadFlags()const override;
 
 	private:
+		bool CreateMipChain(U32 mip, const U8* data);
+		void OnMipsLoaded(U64 size, const U8* mem, bool success);
+
 		GPU::ImagePtr handle;
 		GPU::ImageCreateInfo info;
+
+		FileHeader header = {};
+		GPU::TextureFormatLayout layout;
+		bool streamable = false;
+		U32 tailMip = 0;
+		U32 residentMip = 0;
+		U32 pendingMip = 0;
+		AsyncLoadHandle streamingHandle = AsyncLoadHandle::INVALID;
+		OutputMemoryStream tailData;
 	};
 }
\ No newline at end of file
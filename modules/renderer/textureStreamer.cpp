@@ -0,0 +1,225 @@
+#include "textureStreamer.h"
+#include "core\platform\sync.h"
+#include "core\platform\atomic.h"
+#include "core\utils\profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VulkanTest
+{
+	static Mutex streamingMutex;
+	static Util::IntrusiveList<Texture> lruTextures;	// The most recently demanded textures are at the front
+	static U64 streamingBudget = TextureStreamer::DEFAULT_STREAMING_BUDGET;
+	static volatile I64 frameIndex = 1;
+
+	static const U32 DEMAND_MIP_BITS = 8;
+	static const I64 DEMAND_MIP_MASK = (1ll << DEMAND_MIP_BITS) - 1;
+	static TextureStreamer::Stats stats;
+
+	// Bytes added to the resident bytes when the pending mips are uploaded
+	static U64 GetPendingGrowth(const Texture& texture)
+	{
+		if (!texture.IsStreaming() || texture.GetPendingMip() >= texture.GetResidentMip())
+			return 0;
+		return texture.GetMipChainSize(texture.GetPendingMip()) - texture.GetMipChainSize(texture.GetResidentMip());
+	}
+
+	// Drop the least recently demanded texture which is not visible in the current frame
+	static U64 EvictLeastRecentlyUsed()
+	{
+		for (auto it = lruTextures.rbegin(); it != lruTextures.end(); --it)
+		{
+			Texture& texture = *it;
+			if (texture.lastDemandFrame == (U64)frameIndex)
+				break;
+
+			if (texture.IsStreaming() || texture.GetResidentMip() == texture.GetTailMip())
+				continue;
+
+			const U64 freedBytes = texture.GetMipChainSize(texture.GetResidentMip()) - texture.GetMipChainSize(texture.GetTailMip());
+			texture.DropMips();
+			if (texture.GetResidentMip() == texture.GetTailMip())
+				return freedBytes;
+		}
+		return 0;
+	}
+
+	void TextureStreamer::Initialize()
+	{
+		streamingBudget = DEFAULT_STREAMING_BUDGET;
+		frameIndex = 1;
+		stats = Stats();
+	}
+
+	void TextureStreamer::Uninitialize()
+	{
+		// Textures unregister themselves when they are unloaded
+		ScopedMutex lock(streamingMutex);
+		lruTextures.clear();
+	}
+
+	void TextureStreamer::Update()
+	{
+		PROFILE_FUNCTION();
+		ScopedMutex lock(streamingMutex);
+
+		// Merge the demand of the frame, the demanded textures are moved to the front of the LRU
+		Array<Texture*> demandedTextures;
+		for (auto it = lruTextures.begin(); it != lruTextures.end(); ++it)
+		{
+			Texture& texture = *it;
+			const I64 demand = texture.frameDemand;
+			if ((demand >> DEMAND_MIP_BITS) != frameIndex)
+				continue;
+
+			texture.lastDemandFrame = frameIndex;
+			texture.demandedMip = (U32)(demand & DEMAND_MIP_MASK);
+			demandedTextures.push_back(&texture);
+		}
+		for (I32 i = (I32)demandedTextures.size() - 1; i >= 0; i--)
+		{
+			lruTextures.erase(demandedTextures[i]);
+			lruTextures.insert_front(demandedTextures[i]);
+		}
+
+		// Gather the resident bytes and the textures which need more mips
+		Stats newStats;
+		Array<Texture*> requests;
+		for (auto it = lruTextures.begin(); it != lruTextures.end(); ++it)
+		{
+			Texture& texture = *it;
+			newStats.textureCount++;
+			newStats.residentBytes += texture.GetMipChainSize(texture.GetResidentMip());
+			if (texture.IsStreaming())
+			{
+				newStats.pendingUploads++;
+				newStats.pendingBytes += texture.GetMipChainSize(texture.GetPendingMip());
+				continue;
+			}
+
+			if (texture.lastDemandFrame == (U64)frameIndex && texture.demandedMip < texture.GetResidentMip())
+				requests.push_back(&texture);
+		}
+
+		// The most starved textures are served first
+		std::sort(requests.begin(), requests.end(), [](const Texture* a, const Texture* b) {
+			return a->GetResidentMip() - a->demandedMip > b->GetResidentMip() - b->demandedMip;
+		});
+
+		U64 usedBytes = newStats.residentBytes;
+		for (auto it = lruTextures.begin(); it != lruTextures.end(); ++it)
+			usedBytes += GetPendingGrowth(*it);
+
+		for (Texture* texture : requests)
+		{
+			if (newStats.pendingUploads >= MAX_PENDING_STREAMING_COUNT)
+				break;
+
+			const U64 residentSize = texture->GetMipChainSize(texture->GetResidentMip());
+			U32 mip = texture->demandedMip;
+			while (mip < texture->GetResidentMip() && usedBytes + texture->GetMipChainSize(mip) - residentSize > streamingBudget)
+			{
+				// Evict the invisible textures first, then lower the requested mip
+				const U64 freedBytes = EvictLeastRecentlyUsed();
+				if (freedBytes > 0)
+				{
+					usedBytes -= freedBytes;
+					newStats.residentBytes -= freedBytes;
+				}
+				else
+				{
+					mip++;
+				}
+			}
+
+			if (mip >= texture->GetResidentMip() || !texture->StreamMips(mip))
+				continue;
+
+			const U64 mipChainSize = texture->GetMipChainSize(mip);
+			usedBytes += mipChainSize - residentSize;
+			newStats.pendingUploads++;
+			newStats.pendingBytes += mipChainSize;
+		}
+
+		// Drop the invisible textures when the budget is reduced
+		while (usedBytes > streamingBudget)
+		{
+			const U64 freedBytes = EvictLeastRecentlyUsed();
+			if (freedBytes == 0)
+				break;
+
+			usedBytes -= freedBytes;
+			newStats.residentBytes -= freedBytes;
+		}
+
+		newStats.budget = streamingBudget;
+		stats = newStats;
+		AtomicIncrement(&frameIndex);
+	}
+
+	void TextureStreamer::AddDemand(Texture& texture, F32 screenSize)
+	{
+		if (!texture.IsStreamable())
+			return;
+
+		// One texel per pixel
+		U32 mip = texture.GetTailMip();
+		if (screenSize > 0.0f)
+		{
+			const F32 ratio = (F32)std::max(texture.GetWidth(), texture.GetHeight()) / screenSize;
+			mip = ratio > 1.0f ? (U32)std::floor(std::log2(ratio)) : 0;
+			mip = std::min(mip, texture.GetTailMip());
+		}
+
+		// Called from the parallel draw jobs, the lowest mip of the frame is kept without the lock
+		// and merged in the update of the streamer
+		const I64 frame = frameIndex;
+		const I64 demand = (frame << DEMAND_MIP_BITS) | mip;
+		I64 current = texture.frameDemand;
+		for (;;)
+		{
+			if ((current >> DEMAND_MIP_BITS) == frame && (current & DEMAND_MIP_MASK) <= mip)
+				break;
+
+			const I64 prev = AtomicCmpExchange(&texture.frameDemand, demand, current);
+			if (prev == current)
+				break;
+
+			current = prev;
+		}
+	}
+
+	void TextureStreamer::SetBudget(U64 budget)
+	{
+		ScopedMutex lock(streamingMutex);
+		streamingBudget = budget;
+	}
+
+	U64 TextureStreamer::GetBudget()
+	{
+		ScopedMutex lock(streamingMutex);
+		return streamingBudget;
+	}
+
+	TextureStreamer::Stats TextureStreamer::GetStats()
+	{
+		ScopedMutex lock(streamingMutex);
+		return stats;
+	}
+
+	void TextureStreamer::Register(Texture& texture)
+	{
+		ScopedMutex lock(streamingMutex);
+		texture.frameDemand = 0;
+		texture.lastDemandFrame = 0;
+		texture.demandedMip = texture.GetTailMip();
+		lruTextures.insert_back(&texture);
+	}
+
+	void TextureStreamer::Unregister(Texture& texture)
+	{
+		ScopedMutex lock(streamingMutex);
+		lruTextures.erase(&texture);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "texture.h"
+
+namespace VulkanTest
+{
+	// Stream the mips of the streamable textures according to the screen-space demand,
+	// the least recently demanded textures are dropped to the tail mips when the budget is exceeded
+	namespace TextureStreamer
+	{
+		static const U64 DEFAULT_STREAMING_BUDGET = 512 * 1024 * 1024;
+		static const U32 MAX_PENDING_STREAMING_COUNT = 8;
+
+		struct Stats
+		{
+			U64 budget = 0;
+			U64 residentBytes = 0;
+			U64 pendingBytes = 0;
+			U32 pendingUploads = 0;
+			U32 textureCount = 0;
+		};
+
+		void Initialize();
+		void Uninitialize();
+
+		// Process the demand of the current frame, call it once per frame after the visibility pass
+		void Update();
+
+		// The texture is seen with the size in pixels on the screen, the mip which maps one texel
+		// to one pixel is requested. It is lock free for the draw jobs, the demand is merged in Update
+		void AddDemand(Texture& texture, F32 screenSize);
+
+		// Budget of the streamable textures in bytes, the tail mips are always resident
+		void SetBudget(U64 budget);
+		U64 GetBudget();
+		Stats GetStats();
+
+		// Called by the streamable textures when they are loaded or unloaded
+		void Register(Texture& texture);
+		void Unregister(Texture& texture);
+	}
+}
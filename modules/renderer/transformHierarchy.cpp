@@ -0,0 +1,145 @@
+#include "transformHierarchy.h"
+#include "core\jobsystem\jobsystem.h"
+#include "core\utils\profiler.h"
+
+namespace VulkanTest
+{
+	void TransformHierarchy::Build(const U32* parents, U32 count, const U32* previousNodes)
+	{
+		PROFILE_FUNCTION();
+		const Array<U32> oldNodeSlots = std::move(nodeSlots);
+		const Array<FMat4x4> oldLocalMatrices = std::move(localMatrices);
+		const Array<FMat4x4> oldWorldMatrices = std::move(worldMatrices);
+		const Array<U8> oldDirtyFlags = std::move(dirtyFlags);
+		Clear();
+		if (count == 0)
+			return;
+
+		// Depth of each node, the chains are walked once
+		Array<U32> depths;
+		depths.resize(count);
+		for (U32 i = 0; i < count; i++)
+			depths[i] = INVALID_NODE;
+
+		Array<U32> chain;
+		U32 maxDepth = 0;
+		for (U32 i = 0; i < count; i++)
+		{
+			U32 node = i;
+			while (node != INVALID_NODE && depths[node] == INVALID_NODE)
+			{
+				chain.push_back(node);
+				node = parents[node];
+			}
+
+			U32 depth = node == INVALID_NODE ? 0 : depths[node] + 1;
+			while (!chain.empty())
+			{
+				depths[chain.back()] = depth++;
+				chain.pop_back();
+			}
+			maxDepth = std::max(maxDepth, depths[i]);
+		}
+
+		// Counting sort by depth, the nodes of a level keep their order
+		levelOffsets.resize(maxDepth + 2);
+		memset(levelOffsets.data(), 0, levelOffsets.size() * sizeof(U32));
+		for (U32 i = 0; i < count; i++)
+			levelOffsets[depths[i] + 1]++;
+		for (U32 level = 1; level < levelOffsets.size(); level++)
+			levelOffsets[level] += levelOffsets[level - 1];
+
+		Array<U32> levelCursors;
+		levelCursors.resize(maxDepth + 1);
+		memcpy(levelCursors.data(), levelOffsets.data(), levelCursors.size() * sizeof(U32));
+
+		nodeSlots.resize(count);
+		for (U32 i = 0; i < count; i++)
+			nodeSlots[i] = levelCursors[depths[i]]++;
+
+		// The parents are always in the previous level
+		parentSlots.resize(count);
+		for (U32 i = 0; i < count; i++)
+			parentSlots[nodeSlots[i]] = parents[i] != INVALID_NODE ? nodeSlots[parents[i]] : INVALID_NODE;
+
+		localMatrices.resize(count);
+		worldMatrices.resize(count);
+		dirtyFlags.resize(count);
+		updatedFlags.resize(count);
+		memset(updatedFlags.data(), 0, count);
+		for (U32 i = 0; i < count; i++)
+		{
+			const U32 slot = nodeSlots[i];
+			const U32 previous = previousNodes != nullptr ? previousNodes[i] : INVALID_NODE;
+			if (previous != INVALID_NODE)
+			{
+				const U32 oldSlot = oldNodeSlots[previous];
+				localMatrices[slot] = oldLocalMatrices[oldSlot];
+				worldMatrices[slot] = oldWorldMatrices[oldSlot];
+				dirtyFlags[slot] = oldDirtyFlags[oldSlot];
+			}
+			else
+			{
+				localMatrices[slot] = IDENTITY_MATRIX;
+				worldMatrices[slot] = IDENTITY_MATRIX;
+				dirtyFlags[slot] = 1;
+			}
+			dirtyCount += dirtyFlags[slot];
+		}
+	}
+
+	void TransformHierarchy::Clear()
+	{
+		nodeSlots.clear();
+		parentSlots.clear();
+		localMatrices.clear();
+		worldMatrices.clear();
+		dirtyFlags.clear();
+		updatedFlags.clear();
+		levelOffsets.clear();
+		dirtyCount = 0;
+	}
+
+	void TransformHierarchy::SetLocalMatrix(U32 node, const FMat4x4& local)
+	{
+		const U32 slot = nodeSlots[node];
+		localMatrices[slot] = local;
+		if (dirtyFlags[slot] == 0)
+		{
+			dirtyFlags[slot] = 1;
+			dirtyCount++;
+		}
+	}
+
+	void TransformHierarchy::Update()
+	{
+		PROFILE_FUNCTION();
+		const U32 count = nodeSlots.size();
+		if (dirtyCount == 0)
+		{
+			memset(updatedFlags.data(), 0, count);
+			return;
+		}
+
+		// A node is updated when it or its parent is, the previous level is finished before the next one
+		for (U32 level = 0; level + 1 < levelOffsets.size(); level++)
+		{
+			const U32 levelBegin = levelOffsets[level];
+			Jobsystem::ForEach(levelOffsets[level + 1] - levelBegin, PARALLEL_GROUP_SIZE, [&](U32 i) {
+				const U32 slot = levelBegin + i;
+				const U32 parent = parentSlots[slot];
+				const bool isParentUpdated = parent != INVALID_NODE && updatedFlags[parent] != 0;
+				updatedFlags[slot] = dirtyFlags[slot] | (U8)isParentUpdated;
+				if (updatedFlags[slot] == 0)
+					return;
+
+				dirtyFlags[slot] = 0;
+				MATRIX world = LoadFMat4x4(localMatrices[slot]);
+				if (parent != INVALID_NODE)
+					world = MatrixMultiply(world, LoadFMat4x4(worldMatrices[parent]));
+				worldMatrices[slot] = StoreFMat4x4(world);
+			});
+		}
+		dirtyCount = 0;
+	}
+}
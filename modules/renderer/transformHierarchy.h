@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core\common.h"
+#include "core\collections\array.h"
+#include "math\math.hpp"
+
+namespace VulkanTest
+{
+	// World matrices of a transform hierarchy. The nodes are stored as structure of arrays sorted by depth,
+	// a level only depends on the previous one so the nodes of a level are updated in parallel.
+	// The nodes are referenced by their index in the parents passed to Build
+	class VULKAN_TEST_API TransformHierarchy
+	{
+	public:
+		static const U32 INVALID_NODE = ~0u;
+		static const U32 PARALLEL_GROUP_SIZE = 1024;
+
+		// parents[i] is the parent of the node i or INVALID_NODE for the roots, the hierarchy is acyclic.
+		// previousNodes[i] is the node of the last build kept as the node i with the same parent, or INVALID_NODE.
+		// The kept nodes keep their matrices and dirtiness, the others are dirty with an identity local matrix
+		void Build(const U32* parents, U32 count, const U32* previousNodes = nullptr);
+		void Clear();
+
+		void SetLocalMatrix(U32 node, const FMat4x4& local);
+
+		// Propagate the dirtiness down the subtrees and update their world matrices
+		void Update();
+		bool IsDirty()const { return dirtyCount > 0; }
+
+		const FMat4x4& GetWorldMatrix(U32 node)const { return worldMatrices[nodeSlots[node]]; }
+
+		// The world matrix is changed by the last Update
+		bool IsUpdated(U32 node)const { return updatedFlags[nodeSlots[node]] != 0; }
+
+		U32 GetNodeCount()const { return nodeSlots.size(); }
+		U32 GetLevelCount()const { return levelOffsets.empty() ? 0 : levelOffsets.size() - 1; }
+
+	private:
+		Array<U32> nodeSlots;		// Node to slot
+		Array<U32> parentSlots;		// INVALID_NODE for the roots
+		Array<FMat4x4> localMatrices;
+		Array<FMat4x4> worldMatrices;
+		Array<U8> dirtyFlags;
+		Array<U8> updatedFlags;
+		Array<U32> levelOffsets;	// First slot of each depth, the last one is the node count
+		U32 dirtyCount = 0;
+	};
+}
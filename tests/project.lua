@@ -21,4 +21,15 @@ create_test_instance("particleDream", { "particleDream.cpp"} )
 create_test_instance("jobsystemTest", { "jobsystemTest.cpp"} )
 create_test_instance("renderGraphTest", { "renderGraphTest.cpp"} )
 create_test_instance("ecsTest", { "ecsTest.cpp"} )
+create_test_instance("allocatorTest", { "allocatorTest.cpp"} )
+create_test_instance("tempHashMapTest", { "tempHashMapTest.cpp"} )
+create_test_instance("profilerBenchmark", { "profilerBenchmark.cpp"} )
+create_test_instance("resourceLoadTest", { "resourceLoadTest.cpp"} )
+create_test_instance("pipelineReplay", { "pipelineReplay.cpp"} )
+create_test_instance("commandRecordingBenchmark", { "commandRecordingBenchmark.cpp"} )
+create_test_instance("cullingBenchmark", { "cullingBenchmark.cpp"} )
+create_test_instance("frustumKernelBenchmark", { "frustumKernelBenchmark.cpp"} )
+create_test_instance("transformHierarchyBenchmark", { "transformHierarchyBenchmark.cpp"} )
+create_test_instance("textureStreamerTest", { "textureStreamerTest.cpp"} )
+create_test_instance("assetCompilerTest", { "assetCompilerTest.cpp"} )
 group ""
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "core\memory\memory.h"
+#include "core\platform\timer.h"
+
+#include <thread>
+
+using namespace VulkanTest;
+
+namespace
+{
+    const U32 ROUND_COUNT = 200;
+    const U32 ALLOCATION_COUNT_PER_ROUND = 1024;
+    const U32 MAX_ALLOCATION_SIZE = 512;
+    const U32 THREAD_COUNTS[] = { 1, 4, 16 };
+
+    struct MallocAllocator
+    {
+        void* Allocate(size_t size) { return malloc(size); }
+        void Free(void* ptr) { free(ptr); }
+    };
+
+    template<typename T>
+    struct AllocatorWrapper
+    {
+        T& allocator;
+
+        void* Allocate(size_t size) { return CJING_ALLOCATOR_MALLOC(allocator, size); }
+        void Free(void* ptr) { CJING_ALLOCATOR_FREE(allocator, ptr); }
+    };
+
+    template<>
+    struct AllocatorWrapper<MallocAllocator>
+    {
+        MallocAllocator& allocator;
+
+        void* Allocate(size_t size) { return allocator.Allocate(size); }
+        void Free(void* ptr) { allocator.Free(ptr); }
+    };
+
+    // Allocate small blocks of random sizes, free half of them in a different order,
+    // then free the rest, similar to the component and job allocations of a frame
+    template<typename T>
+    void RunAllocations(T& allocator, U32 seed)
+    {
+        AllocatorWrapper<T> wrapper = { allocator };
+        void* ptrs[ALLOCATION_COUNT_PER_ROUND];
+        for (U32 round = 0; round < ROUND_COUNT; round++)
+        {
+            for (U32 i = 0; i < ALLOCATION_COUNT_PER_ROUND; i++)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                const size_t size = (seed % MAX_ALLOCATION_SIZE) + 1;
+                ptrs[i] = wrapper.Allocate(size);
+                memset(ptrs[i], 0, std::min(size, (size_t)16));
+            }
+
+            for (U32 i = 1; i < ALLOCATION_COUNT_PER_ROUND; i += 2)
+                wrapper.Free(ptrs[i]);
+            for (U32 i = 0; i < ALLOCATION_COUNT_PER_ROUND; i += 2)
+                wrapper.Free(ptrs[i]);
+        }
+    }
+
+    template<typename T>
+    F32 RunBenchmark(T& allocator, U32 threadCount)
+    {
+        Timer timer;
+        std::vector<std::thread> threads;
+        for (U32 i = 0; i < threadCount; i++)
+            threads.emplace_back([&allocator, i]() { RunAllocations(allocator, i * 7919u + 1u); });
+
+        for (auto& thread : threads)
+            thread.join();
+
+        return timer.GetTimeSinceStart();
+    }
+
+    template<typename T>
+    void PrintBenchmark(const char* name, T& allocator, U32 threadCount)
+    {
+        const U64 opCount = (U64)threadCount * ROUND_COUNT * ALLOCATION_COUNT_PER_ROUND * 2;
+        F32 elapsed = RunBenchmark(allocator, threadCount);
+        std::cout << "Threads:" << threadCount
+                  << " Allocator:" << name
+                  << " Time:" << elapsed * 1000.0f << "ms"
+                  << " Ops/sec:" << (U64)(opCount / std::max(elapsed, 0.0001f))
+                  << std::endl;
+    }
+}
+
+int main()
+{
+    std::cout << "Small allocation benchmark, size:(0, " << MAX_ALLOCATION_SIZE << "]" << std::endl;
+    // Thread cache disabled, every allocation takes the allocator mutex
+    DefaultAllocator lockedAllocator(false);
+    DefaultAllocator cachedAllocator;
+    MallocAllocator mallocAllocator;
+    for (U32 threadCount : THREAD_COUNTS)
+    {
+        PrintBenchmark("DefaultAllocator(locked)", lockedAllocator, threadCount);
+        PrintBenchmark("DefaultAllocator", cachedAllocator, threadCount);
+        PrintBenchmark("malloc", mallocAllocator, threadCount);
+    }
+
+	return 0;
+}
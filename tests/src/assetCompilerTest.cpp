@@ -0,0 +1,260 @@
+#include "client\app\app.h"
+#include "core\filesystem\filesystem.h"
+#include "core\resource\resourceManager.h"
+#include "core\platform\timer.h"
+#include "editor\editor.h"
+#include "editor\widgets\assetCompiler.h"
+
+namespace VulkanTest
+{
+    // Drive AssetCompiler::Update with hooked resources before and after 50k assets are registered:
+    // Phase 0: the sources are loaded, deferred by the load hook and continued after compiling
+    // Phase 1: 50k assets are registered, the same count of sources is loaded again
+    // A frame continues at most MAX_CONTINUED_PER_FRAME resources and its cost must not grow with the registered assets.
+    const U32 SOURCE_COUNT = 256;
+    const U32 REGISTERED_COUNT = 50000;
+    const U32 MAX_CONTINUED_PER_FRAME = 16;
+    const U32 MAX_PHASE_FRAMES = 3000;
+    const F32 MAX_UPDATE_TIME_RATIO = 4.0f;
+    const F32 UPDATE_TIME_TOLERANCE = 0.0005f;
+    const char* SOURCE_DIR = "assetCompilerTest";
+    const char* SOURCE_EXT = "tres";
+
+    static int testResult = 0;
+
+    class TestResource final : public Resource
+    {
+    public:
+        DECLARE_RESOURCE(TestResource);
+
+        TestResource(const Path& path_, ResourceFactory& resFactory_) :
+            Resource(path_, resFactory_)
+        {
+        }
+
+    protected:
+        bool OnLoaded(U64 size, const U8* mem) override
+        {
+            return true;
+        }
+
+        void OnUnLoaded() override
+        {
+        }
+    };
+    DEFINE_RESOURCE(TestResource);
+
+    struct TestResourceFactory : public ResourceFactory
+    {
+    protected:
+        Resource* CreateResource(const Path& path) override
+        {
+            return CJING_NEW(TestResource)(path, *this);
+        }
+
+        void DestroyResource(Resource* res) override
+        {
+            CJING_DELETE(res);
+        }
+    };
+
+    struct TestCompilerPlugin : Editor::AssetCompiler::IPlugin
+    {
+        Editor::AssetCompiler* compiler = nullptr;
+
+        bool Compile(const Path& path) override
+        {
+            return compiler->CopyCompile(path);
+        }
+
+        std::vector<const char*> GetSupportExtensions() override
+        {
+            return { SOURCE_EXT };
+        }
+    };
+
+    // Only the engine of the editor is used by the asset compiler
+    class TestEditor : public Editor::EditorApp
+    {
+    private:
+        UniquePtr<Editor::AssetCompiler> compiler;
+        TestResourceFactory factory;
+        TestCompilerPlugin plugin;
+        ResPtr<TestResource> resources[SOURCE_COUNT];
+        Array<Utils::Action*> actions;
+        Array<Platform::WindowEvent> windowEvents;
+        U32 phase = 0;
+        U32 phaseFrames = 0;
+        U32 updateCount = 0;
+        F32 updateTime = 0.0f;
+        F32 phaseUpdateTimes[2] = {};
+
+    public:
+        void Initialize() override
+        {
+            App::Initialize();
+
+            factory.Initialize(TestResource::ResType, engine->GetResourceManager());
+
+            compiler = Editor::AssetCompiler::Create(*this);
+            compiler->RegisterExtension(SOURCE_EXT, TestResource::ResType);
+            plugin.compiler = compiler.Get();
+            compiler->AddPlugin(plugin);
+            compiler->InitFinished();
+
+            Platform::MakeDir(SOURCE_DIR);
+            StartPhase();
+        }
+
+        void Uninitialize() override
+        {
+            for (auto& res : resources)
+                res.reset();
+
+            compiler.Reset();
+            factory.Uninitialize();
+
+            App::Uninitialize();
+        }
+
+        void Update(F32 dt) override
+        {
+            App::Update(dt);
+            if (requestedShutdown)
+                return;
+
+            if (++phaseFrames > MAX_PHASE_FRAMES)
+            {
+                Fail("Phase timeout");
+                return;
+            }
+
+            bool hooked[SOURCE_COUNT];
+            for (U32 i = 0; i < SOURCE_COUNT; i++)
+                hooked[i] = resources[i]->IsHooked();
+
+            Timer timer;
+            compiler->Update(dt);
+            updateTime += timer.GetTimeSinceStart();
+            updateCount++;
+
+            U32 continuedCount = 0;
+            bool finished = true;
+            for (U32 i = 0; i < SOURCE_COUNT; i++)
+            {
+                if (hooked[i] && !resources[i]->IsHooked())
+                    continuedCount++;
+
+                if (resources[i]->IsHooked() || resources[i]->IsEmpty())
+                    finished = false;
+            }
+
+            if (continuedCount > MAX_CONTINUED_PER_FRAME)
+            {
+                Fail("Too many resources continued in a frame");
+                return;
+            }
+
+            if (finished)
+                FinishPhase();
+        }
+
+        void AddPlugin(Editor::EditorPlugin& plugin) override {}
+        void AddWidget(Editor::EditorWidget& widget) override {}
+        Editor::EditorWidget* GetWidget(const char* name) override { return nullptr; }
+        void RemoveWidget(Editor::EditorWidget& widget) override {}
+        void AddWindow(Platform::WindowType window) override {}
+        void RemoveWindow(Platform::WindowType window) override {}
+        void DeferredDestroyWindow(Platform::WindowType window) override {}
+        void AddAction(Utils::Action* action) override {}
+        void RemoveAction(Utils::Action* action) override {}
+        Array<Utils::Action*>& GetActions() override { return actions; }
+        void SetCursorCaptured(bool capture) override {}
+        void SaveSettings() override {}
+        Utils::Action* GetAction(const char* name) override { return nullptr; }
+        const Array<Platform::WindowEvent>& GetWindowEvents()const override { return windowEvents; }
+        Editor::AssetCompiler& GetAssetCompiler() override { return *compiler; }
+        Editor::EntityListWidget& GetEntityList() override { abort(); }
+        Editor::WorldEditor& GetWorldEditor() override { abort(); }
+        Editor::Gizmo::Config& GetGizmoConfig() override { abort(); }
+        ImFont* GetBigIconFont() override { return nullptr; }
+        ImFont* GetBoldFont() override { return nullptr; }
+
+    private:
+        // Rewrite the sources so they are newer than the compiled resources and deferred by the load hook
+        void StartPhase()
+        {
+            FileSystem& fs = engine->GetFileSystem();
+            ResourceManager& resManager = engine->GetResourceManager();
+            for (U32 i = 0; i < SOURCE_COUNT; i++)
+            {
+                resources[i].reset();
+
+                const StaticString<MAX_PATH_LENGTH> path(SOURCE_DIR, "/source_", phase, "_", i, ".", SOURCE_EXT);
+                auto file = fs.OpenFile(path.c_str(), FileFlags::DEFAULT_WRITE);
+                if (!file->IsValid())
+                {
+                    Fail("Failed to write the source");
+                    return;
+                }
+                file->Write(path.c_str(), StringLength(path.c_str()));
+                file->Close();
+
+                resources[i] = resManager.LoadResourcePtr<TestResource>(Path(path.c_str()));
+            }
+
+            phaseFrames = 0;
+            updateCount = 0;
+            updateTime = 0.0f;
+        }
+
+        void FinishPhase()
+        {
+            phaseUpdateTimes[phase] = updateTime / std::max(updateCount, 1u);
+            std::cout << "Phase:" << phase
+                      << " Frames:" << updateCount
+                      << " Update:" << phaseUpdateTimes[phase] * 1000.0f << "ms" << std::endl;
+
+            if (phase == 0)
+            {
+                for (U32 i = 0; i < REGISTERED_COUNT; i++)
+                {
+                    const StaticString<MAX_PATH_LENGTH> path(SOURCE_DIR, "/registered/dir_", i % 64, "/asset_", i, ".", SOURCE_EXT);
+                    compiler->AddResource(TestResource::ResType, path.c_str());
+                }
+
+                phase++;
+                StartPhase();
+                return;
+            }
+
+            if (phaseUpdateTimes[1] > phaseUpdateTimes[0] * MAX_UPDATE_TIME_RATIO + UPDATE_TIME_TOLERANCE)
+            {
+                Fail("Update cost grows with the registered assets");
+                return;
+            }
+
+            std::cout << "Asset compiler update passed" << std::endl;
+            RequestShutdown();
+        }
+
+        void Fail(const char* msg)
+        {
+            std::cout << msg << ", phase:" << phase << std::endl;
+            testResult = 1;
+            RequestShutdown();
+        }
+    };
+
+    App* CreateApplication(int, char**)
+    {
+        return new TestEditor();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (VulkanTest::ApplicationMain(VulkanTest::CreateApplication, argc, argv) != 0)
+        return 1;
+    return VulkanTest::testResult;
+}
@@ -0,0 +1,235 @@
+#include "gpu\vulkan\device.h"
+#include "gpu\vulkan\shaderManager.h"
+#include "core\jobsystem\jobsystem.h"
+#include "core\platform\platform.h"
+#include "core\platform\timer.h"
+#include "renderer\renderGraph.h"
+#include "math\math.hpp"
+
+using namespace VulkanTest;
+
+namespace
+{
+    // Render a render graph pass of DRAW_COUNT draws with the growing worker count, without window.
+    // The pass is built by SetParallelBuildCallback, the render graph splits the draws into secondary
+    // command lists recorded on the workers. The inline time is measured with a group size larger than
+    // the draw count, then the pass is recorded on a single command list.
+    // The CPU time of RenderGraph::Render is measured, the frames are still submitted.
+    const U32 DRAW_COUNT = 10000;
+    const U32 GROUP_SIZE = 256;
+    const U32 FRAME_COUNT = 16;
+    const U32 MAX_WORKER_COUNT = 16;
+    const U32 TARGET_WIDTH = 1280;
+    const U32 TARGET_HEIGHT = 720;
+
+    struct PushConstantImage
+    {
+        int textureIndex = 0;
+    };
+
+    struct BenchmarkScene
+    {
+        GPU::ImagePtr images[4];
+        GPU::BufferPtr vertexBuffer;
+        GPU::BufferPtr indexBuffer;
+        GPU::ShaderProgram* program = nullptr;
+        VkDescriptorSet bindlessSet = VK_NULL_HANDLE;
+    };
+
+    bool InitScene(GPU::DeviceVulkan& device, BenchmarkScene& scene)
+    {
+        GPU::TextureFormatLayout formatLayout;
+        formatLayout.SetTexture2D(VK_FORMAT_R8G8B8A8_SRGB, 1, 1);
+        GPU::ImageCreateInfo imageInfo = GPU::ImageCreateInfo::ImmutableImage2D(1, 1, VK_FORMAT_R8G8B8A8_SRGB);
+        GPU::SubresourceData data = {};
+        data.rowPitch = formatLayout.RowByteStride(1);
+
+        const uint8_t colors[4][4] = {
+            { 0xff, 0, 0, 0xff },
+            { 0, 0xff, 0, 0xff },
+            { 0, 0, 0xff, 0xff },
+            { 0, 0, 0, 0xff },
+        };
+        for (U32 i = 0; i < 4; i++)
+        {
+            data.data = colors[i];
+            scene.images[i] = device.CreateImage(imageInfo, &data);
+            if (!scene.images[i])
+                return false;
+        }
+
+        const Vec2 vertices[4] = {
+            Vec2(-0.5f, -0.5f),
+            Vec2(-0.5f, +0.5f),
+            Vec2(+0.5f, +0.5f),
+            Vec2(+0.5f, -0.5f),
+        };
+        const U32 indices[6] = {
+            0, 1, 2,
+            0, 2, 3
+        };
+
+        GPU::BufferCreateInfo bufferInfo = {};
+        bufferInfo.domain = GPU::BufferDomain::Device;
+        bufferInfo.size = sizeof(vertices);
+        bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        scene.vertexBuffer = device.CreateBuffer(bufferInfo, vertices);
+
+        bufferInfo.size = sizeof(indices);
+        bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+        scene.indexBuffer = device.CreateBuffer(bufferInfo, indices);
+        if (!scene.vertexBuffer || !scene.indexBuffer)
+            return false;
+
+        // Resolve the program once, the recording threads only bind it
+        auto* templateProgram = device.GetShaderManager().RegisterGraphics("test/triangleVS.hlsl", "test/trianglePS.hlsl");
+        if (templateProgram == nullptr)
+            return false;
+
+        scene.program = templateProgram->RegisterVariant({})->GetProgram();
+        return scene.program != nullptr;
+    }
+
+    void RecordDraws(GPU::CommandList& cmd, const BenchmarkScene& scene, U32 begin, U32 end)
+    {
+        cmd.SetShaderProgram(scene.program);
+        cmd.SetDefaultOpaqueState();
+        cmd.SetPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+        cmd.SetBindless(1, scene.bindlessSet);
+        cmd.SetSampler(0, 0, GPU::StockSampler::NearestClamp);
+        cmd.BindVertexBuffer(scene.vertexBuffer, 0, 0, sizeof(Vec2), VK_VERTEX_INPUT_RATE_VERTEX);
+        cmd.SetVertexAttribute(0, 0, VK_FORMAT_R32G32_SFLOAT, 0);
+        cmd.BindIndexBuffer(scene.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+        for (U32 i = begin; i < end; i++)
+        {
+            PushConstantImage push;
+            push.textureIndex = i % 4;
+            cmd.PushConstants(&push, 0, sizeof(push));
+            cmd.DrawIndexed(6);
+        }
+    }
+
+    void BakeGraph(RenderGraph& graph, GPU::DeviceVulkan& device, const BenchmarkScene& scene, U32 groupSize)
+    {
+        graph.SetDevice(&device);
+
+        ResourceDimensions dim;
+        dim.width = TARGET_WIDTH;
+        dim.height = TARGET_HEIGHT;
+        dim.format = VK_FORMAT_R8G8B8A8_UNORM;
+        graph.SetBackbufferDimension(dim);
+
+        AttachmentInfo back;
+        back.format = dim.format;
+        back.sizeX = (F32)dim.width;
+        back.sizeY = (F32)dim.height;
+
+        auto& drawPass = graph.AddRenderPass("Draws", RenderGraphQueueFlag::Graphics);
+        drawPass.WriteColor("back", back);
+        drawPass.SetClearColorCallback([](U32 index, VkClearColorValue* value) {
+            if (value != nullptr)
+                memset(value, 0, sizeof(VkClearColorValue));
+            return true;
+        });
+        drawPass.SetParallelBuildCallback([]() { return DRAW_COUNT; }, [&scene](GPU::CommandList& cmd, U32 begin, U32 end) {
+            RecordDraws(cmd, scene, begin, end);
+        }, groupSize);
+
+        graph.DisableSwapchain();
+        graph.SetBackBufferSource("back");
+        graph.Bake();
+    }
+
+    F32 RenderFrame(GPU::DeviceVulkan& device, BenchmarkScene& scene, RenderGraph& graph)
+    {
+        GPU::BindlessDescriptorPoolPtr bindlessPool = device.GetBindlessDescriptorPool(GPU::BindlessReosurceType::SampledImage, 1, 4);
+        if (!bindlessPool)
+            return 0.0f;
+
+        bindlessPool->AllocateDescriptors(4);
+        for (U32 i = 0; i < 4; i++)
+            bindlessPool->SetTexture(i, scene.images[i]->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        scene.bindlessSet = bindlessPool->GetDescriptorSet();
+
+        graph.SetupAttachments(device, nullptr);
+
+        Timer timer;
+        Jobsystem::JobHandle handle;
+        graph.Render(device, handle);
+        Jobsystem::Wait(&handle);
+        const F32 elapsed = timer.GetTimeSinceStart();
+
+        device.NextFrameContext();
+        return elapsed;
+    }
+
+    F32 RunBenchmark(GPU::DeviceVulkan& device, BenchmarkScene& scene, U32 groupSize)
+    {
+        RenderGraph graph;
+        BakeGraph(graph, device, scene, groupSize);
+
+        // The first frame compiles the pipeline
+        RenderFrame(device, scene, graph);
+
+        F32 elapsed = 0.0f;
+        for (U32 i = 0; i < FRAME_COUNT; i++)
+            elapsed += RenderFrame(device, scene, graph);
+
+        graph.Reset();
+        return elapsed / FRAME_COUNT;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const U32 maxWorkerCount = std::min((U32)std::max(Platform::GetCPUsCount(), 1), MAX_WORKER_COUNT);
+
+    // Headless device, the workers record with the thread indices [1, maxWorkerCount]
+    GPU::VulkanContext context(maxWorkerCount + 1);
+    if (!context.Initialize({}, {}, false))
+    {
+        std::cout << "Failed to initialize vulkan" << std::endl;
+        return 1;
+    }
+
+    int ret = 0;
+    {
+        GPU::DeviceVulkan device;
+        device.SetContext(context);
+
+        BenchmarkScene scene;
+        if (!InitScene(device, scene))
+        {
+            std::cout << "Failed to initialize the benchmark scene" << std::endl;
+            return 1;
+        }
+
+        std::cout << "Draws:" << DRAW_COUNT << std::endl;
+        for (U32 workerCount = 1; workerCount <= maxWorkerCount; workerCount *= 2)
+        {
+            if (!Jobsystem::Initialize(workerCount))
+            {
+                ret = 1;
+                break;
+            }
+
+            if (workerCount == 1)
+            {
+                const F32 inlineTime = RunBenchmark(device, scene, DRAW_COUNT);
+                std::cout << "Inline Time:" << inlineTime * 1000.0f << "ms" << std::endl;
+            }
+
+            const F32 parallelTime = RunBenchmark(device, scene, GROUP_SIZE);
+            std::cout << "Workers:" << workerCount
+                      << " Time:" << parallelTime * 1000.0f << "ms"
+                      << " Throughput:" << DRAW_COUNT / std::max(parallelTime, 0.0001f) << "draws/s"
+                      << std::endl;
+
+            Jobsystem::Uninitialize();
+        }
+
+        device.WaitIdle();
+    }
+    return ret;
+}
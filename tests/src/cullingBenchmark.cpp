@@ -0,0 +1,206 @@
+#include "renderer\sceneBVH.h"
+#include "renderer\culling.h"
+#include "core\platform\timer.h"
+#include "core\platform\platform.h"
+#include "core\jobsystem\jobsystem.h"
+#include "math\math.hpp"
+#include "math\random.h"
+
+#include <algorithm>
+
+using namespace VulkanTest;
+
+namespace
+{
+    // Compare the brute-force frustum culling with the BVH culling over random scenes.
+    // The objects are spread in a cube around the camera, so most of them are off-screen
+    const U32 OBJECT_COUNTS[] = { 100000, 1000000 };
+    const U32 FRAME_COUNT = 8;
+    const F32 WORLD_SIZE = 2000.0f;
+    const U32 VIEW_COUNT = 4;   // Main camera and three shadow cascades
+
+    void CreateScene(U32 count, Array<AABB>& aabbs)
+    {
+        aabbs.resize(count);
+        for (U32 i = 0; i < count; i++)
+        {
+            const F32x3 center(
+                Random::RandomFloat(-WORLD_SIZE, WORLD_SIZE),
+                Random::RandomFloat(-WORLD_SIZE, WORLD_SIZE),
+                Random::RandomFloat(-WORLD_SIZE, WORLD_SIZE));
+            const F32 halfWidth = Random::RandomFloat(0.5f, 4.0f);
+            aabbs[i] = AABB::CreateFromHalfWidth(center, F32x3(halfWidth, halfWidth, halfWidth));
+        }
+    }
+
+    Frustum CreateFrustum(F32 yaw)
+    {
+        // Same projection as the CameraComponent, reversed z
+        MATRIX P = MatrixPerspectiveFovLH(MATH_PI / 3.0f, 16.0f / 9.0f, 1000.0f, 0.1f);
+        MATRIX V = MatrixLookToLH(VectorSet(0, 0, 0, 1), VectorSet(std::sin(yaw), 0, std::cos(yaw), 0), VectorSet(0, 1, 0, 0));
+
+        Frustum frustum;
+        frustum.Compute(MatrixMultiply(V, P));
+        return frustum;
+    }
+
+    F32 CullBruteForce(const Frustum& frustum, const Array<AABB>& aabbs, Array<U32>& visibles)
+    {
+        Timer timer;
+        for (U32 i = 0; i < aabbs.size(); i++)
+        {
+            if (frustum.CheckBoxFast(aabbs[i]))
+                visibles.push_back(i);
+        }
+        return timer.GetTimeSinceStart();
+    }
+
+    F32 CullBVH(const Frustum& frustum, const SceneBVH& bvh, Array<U32>& visibles)
+    {
+        Timer timer;
+        bvh.Cull(frustum, [&](U32 index) {
+            visibles.push_back(index);
+        });
+        return timer.GetTimeSinceStart();
+    }
+
+    // Cull the views one after the other on the calling thread, in one traversal of the whole tree
+    F32 CullViewsSerial(const Frustum* frustums, const SceneBVH& bvh, const Array<ECS::EntityID>& bvhObjects, Array<ECS::EntityID>* visibles)
+    {
+        Timer timer;
+        for (U32 view = 0; view < VIEW_COUNT; view++)
+        {
+            bvh.Cull(frustums[view], [&](U32 index) {
+                visibles[view].push_back(bvhObjects[index]);
+            });
+        }
+        return timer.GetTimeSinceStart();
+    }
+
+    // Cull all views with the CullingSystem, the subtrees are split across the workers
+    F32 CullViewsParallel(CullingSystem& cullingSystem, const Frustum* frustums, const SceneBVH& bvh, const Array<ECS::EntityID>& bvhObjects, Visibility* visibilities)
+    {
+        Visibility* views[VIEW_COUNT];
+        for (U32 view = 0; view < VIEW_COUNT; view++)
+        {
+            visibilities[view].Clear();
+            visibilities[view].frustum = frustums[view];
+            views[view] = &visibilities[view];
+        }
+
+        Timer timer;
+        cullingSystem.CullViews(Span<Visibility*>(views), bvh, bvhObjects);
+        return timer.GetTimeSinceStart();
+    }
+
+    // The lists of the CullingSystem must have the order of the serial traversal
+    bool IsSameVisibles(const Array<ECS::EntityID>& a, const Array<ECS::EntityID>& b)
+    {
+        return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(ECS::EntityID)) == 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (!Jobsystem::Initialize(std::max(Platform::GetCPUsCount() - 1, 1)))
+        return 1;
+
+    int ret = 0;
+    UniquePtr<CullingSystem> cullingSystem = CullingSystem::Create();
+    for (U32 count : OBJECT_COUNTS)
+    {
+        Array<AABB> aabbs;
+        CreateScene(count, aabbs);
+
+        // The BVH items stand for the objects of a scene
+        Array<ECS::EntityID> bvhObjects;
+        bvhObjects.resize(count);
+        for (U32 i = 0; i < count; i++)
+            bvhObjects[i] = (ECS::EntityID)(i + 1);
+
+        SceneBVH bvh;
+        Timer timer;
+        bvh.Build(aabbs.data(), aabbs.size());
+        const F32 buildTime = timer.GetTimeSinceStart();
+
+        // Move the objects a little, the topology is kept
+        for (AABB& aabb : aabbs)
+        {
+            aabb.min.y += 1.0f;
+            aabb.max.y += 1.0f;
+        }
+        Timer refitTimer;
+        bvh.Refit(aabbs.data(), aabbs.size());
+        const F32 refitTime = refitTimer.GetTimeSinceStart();
+
+        F32 bruteForceTime = 0.0f;
+        F32 bvhTime = 0.0f;
+        U32 visibleCount = 0;
+        Array<U32> bruteForceVisibles;
+        Array<U32> bvhVisibles;
+        for (U32 frame = 0; frame < FRAME_COUNT; frame++)
+        {
+            const Frustum frustum = CreateFrustum(frame * MATH_PI * 2.0f / FRAME_COUNT);
+            bruteForceVisibles.clear();
+            bvhVisibles.clear();
+            bruteForceTime += CullBruteForce(frustum, aabbs, bruteForceVisibles);
+            bvhTime += CullBVH(frustum, bvh, bvhVisibles);
+
+            // Both must find the same objects
+            std::sort(bvhVisibles.begin(), bvhVisibles.end());
+            if (bruteForceVisibles.size() != bvhVisibles.size() ||
+                memcmp(bruteForceVisibles.data(), bvhVisibles.data(), bvhVisibles.size() * sizeof(U32)) != 0)
+            {
+                std::cout << "Mismatched visible objects, frame:" << frame << std::endl;
+                ret = 1;
+            }
+            visibleCount += bvhVisibles.size();
+        }
+
+        std::cout << "Objects:" << count
+                  << " Nodes:" << bvh.GetNodeCount()
+                  << " Visible:" << visibleCount / FRAME_COUNT
+                  << " Build:" << buildTime * 1000.0f << "ms"
+                  << " Refit:" << refitTime * 1000.0f << "ms"
+                  << std::endl;
+        std::cout << "    BruteForce:" << bruteForceTime * 1000.0f / FRAME_COUNT << "ms"
+                  << " BVH:" << bvhTime * 1000.0f / FRAME_COUNT << "ms"
+                  << " Speedup:" << bruteForceTime / std::max(bvhTime, 0.000001f)
+                  << std::endl;
+
+        // Several views of the same frame
+        F32 serialTime = 0.0f;
+        F32 parallelTime = 0.0f;
+        for (U32 frame = 0; frame < FRAME_COUNT; frame++)
+        {
+            Frustum frustums[VIEW_COUNT];
+            for (U32 view = 0; view < VIEW_COUNT; view++)
+                frustums[view] = CreateFrustum((frame * VIEW_COUNT + view) * MATH_PI * 2.0f / (FRAME_COUNT * VIEW_COUNT));
+
+            Array<ECS::EntityID> serialVisibles[VIEW_COUNT];
+            Visibility parallelVisibilities[VIEW_COUNT];
+            serialTime += CullViewsSerial(frustums, bvh, bvhObjects, serialVisibles);
+            parallelTime += CullViewsParallel(*cullingSystem, frustums, bvh, bvhObjects, parallelVisibilities);
+
+            for (U32 view = 0; view < VIEW_COUNT; view++)
+            {
+                if (!IsSameVisibles(serialVisibles[view], parallelVisibilities[view].objects))
+                {
+                    std::cout << "Mismatched visible objects, frame:" << frame << " view:" << view << std::endl;
+                    ret = 1;
+                }
+            }
+        }
+
+        std::cout << "    Views:" << VIEW_COUNT
+                  << " Workers:" << Jobsystem::GetWorkerCount()
+                  << " Serial:" << serialTime * 1000.0f / FRAME_COUNT << "ms"
+                  << " Parallel:" << parallelTime * 1000.0f / FRAME_COUNT << "ms"
+                  << " Speedup:" << serialTime / std::max(parallelTime, 0.000001f)
+                  << std::endl;
+    }
+
+    cullingSystem.Reset();
+    Jobsystem::Uninitialize();
+    return ret;
+}
@@ -0,0 +1,183 @@
+#include "math\geometry.h"
+#include "math\simd.h"
+#include "core\platform\timer.h"
+#include "math\math.hpp"
+#include "math\random.h"
+
+#include <algorithm>
+
+using namespace VulkanTest;
+
+namespace
+{
+    // Compare the per object frustum test with the batched structure of arrays kernel.
+    // The boxes are spread in a cube around the camera, so most of them are off-screen
+    const U32 OBJECT_COUNT = 1000000;
+    const U32 FRAME_COUNT = 16;
+    const F32 WORLD_SIZE = 2000.0f;
+    // CheckBoxFast tests the corners of min/max, the kernel uses center/extent, so their results
+    // may differ for the boxes touching a plane within the float rounding
+    const F32 PLANE_EPSILON = 0.01f;
+
+    struct BoxArray
+    {
+        Array<F32> centers[3];
+        Array<F32> extents[3];
+
+        BoxArraySoA GetSoA()const
+        {
+            BoxArraySoA ret;
+            ret.centerX = centers[0].data();
+            ret.centerY = centers[1].data();
+            ret.centerZ = centers[2].data();
+            ret.extentX = extents[0].data();
+            ret.extentY = extents[1].data();
+            ret.extentZ = extents[2].data();
+            return ret;
+        }
+    };
+
+    void CreateScene(U32 count, Array<AABB>& aabbs, BoxArray& boxes)
+    {
+        aabbs.resize(count);
+        for (U32 axis = 0; axis < 3; axis++)
+        {
+            boxes.centers[axis].resize(count);
+            boxes.extents[axis].resize(count);
+        }
+
+        for (U32 i = 0; i < count; i++)
+        {
+            const F32x3 center(
+                Random::RandomFloat(-WORLD_SIZE, WORLD_SIZE),
+                Random::RandomFloat(-WORLD_SIZE, WORLD_SIZE),
+                Random::RandomFloat(-WORLD_SIZE, WORLD_SIZE));
+            const F32 halfWidth = Random::RandomFloat(0.5f, 4.0f);
+            aabbs[i] = AABB::CreateFromHalfWidth(center, F32x3(halfWidth, halfWidth, halfWidth));
+
+            boxes.centers[0][i] = center.x;
+            boxes.centers[1][i] = center.y;
+            boxes.centers[2][i] = center.z;
+            boxes.extents[0][i] = halfWidth;
+            boxes.extents[1][i] = halfWidth;
+            boxes.extents[2][i] = halfWidth;
+        }
+    }
+
+    Frustum CreateFrustum(F32 yaw)
+    {
+        // Same projection as the CameraComponent, reversed z
+        MATRIX P = MatrixPerspectiveFovLH(MATH_PI / 3.0f, 16.0f / 9.0f, 1000.0f, 0.1f);
+        MATRIX V = MatrixLookToLH(VectorSet(0, 0, 0, 1), VectorSet(std::sin(yaw), 0, std::cos(yaw), 0), VectorSet(0, 1, 0, 0));
+
+        Frustum frustum;
+        frustum.Compute(MatrixMultiply(V, P));
+        return frustum;
+    }
+
+    F32 CheckScalar(const Frustum& frustum, const Array<AABB>& aabbs, Array<U32>& visibleMask)
+    {
+        Timer timer;
+        memset(visibleMask.data(), 0, visibleMask.size() * sizeof(U32));
+        for (U32 i = 0; i < aabbs.size(); i++)
+        {
+            if (frustum.CheckBoxFast(aabbs[i]))
+                visibleMask[i >> 5] |= 1u << (i & 31);
+        }
+        return timer.GetTimeSinceStart();
+    }
+
+    F32 CheckBatched(const Frustum& frustum, const BoxArray& boxes, U32 count, Array<U32>& visibleMask)
+    {
+        Timer timer;
+        frustum.CheckBoxes(boxes.GetSoA(), count, visibleMask.data());
+        return timer.GetTimeSinceStart();
+    }
+
+    bool IsTouchingPlane(const Frustum& frustum, const BoxArray& boxes, U32 index)
+    {
+        for (U32 p = 0; p < (U32)Frustum::Planes::Count; p++)
+        {
+            const F32x4& plane = frustum.GetPlane((Frustum::Planes)p);
+            const F64 dist =
+                (F64)plane.x * boxes.centers[0][index] + (F64)plane.y * boxes.centers[1][index] + (F64)plane.z * boxes.centers[2][index] + plane.w +
+                std::abs((F64)plane.x) * boxes.extents[0][index] + std::abs((F64)plane.y) * boxes.extents[1][index] + std::abs((F64)plane.z) * boxes.extents[2][index];
+            if (std::abs(dist) < PLANE_EPSILON)
+                return true;
+        }
+        return false;
+    }
+
+    U32 CountMismatches(const Frustum& frustum, const BoxArray& boxes, const Array<U32>& lhs, const Array<U32>& rhs)
+    {
+        U32 ret = 0;
+        for (U32 word = 0; word < lhs.size(); word++)
+        {
+            ForEachBit(lhs[word] ^ rhs[word], [&](U32 bit) {
+                if (!IsTouchingPlane(frustum, boxes, word * 32 + bit))
+                    ret++;
+            });
+        }
+        return ret;
+    }
+
+    U32 CountBits(const Array<U32>& mask)
+    {
+        U32 ret = 0;
+        for (U32 word : mask)
+            ForEachBit(word, [&](U32 bit) { ret++; });
+        return ret;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Array<AABB> aabbs;
+    BoxArray boxes;
+    CreateScene(OBJECT_COUNT, aabbs, boxes);
+
+    Array<U32> scalarMask;
+    Array<U32> batchedMask;
+    scalarMask.resize((OBJECT_COUNT + 31) / 32);
+    batchedMask.resize((OBJECT_COUNT + 31) / 32);
+
+    int ret = 0;
+    F32 scalarTime = 0.0f;
+    F32 batchedTime = 0.0f;
+    U32 visibleCount = 0;
+    for (U32 frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        const Frustum frustum = CreateFrustum(frame * MATH_PI * 2.0f / FRAME_COUNT);
+        scalarTime += CheckScalar(frustum, aabbs, scalarMask);
+        batchedTime += CheckBatched(frustum, boxes, OBJECT_COUNT, batchedMask);
+
+        // Both must find the same objects, except the ones touching a plane
+        const U32 mismatchCount = CountMismatches(frustum, boxes, scalarMask, batchedMask);
+        if (mismatchCount > 0)
+        {
+            std::cout << "Mismatched visible objects:" << mismatchCount << ", frame:" << frame << std::endl;
+            ret = 1;
+        }
+        visibleCount += CountBits(batchedMask);
+    }
+
+#if defined(CJING_SIMD_SSE)
+    const char* kernel = "SSE";
+#else
+    const char* kernel = "Scalar";
+#endif
+#if defined(__AVX__)
+    if (IsAVXSupported())
+        kernel = "AVX";
+#endif
+    const F32 totalCount = (F32)OBJECT_COUNT * FRAME_COUNT;
+    std::cout << "Objects:" << OBJECT_COUNT
+              << " Visible:" << visibleCount / FRAME_COUNT
+              << " Kernel:" << kernel
+              << std::endl;
+    std::cout << "    CheckBoxFast:" << totalCount / std::max(scalarTime, 0.000001f) << "objects/s"
+              << " CheckBoxes:" << totalCount / std::max(batchedTime, 0.000001f) << "objects/s"
+              << " Speedup:" << scalarTime / std::max(batchedTime, 0.000001f)
+              << std::endl;
+    return ret;
+}
@@ -1,60 +1,327 @@
-#include "client\app\app.h"
-#include "gpu\vulkan\device.h"
-#include "math\math.hpp"
 #include "core\jobsystem\jobsystem.h"
 #include "core\platform\platform.h"
+#include "core\platform\timer.h"
+#include "core\platform\sync.h"
 
-#include <coroutine>
-#include <chrono>
+#include <atomic>
 
 using namespace VulkanTest;
 
-int main()
+namespace
 {
-	if (!Jobsystem::Initialize(VulkanTest::Platform::GetCPUsCount()))
-    {
-        std::cout << "Failed to init jobsystem" << std::endl;
-        return 0;
-    }
-
-   /* Jobsystem::ShowDebugInfo();
-
-    struct TestData
-    {
-        int value = 0;
-    } 
-    testData;
-
-    auto time = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-    Jobsystem::JobHandle handle = Jobsystem::INVALID_HANDLE;
-    for(int i = 0; i < 200; i++)
-    { 
-        Jobsystem::JobInfo jobInfo = {};
-        jobInfo.name = "Test";
-        jobInfo.priority = Jobsystem::Priority::NORMAL;
-        jobInfo.precondition = Jobsystem::INVALID_HANDLE;
-        jobInfo.data = &testData;
-        jobInfo.jobFunc = [](void* data) {
-            TestData* testData = reinterpret_cast<TestData*>(data);
-            
-            Jobsystem::JobHandle handle = Jobsystem::INVALID_HANDLE;
-            Jobsystem::Run(testData, [](void* data) {
-                TestData* testData = reinterpret_cast<TestData*>(data);
-                testData->value-=2;
-            }, & handle);
-            Jobsystem::Wait(handle);
-
-            testData->value++;
+    const U32 JOB_ROUND_COUNT = 200;
+    const U32 JOB_COUNT_PER_ROUND = 2048;
+
+    // Dependent job tree: every inner job spawns children and waits for them
+    const U32 TREE_ROUND_COUNT = 50;
+    const U32 TREE_BRANCH_COUNT = 16;
+    const U32 TREE_DEPTH = 3;
+
+    // Long background jobs must not delay frame jobs
+    const U32 BACKGROUND_JOB_COUNT = 64;
+    const F32 BACKGROUND_JOB_TIME = 0.01f;
+    const U32 FRAME_ROUND_COUNT = 100;
+
+    // Waitors of a reused handle must not return before the jobs submitted before their wait
+    const U32 REUSE_ROUND_COUNT = 2000;
+    const U32 REUSE_JOB_COUNT = 16;
+    const U32 REUSE_WAITOR_COUNT = 8;
+
+    enum class SubmitMode
+    {
+        Single,
+        Batch,
+        ForEach
+    };
+
+    struct BenchmarkData
+    {
+        volatile I64 values[64] = {};
+        Semaphore* semaphore = nullptr;
+        SubmitMode mode = SubmitMode::Single;
+        F32 elapsed = 0.0f;
+    };
+
+    void DoTinyWork(void* data)
+    {
+        // Tiny workload, the benchmark is dominated by the job scheduling cost
+        BenchmarkData* benchmark = static_cast<BenchmarkData*>(data);
+        U32 index = Platform::GetCurrentThreadIndex() % 64;
+        benchmark->values[index]++;
+    }
+
+    // Fan out small jobs from a worker, all workers contend on the queues
+    F32 RunContentionBenchmark(U32 workerCount, SubmitMode mode)
+    {
+        if (!Jobsystem::Initialize(workerCount))
+            return 0.0f;
+
+        Semaphore semaphore(0, 1);
+        BenchmarkData data;
+        data.semaphore = &semaphore;
+        data.mode = mode;
+
+        Jobsystem::Run(&data, [](void* ptr) {
+            BenchmarkData* data = static_cast<BenchmarkData*>(ptr);
+            Timer timer;
+            std::vector<Jobsystem::JobDecl> decls(JOB_COUNT_PER_ROUND);
+            for (auto& decl : decls)
+            {
+                decl.task = DoTinyWork;
+                decl.data = data;
+            }
+
+            for (U32 round = 0; round < JOB_ROUND_COUNT; round++)
+            {
+                Jobsystem::JobHandle handle;
+                switch (data->mode)
+                {
+                case SubmitMode::Single:
+                    for (U32 i = 0; i < JOB_COUNT_PER_ROUND; i++)
+                        Jobsystem::Run(data, DoTinyWork, &handle);
+                    break;
+                case SubmitMode::Batch:
+                    Jobsystem::RunBatch(Span<const Jobsystem::JobDecl>(decls.data(), decls.size()), &handle);
+                    break;
+                case SubmitMode::ForEach:
+                    Jobsystem::ForEach(JOB_COUNT_PER_ROUND, 1, [data](U32 index) {
+                        DoTinyWork(data);
+                    });
+                    break;
+                }
+                Jobsystem::Wait(&handle);
+            }
+            data->elapsed = timer.GetTimeSinceStart();
+            data->semaphore->Signal();
+        }, nullptr, 0);
+
+        semaphore.Wait();
+        Jobsystem::Uninitialize();
+
+        I64 total = 0;
+        for (auto value : data.values)
+            total += value;
+        if (total != (I64)JOB_ROUND_COUNT * JOB_COUNT_PER_ROUND)
+            std::cout << "Invalid job count:" << total << std::endl;
+
+        return data.elapsed;
+    }
+
+    struct TreeNode
+    {
+        U32 depth = 0;
+        std::atomic<U32>* leafCount = nullptr;
+        std::atomic<U32>* jobCount = nullptr;
+    };
+
+    void RunTreeNode(void* data)
+    {
+        TreeNode* node = static_cast<TreeNode*>(data);
+        node->jobCount->fetch_add(1, std::memory_order_relaxed);
+        if (node->depth == TREE_DEPTH)
+        {
+            node->leafCount->fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Children live on the stack of the parent, it waits for all of them
+        TreeNode children[TREE_BRANCH_COUNT];
+        Jobsystem::JobHandle handle;
+        for (auto& child : children)
+        {
+            child.depth = node->depth + 1;
+            child.leafCount = node->leafCount;
+            child.jobCount = node->jobCount;
+            Jobsystem::Run(&child, RunTreeNode, &handle);
+        }
+        Jobsystem::Wait(&handle);
+    }
+
+    // Thousands of jobs completing handles and resuming waiting fibers concurrently
+    void RunDependentJobsStressTest(U32 workerCount)
+    {
+        if (!Jobsystem::Initialize(workerCount))
             return;
-        };
-        Jobsystem::Run(jobInfo, &handle);
+
+        std::atomic<U32> leafCount = 0;
+        std::atomic<U32> jobCount = 0;
+        Timer timer;
+        for (U32 round = 0; round < TREE_ROUND_COUNT; round++)
+        {
+            TreeNode root;
+            root.leafCount = &leafCount;
+            root.jobCount = &jobCount;
+
+            Jobsystem::JobHandle handle;
+            Jobsystem::Run(&root, RunTreeNode, &handle);
+            Jobsystem::Wait(&handle);
+        }
+        F32 elapsed = timer.GetTimeSinceStart();
+        Jobsystem::Uninitialize();
+
+        U32 expectedLeafCount = TREE_ROUND_COUNT;
+        for (U32 i = 0; i < TREE_DEPTH; i++)
+            expectedLeafCount *= TREE_BRANCH_COUNT;
+
+        std::cout << "Workers:" << workerCount
+                  << " Dependent jobs:" << jobCount.load()
+                  << " Time:" << elapsed * 1000.0f << "ms"
+                  << " Jobs/sec:" << (U64)(jobCount.load() / std::max(elapsed, 0.0001f))
+                  << (leafCount.load() == expectedLeafCount ? "" : " FAILED")
+                  << std::endl;
+    }
+
+    void DoBackgroundWork(void* data)
+    {
+        std::atomic<U32>* finishedCount = static_cast<std::atomic<U32>*>(data);
+        Timer timer;
+        while (timer.GetTimeSinceStart() < BACKGROUND_JOB_TIME) {}
+        finishedCount->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Measure frame job latency while the background lane is saturated
+    void RunBackgroundLaneTest(U32 workerCount)
+    {
+        if (!Jobsystem::Initialize(workerCount, 1))
+            return;
+
+        std::atomic<U32> finishedCount = 0;
+        Jobsystem::JobHandle backgroundHandle;
+        for (U32 i = 0; i < BACKGROUND_JOB_COUNT; i++)
+            Jobsystem::Run(&finishedCount, DoBackgroundWork, &backgroundHandle, Jobsystem::ANY_WORKER, Jobsystem::Priority::Background);
+
+        U32 maxBackgroundDepth = Jobsystem::GetQueueDepth(Jobsystem::Priority::Background);
+        F32 maxLatency = 0.0f;
+        BenchmarkData data;
+        for (U32 round = 0; round < FRAME_ROUND_COUNT; round++)
+        {
+            Timer timer;
+            Jobsystem::JobHandle handle;
+            Jobsystem::Run(&data, DoTinyWork, &handle, Jobsystem::ANY_WORKER, Jobsystem::Priority::High);
+            for (U32 i = 0; i < 64; i++)
+                Jobsystem::Run(&data, DoTinyWork, &handle);
+            Jobsystem::Wait(&handle);
+            maxLatency = std::max(maxLatency, timer.GetTimeSinceStart());
+        }
+        Jobsystem::Wait(&backgroundHandle);
+        Jobsystem::Uninitialize();
+
+        std::cout << "Workers:" << workerCount
+                  << " Background depth:" << maxBackgroundDepth
+                  << " Max frame latency:" << maxLatency * 1000.0f << "ms"
+                  << (finishedCount.load() == BACKGROUND_JOB_COUNT ? "" : " FAILED")
+                  << std::endl;
+    }
+
+    struct ReuseData
+    {
+        Jobsystem::JobHandle handle;
+        std::atomic<U32> submittedCount = 0;
+        std::atomic<U32> finishedCount = 0;
+        std::atomic<U32> earlyCount = 0;
+        std::atomic<bool> isDone = false;
+    };
+
+    void DoCountedWork(void* data)
+    {
+        ReuseData* reuseData = static_cast<ReuseData*>(data);
+        reuseData->finishedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void WaitReusedHandle(void* data)
+    {
+        ReuseData* reuseData = static_cast<ReuseData*>(data);
+        while (!reuseData->isDone.load(std::memory_order_acquire))
+        {
+            // The jobs counted as submitted are in the waited generation or in a finished one
+            const U32 submittedCount = reuseData->submittedCount.load(std::memory_order_acquire);
+            Jobsystem::Wait(&reuseData->handle);
+            if (reuseData->finishedCount.load(std::memory_order_acquire) < submittedCount)
+                reuseData->earlyCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // One handle reused by many generations while the fibers of the workers wait on it
+    void RunHandleReuseTest(U32 workerCount)
+    {
+        if (!Jobsystem::Initialize(workerCount))
+            return;
+
+        ReuseData reuseData;
+        Jobsystem::JobHandle waitorHandle;
+        for (U32 i = 0; i < REUSE_WAITOR_COUNT; i++)
+            Jobsystem::Run(&reuseData, WaitReusedHandle, &waitorHandle);
+
+        for (U32 round = 0; round < REUSE_ROUND_COUNT; round++)
+        {
+            for (U32 i = 0; i < REUSE_JOB_COUNT; i++)
+            {
+                Jobsystem::Run(&reuseData, DoCountedWork, &reuseData.handle);
+                reuseData.submittedCount.fetch_add(1, std::memory_order_release);
+            }
+            Jobsystem::Wait(&reuseData.handle);
+        }
+        reuseData.isDone.store(true, std::memory_order_release);
+        Jobsystem::Wait(&waitorHandle);
+        Jobsystem::Uninitialize();
+
+        std::cout << "Workers:" << workerCount
+                  << " Generations:" << REUSE_ROUND_COUNT
+                  << " Early waitors:" << reuseData.earlyCount.load()
+                  << (reuseData.earlyCount.load() == 0 ? "" : " FAILED")
+                  << std::endl;
+    }
+}
+
+int main()
+{
+    const U32 maxWorkerCount = (U32)Platform::GetCPUsCount();
+    const U32 jobCount = JOB_ROUND_COUNT * JOB_COUNT_PER_ROUND;
+
+    std::cout << "Jobsystem contention benchmark, jobs:" << jobCount << std::endl;
+    for (U32 workerCount = 1; workerCount <= maxWorkerCount; workerCount *= 2)
+    {
+        const char* modeNames[] = { "Run", "RunBatch", "ForEach" };
+        for (U32 mode = 0; mode < 3; mode++)
+        {
+            F32 elapsed = RunContentionBenchmark(workerCount, (SubmitMode)mode);
+            std::cout << "Workers:" << workerCount
+                      << " Mode:" << modeNames[mode]
+                      << " Time:" << elapsed * 1000.0f << "ms"
+                      << " Jobs/sec:" << (U64)(jobCount / std::max(elapsed, 0.0001f))
+                      << std::endl;
+        }
+
+        if (workerCount < maxWorkerCount && workerCount * 2 > maxWorkerCount)
+            workerCount = maxWorkerCount / 2;
+    }
+
+    std::cout << "Jobsystem dependent jobs stress test" << std::endl;
+    for (U32 workerCount = 1; workerCount <= maxWorkerCount; workerCount *= 2)
+    {
+        RunDependentJobsStressTest(workerCount);
+
+        if (workerCount < maxWorkerCount && workerCount * 2 > maxWorkerCount)
+            workerCount = maxWorkerCount / 2;
+    }
+
+    std::cout << "Jobsystem background lane test" << std::endl;
+    for (U32 workerCount = 1; workerCount <= maxWorkerCount; workerCount *= 2)
+    {
+        RunBackgroundLaneTest(workerCount);
+
+        if (workerCount < maxWorkerCount && workerCount * 2 > maxWorkerCount)
+            workerCount = maxWorkerCount / 2;
+    }
+
+    std::cout << "Jobsystem handle reuse test" << std::endl;
+    for (U32 workerCount = 2; workerCount <= maxWorkerCount; workerCount *= 2)
+    {
+        RunHandleReuseTest(workerCount);
+
+        if (workerCount < maxWorkerCount && workerCount * 2 > maxWorkerCount)
+            workerCount = maxWorkerCount / 2;
     }
 
-    Jobsystem::Wait(handle);
-    time = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() - time;
-    std::cout << "Test value:" << testData.value << std::endl;
-    std::cout << "Wait time:" << time << std::endl;
-    Jobsystem::ShowDebugInfo();*/
-    Jobsystem::Uninitialize();
 	return 0;
-}
\ No newline at end of file
+}
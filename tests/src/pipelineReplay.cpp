@@ -0,0 +1,103 @@
+#include "gpu\vulkan\device.h"
+#include "core\jobsystem\jobsystem.h"
+#include "core\platform\platform.h"
+#include "core\platform\timer.h"
+
+#include <atomic>
+
+using namespace VulkanTest;
+
+namespace
+{
+    // Rebuild all graphics pipelines of the pipeline database recorded by the application run with -record_pipelines,
+    // without window.
+    // The creation throughput is measured with the growing worker count, then the pipelines are compiled
+    // into the pipeline cache which is saved with the shader cache.
+    // Usage: pipelineReplay [pipeline database]
+    const U32 MAX_WORKER_COUNT = 16;
+
+    struct ReplayStats
+    {
+        std::atomic<U32> createdCount = 0;
+        std::atomic<U32> failedCount = 0;
+    };
+
+    F32 RunReplay(GPU::DeviceVulkan& device, const std::vector<GPU::GraphicsPipelineDesc>& descs, U32 workerCount, ReplayStats& stats)
+    {
+        if (!Jobsystem::Initialize(workerCount))
+            return 0.0f;
+
+        Timer timer;
+        Jobsystem::ForEach((U32)descs.size(), 1, [&](U32 index) {
+            // Without pipeline cache, measure the compilation of the driver
+            GPU::GraphicsPipelineDesc desc = descs[index];
+            desc.pipelineState.cache = VK_NULL_HANDLE;
+            VkPipeline pipeline = GPU::CommandList::CreateGraphicsPipeline(device, desc);
+            if (pipeline == VK_NULL_HANDLE)
+            {
+                stats.failedCount++;
+                return;
+            }
+
+            vkDestroyPipeline(device.device, pipeline, nullptr);
+            stats.createdCount++;
+        });
+        const F32 elapsed = timer.GetTimeSinceStart();
+
+        Jobsystem::Uninitialize();
+        return elapsed;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : GPU::DeviceVulkan::PIPELINE_DATABASE_PATH;
+    const U32 maxWorkerCount = std::min((U32)std::max(Platform::GetCPUsCount(), 1), MAX_WORKER_COUNT);
+
+    // Headless device, no surface extensions
+    GPU::VulkanContext context(maxWorkerCount);
+    if (!context.Initialize({}, {}, false))
+    {
+        std::cout << "Failed to initialize vulkan" << std::endl;
+        return 1;
+    }
+
+    int ret = 0;
+    {
+        GPU::DeviceVulkan device;
+        device.SetContext(context);
+
+        std::vector<GPU::GraphicsPipelineDesc> descs;
+        if (!device.LoadPipelineDatabase(path, descs) || descs.empty())
+        {
+            std::cout << "No pipeline found in " << path << std::endl;
+            return 1;
+        }
+        std::cout << "Pipelines:" << descs.size() << std::endl;
+
+        for (U32 workerCount = 1; workerCount <= maxWorkerCount; workerCount *= 2)
+        {
+            ReplayStats stats;
+            const F32 elapsed = RunReplay(device, descs, workerCount, stats);
+            std::cout << "Workers:" << workerCount
+                      << " Created:" << stats.createdCount
+                      << " Failed:" << stats.failedCount
+                      << " Time:" << elapsed * 1000.0f << "ms"
+                      << " Throughput:" << stats.createdCount / std::max(elapsed, 0.0001f) << "pipelines/s"
+                      << std::endl;
+
+            if (stats.failedCount > 0)
+                ret = 1;
+        }
+
+        // Warm the pipeline cache, it is saved when the device is destroyed
+        if (!Jobsystem::Initialize(maxWorkerCount, maxWorkerCount))
+            return 1;
+
+        Timer timer;
+        device.PrewarmGraphicsPipelines(descs.data(), (U32)descs.size());
+        std::cout << "Prewarm:" << timer.GetTimeSinceStart() * 1000.0f << "ms" << std::endl;
+    }
+    Jobsystem::Uninitialize();
+    return ret;
+}
@@ -0,0 +1,63 @@
+#include "core\utils\profiler.h"
+#include "core\platform\timer.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace VulkanTest;
+
+namespace
+{
+    // Cost of a profiled block with the profiler enabled and disabled, and the memory
+    // of the per-thread event ring buffers. The events wrap around the ring buffer several times
+    const U32 BLOCK_COUNT = 1000000;
+    const U32 THREAD_COUNTS[] = { 1, 4, 16 };
+
+    F32 RunBlocks(U32 threadCount)
+    {
+        Timer timer;
+        std::vector<std::thread> threads;
+        for (U32 i = 0; i < threadCount; i++)
+        {
+            threads.emplace_back([]() {
+                for (U32 block = 0; block < BLOCK_COUNT; block++)
+                {
+                    PROFILE_BLOCK("Block");
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        return timer.GetTimeSinceStart();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    for (U32 threadCount : THREAD_COUNTS)
+    {
+        Profiler::SetEnabled(false);
+        const F32 disabledTime = RunBlocks(threadCount);
+        Profiler::SetEnabled(true);
+        const F32 enabledTime = RunBlocks(threadCount);
+
+        // Nanoseconds of one block on one thread
+        const F32 scale = 1000000000.0f / BLOCK_COUNT;
+        std::cout << "Threads:" << threadCount
+                  << " Disabled:" << disabledTime * scale << "ns/block"
+                  << " Enabled:" << enabledTime * scale << "ns/block"
+                  << " Overhead:" << std::max(enabledTime - disabledTime, 0.0f) * scale << "ns/block"
+                  << std::endl;
+    }
+
+    // Take a snapshot to check the copy of the ring buffers too
+    Timer snapshotTimer;
+    Profiler::RequestSnapshot();
+    Profiler::EndFrame();
+    const F32 snapshotTime = snapshotTimer.GetTimeSinceStart();
+
+    std::cout << "Event buffers:" << Profiler::GetEventBufferBytes() / 1024 << "KB"
+              << " Snapshot:" << snapshotTime * 1000.0f << "ms"
+              << std::endl;
+    return Profiler::HasSnapshot() ? 0 : 1;
+}
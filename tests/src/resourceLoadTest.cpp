@@ -0,0 +1,181 @@
+#include "core\filesystem\filesystem.h"
+#include "core\resource\resource.h"
+#include "core\platform\platform.h"
+#include "core\platform\timer.h"
+#include "core\utils\compression.h"
+
+using namespace VulkanTest;
+
+namespace
+{
+    // Compare the async loading of raw and LZ4 compressed compiled resources, e.g. the exported models.
+    // The loaded data is checksummed so the mapped pages are really read and both modes are checked.
+    // Usage: resourceLoadTest [compiled resource directory] [compression level]
+    const char* DEFAULT_RESOURCE_DIR = ".export/resources";
+    const char* OUTPUT_DIR = "resourceLoadTest";
+    const U32 ROUND_COUNT = 5;
+
+    // FNV-1a of the resource data, the results of the files are summed so the order does not matter
+    U64 Checksum(const U8* data, U64 size)
+    {
+        U64 ret = 14695981039346656037ull;
+        for (U64 i = 0; i < size; i++)
+            ret = (ret ^ data[i]) * 1099511628211ull;
+        return ret;
+    }
+
+    struct LoadStats
+    {
+        U32 loadedCount = 0;
+        U32 failedCount = 0;
+        U64 loadedBytes = 0;
+        U64 checksum = 0;
+
+        void OnFileLoaded(U64 size, const U8* mem, bool success)
+        {
+            if (success && size >= sizeof(CompiledResourceHeader))
+            {
+                loadedCount++;
+                loadedBytes += size;
+                checksum += Checksum(mem + sizeof(CompiledResourceHeader), size - sizeof(CompiledResourceHeader));
+            }
+            else
+            {
+                failedCount++;
+            }
+        }
+    };
+
+    bool WriteFile(FileSystem& fs, const char* path, const CompiledResourceHeader& header, const void* data, U64 size)
+    {
+        auto file = fs.OpenFile(path, FileFlags::DEFAULT_WRITE);
+        if (!file->IsValid())
+            return false;
+
+        bool ret = file->Write(&header, sizeof(header)) && file->Write(data, size);
+        file->Close();
+        return ret;
+    }
+
+    // Write the raw and compressed version of each compiled resource
+    bool PrepareFiles(FileSystem& fs, const char* resourceDir, I32 level, std::vector<StaticString<MAX_PATH_LENGTH>>& names, U64& rawBytes, U64& compressedBytes, U64& checksum)
+    {
+        for (const auto& entry : fs.Enumerate(resourceDir, (int)EnumrateMode::File))
+        {
+            if (!EndsWith(entry.filename, ".res"))
+                continue;
+
+            OutputMemoryStream mem;
+            StaticString<MAX_PATH_LENGTH> path(resourceDir, "/", entry.filename);
+            if (!fs.LoadContext(path, mem) || mem.Size() < sizeof(CompiledResourceHeader))
+                continue;
+
+            CompiledResourceHeader header;
+            memcpy(&header, mem.Data(), sizeof(header));
+            if (header.magic != CompiledResourceHeader::MAGIC)
+                continue;
+
+            OutputMemoryStream raw;
+            if (!Resource::DecompressFile(mem.Size(), mem.Data(), raw) || (header.isCompressed && raw.Empty()))
+                continue;
+
+            const U8* rawData = (header.isCompressed ? raw.Data() : mem.Data()) + sizeof(header);
+            const I32 rawSize = (I32)header.originSize;
+            OutputMemoryStream compressed;
+            compressed.Resize(LZ4::CompressBound(rawSize));
+            const I32 compressedSize = LZ4::Compress(rawData, compressed.Data(), rawSize, (I32)compressed.Size(), level);
+            if (compressedSize <= 0)
+                continue;
+
+            header.isCompressed = false;
+            if (!WriteFile(fs, StaticString<MAX_PATH_LENGTH>(OUTPUT_DIR, "/raw/", entry.filename), header, rawData, rawSize))
+                return false;
+
+            header.isCompressed = true;
+            if (!WriteFile(fs, StaticString<MAX_PATH_LENGTH>(OUTPUT_DIR, "/lz4/", entry.filename), header, compressed.Data(), compressedSize))
+                return false;
+
+            names.push_back(entry.filename);
+            rawBytes += rawSize;
+            compressedBytes += compressedSize;
+            checksum += Checksum(rawData, rawSize);
+        }
+        return !names.empty();
+    }
+
+    F32 RunLoading(FileSystem& fs, const char* dir, const std::vector<StaticString<MAX_PATH_LENGTH>>& names, LoadStats& stats)
+    {
+        AsyncLoadCallback cb;
+        cb.Bind<&LoadStats::OnFileLoaded>(&stats);
+        AsyncLoadProcessor processor;
+        processor.Bind<&Resource::DecompressFile>();
+
+        Timer timer;
+        for (const auto& name : names)
+        {
+            StaticString<MAX_PATH_LENGTH> path(OUTPUT_DIR, "/", dir, "/", name);
+            fs.LoadFileAsync(Path(path.c_str()), cb, AsyncLoadPriority::Normal, AsyncLoadFlags::MEMORY_MAPPED, processor);
+        }
+
+        while (fs.HasWork())
+            fs.ProcessAsync();
+
+        return timer.GetTimeSinceStart();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* resourceDir = argc > 1 ? argv[1] : DEFAULT_RESOURCE_DIR;
+    const I32 level = argc > 2 ? atoi(argv[2]) : LZ4::DEFAULT_LEVEL;
+
+    char currentDir[MAX_PATH_LENGTH];
+    Platform::GetCurrentDir(Span(currentDir));
+    auto fs = FileSystem::Create(currentDir);
+    Platform::MakeDir(OUTPUT_DIR);
+    Platform::MakeDir(StaticString<MAX_PATH_LENGTH>(OUTPUT_DIR, "/raw"));
+    Platform::MakeDir(StaticString<MAX_PATH_LENGTH>(OUTPUT_DIR, "/lz4"));
+
+    std::vector<StaticString<MAX_PATH_LENGTH>> names;
+    U64 rawBytes = 0;
+    U64 compressedBytes = 0;
+    U64 checksum = 0;
+    if (!PrepareFiles(*fs, resourceDir, level, names, rawBytes, compressedBytes, checksum))
+    {
+        std::cout << "No compiled resource found in " << resourceDir << std::endl;
+        return 1;
+    }
+
+    std::cout << "Files:" << names.size()
+              << " Raw:" << rawBytes / 1024 << "KB"
+              << " LZ4:" << compressedBytes / 1024 << "KB"
+              << " Ratio:" << (F32)compressedBytes / std::max(rawBytes, (U64)1)
+              << " Level:" << level
+              << std::endl;
+
+    int ret = 0;
+    const char* dirs[] = { "raw", "lz4" };
+    for (U32 round = 0; round < ROUND_COUNT; round++)
+    {
+        for (const char* dir : dirs)
+        {
+            LoadStats stats;
+            F32 elapsed = RunLoading(*fs, dir, names, stats);
+            std::cout << "Round:" << round
+                      << " Mode:" << dir
+                      << " Loaded:" << stats.loadedCount
+                      << " Failed:" << stats.failedCount
+                      << " Time:" << elapsed * 1000.0f << "ms"
+                      << " Throughput:" << (F32)(stats.loadedBytes / std::max(elapsed, 0.0001f) / (1024.0f * 1024.0f)) << "MB/s"
+                      << std::endl;
+
+            if (stats.failedCount > 0 || stats.checksum != checksum)
+            {
+                std::cout << "Mismatched loaded data, mode:" << dir << std::endl;
+                ret = 1;
+            }
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,157 @@
+#include "core\utils\tempHashMap.h"
+#include "core\platform\timer.h"
+
+#include <list>
+#include <unordered_map>
+
+using namespace VulkanTest;
+
+namespace
+{
+    // Render graph like workload: every frame requests a stable set of framebuffers,
+    // a few passes change their attachments and create new framebuffers
+    const U32 FRAME_COUNT = 2000;
+    const U32 REQUEST_COUNT_PER_FRAME = 512;
+    const U32 CHANGED_REQUEST_COUNT_PER_FRAME = 16;
+    const U32 RING_SIZE = 8;
+
+    struct FrameBufferNode : Util::TempHashMapItem<FrameBufferNode>
+    {
+        explicit FrameBufferNode(U32 value_) : value(value_) {}
+        U32 value;
+    };
+
+    // The previous implementation, std::list rings with std::find to relink a hit
+    template <typename T, size_t RingSize>
+    class ListTempHashMap
+    {
+    private:
+        U32 ringIndex = 0;
+        Util::ObjectPool<T> objectPool;
+        std::unordered_map<HashValue, T *> hashMap;
+        std::list<T *> rings[RingSize];
+
+    public:
+        ~ListTempHashMap()
+        {
+            for (std::list<T *> &list : rings)
+            {
+                for (auto &obj : list)
+                    objectPool.free(obj);
+            }
+        }
+
+        U32 Size() const
+        {
+            return (U32)hashMap.size();
+        }
+
+        void BeginFrame()
+        {
+            ringIndex = (ringIndex + 1) % RingSize;
+            for (auto node : rings[ringIndex])
+            {
+                hashMap.erase(node->GetHash());
+                objectPool.free(node);
+            }
+            rings[ringIndex].clear();
+        }
+
+        T *Requset(HashValue hash)
+        {
+            auto it = hashMap.find(hash);
+            if (it == hashMap.end())
+                return nullptr;
+
+            T *ret = it->second;
+            if (ret->GetIndex() != ringIndex)
+            {
+                auto& ring = rings[ret->GetIndex()];
+                ring.erase(std::find(ring.begin(), ring.end(), ret));
+                rings[ringIndex].push_back(ret);
+                ret->SetIndex(ringIndex);
+            }
+            return ret;
+        }
+
+        template <typename... Args>
+        T *Emplace(HashValue hash, Args &&...args)
+        {
+            auto obj = objectPool.allocate(std::forward<Args>(args)...);
+            obj->SetHash(hash);
+            obj->SetIndex(ringIndex);
+            hashMap[hash] = obj;
+            rings[ringIndex].push_back(obj);
+            return obj;
+        }
+    };
+
+    HashValue GetFrameBufferHash(U32 pass, U32 version)
+    {
+        HashCombiner hasher;
+        hasher.HashCombine(pass);
+        hasher.HashCombine(version);
+        return hasher.Get();
+    }
+
+    template<typename MapType>
+    bool RunFrames(MapType& map, U32& createdCount)
+    {
+        U32 versions[REQUEST_COUNT_PER_FRAME] = {};
+        U32 seed = 1;
+        for (U32 frame = 0; frame < FRAME_COUNT; frame++)
+        {
+            map.BeginFrame();
+
+            for (U32 i = 0; i < CHANGED_REQUEST_COUNT_PER_FRAME; i++)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                versions[seed % REQUEST_COUNT_PER_FRAME]++;
+            }
+
+            for (U32 pass = 0; pass < REQUEST_COUNT_PER_FRAME; pass++)
+            {
+                const HashValue hash = GetFrameBufferHash(pass, versions[pass]);
+                auto* node = map.Requset(hash);
+                if (node == nullptr)
+                {
+                    node = map.Emplace(hash, pass);
+                    createdCount++;
+                }
+
+                if (node->value != pass || node->GetHash() != hash)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename MapType>
+    void RunBenchmark(const char* name)
+    {
+        MapType map;
+        U32 createdCount = 0;
+        Timer timer;
+        bool ret = RunFrames(map, createdCount);
+        F32 elapsed = timer.GetTimeSinceStart();
+
+        std::cout << "Map:" << name
+                  << " Frames:" << FRAME_COUNT
+                  << " Requests/frame:" << REQUEST_COUNT_PER_FRAME
+                  << " Created:" << createdCount
+                  << " Alive:" << map.Size()
+                  << " Time:" << elapsed * 1000.0f << "ms"
+                  << " Per frame:" << elapsed * 1000000.0f / FRAME_COUNT << "us"
+                  << (ret ? "" : " FAILED")
+                  << std::endl;
+    }
+}
+
+int main()
+{
+    RunBenchmark<ListTempHashMap<FrameBufferNode, RING_SIZE>>("std::list");
+    RunBenchmark<Util::TempHashMap<FrameBufferNode, RING_SIZE>>("TempHashMap");
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "client\app\app.h"
+#include "core\filesystem\filesystem.h"
+#include "core\resource\resourceManager.h"
+#include "renderer\texture.h"
+#include "renderer\textureStreamer.h"
+
+namespace VulkanTest
+{
+    // Stream the mips of generated textures by the demand and check the budget of the streamer:
+    // Phase 0: two textures are demanded at full size, they are streamed in
+    // Phase 1: two other textures are demanded, the budget only fits three so an invisible one is evicted
+    // Phase 2: the budget is reduced without demand, the resident mips are dropped under it
+    const U32 TEXTURE_COUNT = 8;
+    const U32 TEXTURE_SIZE = 1024;
+    const U32 TEXTURE_LEVELS = 11;
+    const U32 MAX_PHASE_FRAMES = 600;
+    const char* TEXTURE_DIR = "textureStreamerTest";
+
+    static int testResult = 0;
+
+    class TestApp : public App
+    {
+    private:
+        ResPtr<Texture> textures[TEXTURE_COUNT];
+        U64 fullChainSize = 0;
+        U64 tailChainSize = 0;
+        U32 phase = 0;
+        U32 phaseFrames = 0;
+
+    public:
+        void Initialize() override
+        {
+            App::Initialize();
+
+            ResourceManager& resManager = engine->GetResourceManager();
+            for (U32 i = 0; i < TEXTURE_COUNT; i++)
+            {
+                const Path path(StaticString<MAX_PATH_LENGTH>(TEXTURE_DIR, "/texture_", i, ".tex").c_str());
+                if (!WriteTexture(path, (U8)i))
+                {
+                    Fail("Failed to write the compiled texture");
+                    return;
+                }
+                textures[i] = resManager.LoadResourcePtr<Texture>(path);
+            }
+        }
+
+        void Uninitialize() override
+        {
+            for (auto& texture : textures)
+                texture.reset();
+
+            App::Uninitialize();
+        }
+
+        void Update(F32 dt) override
+        {
+            // The streamer processes the demand of the last frame in the engine update
+            App::Update(dt);
+            if (requestedShutdown)
+                return;
+
+            if (++phaseFrames > MAX_PHASE_FRAMES)
+            {
+                Fail("Phase timeout");
+                return;
+            }
+
+            for (auto& texture : textures)
+            {
+                if (texture->IsFailure())
+                {
+                    Fail("Failed to load the texture");
+                    return;
+                }
+                if (!texture->IsReady())
+                    return;
+            }
+
+            if (fullChainSize == 0)
+            {
+                fullChainSize = textures[0]->GetMipChainSize(0);
+                tailChainSize = textures[0]->GetMipChainSize(textures[0]->GetTailMip());
+                TextureStreamer::SetBudget(fullChainSize * 3 + tailChainSize * TEXTURE_COUNT);
+            }
+
+            const TextureStreamer::Stats stats = TextureStreamer::GetStats();
+            if (stats.budget > 0 && stats.residentBytes > stats.budget)
+            {
+                Fail("Resident textures over the budget");
+                return;
+            }
+
+            switch (phase)
+            {
+            case 0:
+                if (IsStreamedIn(0, 2))
+                    NextPhase();
+                else
+                    Demand(0, 2);
+                break;
+            case 1:
+                if (IsStreamedIn(2, 4))
+                {
+                    if (!IsDropped(0) && !IsDropped(1))
+                    {
+                        Fail("No invisible texture evicted");
+                        return;
+                    }
+                    NextPhase();
+
+                    // Only the tails and one full chain fit
+                    TextureStreamer::SetBudget(fullChainSize + tailChainSize * TEXTURE_COUNT);
+                }
+                else
+                {
+                    Demand(2, 4);
+                }
+                break;
+            case 2:
+                if (stats.budget == TextureStreamer::GetBudget() && stats.residentBytes <= stats.budget)
+                {
+                    std::cout << "Texture streaming passed, resident:" << stats.residentBytes / 1024 << "KB"
+                              << " budget:" << stats.budget / 1024 << "KB" << std::endl;
+                    RequestShutdown();
+                }
+                break;
+            }
+        }
+
+    private:
+        bool WriteTexture(const Path& path, U8 value)
+        {
+            GPU::TextureFormatLayout layout;
+            layout.SetTexture2D(VK_FORMAT_R8G8B8A8_UNORM, TEXTURE_SIZE, TEXTURE_SIZE, 1, TEXTURE_LEVELS);
+
+            Texture::FileHeader header = {};
+            header.magic = Texture::FILE_MAGIC;
+            header.version = Texture::FILE_VERSION;
+            header.format = VK_FORMAT_R8G8B8A8_UNORM;
+            header.width = TEXTURE_SIZE;
+            header.height = TEXTURE_SIZE;
+            header.layers = 1;
+            header.levels = TEXTURE_LEVELS;
+            header.dataSize = layout.GetRequiredSize();
+            header.flags = Texture::FILE_FLAG_STREAMABLE;
+
+            // Streamable textures are never compressed, the mips are read by ranges
+            CompiledResourceHeader resHeader;
+            resHeader.version = CompiledResourceHeader::VERSION;
+            resHeader.originSize = sizeof(header) + header.dataSize;
+            resHeader.isCompressed = false;
+
+            OutputMemoryStream data;
+            data.Resize(header.dataSize);
+            memset(data.Data(), value, data.Size());
+
+            FileSystem& fs = engine->GetFileSystem();
+            Platform::MakeDir(".export");
+            Platform::MakeDir(".export/resources");
+            StaticString<MAX_PATH_LENGTH> resPath(".export/resources/", path.GetHashValue(), ".res");
+            auto file = fs.OpenFile(resPath.c_str(), FileFlags::DEFAULT_WRITE);
+            if (!file->IsValid())
+                return false;
+
+            bool ret = file->Write(&resHeader, sizeof(resHeader)) &&
+                file->Write(&header, sizeof(header)) &&
+                file->Write(data.Data(), data.Size());
+            file->Close();
+            return ret;
+        }
+
+        void Demand(U32 begin, U32 end)
+        {
+            for (U32 i = begin; i < end; i++)
+                TextureStreamer::AddDemand(*textures[i], (F32)TEXTURE_SIZE);
+        }
+
+        bool IsStreamedIn(U32 begin, U32 end)const
+        {
+            for (U32 i = begin; i < end; i++)
+            {
+                if (textures[i]->IsStreaming() || textures[i]->GetResidentMip() != 0)
+                    return false;
+            }
+            return true;
+        }
+
+        bool IsDropped(U32 index)const
+        {
+            return textures[index]->GetResidentMip() == textures[index]->GetTailMip();
+        }
+
+        void NextPhase()
+        {
+            phase++;
+            phaseFrames = 0;
+        }
+
+        void Fail(const char* msg)
+        {
+            std::cout << msg << ", phase:" << phase << std::endl;
+            testResult = 1;
+            RequestShutdown();
+        }
+    };
+
+    App* CreateApplication(int, char**)
+    {
+        return new TestApp();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (VulkanTest::ApplicationMain(VulkanTest::CreateApplication, argc, argv) != 0)
+        return 1;
+    return VulkanTest::testResult;
+}
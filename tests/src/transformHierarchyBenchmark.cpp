@@ -0,0 +1,170 @@
+#include "renderer\transformHierarchy.h"
+#include "core\jobsystem\jobsystem.h"
+#include "core\platform\platform.h"
+#include "core\platform\timer.h"
+#include "math\random.h"
+
+#include <algorithm>
+
+using namespace VulkanTest;
+
+namespace
+{
+    // Update the world matrices of a random hierarchy with a part of the nodes dirty.
+    // The reference composes the parent chains on one thread in the node order.
+    // A leaf is added at last, the rebuild only updates the new node
+    const U32 NODE_COUNT = 100000;
+    const U32 ROOT_COUNT = 100;
+    const U32 FRAME_COUNT = 16;
+    const F32 DIRTY_RATIOS[] = { 0.01f, 1.0f };
+
+    void CreateHierarchy(Array<U32>& parents, Array<FMat4x4>& locals)
+    {
+        // The parent is always created before its children
+        parents.resize(NODE_COUNT);
+        locals.resize(NODE_COUNT);
+        for (U32 i = 0; i < NODE_COUNT; i++)
+        {
+            parents[i] = i < ROOT_COUNT ? TransformHierarchy::INVALID_NODE : Random::RandomInt(i / 2, i - 1);
+            locals[i] = IDENTITY_MATRIX;
+        }
+    }
+
+    FMat4x4 CreateLocalMatrix()
+    {
+        MATRIX R = MatrixRotationQuaternion(QuaternionRotationRollPitchYaw(
+            Random::RandomFloat(-0.1f, 0.1f),
+            Random::RandomFloat(-0.1f, 0.1f),
+            Random::RandomFloat(-0.1f, 0.1f)));
+        MATRIX T = MatrixTranslation(
+            Random::RandomFloat(-1.0f, 1.0f),
+            Random::RandomFloat(-1.0f, 1.0f),
+            Random::RandomFloat(-1.0f, 1.0f));
+        return StoreFMat4x4(R * T);
+    }
+
+    F32 UpdateReference(const Array<U32>& parents, const Array<FMat4x4>& locals, Array<FMat4x4>& worlds)
+    {
+        Timer timer;
+        for (U32 i = 0; i < parents.size(); i++)
+        {
+            MATRIX world = LoadFMat4x4(locals[i]);
+            if (parents[i] != TransformHierarchy::INVALID_NODE)
+                world = MatrixMultiply(world, LoadFMat4x4(worlds[parents[i]]));
+            worlds[i] = StoreFMat4x4(world);
+        }
+        return timer.GetTimeSinceStart();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (!Jobsystem::Initialize(std::max(Platform::GetCPUsCount() - 1, 1)))
+        return 1;
+
+    Array<U32> parents;
+    Array<FMat4x4> locals;
+    CreateHierarchy(parents, locals);
+
+    TransformHierarchy hierarchy;
+    Timer buildTimer;
+    hierarchy.Build(parents.data(), NODE_COUNT);
+    const F32 buildTime = buildTimer.GetTimeSinceStart();
+    hierarchy.Update();
+
+    Array<FMat4x4> worlds;
+    worlds.resize(NODE_COUNT);
+
+    std::cout << "Nodes:" << NODE_COUNT
+              << " Levels:" << hierarchy.GetLevelCount()
+              << " Workers:" << Jobsystem::GetWorkerCount()
+              << " Build:" << buildTime * 1000.0f << "ms"
+              << std::endl;
+
+    int ret = 0;
+    for (F32 dirtyRatio : DIRTY_RATIOS)
+    {
+        const U32 dirtyCount = std::max((U32)(NODE_COUNT * dirtyRatio), 1u);
+        F32 referenceTime = 0.0f;
+        F32 hierarchyTime = 0.0f;
+        U32 updatedCount = 0;
+        for (U32 frame = 0; frame < FRAME_COUNT; frame++)
+        {
+            for (U32 i = 0; i < dirtyCount; i++)
+            {
+                const U32 node = dirtyCount == NODE_COUNT ? i : Random::RandomInt(0, NODE_COUNT - 1);
+                locals[node] = CreateLocalMatrix();
+                hierarchy.SetLocalMatrix(node, locals[node]);
+            }
+
+            Timer timer;
+            hierarchy.Update();
+            hierarchyTime += timer.GetTimeSinceStart();
+            referenceTime += UpdateReference(parents, locals, worlds);
+
+            // Same multiplications in the same order, the results are identical
+            for (U32 i = 0; i < NODE_COUNT; i++)
+            {
+                if (hierarchy.IsUpdated(i))
+                    updatedCount++;
+
+                if (memcmp(&hierarchy.GetWorldMatrix(i), &worlds[i], sizeof(FMat4x4)) != 0)
+                {
+                    std::cout << "Mismatched world matrix, frame:" << frame << " node:" << i << std::endl;
+                    ret = 1;
+                    break;
+                }
+            }
+        }
+
+        std::cout << "    Dirty:" << dirtyRatio * 100.0f << "%"
+                  << " Updated:" << updatedCount / FRAME_COUNT
+                  << " Reference:" << referenceTime * 1000.0f / FRAME_COUNT << "ms"
+                  << " Hierarchy:" << hierarchyTime * 1000.0f / FRAME_COUNT << "ms"
+                  << " Speedup:" << referenceTime / std::max(hierarchyTime, 0.000001f)
+                  << std::endl;
+    }
+
+    // The previous nodes keep their matrices, only the new leaf is dirty
+    Array<U32> previousNodes;
+    previousNodes.resize(NODE_COUNT + 1);
+    for (U32 i = 0; i < NODE_COUNT; i++)
+        previousNodes[i] = i;
+    previousNodes[NODE_COUNT] = TransformHierarchy::INVALID_NODE;
+    parents.push_back(Random::RandomInt(0, NODE_COUNT - 1));
+    locals.push_back(CreateLocalMatrix());
+    worlds.resize(NODE_COUNT + 1);
+
+    Timer rebuildTimer;
+    hierarchy.Build(parents.data(), NODE_COUNT + 1, previousNodes.data());
+    hierarchy.SetLocalMatrix(NODE_COUNT, locals[NODE_COUNT]);
+    hierarchy.Update();
+    const F32 rebuildTime = rebuildTimer.GetTimeSinceStart();
+    UpdateReference(parents, locals, worlds);
+
+    U32 updatedCount = 0;
+    for (U32 i = 0; i <= NODE_COUNT; i++)
+    {
+        if (hierarchy.IsUpdated(i))
+            updatedCount++;
+
+        if (memcmp(&hierarchy.GetWorldMatrix(i), &worlds[i], sizeof(FMat4x4)) != 0)
+        {
+            std::cout << "Mismatched world matrix after the rebuild, node:" << i << std::endl;
+            ret = 1;
+            break;
+        }
+    }
+    if (updatedCount != 1)
+    {
+        std::cout << "Kept nodes updated after the rebuild:" << updatedCount - 1 << std::endl;
+        ret = 1;
+    }
+
+    std::cout << "    Rebuild:" << rebuildTime * 1000.0f << "ms"
+              << " Updated:" << updatedCount
+              << std::endl;
+
+    Jobsystem::Uninitialize();
+    return ret;
+}